@@ -1,4 +1,4 @@
-const state = { plants: [] };
+const state = { plants: [], stream: null };
 
 async function loadData() {
     try {
@@ -6,30 +6,35 @@ async function loadData() {
         const data = await res.json();
         state.plants = data.plants || [];
         
-        // Update Stats
-        document.getElementById('vpd-val').innerText = data.env.vpd.toFixed(2);
-        document.getElementById('temp-val').innerText = data.env.temp.toFixed(1);
-        document.getElementById('hum-val').innerText = data.env.hum.toFixed(0);
-        
+        renderEnv(data.env);
         renderList();
     } catch(e) { console.log("Connection lost..."); }
-    setTimeout(loadData, 2000);
 }
 
-function renderList() {
-    const list = document.getElementById('plant-list');
-    if(!list) return;
+// Fallback for browsers without EventSource
+async function pollData() {
+    await loadData();
+    setTimeout(pollData, 2000);
+}
+
+function renderEnv(env) {
+    if(!env) return;
+    // Missing or null while the DHT22 has gone quiet
+    const fmt = (v, d) => (v == null) ? '--' : v.toFixed(d);
+    document.getElementById('vpd-val').innerText = fmt(env.vpd, 2);
+    document.getElementById('temp-val').innerText = fmt(env.temp, 1);
+    document.getElementById('hum-val').innerText = fmt(env.hum, 0);
+}
+
+function rowHtml(p) {
+    let statusTag = "";
+    if(p.is_watering) statusTag = `<span class="tag water">PUMPING</span>`;
+    else if(p.error) statusTag = `<span class="tag err">ERROR</span>`;
+    else if(p.moisture < p.threshold) statusTag = `<span class="tag dry">DRY</span>`;
     
-    list.innerHTML = state.plants.map(p => {
-        let statusTag = "";
-        if(p.is_watering) statusTag = `<span class="tag water">PUMPING</span>`;
-        else if(p.error) statusTag = `<span class="tag err">ERROR</span>`;
-        else if(p.moisture < p.threshold) statusTag = `<span class="tag dry">DRY</span>`;
-        
-        let sensorType = (p.sensor_mode && p.sensor_mode.includes("Radar")) ? "RADAR" : "ANALOG";
+    let sensorType = (p.sensor_mode && p.sensor_mode.includes("Radar")) ? "RADAR" : "ANALOG";
 
-        return `
-        <div class="plant-row">
+    return `
             <div class="p-info">
                 <div class="p-name">${p.name} ${statusTag}</div>
                 <div class="p-meta">CH:${p.originalIndex} | ${sensorType} | TH:${p.threshold}%</div>
@@ -38,9 +43,42 @@ function renderList() {
                     <button class="btn-del" onclick="app.del(${p.id})">RM</button>
                 </div>
             </div>
-            <div class="p-val">${p.moisture}%</div>
-        </div>`;
-    }).join('');
+            <div class="p-val">${p.moisture}%</div>`;
+}
+
+function renderList() {
+    const list = document.getElementById('plant-list');
+    if(!list) return;
+    
+    list.innerHTML = state.plants.map(p => `
+        <div class="plant-row" id="row-${p.originalIndex}">${rowHtml(p)}
+        </div>`).join('');
+}
+
+// Patch a single row from a delta event
+function patchPlant(delta) {
+    const p = state.plants.find(x => x.originalIndex === delta.originalIndex);
+    if(!p) { loadData(); return; }
+    Object.assign(p, delta);
+    const row = document.getElementById('row-' + p.originalIndex);
+    if(row) row.innerHTML = rowHtml(p);
+}
+
+function setOnline(online) {
+    const el = document.querySelector('.status-indicator');
+    if(el) el.innerText = online ? "\u25CF ONLINE" : "\u25CB RECONNECTING";
+}
+
+function connectStream() {
+    if(!window.EventSource) { pollData(); return; }
+    
+    const es = new EventSource('/api/events');
+    es.addEventListener('plant', e => patchPlant(JSON.parse(e.data)));
+    es.addEventListener('env', e => renderEnv(JSON.parse(e.data)));
+    es.addEventListener('sync', () => loadData());
+    es.onopen = () => { setOnline(true); loadData(); };  // resync after (re)connect
+    es.onerror = () => { setOnline(false); console.log("Connection lost..."); };
+    state.stream = es;
 }
 
 window.app = {
@@ -74,4 +112,4 @@ window.app = {
     reboot: () => { if(confirm('Reboot?')) fetch('/api/reboot', {method:'POST'}); }
 };
 
-loadData();
\ No newline at end of file
+connectStream();
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// ==========================================================
+// Rosemary Core - Host Simulation Board
+// Virtual clock + GPIO/ADC state behind the Arduino HAL shims
+// ==========================================================
+
+namespace sim {
+
+#define SIM_PIN_COUNT 64
+
+struct BoardStats {
+    uint64_t analogReads = 0;
+    uint64_t digitalWrites = 0;
+    uint64_t fsOpens = 0;
+    uint64_t fsBytesWritten = 0;
+    uint64_t prefsWrites = 0;
+    uint64_t delayCalls = 0;
+    uint64_t delayMs = 0;
+    uint64_t heapAllocs = 0;     // operator new calls (counted in SimHeap.h)
+    uint64_t i2cTransfers = 0;
+};
+
+class Board {
+public:
+    // --- Virtual Clock ---
+    uint64_t nowUs = 0;
+
+    // --- GPIO State ---
+    int pinModes[SIM_PIN_COUNT];
+    int levels[SIM_PIN_COUNT];
+
+    // Analog source: (pin, pinMode) -> raw 12-bit value
+    std::function<int(int, int)> adcSource;
+    // Physics hooks: called with elapsed seconds whenever the clock moves
+    std::vector<std::function<void(double)>> steppers;
+    // Output hook: (pin, level) on every digitalWrite
+    std::vector<std::function<void(int, int)>> writeHooks;
+    // Mode hook: (pin, mode) on every pinMode (open-drain buses release this way)
+    std::vector<std::function<void(int, int)>> modeHooks;
+    // attachInterruptArg() handlers; edge() runs them with micros() at the edge time
+    struct Irq { void (*fn)(void*) = nullptr; void *arg = nullptr; };
+    Irq irqs[SIM_PIN_COUNT];
+    bool inIrq = false;
+    uint64_t irqUs = 0;
+    // Scheduler hook: called every simulated ms spent in delay()
+    std::function<void()> onDelay;
+
+    // Task whose step is running (TaskRunner), for trace spans
+    const char *taskName = "loop";
+    uint8_t taskCore = 1;
+
+    // Host paths / switches
+    std::string fsRoot = "sim_fs";
+    bool quiet = false;
+    bool rebootRequested = false;
+
+    BoardStats stats;
+
+    Board() { reset(); }
+
+    void reset() {
+        nowUs = 0;
+        for (int i = 0; i < SIM_PIN_COUNT; i++) { pinModes[i] = 0; levels[i] = 0; irqs[i] = Irq(); }
+        stats = BoardStats();
+        rebootRequested = false;
+    }
+
+    uint64_t nowMs() const { return nowUs / 1000; }
+
+    void advanceUs(uint64_t us) {
+        if (us == 0) return;
+        nowUs += us;
+        double dt = us / 1e6;
+        for (auto &s : steppers) s(dt);
+    }
+
+    void advanceMs(uint64_t ms) { advanceUs(ms * 1000); }
+
+    void setMode(int pin, int mode) {
+        if (pin < 0 || pin >= SIM_PIN_COUNT) return;
+        pinModes[pin] = mode;
+        for (auto &h : modeHooks) h(pin, mode);
+    }
+
+    // An external device moves an input pin (CHANGE interrupts only)
+    void edge(int pin, int level, uint64_t atUs) {
+        if (pin < 0 || pin >= SIM_PIN_COUNT || levels[pin] == level) return;
+        levels[pin] = level;
+        if (!irqs[pin].fn) return;
+        inIrq = true; irqUs = atUs;
+        irqs[pin].fn(irqs[pin].arg);
+        inIrq = false;
+    }
+
+    void write(int pin, int level) {
+        stats.digitalWrites++;
+        if (pin < 0 || pin >= SIM_PIN_COUNT) return;
+        levels[pin] = level;
+        for (auto &h : writeHooks) h(pin, level);
+    }
+
+    int read(int pin) const {
+        return (pin >= 0 && pin < SIM_PIN_COUNT) ? levels[pin] : 0;
+    }
+
+    int analog(int pin) {
+        stats.analogReads++;
+        if (!adcSource || pin < 0 || pin >= SIM_PIN_COUNT) return 0;
+        return adcSource(pin, pinModes[pin]);
+    }
+
+    // "d03 14:22:05.120" style stamp for log lines
+    void stamp(char *buf, size_t len) const {
+        uint64_t ms = nowMs();
+        unsigned d = ms / 86400000ULL; ms %= 86400000ULL;
+        unsigned h = ms / 3600000ULL; ms %= 3600000ULL;
+        unsigned m = ms / 60000ULL; ms %= 60000ULL;
+        unsigned s = ms / 1000ULL; ms %= 1000ULL;
+        snprintf(buf, len, "d%02u %02u:%02u:%02u.%03u", d, h, m, s, (unsigned)ms);
+    }
+};
+
+inline Board& board() {
+    static Board b;
+    return b;
+}
+
+} // namespace sim
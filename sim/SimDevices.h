@@ -0,0 +1,223 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "hal/Arduino.h"
+#include "hal/Wire.h"
+#include "SimBoard.h"
+#include "SoilModel.h"
+#include "../src/Config.h"
+
+// ==========================================================
+// Rosemary Core - External Front-End Models (Host Simulation)
+// 74HC4067 muxes, a 74HC595 chain, ADS1115s and an MCP23017,
+// wired to the soil model for the selected ZONE_LAYOUT, and the
+// DHT22 on its open-drain line.
+// ==========================================================
+
+namespace sim {
+
+// 74HC4067 bank: common pin m reads zone m*16 + select lines
+class MuxBankModel {
+public:
+    const int *selectPins, *commonPins;
+    int muxes;
+
+    MuxBankModel(const int *sel, const int *common, int n) : selectPins(sel), commonPins(common), muxes(n) {}
+
+    int zoneOf(Board &b, int pin) const {
+        for (int m = 0; m < muxes; m++) if (commonPins[m] == pin) {
+            int sel = 0;
+            for (int i = 0; i < 4; i++) sel |= (b.read(selectPins[i]) ? 1 : 0) << i;
+            return m * 16 + sel;
+        }
+        return -1;
+    }
+};
+
+// 74HC595 chain: shifts on clock rising edges, outputs follow the latch
+class ShiftChainModel {
+public:
+    int dataPin, clockPin, latchPin, bits;
+    uint64_t shift = 0, outputs = 0;
+    int lastClock = 0, lastLatch = 0;
+    std::function<void(int, bool)> onOutput;    // (bit, level) on every change
+
+    ShiftChainModel(int data, int clock, int latch, int chips) : dataPin(data), clockPin(clock), latchPin(latch), bits(chips * 8) {}
+
+    void onWrite(Board &b, int pin, int level) {
+        if (pin == clockPin) {
+            if (level && !lastClock) shift = (shift << 1) | (b.read(dataPin) ? 1 : 0);
+            lastClock = level;
+        } else if (pin == latchPin) {
+            if (level && !lastLatch) {
+                uint64_t mask = bits >= 64 ? ~0ULL : ((1ULL << bits) - 1);
+                uint64_t next = shift & mask, changed = next ^ outputs;
+                outputs = next;
+                for (int i = 0; i < bits; i++) if ((changed >> i) & 1) onOutput(i, (next >> i) & 1);
+            }
+            lastLatch = level;
+        }
+    }
+};
+
+// ADS1115: single-shot conversions that complete 1/860 s after the config write
+class Ads1115Model : public I2cDevice {
+public:
+    std::function<int(int)> source;             // channel -> 12-bit raw at 3.3 V full scale
+    uint8_t reg = 0;
+    int pendingCh = -1;
+    uint64_t readyAtUs = 0;
+    int16_t conversion = 0;
+
+    void onWrite(const uint8_t *data, size_t n) override {
+        if (n == 0) return;
+        reg = data[0];
+        if (reg == 0x01 && n >= 3) {
+            uint16_t config = (data[1] << 8) | data[2];
+            if (config & 0x8000) {
+                pendingCh = ((config >> 12) & 0x7) - 4;
+                readyAtUs = board().nowUs + 1163;
+            }
+        }
+    }
+
+    size_t onRead(uint8_t *data, size_t n) override {
+        // Reading early returns the previous result, as the real part does
+        if (pendingCh >= 0 && board().nowUs >= readyAtUs) {
+            conversion = (int16_t)(source(pendingCh) * 26400L / 4095);
+            pendingCh = -1;
+        }
+        uint16_t v = reg == 0x00 ? (uint16_t)conversion : 0;
+        if (n > 0) data[0] = v >> 8;
+        if (n > 1) data[1] = v & 0xFF;
+        return n < 2 ? n : 2;
+    }
+};
+
+// MCP23017 (IOCON.BANK = 0): register pointer auto-increments
+class Mcp23017Model : public I2cDevice {
+public:
+    uint8_t regs[0x16] = {0};
+    uint8_t reg = 0;
+    std::function<void(int, bool)> onOutput;    // (pin 0..15, level) on every change
+
+    void onWrite(const uint8_t *data, size_t n) override {
+        if (n == 0) return;
+        reg = data[0];
+        uint16_t before = regs[0x14] | (regs[0x15] << 8);
+        for (size_t i = 1; i < n; i++, reg++) if (reg < sizeof(regs)) regs[reg] = data[i];
+        uint16_t after = regs[0x14] | (regs[0x15] << 8);
+        for (int i = 0; i < 16; i++) if (((before ^ after) >> i) & 1) onOutput(i, (after >> i) & 1);
+    }
+
+    size_t onRead(uint8_t *data, size_t n) override {
+        for (size_t i = 0; i < n; i++) data[i] = reg + i < sizeof(regs) ? regs[reg + i] : 0;
+        return n;
+    }
+};
+
+// DHT22: a start pulse of >= 0.8 ms, then release, gets a full frame of
+// edges (+-3 us jitter) built from the climate model, delivered as
+// the clock passes them
+class Dht22Model {
+public:
+    int pin;
+    bool hostLow = false;
+    uint64_t lowSinceUs = 0;
+    std::vector<std::pair<uint64_t, int>> pending;   // (at us, level), in time order
+    size_t next = 0;
+    uint64_t frames = 0, corrupted = 0;
+
+    Dht22Model(int p) : pin(p) {}
+
+    void onWrite(Board &b, int p, int level) {
+        if (p != pin || b.pinModes[pin] != OUTPUT) return;
+        if (!level && !hostLow) lowSinceUs = b.nowUs;
+        hostLow = !level;
+    }
+
+    void onMode(Board &b, int p, int mode) {
+        if (p != pin || mode == OUTPUT) return;
+        b.edge(pin, HIGH, b.nowUs);                  // Pull-up takes the line
+        if (hostLow && b.nowUs - lowSinceUs >= 800) respond(b);
+        hostLow = false;
+    }
+
+    void respond(Board &b) {
+        Climate &c = world().climate;
+        if (!c.dhtConnected) return;
+        uint16_t h = (uint16_t)lround(c.hum * 10), t = (uint16_t)lround(fabs(c.temp) * 10);
+        if (c.temp < 0) t |= 0x8000;
+        uint8_t d[5] = { (uint8_t)(h >> 8), (uint8_t)h, (uint8_t)(t >> 8), (uint8_t)t, 0 };
+        d[4] = d[0] + d[1] + d[2] + d[3];
+        std::uniform_real_distribution<double> u(0, 1);
+        if (u(world().rng) < c.dhtErrorRate) { d[world().rng() % 4] ^= 1 << (world().rng() % 8); corrupted++; }
+        frames++;
+
+        std::uniform_int_distribution<int> jitter(-3, 3);
+        pending.clear(); next = 0;
+        uint64_t at = b.nowUs + 30;
+        auto push = [&](int level, int us) { pending.push_back({at, level}); at += us + jitter(world().rng); };
+        push(LOW, 80); push(HIGH, 80);
+        for (int i = 0; i < 40; i++) {
+            push(LOW, 50);
+            push(HIGH, (d[i / 8] >> (7 - i % 8)) & 1 ? 70 : 27);
+        }
+        push(LOW, 50); push(HIGH, 0);                // Frame end, then idle high
+    }
+
+    void step(Board &b) {
+        while (next < pending.size() && pending[next].first <= b.nowUs) {
+            b.edge(pin, pending[next].second, pending[next].first);
+            next++;
+        }
+    }
+};
+
+inline Dht22Model& dht22() {
+    static Dht22Model m(PIN_DHT);
+    return m;
+}
+
+inline void attachDht(Board &b) {
+    b.writeHooks.push_back([&b](int pin, int level) { dht22().onWrite(b, pin, level); });
+    b.modeHooks.push_back([&b](int pin, int mode) { dht22().onMode(b, pin, mode); });
+    b.steppers.push_back([&b](double) { dht22().step(b); });
+}
+
+// Create the soil zones and wire them to the board for ZONE_LAYOUT
+inline void attachZones(Board &b, SoilModel &w) {
+#if ZONE_LAYOUT == ZONE_LAYOUT_MUX
+    for (int i = 0; i < MAX_PLANTS; i++) w.addZone(-1, -1);
+    w.attach(b);
+    static MuxBankModel mux(PINS_MUX_SELECT, PINS_MUX_COMMON, MUX_COUNT);
+    static ShiftChainModel chain(PIN_SR_DATA, PIN_SR_CLOCK, PIN_SR_LATCH, SR_CHIPS);
+    b.adcSource = [&b, &w](int pin, int mode) {
+        int zone = mux.zoneOf(b, pin);
+        return zone >= 0 ? w.readZone(zone, mode) : w.readAdc(pin, mode);
+    };
+    chain.onOutput = [&w](int bit, bool on) { w.setPump(bit, on); };
+    b.writeHooks.push_back([&b](int pin, int level) { chain.onWrite(b, pin, level); });
+#elif ZONE_LAYOUT == ZONE_LAYOUT_I2C
+    for (int i = 0; i < MAX_PLANTS; i++) w.addZone(-1, -1);
+    w.attach(b);
+    static Ads1115Model ads[ADS_COUNT];
+    static Mcp23017Model mcp;
+    for (int a = 0; a < ADS_COUNT; a++) {
+        // Open inputs are held at 0 V by the board's pull-down resistors
+        ads[a].source = [&w, a](int ch) {
+            size_t zone = a * 4 + ch;
+            if (zone < w.zones.size() && !w.zones[zone].connected) return 0;
+            return w.readZone(zone, INPUT);
+        };
+        i2cBus()[ADS_ADDR[a]] = &ads[a];
+    }
+    mcp.onOutput = [&w](int pin, bool on) { w.setPump(pin, on); };
+    i2cBus()[MCP_ADDR] = &mcp;
+#else
+    for (int i = 0; i < MAX_PLANTS; i++) w.addZone(PINS_SENSOR[i], PINS_PUMP[i]);
+    w.attach(b);
+#endif
+}
+
+} // namespace sim
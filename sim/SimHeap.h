@@ -0,0 +1,84 @@
+#pragma once
+// ==========================================================
+// SimHeap - Heap accounting for the host builds
+// Replaces the allocator entry points (malloc family and the
+// global operator new) with counting wrappers around glibc's
+// own functions: live and peak bytes (usable size) and the
+// number of allocations. operator new also feeds the per-task
+// allocation count in Board::stats.
+//
+// Defines the functions, so exactly one translation unit per
+// binary includes it (sim_main.cpp, bench_main.cpp). The sim
+// is single-threaded; the counters are plain integers.
+// ==========================================================
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include "SimBoard.h"
+
+namespace sim {
+struct HeapStats {
+    int64_t live = 0;        // Bytes allocated now
+    int64_t peak = 0;        // High-water mark of live (reset by measurements)
+    uint64_t allocs = 0;     // Allocations of any kind
+};
+inline HeapStats heapStats;
+
+inline HeapStats& heap() { return heapStats; }
+
+// Peak measurement from here on: returns the baseline for peakSince()
+inline int64_t heapMark() { heapStats.peak = heapStats.live; return heapStats.live; }
+inline int64_t peakSince(int64_t mark) { return heapStats.peak - mark; }
+}
+
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void __libc_free(void*);
+}
+
+static void* heapAdd(void *p) {
+    if (!p) return p;
+    sim::HeapStats &h = sim::heapStats;
+    h.allocs++;
+    if ((h.live += malloc_usable_size(p)) > h.peak) h.peak = h.live;
+    return p;
+}
+static void heapSub(void *p) { if (p) sim::heapStats.live -= malloc_usable_size(p); }
+
+extern "C" {
+void* malloc(size_t n) noexcept { return heapAdd(__libc_malloc(n)); }
+void* calloc(size_t n, size_t size) noexcept { return heapAdd(__libc_calloc(n, size)); }
+void free(void *p) noexcept { heapSub(p); __libc_free(p); }
+void* realloc(void *p, size_t n) noexcept {
+    heapSub(p);
+    void *q = __libc_realloc(p, n);
+    if (!q && n) { heapAdd(p); return nullptr; }   // Failed: p is still live
+    return heapAdd(q);
+}
+void* memalign(size_t align, size_t n) noexcept { return heapAdd(__libc_memalign(align, n)); }
+void* aligned_alloc(size_t align, size_t n) noexcept { return memalign(align, n); }
+int posix_memalign(void **out, size_t align, size_t n) noexcept {
+    void *p = memalign(align, n);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+}
+
+// Count heap allocations (the control task should make none)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void* operator new(size_t n) {
+    sim::board().stats.heapAllocs++;
+    if (void *p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
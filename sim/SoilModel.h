@@ -0,0 +1,195 @@
+#pragma once
+#include <cmath>
+#include <random>
+#include <vector>
+#include "SimBoard.h"
+
+// ==========================================================
+// Rosemary Core - Soil / Climate Model (Host Simulation)
+// Bucket model per zone: evapotranspiration dries the pot,
+// pumps fill a surface store that infiltrates with a lag.
+// ==========================================================
+
+namespace sim {
+
+// Pin modes as seen by the board (mirror of hal/Arduino.h)
+#define SIM_MODE_PULLUP     0x05
+#define SIM_MODE_PULLDOWN   0x09
+
+struct ZoneStats {
+    unsigned long pumpStarts = 0;
+    double pumpOnSec = 0;
+    double minPct = 100, maxPct = 0;
+    double secBelowThreshold = 0;
+};
+
+// Probe faults the presence test cannot see (--sensor-fault)
+enum SensorFault { FAULT_NONE, FAULT_STUCK, FAULT_NOISY, FAULT_STEP };
+
+struct SoilZone {
+    int adcPin = -1;
+    int pumpPin = -1;
+    bool connected = true;     // false = broken wire / floating pin
+
+    // State (volumetric water content, m3/m3)
+    double theta = 0.30;
+    double pond = 0;           // applied water not yet in the root zone
+    bool pumpOn = false;
+
+    // Soil constants
+    double thetaSat = 0.45;
+    double fieldCap = 0.36;
+    double wiltPoint = 0.08;
+    double etPerHour = 0.004;  // loss at 1 kPa VPD with a wet pot
+    double pumpFlow = 0.012;   // theta per second of pumping
+    double infiltTau = 20.0;   // seconds
+
+    // Sensor (capacitive, raw drops as soil gets wetter)
+    int rawAir = 4095;
+    int rawWater = 1500;
+    int fault = FAULT_NONE;
+    double faultAtSec = 0;
+    int stuckRaw = 3600;       // FAULT_STUCK: latched ADC, reads dry
+    int stepRaw = 700;         // FAULT_STEP: offset after a knock / water in the probe
+    double faultNoise = 400;   // FAULT_NOISY: extra sigma (corroded contact)
+
+    ZoneStats stats;
+
+    double percent() const { return theta / thetaSat * 100.0; }
+};
+
+struct Climate {
+    double temp = 26.0;
+    double hum = 65.0;
+    double vpd = 1.2;
+    bool dhtConnected = true;
+    double dhtErrorRate = 0;    // Fraction of frames with one bit flipped
+};
+
+class SoilModel {
+public:
+    std::vector<SoilZone> zones;
+    Climate climate;
+    double baseNoise = 8.0;     // ADC counts (1 sigma)
+    double pumpNoise = 120.0;   // extra sigma while any pump runs
+    double thresholdPct = 40.0; // for time-below-threshold stats
+    double elapsedSec = 0;
+    double maxStepSec = 1.0;    // physics is integrated in chunks of at most this
+    double pendingSec = 0;
+
+    std::mt19937 rng{42};
+
+    SoilZone& addZone(int adcPin, int pumpPin) {
+        SoilZone z; z.adcPin = adcPin; z.pumpPin = pumpPin;
+        zones.push_back(z);
+        return zones.back();
+    }
+
+    // Hook the model into the board clock / GPIO / ADC
+    void attach(Board &b) {
+        b.steppers.push_back([this](double dt) { pendingSec += dt; if (pendingSec >= maxStepSec) flush(); });
+        b.writeHooks.push_back([this](int pin, int level) { onWrite(pin, level); });
+        b.adcSource = [this](int pin, int mode) { return readAdc(pin, mode); };
+    }
+
+    bool anyPumpOn() const {
+        for (auto &z : zones) if (z.pumpOn) return true;
+        return false;
+    }
+
+    int pumpsOn() const {
+        int n = 0;
+        for (auto &z : zones) if (z.pumpOn) n++;
+        return n;
+    }
+
+    // Integrate any clock time not yet applied to the zones
+    void flush() {
+        if (pendingSec <= 0) return;
+        double dt = pendingSec; pendingSec = 0;
+        step(dt);
+    }
+
+    void onWrite(int pin, int level) {
+        for (size_t i = 0; i < zones.size(); i++) if (zones[i].pumpPin == pin) setPump(i, level != 0);
+    }
+
+    // Pump driven through an external output (shift register, expander)
+    void setPump(size_t idx, bool on) {
+        if (idx >= zones.size()) return;
+        SoilZone &z = zones[idx];
+        if (on == z.pumpOn) return;
+        flush();
+        if (on) z.stats.pumpStarts++;
+        z.pumpOn = on;
+    }
+
+    void step(double dt) {
+        elapsedSec += dt;
+        updateClimate();
+        for (auto &z : zones) {
+            // Pump -> surface store -> root zone
+            if (z.pumpOn) { z.pond += z.pumpFlow * dt; z.stats.pumpOnSec += dt; }
+            double inf = z.pond * (1.0 - exp(-dt / z.infiltTau));
+            z.pond -= inf; z.theta += inf;
+
+            // Evapotranspiration, scaled by VPD and available water
+            double avail = (z.theta - z.wiltPoint) / (z.fieldCap - z.wiltPoint);
+            if (avail > 0) z.theta -= z.etPerHour * climate.vpd * std::min(avail, 1.0) * dt / 3600.0;
+
+            // Drainage above field capacity
+            if (z.theta > z.fieldCap) z.theta -= (z.theta - z.fieldCap) * (1.0 - exp(-dt / 1800.0));
+            if (z.theta > z.thetaSat) z.theta = z.thetaSat;
+            if (z.theta < 0.02) z.theta = 0.02;
+
+            double pct = z.percent();
+            if (pct < z.stats.minPct) z.stats.minPct = pct;
+            if (pct > z.stats.maxPct) z.stats.maxPct = pct;
+            if (pct < thresholdPct) z.stats.secBelowThreshold += dt;
+        }
+    }
+
+    // Diurnal cycle: warm dry afternoons, cool humid nights
+    void updateClimate() {
+        double hour = fmod(elapsedSec / 3600.0 + 6.0, 24.0);  // sim starts at 06:00
+        double phase = sin(2.0 * M_PI * (hour - 9.0) / 24.0);
+        climate.temp = 26.0 + 6.0 * phase;
+        climate.hum = 65.0 - 15.0 * phase;
+        double svp = 0.61078 * exp((17.27 * climate.temp) / (climate.temp + 237.3));
+        climate.vpd = svp * (1.0 - climate.hum / 100.0);
+    }
+
+    int readAdc(int pin, int mode) {
+        for (size_t i = 0; i < zones.size(); i++) if (zones[i].adcPin == pin) return readZone(i, mode);
+        return floating(mode);
+    }
+
+    // Sensor output of one zone (also used by mux / I2C ADC models)
+    int readZone(size_t idx, int mode) {
+        if (idx >= zones.size()) return floating(mode);
+        const SoilZone &z = zones[idx];
+        if (!z.connected) return floating(mode);
+        bool faulty = z.fault != FAULT_NONE && elapsedSec >= z.faultAtSec;
+        if (faulty && z.fault == FAULT_STUCK) return z.stuckRaw;
+        double raw = z.rawAir - (z.theta / z.thetaSat) * (z.rawAir - z.rawWater);
+        std::normal_distribution<double> n(0.0, baseNoise + (anyPumpOn() ? pumpNoise : 0.0) + (faulty && z.fault == FAULT_NOISY ? z.faultNoise : 0.0));
+        raw += n(rng);
+        if (faulty && z.fault == FAULT_STEP) raw += z.stepRaw;
+        return (int)std::max(0.0, std::min(4095.0, raw));
+    }
+
+private:
+    int floating(int mode) {
+        if (mode == SIM_MODE_PULLUP) return 4095;
+        if (mode == SIM_MODE_PULLDOWN) return 0;
+        std::uniform_int_distribution<int> u(0, 4095);
+        return u(rng);
+    }
+};
+
+inline SoilModel& world() {
+    static SoilModel w;
+    return w;
+}
+
+} // namespace sim
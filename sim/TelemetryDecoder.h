@@ -0,0 +1,290 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../src/Core/Telemetry.h"
+
+// ==========================================================
+// Rosemary Core - Telemetry Decoder (Host Side)
+// Reference decoder for /api/data.cbor and the MQTT batch
+// frames, as a fleet collector would run it: generic CBOR ->
+// item tree -> typed frame. Unknown keys are skipped, per the
+// schema rules.
+// ==========================================================
+
+namespace sim {
+
+struct CborItem {
+    enum Type { Invalid, Uint, Neg, Bytes, Text, Array, Map, Bool, Null, Float } type = Invalid;
+    int64_t i = 0;
+    double f = 0;
+    bool b = false;
+    std::string s;
+    std::vector<CborItem> items;    // Array items, or map key/value pairs flattened
+
+    const CborItem* find(int64_t key) const {
+        if (type != Map) return nullptr;
+        for (size_t k = 0; k + 1 < items.size(); k += 2) {
+            if (items[k].type == Uint && items[k].i == key) return &items[k + 1];
+        }
+        return nullptr;
+    }
+    int64_t asInt(int64_t def = 0) const { return (type == Uint || type == Neg) ? i : def; }
+    double asFloat(double def = 0) const { return type == Float ? f : (type == Uint || type == Neg) ? (double)i : def; }
+    bool asBool(bool def = false) const { return type == Bool ? b : def; }
+};
+
+class CborReader {
+private:
+    const uint8_t *p, *end;
+
+public:
+    CborReader(const uint8_t *data, size_t len) : p(data), end(data + len) {}
+
+    bool read(CborItem &out, int depth = 0) {
+        if (p >= end || depth > 16) return false;
+        uint8_t ib = *p++;
+        uint8_t major = ib >> 5, info = ib & 0x1F;
+
+        if (major == 7) {
+            if (info == 20 || info == 21) { out.type = CborItem::Bool; out.b = info == 21; return true; }
+            if (info == 22 || info == 23) { out.type = CborItem::Null; return true; }
+            if (info == 25) {
+                uint64_t h; if (!arg(2, h)) return false;
+                out.type = CborItem::Float; out.f = half((uint16_t)h); return true;
+            }
+            if (info == 26) {
+                uint64_t v; if (!arg(4, v)) return false;
+                uint32_t bits = (uint32_t)v; float f; memcpy(&f, &bits, 4);
+                out.type = CborItem::Float; out.f = f; return true;
+            }
+            if (info == 27) {
+                uint64_t v; if (!arg(8, v)) return false;
+                double d; memcpy(&d, &v, 8);
+                out.type = CborItem::Float; out.f = d; return true;
+            }
+            return false;
+        }
+
+        if (major == 4 && info == 31) {
+            out.type = CborItem::Array;
+            while (p < end && *p != 0xFF) {
+                out.items.emplace_back();
+                if (!read(out.items.back(), depth + 1)) return false;
+            }
+            if (p >= end) return false;
+            p++;
+            return true;
+        }
+
+        uint64_t v;
+        if (info < 24) v = info;
+        else if (info == 24) { if (!arg(1, v)) return false; }
+        else if (info == 25) { if (!arg(2, v)) return false; }
+        else if (info == 26) { if (!arg(4, v)) return false; }
+        else if (info == 27) { if (!arg(8, v)) return false; }
+        else return false;   // Indefinite lengths are never sent
+
+        switch (major) {
+        case 0: out.type = CborItem::Uint; out.i = (int64_t)v; return true;
+        case 1: out.type = CborItem::Neg; out.i = -1 - (int64_t)v; return true;
+        case 2: case 3:
+            if ((uint64_t)(end - p) < v) return false;
+            out.type = major == 2 ? CborItem::Bytes : CborItem::Text;
+            out.s.assign((const char*)p, (size_t)v); p += v;
+            return true;
+        case 4: case 5: {
+            out.type = major == 4 ? CborItem::Array : CborItem::Map;
+            uint64_t n = major == 5 ? v * 2 : v;
+            if (n > (uint64_t)(end - p)) return false;
+            out.items.resize((size_t)n);
+            for (auto &it : out.items) if (!read(it, depth + 1)) return false;
+            return true;
+        }
+        case 6: return read(out, depth + 1);   // Tag: keep the content
+        }
+        return false;
+    }
+
+    bool atEnd() const { return p == end; }
+
+private:
+    bool arg(int n, uint64_t &v) {
+        if (end - p < n) return false;
+        v = 0;
+        for (int k = 0; k < n; k++) v = (v << 8) | *p++;
+        return true;
+    }
+
+    static double half(uint16_t h) {
+        int e = (h >> 10) & 0x1F, m = h & 0x3FF;
+        double v = e == 0 ? ldexp(m, -24) : e == 31 ? (m ? NAN : INFINITY) : ldexp(m + 1024, e - 25);
+        return (h & 0x8000) ? -v : v;
+    }
+};
+
+struct TelemetryPlant {
+    int id = 0, type = 0, threshold = 0, moisture = 0, noise = 0, sensor = 0;
+    int zone = -1, duration = 0, waterGain = 0, soakMs = 0, health = 0, anomaly = 0;
+    bool error = false, watering = false;
+    std::string name;
+};
+
+struct TelemetryFrame {
+    unsigned schema = 0, version = 0, uptime = 0, pumpLateMs = 0;
+    bool wifi = false, dnd = false;
+    std::string ssid, ip;
+    float temp = 0, hum = 0, vpd = 0;
+    std::vector<TelemetryPlant> plants;
+};
+
+inline bool decodeTelemetry(const uint8_t *data, size_t len, TelemetryFrame &f) {
+    CborReader r(data, len);
+    CborItem root;
+    if (!r.read(root) || !r.atEnd() || root.type != CborItem::Map) return false;
+
+    const CborItem *schema = root.find(TK_SCHEMA);
+    if (!schema || schema->asInt() != TELEMETRY_SCHEMA) return false;
+    f.schema = (unsigned)schema->asInt();
+
+    auto num = [](const CborItem *m, int key, int64_t def = 0) { const CborItem *v = m->find(key); return v ? v->asInt(def) : def; };
+    auto flag = [](const CborItem *m, int key) { const CborItem *v = m->find(key); return v && v->asBool(); };
+    auto text = [](const CborItem *m, int key) { const CborItem *v = m->find(key); return v && v->type == CborItem::Text ? v->s : std::string(); };
+
+    f.version = (unsigned)num(&root, TK_VERSION);
+    f.uptime = (unsigned)num(&root, TK_UPTIME);
+    f.wifi = flag(&root, TK_WIFI);
+    f.ssid = text(&root, TK_SSID);
+    f.ip = text(&root, TK_IP);
+    f.dnd = flag(&root, TK_DND);
+    f.pumpLateMs = (unsigned)num(&root, TK_PUMP_LATE_MS);
+
+    if (const CborItem *env = root.find(TK_ENV)) {
+        if (const CborItem *v = env->find(TE_TEMP)) f.temp = (float)v->asFloat();
+        if (const CborItem *v = env->find(TE_HUM)) f.hum = (float)v->asFloat();
+        if (const CborItem *v = env->find(TE_VPD)) f.vpd = (float)v->asFloat();
+    }
+
+    f.plants.clear();
+    const CborItem *plants = root.find(TK_PLANTS);
+    if (!plants || plants->type != CborItem::Array) return false;
+    for (const CborItem &m : plants->items) {
+        if (m.type != CborItem::Map) return false;
+        TelemetryPlant p;
+        p.id = (int)num(&m, TP_ID);
+        p.name = text(&m, TP_NAME);
+        p.type = (int)num(&m, TP_TYPE);
+        p.threshold = (int)num(&m, TP_THRESHOLD);
+        p.moisture = (int)num(&m, TP_MOISTURE);
+        p.noise = (int)num(&m, TP_NOISE);
+        p.sensor = (int)num(&m, TP_SENSOR);
+        p.error = flag(&m, TP_ERROR);
+        p.zone = (int)num(&m, TP_ZONE, -1);
+        p.duration = (int)num(&m, TP_DURATION);
+        p.watering = flag(&m, TP_WATERING);
+        p.waterGain = (int)num(&m, TP_WATER_GAIN);
+        p.soakMs = (int)num(&m, TP_SOAK_MS);
+        p.health = (int)num(&m, TP_HEALTH);
+        p.anomaly = (int)num(&m, TP_ANOMALY);
+        f.plants.push_back(p);
+    }
+    return true;
+}
+
+// --- MQTT batch frames ---
+
+struct TelemetrySample {
+    uint64_t t = 0;              // Uptime ms
+    bool env = false;
+    float temp = 0, hum = 0;
+    std::vector<int> moisture;   // -1 = no reading
+};
+
+struct TelemetryEvent {
+    uint64_t t = 0;
+    int zone = -1, event = 0, value = 0;
+};
+
+struct TelemetryBatch {
+    std::string node;
+    uint32_t boot = 0, seq = 0, clock = 0;
+    uint64_t t = 0;
+    int zones = 0;
+    std::vector<TelemetrySample> samples;
+    std::vector<TelemetryEvent> events;
+};
+
+// Undoes the per-frame delta coding
+inline bool decodeBatch(const uint8_t *data, size_t len, TelemetryBatch &b) {
+    CborReader r(data, len);
+    CborItem root;
+    if (!r.read(root) || !r.atEnd() || root.type != CborItem::Map) return false;
+    const CborItem *schema = root.find(FK_SCHEMA);
+    const CborItem *recs = root.find(FK_RECORDS);
+    if (!schema || schema->asInt() != TELEMETRY_SCHEMA || !recs || recs->type != CborItem::Array) return false;
+
+    auto num = [&root](int key) { const CborItem *v = root.find(key); return v ? v->asInt() : 0; };
+    const CborItem *node = root.find(FK_NODE);
+    b.node = node && node->type == CborItem::Text ? node->s : std::string();
+    b.boot = (uint32_t)num(FK_BOOT); b.seq = (uint32_t)num(FK_SEQ);
+    b.t = (uint64_t)num(FK_T); b.clock = (uint32_t)num(FK_CLOCK);
+    b.zones = (int)num(FK_ZONES);
+    b.samples.clear(); b.events.clear();
+
+    uint64_t t = b.t;
+    int64_t temp = 0, hum = 0;
+    std::vector<int64_t> m(b.zones, 0);
+    for (const CborItem &rec : recs->items) {
+        if (rec.type != CborItem::Array || rec.items.size() < 2) return false;
+        t += (uint64_t)rec.items[1].asInt();
+        int kind = (int)rec.items[0].asInt(-1);
+        if (kind == REC_SAMPLE) {
+            if (rec.items.size() < 4 + (size_t)b.zones) return false;
+            TelemetrySample s;
+            s.t = t;
+            s.env = rec.items[2].type != CborItem::Null;
+            if (s.env) {
+                temp += rec.items[2].asInt(); hum += rec.items[3].asInt();
+                s.temp = temp / 10.0f; s.hum = hum / 10.0f;
+            }
+            for (int z = 0; z < b.zones; z++) { m[z] += rec.items[4 + z].asInt(); s.moisture.push_back((int)m[z]); }
+            b.samples.push_back(s);
+        } else if (kind == REC_EVENT) {
+            if (rec.items.size() < 5) return false;
+            TelemetryEvent e;
+            e.t = t;
+            e.zone = (int)rec.items[2].asInt(); e.event = (int)rec.items[3].asInt(); e.value = (int)rec.items[4].asInt();
+            b.events.push_back(e);
+        }   // Unknown record kinds are skipped
+    }
+    return true;
+}
+
+// Human-readable dump (RFC 8949 diagnostic notation)
+inline void cborDiagnostic(const CborItem &it, std::string &out) {
+    char num[32];
+    switch (it.type) {
+    case CborItem::Uint: case CborItem::Neg: snprintf(num, sizeof(num), "%lld", (long long)it.i); out += num; break;
+    case CborItem::Float: snprintf(num, sizeof(num), "%g", it.f); out += num; break;
+    case CborItem::Bool: out += it.b ? "true" : "false"; break;
+    case CborItem::Null: out += "null"; break;
+    case CborItem::Text: out += '"'; out += it.s; out += '"'; break;
+    case CborItem::Bytes: snprintf(num, sizeof(num), "h'<%zu bytes>'", it.s.size()); out += num; break;
+    case CborItem::Array: case CborItem::Map: {
+        bool map = it.type == CborItem::Map;
+        out += map ? '{' : '[';
+        for (size_t k = 0; k < it.items.size(); k++) {
+            if (k) out += (map && k % 2) ? ": " : ", ";
+            cborDiagnostic(it.items[k], out);
+        }
+        out += map ? '}' : ']';
+        break;
+    }
+    default: out += "?"; break;
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,310 @@
+// ==========================================================
+// Rosemary Core - Host Benchmarks
+// Times the hot paths of the real firmware, built exactly as
+// for the simulation (same HAL, same soil model), with 4, 16
+// and 64 plants where the layout has the zones:
+//
+//   store.save / store.load   plants.json commit and boot load
+//   api.data.json / .cbor     /api/data and /api/data.cbor encoders
+//   api.data.http             a full /api/data request (body drained)
+//   water.request             a manual request for an already queued zone
+//   sensor.value              raw -> % mapping with the zone's calibration
+//   loop                      one loop() pass plus a 10 ms virtual tick
+//
+// Reports ns/op, heap allocations per op and the peak heap above
+// the starting point. Times are the best round, relative to a
+// fixed reference loop timed alongside (the fastest of
+// BENCH_RUNS), then scaled to the baseline's reference speed: a
+// busy or slower host moves both alike. With --baseline the run
+// fails (exit 1) when a case got slower than the tolerance (after
+// four spaced re-measures), allocates more, or needs more heap
+// than the stored numbers. Each layout, plain and TRACE=1, has
+// its own baseline file.
+//
+//   ./rosemary_bench --baseline bench/baseline_direct.txt
+//   ./rosemary_bench --baseline bench/baseline_direct.txt --update
+//   (make bench / make bench-baseline)
+// ==========================================================
+#include <filesystem>
+#include <time.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "hal/Arduino.h"
+#include "hal/ESPAsyncWebServer.h"
+#include "SimBoard.h"
+#include "SimHeap.h"
+#include "SoilModel.h"
+#include "SimDevices.h"
+#include "../src/Config.h"
+#include "../src/Modules/PlantManager.h"
+#include "../src/Modules/UniversalSensor.h"
+#include "../src/Core/Tasks.h"
+#include "../src/Core/Network.h"
+
+#define BENCH_TICK_MS       10
+#define BENCH_ROUNDS        25
+#define BENCH_ROUND_MS      4        // CPU time per timed round: short, so some miss host noise
+#define BENCH_RUNS          5        // Reference-relative measurements per case, the fastest counts
+#define BENCH_SLACK_NS      5        // Gate: jitter of ns-scale cases is not a regression
+#define BENCH_RETRIES       4        // Re-measures of a case over the time limit
+#define BENCH_RETRY_PAUSE_MS 250     // Before the first, doubling: a burst of host load passes
+
+void setup();
+void loop();
+extern PlantManager plantManager;
+extern NetworkManager network;
+extern UniversalSensor sensors[MAX_PLANTS];
+
+#if ZONE_LAYOUT == ZONE_LAYOUT_MUX
+static const char *LAYOUT_NAME = "mux";
+#elif ZONE_LAYOUT == ZONE_LAYOUT_I2C
+static const char *LAYOUT_NAME = "i2c";
+#else
+static const char *LAYOUT_NAME = "direct";
+#endif
+
+struct BenchResult {
+    double nsPerOp = 0;
+    double allocsPerOp = 0;
+    int64_t peakBytes = 0;
+};
+
+struct BenchOptions {
+    const char *baseline = nullptr;
+    bool update = false;
+    double tolerance = 0.15;     // Allowed ns/op growth (host timing noise)
+    const char *filter = nullptr;
+    std::string fsRoot;          // Default: RAM-backed when the host has /dev/shm
+};
+
+static void usage() {
+    printf("rosemary_bench [--baseline FILE [--update]] [--tolerance 0.15] [--filter NAME] [--fs DIR]\n");
+}
+
+static bool parseArgs(int argc, char **argv, BenchOptions &opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto val = [&](void) -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        if (a == "--baseline") { if (!(opt.baseline = val())) return false; }
+        else if (a == "--update") opt.update = true;
+        else if (a == "--tolerance") { const char *v = val(); if (!v) return false; opt.tolerance = atof(v); }
+        else if (a == "--filter") { if (!(opt.filter = val())) return false; }
+        else if (a == "--fs") { const char *v = val(); if (!v) return false; opt.fsRoot = v; }
+        else { usage(); return false; }
+    }
+    if (opt.update && !opt.baseline) { usage(); return false; }
+    return true;
+}
+
+// This thread's CPU time: other load on the host does not count
+static double cpuNs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Rounds of op(i) calls, the best round counts. ops = 0: sized to
+// BENCH_ROUND_MS by an untimed warm-up; stateful cases (loop, which
+// moves virtual time) pass a fixed count so every run covers the
+// same work. The warm-up keeps first-use allocations out either way.
+template<typename Op>
+static BenchResult measure(Op op, int ops) {
+    if (ops) op(0);
+    else for (ops = 1; ; ops *= 2) {
+        double t0 = cpuNs();
+        for (int i = 0; i < ops; i++) op(i);
+        if (cpuNs() - t0 >= BENCH_ROUND_MS * 1e6 / 2 || ops >= (1 << 24)) break;
+    }
+    BenchResult r;
+    r.nsPerOp = 1e30;
+    uint64_t allocs = sim::heap().allocs;
+    int64_t mark = sim::heapMark();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        double t0 = cpuNs();
+        for (int i = 0; i < ops; i++) op(i);
+        r.nsPerOp = std::min(r.nsPerOp, (cpuNs() - t0) / ops);
+    }
+    r.allocsPerOp = (double)(sim::heap().allocs - allocs) / ((double)ops * BENCH_ROUNDS);
+    r.peakBytes = sim::peakSince(mark);
+    return r;
+}
+
+static volatile uint32_t referenceSink;    // Keeps the reference loop from being optimised out
+
+// Fixed integer work timed next to every case: on a shared or
+// frequency-scaled host, the gate compares ns/op relative to it
+static double referenceNs() {
+    return measure([](int i){
+        uint32_t x = (uint32_t)i | 1;
+        for (int k = 0; k < 256; k++) { x ^= x << 13; x ^= x >> 17; x ^= x << 5; }
+        referenceSink = x;
+    }, 2000).nsPerOp;
+}
+
+// Exactly n plants, one per zone from 0, with long names (worst-case encodes)
+static void setPlants(int n) {
+    std::vector<int> ids;
+    for (auto &p : plantManager.getPlants()) ids.push_back(p.id);
+    for (int id : ids) plantManager.deletePlant(id);
+    for (int i = 0; i < n; i++) {
+        char name[PLANT_NAME_LEN + 12];     // Room for any %02d; addPlant() keeps PLANT_NAME_LEN
+        snprintf(name, sizeof(name), "Zone %02d - Rosmarinus officinalis \"Tuscan Blue\"", i);
+        plantManager.addPlant(name, i % 2 ? "dry" : "general", 40);
+    }
+    plantManager.flush();
+}
+
+// name -> result, in file order
+typedef std::vector<std::pair<std::string, BenchResult>> BenchTable;
+
+static bool loadBaseline(const char *path, std::map<std::string, BenchResult> &out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        BenchResult r;
+        if (fields >> name >> r.nsPerOp >> r.allocsPerOp >> r.peakBytes) out[name] = r;
+    }
+    return true;
+}
+
+static bool saveBaseline(const char *path, double refNs, const BenchTable &results) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# rosemary_bench baseline, layout %s (make bench-baseline)\n", LAYOUT_NAME);
+    fprintf(f, "# ns/op are scaled to the reference loop's speed (its own line), so the\n");
+    fprintf(f, "# numbers carry across hosts; regenerate after an intended change.\n");
+    fprintf(f, "# name ns/op allocs/op peak-bytes\n");
+    fprintf(f, "reference %.1f 0 0\n", refNs);
+    for (auto &e : results) fprintf(f, "%s %.1f %.3f %lld\n", e.first.c_str(), e.second.nsPerOp, e.second.allocsPerOp, (long long)e.second.peakBytes);
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+
+    // A fresh filesystem and a fixed seed: every run starts alike. The
+    // store cases time the firmware's work, not the host disk: tmpfs.
+    sim::Board &board = sim::board();
+    sim::SoilModel &world = sim::world();
+    std::error_code ec;
+    if (opt.fsRoot.empty()) opt.fsRoot = std::filesystem::is_directory("/dev/shm", ec) ? "/dev/shm/rosemary_bench_fs" : "bench_fs";
+    board.fsRoot = opt.fsRoot;
+    board.quiet = true;
+    std::filesystem::remove_all(board.fsRoot, ec);
+    world.rng.seed(42);
+    randomSeed(42);
+    sim::attachZones(board, world);
+    sim::attachDht(board);
+    for (size_t i = 0; i < world.zones.size(); i++) world.zones[i].theta = 0.22 + 0.03 * (i % 4);
+
+    std::map<std::string, BenchResult> base;
+    bool haveBase = opt.baseline && !opt.update && loadBaseline(opt.baseline, base);
+    if (opt.baseline && !opt.update && !haveBase) printf("No baseline at %s (make bench-baseline)\n", opt.baseline);
+
+    // ns/op below are scaled to this reference speed: the baseline's
+    // when there is one, so a slower or busier host does not fail the gate
+    double refBase = 0;
+    if (base.count("reference")) refBase = base["reference"].nsPerOp;
+    if (refBase <= 0) {
+        refBase = 1e30;
+        for (int k = 0; k < BENCH_RUNS; k++) refBase = std::min(refBase, referenceNs());
+    }
+
+    setup();
+    // Probes done, first bursts in, snapshots built
+    for (int t = 0; t < 5000 / BENCH_TICK_MS; t++) { loop(); board.advanceMs(BENCH_TICK_MS); }
+
+    auto tooSlow = [&](const std::string &name, double ns) {
+        auto b = base.find(name);
+        return b != base.end() && ns > b->second.nsPerOp * (1.0 + opt.tolerance) + BENCH_SLACK_NS;
+    };
+
+    BenchTable results;
+    auto run = [&](const std::string &name, auto op, int ops = 0) {
+        if (opt.filter && name.find(opt.filter) == std::string::npos) return;
+        // ns/op in reference units (see referenceNs), the fastest run:
+        // noise only ever adds time. Over the limit: measured again, a
+        // busy neighbour is not a regression.
+        BenchResult r;
+        for (int attempt = 0; attempt <= BENCH_RETRIES; attempt++) {
+            if (attempt) usleep((BENCH_RETRY_PAUSE_MS * 1000) << (attempt - 1));
+            double rel = 1e30;
+            for (int k = 0; k < BENCH_RUNS; k++) {
+                double ref = referenceNs();
+                BenchResult m = measure(op, ops);
+                if (k == 0 && attempt == 0) r = m;
+                rel = std::min(rel, m.nsPerOp / ref);
+            }
+            double ns = rel * refBase;
+            if (attempt == 0 || ns < r.nsPerOp) r.nsPerOp = ns;
+            if (!tooSlow(name, r.nsPerOp)) break;
+        }
+        results.push_back({ name, r });
+    };
+
+    std::vector<uint8_t> out(SNAPSHOT_BUF_SIZE > TELEMETRY_BUF_SIZE ? SNAPSHOT_BUF_SIZE : TELEMETRY_BUF_SIZE);
+    for (int n : { 4, 16, 64 }) {
+        if (n > MAX_PLANTS) break;
+        setPlants(n);
+        for (int t = 0; t < 1000 / BENCH_TICK_MS; t++) { loop(); board.advanceMs(BENCH_TICK_MS); }
+        std::string suffix = "/" + std::to_string(n);
+
+        run("store.save" + suffix, [](int){ plantManager.savePlants(); });
+        run("store.load" + suffix, [](int){ plantManager.loadPlants(); });
+        run("api.data.json" + suffix, [&](int){ network.fillData(out.data(), out.size(), 1); });
+        run("api.data.cbor" + suffix, [&](int){ network.fillTelemetry(out.data(), out.size(), 1); });
+        run("api.data.http" + suffix, [](int){
+            sim::drainBodies() = true;
+            sim::http(HTTP_GET, "/api/data");
+            sim::drainBodies() = false;
+        });
+        run("water.request" + suffix, [n](int i){ plantManager.requestWatering(i % n); });
+        for (int z = 0; z < n; z++) plantManager.getPumps().cancel(z);
+        run("loop" + suffix, [&board](int){ loop(); board.advanceMs(BENCH_TICK_MS); }, 60000 / BENCH_TICK_MS);
+    }
+    run("sensor.value", [](int i){ volatile int v = sensors[i % MAX_PLANTS].getValue(); (void)v; });
+    std::filesystem::remove_all(board.fsRoot, ec);
+
+    printf("=== Rosemary Core Benchmarks (%s, %d zones) ===\n", LAYOUT_NAME, MAX_PLANTS);
+    printf("ns/op at reference speed %.1f ns (this host now: %.1f ns)\n", refBase, referenceNs());
+    printf("%-22s %12s %10s %10s %12s %8s\n", "case", "ns/op", "allocs/op", "peak B", "base ns/op", "delta");
+    int regressions = 0;
+    for (auto &e : results) {
+        const BenchResult &r = e.second;
+        printf("%-22s %12.1f %10.2f %10lld", e.first.c_str(), r.nsPerOp, r.allocsPerOp, (long long)r.peakBytes);
+        auto b = base.find(e.first);
+        if (b == base.end()) { printf(haveBase ? " %12s %8s  new\n" : "\n", "-", "-"); continue; }
+        const BenchResult &o = b->second;
+        double delta = o.nsPerOp > 0 ? (r.nsPerOp / o.nsPerOp - 1.0) : 0;
+        std::string why;
+        if (tooSlow(e.first, r.nsPerOp)) why += " slower";
+        if (r.allocsPerOp > o.allocsPerOp + 0.01) why += " allocs";
+        if (r.peakBytes > o.peakBytes + o.peakBytes / 10 + 64) why += " heap";
+        if (!why.empty()) regressions++;
+        printf(" %12.1f %+7.1f%%  %s\n", o.nsPerOp, 100.0 * delta, why.empty() ? "ok" : ("REGRESSED:" + why).c_str());
+    }
+
+    if (opt.update) {
+        if (!saveBaseline(opt.baseline, refBase, results)) { fprintf(stderr, "cannot write %s\n", opt.baseline); return 2; }
+        printf("Baseline written: %s (%zu cases)\n", opt.baseline, results.size());
+        return 0;
+    }
+    if (haveBase) {
+        printf("Gate      : %d regression(s), time tolerance %.0f%%\n", regressions, 100.0 * opt.tolerance);
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+// ==========================================================
+// AssetsCheck - Pre-gzipped dashboard (--www)
+// The image lands on the filesystem before boot, as uploadfs
+// leaves it. A browser's first visit must get every asset as
+// gzip with its ETag and size; a reload with the cache warm
+// must get 304s for the mutable ones.
+// ==========================================================
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "SimRun.h"
+
+struct AssetsCheck {
+    // Before setup(); false if the image cannot be copied
+    bool begin(SimRun &run) {
+        if (!run.opt.www) return true;
+        std::error_code ec;
+        std::filesystem::create_directories(run.board.fsRoot, ec);
+        std::filesystem::copy(run.opt.www, run.board.fsRoot, std::filesystem::copy_options::recursive |
+                              std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec) fprintf(stderr, "--www %s: %s\n", run.opt.www, ec.message().c_str());
+        return !ec;
+    }
+
+    void report(SimRun &run) {
+        if (!run.opt.www) return;
+        std::ifstream idx(run.board.fsRoot + "/www/assets.idx");
+        std::string url, file, etag, line;
+        unsigned maxAge;
+        int first = 0, reload = 0, notModified = 0;
+        size_t firstBytes = 0, reloadBytes = 0;
+        std::string error;
+        while (std::getline(idx, line)) {
+            std::istringstream in(line);
+            if (!(in >> url >> file >> etag >> maxAge) || url == "/index.html") continue;
+            SimResponse r = sim::http(HTTP_GET, url.c_str());
+            first++; firstBytes += r.body.size();
+            std::error_code ec;
+            if (r.code != 200 || r.headers["Content-Encoding"] != "gzip" || r.headers["ETag"] != etag ||
+                r.body.size() != std::filesystem::file_size(run.board.fsRoot + file, ec)) error = url + ": bad 200";
+            if (maxAge) continue;   // Immutable: served from the browser cache
+            r = sim::http(HTTP_GET, url.c_str(), "", {{"If-None-Match", etag.c_str()}});
+            reload++; reloadBytes += r.body.size();
+            if (r.code == 304 && r.body.empty() && r.headers["ETag"] == etag) notModified++;
+            else error = url + ": no 304";
+        }
+        if (!first) error = "no assets.idx";
+        printf("Assets    : first load %d requests, %zu B gzip | reload %d requests, %d x 304, %zu B | %s\n",
+               first, firstBytes, reload, notModified, reloadBytes, error.empty() ? "ok" : error.c_str());
+        run.check(error.empty(), "assets: " + error);
+    }
+};
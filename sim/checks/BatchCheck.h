@@ -0,0 +1,93 @@
+#pragma once
+// ==========================================================
+// BatchCheck - /api/batch and the single-plant routes
+// Runs after the zone table, as the batch waters a zone. One
+// request re-tunes every plant, swaps the last one, waters
+// and calibrates, in one plants.json and one NVS commit; a
+// view taken before it (a reader in another task) must still
+// walk the zones it had.
+// Then a batch with one bad op must leave everything as it
+// was, a cut or oversized body must be refused, and the
+// single-plant routes (one-op batches) must report an unknown
+// id. A POST only queues (202 and a number); the result is
+// read back from GET /api/batch once the control task ran.
+// ==========================================================
+#include "SimRun.h"
+
+struct BatchCheck {
+    // Runs the queued batch, then its result (code 0 if another took its place)
+    SimResponse result(SimRun &run, const SimResponse &queued, uint64_t ms = 100) {
+        DynamicJsonDocument q(256);
+        deserializeJson(q, queued.body);
+        run.settle(ms);
+        SimResponse r = sim::http(HTTP_GET, "/api/batch");
+        DynamicJsonDocument doc(256);
+        deserializeJson(doc, r.body);
+        if (queued.code != 202 || (doc["batch"] | 0) != (q["batch"] | -1) || doc["pending"].as<bool>()) r.code = 0;
+        return r;
+    }
+
+    void report(SimRun &run) {
+        PlantTable &table = plantManager.getPlants();
+        std::string error, body = "[";
+        int updates = std::min<int>(table.size(), BATCH_MAX_OPS - 4), last = table[table.size() - 1].id;
+        std::vector<std::pair<int, int>> want;    // id, threshold
+        for (int i = 0; i < updates; i++) {
+            want.push_back({table[i].id, std::min(table[i].threshold + 5, 100)});
+            body += "{\"op\": \"update-config\", \"id\": " + std::to_string(want.back().first) + ", \"threshold\": " + std::to_string(want.back().second) + "},\n";
+        }
+        body += "{\"op\": \"delete\", \"id\": " + std::to_string(last) + "},\n"
+                "{\"op\": \"add\", \"name\": \"Batch \\u0e1e\", \"type\": \"dry\", \"threshold\": 35, \"duration\": 8},\n"
+                "{\"op\": \"water\", \"index\": 0},\n"
+                "{\"op\": \"calibrate\", \"index\": 1, \"dry\": 3800, \"wet\": 1400}]";
+        uint32_t plantCommits = plantManager.getConfigCommits(), nvsCommits = config.getCommits();
+        PlantTable::View before = table.view();
+        std::vector<int> zonesBefore;
+        for (auto &q : before) zonesBefore.push_back(q.originalIndex);
+        SimResponse queued = sim::http(HTTP_POST, "/api/batch", body);
+        SimResponse busy = sim::http(HTTP_POST, "/api/batch", "[{\"op\":\"water\",\"index\":0}]");
+        SimResponse r = result(run, queued, SAVE_DEBOUNCE_MS + 2000);
+        DynamicJsonDocument doc(4096);
+        deserializeJson(doc, r.body);
+        int added = doc["results"][updates + 1]["id"] | 0;
+        const Plant *p = table.byId(added);
+        if (r.code != 200 || !doc["applied"].as<bool>() || (int)doc["results"].size() != updates + 4) error = "reply " + std::to_string(r.code) + " " + r.body.substr(0, 120);
+        else if (busy.code != 503) error = "second batch not refused while the first was queued";
+        else if (table.byId(last) || !p || strcmp(p->name, "Batch \xe0\xb8\x9e") || p->type != TYPE_DRY || p->threshold != 35 || p->duration != 8) error = "add/delete not applied";
+        else if (config.getInt(CFG_SENSOR_DRY, 1) != 3800 || config.getInt(CFG_SENSOR_WET, 1) != 1400) error = "calibration not applied";
+        for (auto &w : want) if (error.empty() && w.first != last && table.byId(w.first)->threshold != w.second) error = "threshold not applied";
+        std::vector<int> zonesAfter;
+        for (auto &q : before) zonesAfter.push_back(q.originalIndex);
+        if (error.empty() && zonesAfter != zonesBefore) error = "a view shifted under a delete";
+        uint32_t batchPlantCommits = plantManager.getConfigCommits() - plantCommits, batchNvsCommits = config.getCommits() - nvsCommits;
+
+        std::string bad = "[{\"op\":\"update-config\",\"id\":" + std::to_string(added) + ",\"threshold\":77},{\"op\":\"delete\",\"id\":1},{\"op\":\"water\",\"index\":0,\"rate\":2}]";
+        SimResponse rb = result(run, sim::http(HTTP_POST, "/api/batch", bad));
+        SimResponse rs = sim::http(HTTP_POST, "/api/batch", "[{\"op\":\"water\",\"index\":0}");
+        std::string many = "[";
+        for (int i = 0; i <= BATCH_MAX_OPS; i++) many += std::string(i ? "," : "") + "{\"op\":\"water\",\"index\":0}";
+        SimResponse rm = sim::http(HTTP_POST, "/api/batch", many + "]");
+        SimResponse ru = result(run, sim::http(HTTP_POST, "/api/update-config", "{\"id\":1,\"threshold\":50}"));
+        SimResponse rd = result(run, sim::http(HTTP_POST, "/api/delete-plant", "{\"id\":1}"));
+        SimResponse rw = sim::http(HTTP_POST, "/api/water", "{\"index\":" + std::to_string(MAX_PLANTS) + "}");
+        // A full table is refused by the control task, else the plant is added
+        bool full = table.size() == MAX_PLANTS;
+        SimResponse ra = result(run, sim::http(HTTP_POST, "/api/add-plant", "{\"name\":\"One\",\"type\":\"wet\",\"threshold\":45}"));
+        DynamicJsonDocument adoc(512);
+        deserializeJson(adoc, ra.body);
+        const Plant *one = table.byId(adoc["results"][0]["id"] | 0);
+        run.settle(SAVE_DEBOUNCE_MS + 2000);
+        p = table.byId(added);
+        if (error.empty() && (rb.code != 200 || rb.body.find("\"applied\":false") == std::string::npos || !p || p->threshold != 35 ||
+                              rb.body.find("no such plant") == std::string::npos || rb.body.find("unknown field") == std::string::npos)) error = "bad batch: " + rb.body;
+        if (error.empty() && (rs.code != 400 || rm.code != 413)) error = "malformed batch accepted";
+        if (error.empty() && (ru.body.find("no such plant") == std::string::npos || rd.body.find("no such plant") == std::string::npos)) error = "unknown id not reported";
+        if (error.empty() && rw.code != 400) error = "water index out of range accepted";
+        if (error.empty() && (full ? ra.body.find("no free zone") == std::string::npos : !one || one->threshold != 45 || one->type != TYPE_WET)) error = "add-plant: " + ra.body;
+        printf("\nBatch     : %d ops, %zu B in %zu chunk(s), streamed -> %u plants.json commit, %u NVS commit | queued %d, busy %d | bad op %s, cut body %d, %d ops %d, unknown id %s, water index %d, add-plant %s | %s\n",
+               updates + 4, body.size(), (body.size() + SIM_BODY_CHUNK - 1) / SIM_BODY_CHUNK, (unsigned)batchPlantCommits, (unsigned)batchNvsCommits,
+               queued.code, busy.code, rb.body.find("\"applied\":false") != std::string::npos ? "refused" : "applied", rs.code, BATCH_MAX_OPS + 1, rm.code,
+               ru.body.find("no such plant") != std::string::npos ? "reported" : "missed", rw.code, one ? "added" : full ? "full" : "missed", error.empty() ? "ok" : error.c_str());
+        run.check(error.empty(), "batch: " + error);
+    }
+};
@@ -0,0 +1,50 @@
+#pragma once
+// ==========================================================
+// ConfigCheck - Settings export/import round trip
+// Legacy NVS namespaces must be migrated away. A clone round
+// trip exports, imports a change (chunked when zones are
+// many), rejects a bad value without applying the rest, then
+// restores the export byte for byte. The change includes a
+// password of 64 control characters, the longest escaped
+// string, which must export whole.
+// ==========================================================
+#include "SimRun.h"
+
+struct ConfigCheck {
+    void report(SimRun &run) {
+        std::string error;
+        bool legacyLeft = false;
+        for (const char *ns : {"wifi", "mqtt", "sys_settings"}) legacyLeft |= !sim::nvs()[ns].empty();
+        if (legacyLeft) error = "legacy keys left";
+        SimResponse full = sim::http(HTTP_GET, "/api/config?secrets=1");
+        SimResponse plain = sim::http(HTTP_GET, "/api/config");
+        if (full.code != 200 || plain.code != 200 || plain.body.find("password") != std::string::npos) error = "bad export";
+        std::string worst(sizeof(ConfigValues::wifiPass) - 1, '\x01'), worstJson;
+        for (size_t i = 0; i < worst.size(); i++) worstJson += "\\u0001";
+        std::string change = "{\"schema\":1,\"values\":{\"wifi.password\":\"" + worstJson + "\",\"buzzer.dnd\":true,\"sensor.dry\":[";
+        for (int z = 0; z < MAX_PLANTS; z++) change += (z ? ",  " : "") + std::to_string(3900 - z);
+        change += "]}}";
+        SimResponse set = sim::http(HTTP_POST, "/api/config", change);
+        SimResponse bad = sim::http(HTTP_POST, "/api/config", "{\"values\":{\"buzzer.dnd\":false,\"mqtt.port\":70000}}");
+        SimResponse worstOut = sim::http(HTTP_GET, "/api/config?secrets=1");
+        DynamicJsonDocument worstDoc(4096);
+        bool worstOk = worstOut.code == 200 && !deserializeJson(worstDoc, worstOut.body.c_str()) && worst == (worstDoc["values"]["wifi.password"] | "");
+        if (set.code != 200 || set.body.find("\"changed\":3") == std::string::npos) error = "import: " + set.body;
+        else if (!worstOk) error = "escaped password not exported whole";
+        else if (bad.code != 400 || !config.getBool(CFG_DND)) error = "bad import applied";
+        else if (config.getInt(CFG_SENSOR_DRY, MAX_PLANTS - 1) != 3900 - (MAX_PLANTS - 1)) error = "zone value lost";
+        uint64_t w0 = run.board.stats.prefsWrites;
+        uint32_t c0 = config.getCommits();
+        config.commit();
+        uint64_t changeWrites = run.board.stats.prefsWrites - w0;
+        SimResponse back = sim::http(HTTP_POST, "/api/config", full.body);
+        config.commit();
+        SimResponse again = sim::http(HTTP_GET, "/api/config?secrets=1");
+        if (error.empty() && (back.code != 200 || again.body != full.body)) error = "restore differs";
+        printf("Config    : schema %u -> %d, legacy %s | export %zu B (%zu B without secrets) | import %s, bad value %d, restore in %zu chunk(s) | %llu NVS keys in %u commit(s) | %s\n",
+               (unsigned)config.getMigratedFrom(), CONFIG_SCHEMA, legacyLeft ? "left" : "cleared", full.body.size(), plain.body.size(),
+               set.body.c_str(), bad.code, (full.body.size() + SIM_BODY_CHUNK - 1) / SIM_BODY_CHUNK,
+               (unsigned long long)changeWrites, (unsigned)(config.getCommits() - c0 - 1), error.empty() ? "ok" : error.c_str());
+        run.check(error.empty(), "config: " + error);
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+// ==========================================================
+// DhtCheck - DHT22 frames and outages
+// Every frame sent must be read as valid, or rejected on its
+// checksum when the model corrupted it (--dht-errors); the
+// last one may still be on the wire when the run ends. An
+// outage longer than DHT_STALE_MS (--dht-outage) must turn
+// env invalid within DHT_STALE_MS, and valid again once the
+// sensor returns.
+// ==========================================================
+#include "SimRun.h"
+
+struct DhtCheck {
+    bool staleSeen = false;
+    uint64_t downMs = 0, upMs = 0, staleAfterMs = 0, backMs = 0;
+
+    // Before each loop() pass
+    void tick(SimRun &run) {
+        sim::Climate &climate = run.world.climate;
+        uint64_t now = run.board.nowMs();
+        if (run.opt.dhtOutageStartH >= 0) {
+            double h = run.hours();
+            bool down = h >= run.opt.dhtOutageStartH && h < run.opt.dhtOutageStartH + run.opt.dhtOutageHours;
+            if (down == climate.dhtConnected) {
+                climate.dhtConnected = !down;
+                if (down) downMs = now; else upMs = now;
+            }
+        }
+        // Env must go invalid within DHT_STALE_MS of the sensor dropping out
+        if (!climate.dhtConnected && !staleSeen && !sensorHub.getEnv().isValid()) {
+            staleSeen = true; staleAfterMs = now - downMs;
+        }
+        if (climate.dhtConnected && upMs && !backMs && sensorHub.getEnv().isValid()) backMs = now - upMs;
+    }
+
+    void report(SimRun &run) {
+        sim::Dht22Model &dht = sim::dht22();
+        printf("DHT22     : %llu frames sent (%llu corrupted) | ok %u, checksum %u, timing %u, timeout %u",
+               (unsigned long long)dht.frames, (unsigned long long)dht.corrupted,
+               (unsigned)sensorHub.getDhtResults(Dht22::OK), (unsigned)sensorHub.getDhtResults(Dht22::CHECKSUM),
+               (unsigned)sensorHub.getDhtResults(Dht22::TIMING), (unsigned)sensorHub.getDhtResults(Dht22::TIMEOUT));
+        if (staleSeen) printf(" | outage: env invalid after %.1f s", staleAfterMs / 1000.0);
+        if (upMs) printf(", valid %.1f s after return", backMs / 1000.0);
+        printf("\n");
+        // A flipped bit always breaks the checksum: none may get through
+        uint64_t read = sensorHub.getDhtResults(Dht22::OK) + sensorHub.getDhtResults(Dht22::CHECKSUM);
+        uint64_t inFlight = dht.frames - std::min(read, dht.frames);
+        run.check(read <= dht.frames && inFlight <= 1 && sensorHub.getDhtResults(Dht22::CHECKSUM) <= dht.corrupted &&
+                  dht.corrupted - sensorHub.getDhtResults(Dht22::CHECKSUM) <= inFlight,
+                  "DHT22 frames lost or a corrupted one accepted");
+        if (downMs && run.opt.dhtOutageHours * 3600000.0 > DHT_STALE_MS) run.check(staleSeen && staleAfterMs <= DHT_STALE_MS, "DHT22 outage: env not invalid within DHT_STALE_MS");
+        if (upMs) run.check(backMs > 0 && backMs <= DHT_STALE_MS, "DHT22 back: env not valid again");
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+// ==========================================================
+// HealthCheck - Sensor health scoring (--sensor-fault)
+// Watches the faulted zone from the moment its probe goes
+// bad: time to the first anomaly flag and pump starts after
+// it. An injected fault must be flagged.
+// ==========================================================
+#include "SimRun.h"
+
+struct HealthCheck {
+    uint64_t faultAtMs = 0, faultSeenMs = 0;
+    unsigned long faultStarts = 0;    // Pump starts when it went bad, plus one
+    bool faultSeen = false;
+
+    void begin(SimRun &run) { faultAtMs = (uint64_t)(run.opt.faultStartH * 3600000.0); }
+
+    // Before each loop() pass
+    void tick(SimRun &run) {
+        int zone = run.opt.faultZone;
+        if (zone < 0 || zone >= (int)run.world.zones.size() || run.board.nowMs() < faultAtMs) return;
+        if (!faultStarts) faultStarts = run.world.zones[zone].stats.pumpStarts + 1;   // Baseline, offset by one
+        const Plant *fp = plantManager.getPlants().byZone(zone);
+        if (!faultSeen && fp && fp->anomalies) { faultSeen = true; faultSeenMs = run.board.nowMs() - faultAtMs; }
+    }
+
+    void report(SimRun &run) {
+        const SimOptions &opt = run.opt;
+        SensorHealth &health = plantManager.getHealth();
+        int worst = 0;
+        for (int z = 1; z < (int)run.world.zones.size(); z++) if (health.getScore(z) < health.getScore(worst)) worst = z;
+        printf("Health    : anomalies");
+        for (int k = 0; k < ANOMALY_KINDS; k++) printf(" %s %u%s", SensorHealth::kindName(k), (unsigned)health.getAnomalies(k), k + 1 < ANOMALY_KINDS ? "," : "");
+        printf(" | auto-watering withheld %u | lowest zone %d: %u (%s)", (unsigned)health.getWithheld(), worst, (unsigned)health.getScore(worst),
+               SensorHealth::anomalyName(health.getFlags(worst)));
+        if (opt.faultZone >= 0 && faultStarts) {
+            static const char *kinds[] = { "none", "stuck", "noisy", "step" };
+            printf(" | zone %d %s from %.1f h: ", opt.faultZone, kinds[opt.fault], opt.faultStartH);
+            if (faultSeen) printf("flagged after %.0f s", faultSeenMs / 1000.0); else printf("NOT flagged");
+            printf(", %lu pump starts since", run.world.zones[opt.faultZone].stats.pumpStarts + 1 - faultStarts);
+            run.check(faultSeen, "injected " + std::string(kinds[opt.fault]) + " fault on zone " + std::to_string(opt.faultZone) + " not flagged");
+        }
+        printf("\n");
+    }
+};
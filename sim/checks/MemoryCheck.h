@@ -0,0 +1,67 @@
+#pragma once
+// ==========================================================
+// MemoryCheck - Peak heap of streamed replies
+// Runs last, as it deletes plants. Peak heap above the
+// baseline while one request is served (body drained, not
+// kept), after checking that the reply parses: with the full
+// table, then with one plant; scans with few and many
+// networks, some with quotes in the name. Replies are
+// streamed, so no peak may grow with the table or the scan.
+// ==========================================================
+#include "SimRun.h"
+#include "../SimHeap.h"
+
+// glibc hands out a whole free chunk when splitting it would
+// leave less than 32 B, so the usable size of one allocation
+// depends on what was freed before: each one the request makes
+// may come back this much bigger. The allocation count itself
+// must not change.
+#define SIM_HEAP_SLACK 16
+
+struct MemoryCheck {
+    void report(SimRun &run) {
+        struct { const char *url; int networks; int64_t peak[2]; size_t bytes[2]; uint64_t allocs[2]; } cases[] = {
+            { "/api/data", 0 }, { "/api/sensors", 0 }, { "/api/config?secrets=1", 0 }, { "/api/scan", 2 }, { "/api/scan", 64 }
+        };
+        bool valid = true;
+        int plants[2] = { (int)plantManager.getPlants().size(), 1 };
+        for (int pass = 0; pass < 2; pass++) {
+            if (pass) {
+                PlantTable &table = plantManager.getPlants();
+                while (table.size() > 1) plantManager.deletePlant(table[table.size() - 1].id);
+                for (int i = 0; i < 100; i++) { run.board.advanceMs(run.opt.tickMs); loop(); }
+            }
+            for (auto &c : cases) {
+                if (c.networks) { WiFi.simScanCount = c.networks; WiFi.scanNetworks(true); }
+                SimResponse full = sim::http(HTTP_GET, c.url);
+                DynamicJsonDocument doc(65536);
+                valid &= full.code == 200 && !deserializeJson(doc, full.body.c_str());
+                if (c.networks) {
+                    valid &= (int)doc.size() == c.networks && WiFi.scanComplete() == -2;   // Results freed once sent
+                    for (int i = 0; i < c.networks && valid; i++) valid = doc[i]["ssid"].as<String>() == String(i % 4 == 3 ? "Cafe \"Guest\\" : "SimNet_") + String(i);
+                    WiFi.scanNetworks(true);
+                }
+                sim::drainBodies() = true;
+                int64_t mark = sim::heapMark();
+                uint64_t allocs = sim::heap().allocs;
+                SimResponse r = sim::http(HTTP_GET, c.url);
+                c.peak[pass] = sim::peakSince(mark);
+                c.allocs[pass] = sim::heap().allocs - allocs;
+                c.bytes[pass] = r.drained + r.body.size();
+                sim::drainBodies() = false;
+            }
+        }
+        auto same = [](int64_t a, int64_t b, uint64_t allocs) { return std::abs(a - b) <= (int64_t)(SIM_HEAP_SLACK * allocs); };
+        bool constant = true;
+        printf("\nMemory    : peak heap per request, %d / %d plant(s) |", plants[0], plants[1]);
+        for (auto &c : cases) {
+            if (c.networks) printf(" %s %d nets %zu / %zu B: %lld / %lld B |", c.url, c.networks, c.bytes[0], c.bytes[1], (long long)c.peak[0], (long long)c.peak[1]);
+            else printf(" %s %zu / %zu B: %lld / %lld B |", c.url, c.bytes[0], c.bytes[1], (long long)c.peak[0], (long long)c.peak[1]);
+            constant &= c.allocs[0] == c.allocs[1] && same(c.peak[0], c.peak[1], c.allocs[0]);
+        }
+        constant &= cases[3].allocs[0] == cases[4].allocs[0] && same(cases[3].peak[0], cases[4].peak[0], cases[3].allocs[0]);
+        printf(" %s, %s\n", valid ? "all parse" : "INVALID", constant ? "constant" : "GROWS");
+        run.check(valid, "memory: a streamed reply does not parse");
+        run.check(constant, "memory: peak heap changes with the plant table or the scan size");
+    }
+};
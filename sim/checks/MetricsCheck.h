@@ -0,0 +1,74 @@
+#pragma once
+// ==========================================================
+// MetricsCheck - /metrics as a Prometheus scraper reads it
+// Every line must parse, histograms must be cumulative with
+// _count equal to the +Inf bucket, the exported step count
+// must be the task runner's own, and no block may have been
+// cut short (rosemary_metrics_truncated_total).
+// ==========================================================
+#include <chrono>
+#include <map>
+#include <sstream>
+#include "SimRun.h"
+
+struct MetricsCheck {
+    // Reads a /metrics body the way a Prometheus scraper would:
+    // "name{labels} value" lines, histogram buckets cumulative in
+    // line order, _count equal to the +Inf bucket. Returns the
+    // number of series, or -1 with the first problem in error.
+    static int parse(const std::string &body, std::map<std::string, double> &values, std::string &error) {
+        std::map<std::string, double> lastBucket;    // name + labels without le
+        std::istringstream in(body);
+        std::string line;
+        int series = 0;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            size_t sp = line.rfind(' ');
+            char *end = nullptr;
+            double v = sp == std::string::npos ? 0 : strtod(line.c_str() + sp + 1, &end);
+            std::string key = line.substr(0, sp);
+            if (!end || *end || key.empty() || (key.find('{') != std::string::npos && key.back() != '}')) { error = "bad line: " + line; return -1; }
+            values[key] = v;
+            series++;
+
+            size_t at = key.find("_bucket{"), le = key.find("le=\"");
+            if (at != std::string::npos && le != std::string::npos) {
+                std::string labels = key.substr(at + 8, le - at - 8);
+                if (!labels.empty()) labels.pop_back();   // Trailing comma
+                std::string id = key.substr(0, at) + "{" + labels + "}";
+                if (lastBucket.count(id) && v < lastBucket[id]) { error = "bucket not cumulative: " + key; return -1; }
+                lastBucket[id] = v;
+            }
+            at = key.find("_count");
+            if (at != std::string::npos) {
+                std::string rest = key.substr(at + 6);
+                std::string id = key.substr(0, at) + (rest.empty() ? "{}" : rest);
+                if (lastBucket.count(id) && lastBucket[id] != v) { error = "_count != +Inf bucket: " + key; return -1; }
+            }
+        }
+        return series;
+    }
+
+    void report(SimRun &run) {
+        auto m0 = std::chrono::steady_clock::now();
+        SimResponse r = sim::http(HTTP_GET, "/metrics");
+        double scrapeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m0).count();
+        std::map<std::string, double> values;
+        std::string error;
+        int series = r.code == 200 ? parse(r.body, values, error) : -1;
+        // The exported step count must be the runner's own
+        char key[64];
+        snprintf(key, sizeof(key), "rosemary_task_duration_seconds_count{task=\"%s\"}", tasks.get(0).name);
+        if (series >= 0 && (!values.count("rosemary_metrics_truncated_total") || values["rosemary_metrics_truncated_total"] > 0)) {
+            error = "truncated blocks: " + std::to_string((int)values["rosemary_metrics_truncated_total"]); series = -1;
+        }
+        if (series >= 0 && values[key] != tasks.get(0).runs) { error = "task count mismatch"; series = -1; }
+        double starts = 0;
+        for (auto &kv : values) if (kv.first.rfind("rosemary_pump_starts_total{", 0) == 0) starts += kv.second;
+        double waits = values["rosemary_water_queue_wait_seconds_count"];
+        printf("Metrics   : /metrics %zu B, %d series, scrape %.0f us (host) | %.0f x /api/data | %.0f pump starts, mean queue wait %.1f s | %s\n",
+               r.body.size(), series, scrapeUs, values["rosemary_http_request_duration_seconds_count{route=\"/api/data\"}"],
+               starts, waits > 0 ? values["rosemary_water_queue_wait_seconds_sum"] / waits : 0.0, series >= 0 ? "format ok" : error.c_str());
+        run.check(series >= 0, "/metrics: " + (r.code == 200 ? error : "HTTP " + std::to_string(r.code)));
+    }
+};
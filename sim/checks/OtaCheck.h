@@ -0,0 +1,117 @@
+#pragma once
+// ==========================================================
+// OtaCheck - Delta OTA end to end (--ota, make ota-check)
+// The image the delta was made from runs in app0, as after a
+// USB flash. Broken uploads come first (none may touch the
+// boot slot), then the real one. Each reboot is the
+// bootloader's part only: the firmware keeps running and
+// stands in for the new image. A crash on trial, an unhealthy
+// trial and a healthy one; then the same delta is stale.
+// ==========================================================
+#include <fstream>
+#include "SimRun.h"
+#include "../SimHeap.h"
+#include "../hal/esp_ota_ops.h"
+#include "../../src/Core/Ota.h"
+
+struct OtaCheck {
+    std::string otaOld, otaDelta, otaNew;
+
+    static bool readFile(const std::string &path, std::string &out) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // Before setup(); false if an image cannot be read
+    bool begin(SimRun &run) {
+        const SimOptions &opt = run.opt;
+        if (opt.otaOld.empty()) return true;
+        if (!readFile(opt.otaOld, otaOld) || !readFile(opt.otaDelta, otaDelta) || !readFile(opt.otaNew, otaNew)) {
+            fprintf(stderr, "--ota: cannot read %s, %s or %s\n", opt.otaOld.c_str(), opt.otaDelta.c_str(), opt.otaNew.c_str());
+            return false;
+        }
+        sim::ota().flashImage(std::vector<uint8_t>(otaOld.begin(), otaOld.end()));
+        return true;
+    }
+
+    void report(SimRun &run) {
+        if (otaDelta.empty()) return;
+        sim::Board &board = run.board;
+        sim::OtaFlash &flash = sim::ota();
+        std::string error;
+        auto restarts = [&](uint64_t ms) {    // Until ms pass or the firmware restarts
+            for (uint64_t end = board.nowMs() + ms; board.nowMs() < end && !board.rebootRequested; board.advanceMs(run.opt.tickMs)) loop();
+            bool rebooted = board.rebootRequested;
+            board.rebootRequested = false;
+            return rebooted;
+        };
+        auto boot = [&]() { flash.restart(); ota.begin(); };
+        auto upload = [&]() {            // Applied, rebooted into it, on trial
+            SimResponse r = sim::http(HTTP_POST, "/api/ota", otaDelta);
+            if (r.code != 200) return false;
+            if (!restarts(3000)) return false;
+            boot();
+            return ota.isOnTrial();
+        };
+        auto holds = [&](int slot, const std::string &image) {
+            const std::vector<uint8_t> &f = flash.slots[slot].flash;
+            return image.size() <= f.size() && !memcmp(image.data(), f.data(), image.size());
+        };
+
+        std::string badBase = otaDelta, corrupt = otaDelta;
+        if (otaDelta.size() > DELTA_HEADER_BYTES) { badBase[12] ^= 0x01; corrupt[DELTA_HEADER_BYTES + (otaDelta.size() - DELTA_HEADER_BYTES) / 2] ^= 0x5A; }
+        SimResponse rBase = sim::http(HTTP_POST, "/api/ota", badBase);
+        SimResponse rCorrupt = sim::http(HTTP_POST, "/api/ota", corrupt);
+        SimResponse rCut = sim::httpCut(HTTP_POST, "/api/ota", otaDelta, otaDelta.size() / 2);
+        if (rBase.code != 409 || rCorrupt.code < 400 || rCut.code != 0) error = "broken upload accepted";
+        else if (flash.bootSlot != flash.running || ota.getRejected() != 3) error = "boot slot changed by a broken upload";
+
+        // The good one, peak heap above the request body itself
+        uint64_t r0 = flash.bytesRead, w0 = flash.bytesWritten;
+        int64_t mark = sim::heapMark();
+        SimResponse rGood = sim::http(HTTP_POST, "/api/ota", otaDelta);
+        int64_t peak = sim::peakSince(mark);
+        uint64_t readKb = (flash.bytesRead - r0) / 1024, writtenKb = (flash.bytesWritten - w0) / 1024;
+        int target = 1 - flash.running;
+        if (error.empty() && (rGood.code != 200 || flash.bootSlot != target || !holds(target, otaNew))) error = "applied image differs: " + rGood.body;
+        if (error.empty() && !restarts(3000)) error = "no reboot after the update";
+        boot();
+        bool trial = ota.isOnTrial() && flash.running == target;
+        SimResponse rTrial = sim::http(HTTP_POST, "/api/ota", otaDelta);
+        if (error.empty() && (!trial || rTrial.code != 409)) error = "new image not on trial";
+
+        // Reset before it is kept: the bootloader goes back
+        boot();
+        bool crashBack = !ota.isOnTrial() && flash.running == 1 - target && flash.slots[target].state == ESP_OTA_IMG_ABORTED;
+        if (error.empty() && !crashBack) error = "no rollback after a crash";
+
+        // Unhealthy: an SSID is saved but the link never comes up
+        char ssid[40];
+        config.getStr(CFG_WIFI_SSID, ssid, sizeof(ssid));
+        config.setStr(CFG_WIFI_SSID, "SimNet");
+        WiFi.simSetLinkDown(true);
+        uint64_t t0 = board.nowMs();
+        bool gone = error.empty() && upload() && restarts(OTA_CONFIRM_TIMEOUT_MS + 5000);
+        double unhealthySec = (board.nowMs() - t0) / 1000.0;
+        if (error.empty() && (!gone || flash.slots[target].state != ESP_OTA_IMG_INVALID)) error = "unhealthy image kept";
+        boot();
+        WiFi.simSetLinkDown(false);
+        config.setStr(CFG_WIFI_SSID, ssid);
+        if (error.empty() && (flash.running != 1 - target || ota.isOnTrial())) error = "not back on the old image";
+
+        // Healthy: kept after OTA_CONFIRM_MS, and the old base is gone
+        bool kept = error.empty() && upload() && !restarts(OTA_CONFIRM_MS + 5000) && !ota.isOnTrial();
+        if (error.empty() && (!kept || flash.slots[target].state != ESP_OTA_IMG_VALID)) error = "healthy image not kept";
+        SimResponse rStale = sim::http(HTTP_POST, "/api/ota", otaDelta);
+        if (error.empty() && rStale.code != 409) error = "stale delta accepted";
+
+        printf("OTA       : delta %zu B for a %zu B image (%.0f%%), %zu chunk(s) | flash read %llu KB, written %llu KB | peak heap %lld B | bad base %d, corrupt %d, cut off %s | "
+               "crash on trial %s, unhealthy rolled back after %.0f s, healthy kept after %.0f s | stale %d | %s\n",
+               otaDelta.size(), otaNew.size(), 100.0 * otaDelta.size() / std::max<size_t>(otaNew.size(), 1), (otaDelta.size() + SIM_BODY_CHUNK - 1) / SIM_BODY_CHUNK,
+               (unsigned long long)readKb, (unsigned long long)writtenKb, (long long)peak, rBase.code, rCorrupt.code, rCut.code ? "answered" : "dropped",
+               crashBack ? "rolled back" : "KEPT", unhealthySec, ota.getConfirmMs() / 1000.0, rStale.code, error.empty() ? "ok" : error.c_str());
+        run.check(error.empty(), "ota: " + error);
+    }
+};
@@ -0,0 +1,78 @@
+#pragma once
+// ==========================================================
+// SimRun - State shared by the sim runner and its checks
+// One header per feature under checks/ holds that feature's
+// watcher (called every tick) and its post-run report. A
+// report prints one line and records failed checks here;
+// the runner lists them on its last line and exits 1.
+// ==========================================================
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "../hal/Arduino.h"
+#include "../hal/ESPAsyncWebServer.h"
+#include "../SimBoard.h"
+#include "../SoilModel.h"
+#include "../SimDevices.h"
+#include "../../src/Config.h"
+#include "../../src/Modules/PlantManager.h"
+#include "../../src/Modules/AdcSampler.h"
+#include "../../src/Core/Tasks.h"
+#include "../../src/Core/Network.h"
+#include "../../src/Modules/TelemetryPublisher.h"
+#include "../../src/Core/Power.h"
+#include "../../src/Core/ConfigStore.h"
+
+void setup();
+void loop();
+extern PlantManager plantManager;
+extern TaskRunner tasks;
+extern AdcSampler adcSampler;
+extern SensorHub sensorHub;
+extern NetworkManager network;
+extern TelemetryPublisher telemetry;
+extern int controlTask, sensingTask, networkTask;
+
+struct SimOptions {
+    double days = 14;
+    unsigned tickMs = 10;
+    int zones = MAX_PLANTS;
+    unsigned seed = 42;
+    int disconnect = -1;     // zone with a broken sensor wire
+    int faultZone = -1;      // zone whose probe goes bad at faultStartH
+    int fault = sim::FAULT_NONE;
+    double faultStartH = 0;
+    bool verbose = false;
+    const char *fsRoot = "sim_fs";
+    const char *dumpUrl = nullptr;
+    int clients = 0;         // simulated dashboards polling /api/data
+    unsigned pollMs = 2000;
+    int sseClients = 0;      // dashboards on the /api/events stream
+    const char *mqtt = nullptr;   // "sim" = in-process broker, else HOST[:PORT]
+    double outageStartH = -1, outageHours = 0;
+    const char *www = nullptr;    // LittleFS image from tools/build_assets.py
+    double dhtErrors = 0;         // fraction of DHT22 frames corrupted
+    double dhtOutageStartH = -1, dhtOutageHours = 0;
+    std::string otaOld, otaDelta, otaNew;   // flashed image, delta to upload, image it must produce
+};
+
+struct SimRun {
+    SimOptions opt;
+    sim::Board &board = sim::board();
+    sim::SoilModel &world = sim::world();
+    std::vector<std::string> failed;
+
+    // Records a failed post-run check
+    bool check(bool ok, const std::string &what) {
+        if (!ok) failed.push_back(what);
+        return ok;
+    }
+
+    // Runs the firmware for ms of virtual time
+    void settle(uint64_t ms) {
+        for (uint64_t end = board.nowMs() + ms; board.nowMs() < end; board.advanceMs(opt.tickMs)) loop();
+    }
+
+    double hours() const { return board.nowMs() / 3600000.0; }
+};
@@ -0,0 +1,62 @@
+#pragma once
+// ==========================================================
+// TasksCheck - Task runner, sleep and pump timing
+// Per task: wakeup rate, worst run time and heap allocations
+// (the control and sensing tasks must make none after
+// setup()). Deadline sleeping must keep wakeups well below a
+// fixed tick per task, and no pump may stop later than
+// CONTROL_TICK_MS. Time in setup-AP mode is reported on its
+// own: there the network task polls DNS every AP_DNS_POLL_MS
+// and must not wake much more often.
+// ==========================================================
+#include "SimRun.h"
+
+// FreeRTOS tickless idle only light-sleeps gaps of a few ticks
+#define SIM_SLEEP_MIN_MS 3
+
+struct TasksCheck {
+    uint64_t idleMs = 0;     // Time with no task due
+    uint64_t sleepMs = 0;    // The part of it light sleep could take
+    uint64_t apMs = 0;       // Time in setup-AP mode
+    uint64_t apRuns = 0;     // Network task wakeups in it
+    uint32_t netRuns = 0;
+
+    // After each loop() pass
+    void tick(SimRun &run) {
+        uint32_t idle = std::min<uint32_t>(tasks.idleMs(), run.opt.tickMs);
+        idleMs += idle;
+        if (idle >= SIM_SLEEP_MIN_MS && power.canSleep()) sleepMs += idle;
+        uint32_t runs = tasks.get(networkTask).runs;
+        if (network.isApMode()) { apMs += run.opt.tickMs; apRuns += runs - netRuns; }
+        netRuns = runs;
+    }
+
+    void report(SimRun &run) {
+        uint64_t now = std::max<uint64_t>(run.board.nowMs(), 1);
+        double simSec = std::max(run.board.nowMs() / 1000.0, 1e-9);
+        uint64_t allRuns = 0;
+        double fixedRate = 0;
+        printf("Tasks     :");
+        for (int i = 0; i < tasks.size(); i++) {
+            const PeriodicTask &t = tasks.get(i);
+            allRuns += t.runs;
+            fixedRate += 1000.0 / t.periodMs;
+            printf(" %s %.1f/s (%lu woken) max %lu us (%lu over, %llu allocs)%s", t.name, t.runs / simSec, (unsigned long)t.woken,
+                   (unsigned long)t.maxRunUs, (unsigned long)t.overruns, (unsigned long long)t.heapAllocs, i + 1 < tasks.size() ? " |" : "\n");
+            // The hot path runs allocation-free once set up
+            if (i == controlTask || i == sensingTask) run.check(t.heapAllocs == 0, std::string(t.name) + " task allocated after setup");
+        }
+        printf("Sleep     : %.1f task wakeups/s (%.0f/s at fixed ticks) | no task due %.1f%% of the time | light sleep %.1f%% (%s)",
+               allRuns / simSec, fixedRate, 100.0 * idleMs / now, 100.0 * sleepMs / now,
+               power.isLightSleepAllowed() ? "STA" : "off-link: off");
+        double apRate = apRuns / std::max(apMs / 1000.0, 1e-9);
+        if (apMs) printf(" | setup AP %.1f h: network %.1f wakeups/s (DNS poll %d ms)", apMs / 3600000.0, apRate, AP_DNS_POLL_MS);
+        printf("\n");
+        run.check(allRuns / simSec < fixedRate / 2, "tasks wake at more than half the fixed-tick rate");
+        // Route and plant-event wakes come on top of the DNS poll
+        if (apMs) run.check(apRate <= 1.2 * 1000 / AP_DNS_POLL_MS, "network task wakes too often in setup-AP mode");
+        printf("Pump stop : late by max %lu ms (virtual time, tick %u ms) | max %d pumps at once\n",
+               plantManager.getStopLateMax(), run.opt.tickMs, plantManager.getMaxConcurrentPumps());
+        run.check(plantManager.getStopLateMax() <= std::max<unsigned>(CONTROL_TICK_MS, run.opt.tickMs), "a pump stopped later than CONTROL_TICK_MS");
+    }
+};
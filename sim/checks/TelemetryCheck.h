@@ -0,0 +1,126 @@
+#pragma once
+// ==========================================================
+// TelemetryCheck - CBOR frames and MQTT delivery
+// /api/data.cbor must decode to the plant table. With --mqtt
+// sim a fleet collector on the in-process broker decodes
+// every frame: each published frame must arrive once, and
+// seq gaps must be the frames the spool dropped (or still
+// holds). --wifi-outage takes the station link down.
+// ==========================================================
+#include <chrono>
+#include <map>
+#include <set>
+#include "SimRun.h"
+#include "../TelemetryDecoder.h"
+
+// Fleet collector on the in-process broker: decodes every frame
+struct Collector {
+    uint64_t frames = 0, bytes = 0, samples = 0, events = 0;
+    uint64_t dups = 0, reordered = 0, bad = 0, maxDelayMs = 0;
+    std::map<uint32_t, std::set<uint32_t>> seen;    // boot -> frame seqs
+    std::map<uint32_t, uint32_t> lastSeq;
+
+    void onFrame(const std::string &payload, uint64_t nowMs) {
+        sim::TelemetryBatch b;
+        if (!sim::decodeBatch((const uint8_t*)payload.data(), payload.size(), b)) { bad++; return; }
+        frames++; bytes += payload.size();
+        if (!seen[b.boot].insert(b.seq).second) { dups++; return; }
+        if (lastSeq.count(b.boot) && b.seq < lastSeq[b.boot]) reordered++;
+        lastSeq[b.boot] = b.seq;
+        samples += b.samples.size();
+        events += b.events.size();
+        // Uptime stamps: only comparable within this run's boot
+        if (!b.samples.empty() && b.samples.front().t <= nowMs) maxDelayMs = std::max<uint64_t>(maxDelayMs, nowMs - b.samples.front().t);
+    }
+
+    uint64_t gaps() const {
+        uint64_t g = 0;
+        for (auto &s : seen) g += (*s.second.rbegin() + 1) - s.second.size();
+        return g;
+    }
+};
+
+struct TelemetryCheck {
+    Collector collector;
+    bool linkDown = false;
+
+    // Before setup(): a station link and a saved broker, as /api/save-mqtt leaves them
+    void begin(SimRun &run) {
+        if (!run.opt.mqtt) return;
+        std::string host = run.opt.mqtt;
+        unsigned port = MQTT_PORT_DEFAULT;
+        size_t colon = host.rfind(':');
+        if (colon != std::string::npos) { port = (unsigned)atoi(host.c_str() + colon + 1); host.resize(colon); }
+        Preferences p;
+        p.begin("wifi"); p.putString("ssid", "SimNet"); p.putString("pass", ""); p.end();
+        p.begin("mqtt"); p.putString("host", host.c_str()); p.putUInt("port", port); p.end();
+        run.board.stats.prefsWrites = 0;
+        sim::Board &board = run.board;
+        sim::broker().onMessage = [this, &board](const sim::MqttMessage &m){ collector.onFrame(m.payload, board.nowMs()); };
+    }
+
+    // Before each loop() pass
+    void tick(SimRun &run) {
+        if (run.opt.outageStartH < 0) return;
+        double h = run.hours();
+        bool down = h >= run.opt.outageStartH && h < run.opt.outageStartH + run.opt.outageHours;
+        if (down != linkDown) { linkDown = down; WiFi.simSetLinkDown(down); }
+    }
+
+    void report(SimRun &run) {
+        // /api/data vs /api/data.cbor on the final state (host time per call)
+        const int reps = 200;
+        DynamicJsonDocument jdoc(2048 + 512 * MAX_PLANTS);   // Parse side (a client)
+        std::vector<char> jbuf(SNAPSHOT_BUF_SIZE);
+        std::vector<uint8_t> cbuf(TELEMETRY_BUF_SIZE);
+        size_t jsonLen = 0, cborLen = 0;
+        sim::TelemetryFrame frame;
+        bool decoded = true;
+        auto e0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; i++) jsonLen = network.fillData((uint8_t*)jbuf.data(), jbuf.size(), 1);
+        auto e1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; i++) cborLen = network.fillTelemetry(cbuf.data(), cbuf.size(), 1);
+        auto e2 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; i++) { jdoc.clear(); deserializeJson(jdoc, jbuf.data(), jsonLen); }
+        auto e3 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; i++) decoded = decoded && sim::decodeTelemetry(cbuf.data(), cborLen, frame);
+        auto e4 = std::chrono::steady_clock::now();
+        auto perCall = [reps](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+            return std::chrono::duration<double, std::micro>(b - a).count() / reps;
+        };
+
+        // The decoded frame must carry the same plant state as the table
+        bool match = decoded && frame.plants.size() == plantManager.getPlants().size();
+        if (match) {
+            size_t k = 0;
+            for (auto &p : plantManager.getPlants()) {
+                const sim::TelemetryPlant &d = frame.plants[k++];
+                match = match && d.id == p.id && d.name == p.name && d.zone == p.originalIndex && d.moisture == p.currentMoisture &&
+                        d.threshold == p.threshold && d.sensor == (int)p.sensorMode && d.watering == p.isWatering && d.soakMs == p.soakMs &&
+                        d.health == p.health && d.anomaly == p.anomalies;
+            }
+        }
+        printf("Telemetry : JSON %zu B, encode %.1f us, parse %.1f us | CBOR %zu B (%.0f%%), encode %.1f us, decode %.1f us | decoded %s\n",
+               jsonLen, perCall(e0, e1), perCall(e2, e3), cborLen, 100.0 * cborLen / std::max<size_t>(jsonLen, 1),
+               perCall(e1, e2), perCall(e3, e4), match ? "frame matches" : "MISMATCH");
+        run.check(match, "decoded /api/data.cbor frame differs from the plant table");
+
+        if (!telemetry.isEnabled()) return;
+        printf("MQTT      : %u frames (%u B) published, %u connects | %u samples taken | backlog max %u frames, %u spilled to flash, %u dropped, %u left | %u events lost\n",
+               (unsigned)telemetry.getPublished(), (unsigned)telemetry.getPublishedBytes(), (unsigned)telemetry.getConnects(),
+               (unsigned)telemetry.getSamples(), (unsigned)telemetry.getMaxBacklog(), (unsigned)telemetry.getSpilled(),
+               (unsigned)telemetry.getDropped(), (unsigned)telemetry.getBacklog(), (unsigned)telemetry.getLostEvents());
+        if (collector.frames + collector.bad == 0) return;
+        printf("Collector : %llu frames (%.0f B/frame, %.1f B/sample) | %llu samples, %llu events | %llu dup, %llu gaps, %llu reordered, %llu bad | max delay %.1f h\n",
+               (unsigned long long)collector.frames, collector.bytes / std::max(collector.frames, (uint64_t)1) * 1.0,
+               collector.bytes / std::max(collector.samples, (uint64_t)1) * 1.0,
+               (unsigned long long)collector.samples, (unsigned long long)collector.events,
+               (unsigned long long)collector.dups, (unsigned long long)collector.gaps(),
+               (unsigned long long)collector.reordered, (unsigned long long)collector.bad, collector.maxDelayMs / 3600000.0);
+        // Every published frame decodes, once; seq gaps are the frames the spool
+        // dropped (or still holds)
+        run.check(collector.bad == 0 && collector.frames == telemetry.getPublished(), "collector got bad or unpublished frames");
+        run.check(collector.gaps() >= telemetry.getDropped() && collector.gaps() <= telemetry.getDropped() + telemetry.getBacklog(),
+                  "telemetry seq gaps do not match the dropped frames");
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+// ==========================================================
+// TraceCheck - Trace ring and /api/trace (TRACE=1 builds)
+// Prints the slowest span per trace point still in the ring.
+// The export must load in a trace viewer with one event per
+// kept span (plus thread names), and some spans must be kept.
+// ==========================================================
+#include <map>
+#include "SimRun.h"
+#include "../../src/Core/Trace.h"
+
+struct TraceCheck {
+    void report(SimRun &run) {
+#ifdef ROSEMARY_TRACE
+        SimResponse r = sim::http(HTTP_GET, "/api/trace");
+        std::map<std::string, uint32_t> slowest;
+        uint32_t end = traceRing.getRecorded(), kept = 0;
+        TraceEvent e;
+        for (uint32_t i = end > TRACE_EVENTS ? end - TRACE_EVENTS : 0; i < end; i++) {
+            if (!traceRing.read(i, e)) continue;
+            kept++;
+            uint32_t &m = slowest[e.name];
+            m = std::max(m, e.cycles / traceRing.getCpuMhz());
+        }
+        std::vector<std::pair<uint32_t, std::string>> top;
+        for (auto &kv : slowest) top.push_back({kv.second, kv.first});
+        std::sort(top.rbegin(), top.rend());
+        printf("Trace     : %u spans >= %d us recorded, %u kept | /api/trace %zu B (host time) | slowest:",
+               (unsigned)end, TRACE_MIN_US, (unsigned)kept, r.body.size());
+        for (size_t i = 0; i < top.size() && i < 5; i++) printf(" %s %u us%s", top[i].second.c_str(), (unsigned)top[i].first, i + 1 < std::min<size_t>(top.size(), 5) ? "," : "\n");
+        if (top.empty()) printf(" -\n");
+        DynamicJsonDocument doc(r.body.size() * 4 + 4096);
+        bool loads = r.code == 200 && !deserializeJson(doc, r.body.c_str()) && doc["traceEvents"].size() >= kept;
+        run.check(loads && kept > 0, "/api/trace: not valid trace JSON, or no spans kept");
+#else
+        (void)run;
+#endif
+    }
+};
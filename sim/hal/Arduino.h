@@ -0,0 +1,284 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include "../SimBoard.h"
+
+// ==========================================================
+// Rosemary Core - Arduino HAL (Host Simulation)
+// Same API surface the firmware uses, backed by sim::Board
+// ==========================================================
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH            0x1
+#define LOW             0x0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define INPUT_PULLDOWN  0x09
+
+#define PROGMEM
+#define F(s) (s)
+#define IRAM_ATTR
+
+using std::isnan;
+using std::isinf;
+using std::min;
+using std::max;
+
+// --- Time ---
+inline unsigned long millis() { return (unsigned long)sim::board().nowMs(); }
+inline unsigned long micros() { return (unsigned long)(sim::board().inIrq ? sim::board().irqUs : sim::board().nowUs); }
+inline void delay(unsigned long ms) {
+    sim::board().stats.delayCalls++;
+    sim::board().stats.delayMs += ms;
+    if (!sim::board().onDelay) { sim::board().advanceMs(ms); return; }
+    // Let other tasks run while this one blocks
+    for (unsigned long i = 0; i < ms; i++) { sim::board().advanceMs(1); sim::board().onDelay(); }
+}
+inline void delayMicroseconds(unsigned int us) { sim::board().advanceUs(us); }
+inline void yield() {}
+
+// --- GPIO / ADC ---
+inline void pinMode(uint8_t pin, uint8_t mode) { sim::board().setMode(pin, mode); }
+inline void digitalWrite(uint8_t pin, uint8_t val) { sim::board().write(pin, val); }
+inline int digitalRead(uint8_t pin) { return sim::board().read(pin); }
+#define CHANGE 0x03
+#define digitalPinToInterrupt(p) (p)
+inline void attachInterruptArg(uint8_t pin, void (*fn)(void*), void *arg, int mode) {
+    if (pin < SIM_PIN_COUNT) sim::board().irqs[pin] = { fn, arg };
+}
+inline void detachInterrupt(uint8_t pin) { if (pin < SIM_PIN_COUNT) sim::board().irqs[pin] = {}; }
+// One conversion takes ~20 us on the S3; tasks see that time pass
+#define SIM_ADC_READ_US 20
+inline uint16_t analogRead(uint8_t pin) {
+    sim::board().advanceUs(SIM_ADC_READ_US);
+    return (uint16_t)sim::board().analog(pin);
+}
+inline void analogReadResolution(uint8_t bits) {}
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+inline void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val) {
+    for (int i = 0; i < 8; i++) {
+        int bit = bitOrder == LSBFIRST ? (val >> i) & 1 : (val >> (7 - i)) & 1;
+        digitalWrite(dataPin, bit);
+        digitalWrite(clockPin, HIGH);
+        digitalWrite(clockPin, LOW);
+    }
+}
+
+// --- LEDC (PWM): any duty > 0 drives the pin for the soil model ---
+namespace sim {
+inline int ledcPin[16] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+inline uint32_t ledcDuty[16] = {0};
+}
+inline double ledcSetup(uint8_t ch, double freq, uint8_t bits) { return freq; }
+inline void ledcAttachPin(uint8_t pin, uint8_t ch) { if (ch < 16) { sim::ledcPin[ch] = pin; sim::board().setMode(pin, OUTPUT); } }
+inline void ledcWrite(uint8_t ch, uint32_t duty) {
+    if (ch >= 16 || sim::ledcPin[ch] < 0) return;
+    bool was = sim::ledcDuty[ch] > 0;
+    sim::ledcDuty[ch] = duty;
+    if (was != (duty > 0)) sim::board().write(sim::ledcPin[ch], duty > 0 ? HIGH : LOW);
+}
+
+// --- Math helpers ---
+template<typename T, typename L, typename H>
+inline T constrain(T amt, L low, H high) { return amt < (T)low ? (T)low : (amt > (T)high ? (T)high : amt); }
+
+// newlib (ESP32) has strlcpy; glibc only since 2.38
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t n = strlen(src);
+    if (size) { size_t c = n < size - 1 ? n : size - 1; memcpy(dst, src, c); dst[c] = 0; }
+    return n;
+}
+#endif
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    if (in_max == in_min) return out_min;
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+namespace sim {
+inline std::mt19937& rng() { static std::mt19937 r(1); return r; }
+}
+inline void randomSeed(unsigned long seed) { sim::rng().seed((uint32_t)seed); }
+inline long random(long howbig) { return howbig <= 0 ? 0 : (long)(sim::rng()() % (uint32_t)howbig); }
+inline long random(long howsmall, long howbig) { return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall); }
+
+// --- String ---
+class String {
+private:
+    std::string s;
+
+public:
+    String() {}
+    String(const char *c) : s(c ? c : "") {}
+    String(const std::string &str) : s(str) {}
+    String(char c) : s(1, c) {}
+    String(bool v) : s(v ? "1" : "0") {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(long long v) : s(std::to_string(v)) {}
+    String(unsigned long long v) : s(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2) {
+        char buf[48]; snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v); s = buf;
+    }
+    String(float v, unsigned int decimals = 2) : String((double)v, decimals) {}
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return (unsigned int)s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int n) { s.reserve(n); return true; }
+
+    String& operator+=(const String &o) { s += o.s; return *this; }
+    String& operator+=(const char *c) { if (c) s += c; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    String& operator+=(T v) { s += String(v).s; return *this; }
+    bool concat(const String &o) { s += o.s; return true; }
+    bool concat(const char *c) { if (c) s += c; return true; }
+    bool concat(const char *c, unsigned int n) { if (c) s.append(c, n); return true; }
+    bool concat(char c) { s += c; return true; }
+
+    bool operator==(const String &o) const { return s == o.s; }
+    bool operator==(const char *c) const { return s == (c ? c : ""); }
+    bool operator!=(const String &o) const { return s != o.s; }
+    bool operator!=(const char *c) const { return !(*this == c); }
+    bool operator<(const String &o) const { return s < o.s; }
+    bool equals(const String &o) const { return s == o.s; }
+
+    char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char& operator[](unsigned int i) { return s[i]; }
+    char charAt(unsigned int i) const { return (*this)[i]; }
+
+    int indexOf(char c, unsigned int from = 0) const { size_t p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+    int indexOf(const String &o, unsigned int from = 0) const { size_t p = s.find(o.s, from); return p == std::string::npos ? -1 : (int)p; }
+    int lastIndexOf(char c) const { size_t p = s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+    bool startsWith(const String &o) const { return s.compare(0, o.s.size(), o.s) == 0; }
+    bool endsWith(const String &o) const { return s.size() >= o.s.size() && s.compare(s.size() - o.s.size(), o.s.size(), o.s) == 0; }
+    String substring(unsigned int from) const { return from >= s.size() ? String() : String(s.substr(from)); }
+    String substring(unsigned int from, unsigned int to) const { if (from >= s.size() || to <= from) return String(); return String(s.substr(from, to - from)); }
+    void replace(const String &a, const String &b) {
+        if (a.s.empty()) return;
+        size_t p = 0;
+        while ((p = s.find(a.s, p)) != std::string::npos) { s.replace(p, a.s.size(), b.s); p += b.s.size(); }
+    }
+    void trim() {
+        size_t b = s.find_first_not_of(" \t\r\n"), e = s.find_last_not_of(" \t\r\n");
+        s = (b == std::string::npos) ? "" : s.substr(b, e - b + 1);
+    }
+    void toLowerCase() { for (auto &c : s) c = (char)tolower(c); }
+    void toUpperCase() { for (auto &c : s) c = (char)toupper(c); }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+
+    friend String operator+(const String &a, const String &b) { String r(a); r += b; return r; }
+    friend String operator+(const String &a, const char *b) { String r(a); r += b; return r; }
+    friend String operator+(const char *a, const String &b) { String r(a); r += b; return r; }
+    template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    friend String operator+(const String &a, T v) { String r(a); r += String(v); return r; }
+};
+
+// --- Print / Stream ---
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t len) {
+        size_t n = 0; while (len--) n += write(*buf++); return n;
+    }
+    size_t write(const char *str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t print(const char *c) { return write(c); }
+    size_t print(const String &s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v, int d = 2) { return print(String(v, d)); }
+    template<typename T> size_t println(const T &v) { size_t n = print(v); return n + print("\n"); }
+    size_t println() { return print("\n"); }
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[512];
+        va_list ap; va_start(ap, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        if (n < 0) return 0;
+        return write((const uint8_t*)buf, std::min((size_t)n, sizeof(buf) - 1));
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(char *buf, size_t len) {
+        size_t n = 0;
+        while (n < len) { int c = read(); if (c < 0) break; buf[n++] = (char)c; }
+        return n;
+    }
+    size_t readBytes(uint8_t *buf, size_t len) { return readBytes((char*)buf, len); }
+    void setTimeout(unsigned long) {}
+};
+
+// Serial: stdout with virtual-clock stamps at each line start
+class HardwareSerial : public Stream {
+private:
+    bool lineStart = true;
+
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override {
+        if (sim::board().quiet) return 1;
+        if (lineStart && c != '\n') {
+            char ts[32]; sim::board().stamp(ts, sizeof(ts));
+            fprintf(stdout, "[%s] ", ts);
+            lineStart = false;
+        }
+        fputc(c, stdout);
+        if (c == '\n') lineStart = true;
+        return 1;
+    }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
+
+// --- Chip ---
+class EspClass {
+public:
+    void restart() { sim::board().rebootRequested = true; }
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getHeapSize() { return 320000; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    // 240 MHz counter on host time: trace spans show host cost
+    uint32_t getCycleCount() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        return (uint32_t)((uint64_t)ns * 240 / 1000);
+    }
+};
+
+inline EspClass ESP;
@@ -0,0 +1,2 @@
+#pragma once
+// AsyncTCP - Host Simulation (no sockets; requests are dispatched in-process)
@@ -0,0 +1,10 @@
+#pragma once
+#include "WiFi.h"
+
+// DNSServer - Host Simulation (captive portal is a no-op)
+class DNSServer {
+public:
+    bool start(uint16_t port, const String &domain, const IPAddress &ip) { return true; }
+    void stop() {}
+    void processNextRequest() {}
+};
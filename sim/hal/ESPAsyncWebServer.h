@@ -0,0 +1,344 @@
+#pragma once
+#include <map>
+#include <memory>
+#include "Arduino.h"
+#include "FS.h"
+
+// ==========================================================
+// ESPAsyncWebServer - Host Simulation
+// Routes are registered as on the device; sim::http dispatches
+// requests in-process and captures the response.
+// ==========================================================
+
+#define SIM_BODY_CHUNK 536      // Request bodies arrive a TCP segment at a time (minimum IPv4 MSS)
+
+typedef enum {
+    HTTP_GET = 0b00000001, HTTP_POST = 0b00000010, HTTP_DELETE = 0b00000100, HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000, HTTP_HEAD = 0b00100000, HTTP_OPTIONS = 0b01000000, HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, const String&, size_t, uint8_t*, size_t, bool)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t)> ArBodyHandlerFunction;
+typedef std::function<void(void)> ArDisconnectHandler;
+
+class AsyncWebParameter {
+private:
+    String _name, _value;
+
+public:
+    AsyncWebParameter(const String &n, const String &v) : _name(n), _value(v) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+};
+
+class AsyncWebHeader {
+private:
+    String _name, _value;
+
+public:
+    AsyncWebHeader(const String &n, const String &v) : _name(n), _value(v) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+};
+
+// Captured result of one dispatched request
+struct SimResponse {
+    int code = 0;
+    String contentType;
+    std::string body;
+    std::map<std::string, std::string> headers;
+    bool redirected = false;
+    size_t drained = 0;      // Body bytes not kept (sim::drainBodies)
+};
+
+namespace sim {
+// Streamed and in-flash bodies are counted, not captured, so the
+// capture does not show up in heap measurements
+inline bool& drainBodies() { static bool on = false; return on; }
+}
+
+class AsyncWebServerResponse {
+public:
+    int code = 200;
+    String contentType;
+    std::string body;
+    std::map<std::string, std::string> headers;
+    size_t drained = 0;
+
+    virtual ~AsyncWebServerResponse() {}
+    void addHeader(const String &name, const String &value) { headers[name.c_str()] = value.c_str(); }
+    void setCode(int c) { code = c; }
+    void setContentType(const String &t) { contentType = t; }
+};
+
+class AsyncWebServerRequest {
+private:
+    WebRequestMethodComposite _method;
+    String _url;
+    std::vector<AsyncWebParameter> params;
+    std::vector<AsyncWebHeader> reqHeaders;
+    ArDisconnectHandler disconnectFn;
+
+public:
+    SimResponse result;
+    void *_tempObject = nullptr;    // Handler scratch, freed with the request
+
+    // The connection closes once the response is out
+    ~AsyncWebServerRequest() { if (disconnectFn) disconnectFn(); free(_tempObject); }
+    void onDisconnect(ArDisconnectHandler fn) { disconnectFn = fn; }
+
+    AsyncWebServerRequest(WebRequestMethodComposite m, const String &url) : _method(m) {
+        int q = url.indexOf('?');
+        _url = q < 0 ? url : url.substring(0, q);
+        if (q >= 0) {
+            String qs = url.substring(q + 1);
+            while (qs.length()) {
+                int amp = qs.indexOf('&');
+                String kv = amp < 0 ? qs : qs.substring(0, amp);
+                int eq = kv.indexOf('=');
+                if (eq < 0) params.emplace_back(kv, String(""));
+                else params.emplace_back(kv.substring(0, eq), kv.substring(eq + 1));
+                qs = amp < 0 ? String() : qs.substring(amp + 1);
+            }
+        }
+    }
+
+    WebRequestMethodComposite method() const { return _method; }
+    const String& url() const { return _url; }
+
+    void simAddHeader(const String &n, const String &v) { reqHeaders.emplace_back(n, v); }
+    void addInterestingHeader(const String &name) {}   // The sim keeps every header
+
+    bool hasParam(const String &name, bool post = false, bool file = false) const {
+        for (auto &p : params) if (p.name() == name) return true;
+        return false;
+    }
+    AsyncWebParameter* getParam(const String &name, bool post = false, bool file = false) {
+        for (auto &p : params) if (p.name() == name) return &p;
+        return nullptr;
+    }
+    bool hasHeader(const String &name) const {
+        for (auto &h : reqHeaders) if (h.name() == name) return true;
+        return false;
+    }
+    AsyncWebHeader* getHeader(const String &name) {
+        for (auto &h : reqHeaders) if (h.name() == name) return &h;
+        return nullptr;
+    }
+    String header(const char *name) {
+        auto h = getHeader(name);
+        return h ? h->value() : String();
+    }
+
+    void send(int code, const String &contentType = String(), const String &content = String()) {
+        result.code = code; result.contentType = contentType; result.body = content.c_str();
+    }
+    void send(FS &fs, const String &path, const String &contentType = String(), bool download = false) {
+        File f = fs.open(path.c_str(), "r");
+        if (!f) { send(404); return; }
+        result.code = 200; result.contentType = contentType; result.body.clear();
+        int c; while ((c = f.read()) >= 0) result.body.push_back((char)c);
+        f.close();
+    }
+    void send(AsyncWebServerResponse *response) {
+        result.code = response->code; result.contentType = response->contentType;
+        result.body = response->body; result.headers = response->headers; result.drained = response->drained;
+        delete response;
+    }
+    AsyncWebServerResponse* beginResponse(int code, const String &contentType = String(), const String &content = String()) {
+        auto r = new AsyncWebServerResponse();
+        r->code = code; r->contentType = contentType; r->body = content.c_str();
+        return r;
+    }
+    AsyncWebServerResponse* beginResponse(FS &fs, const String &path, const String &contentType = String(), bool download = false) {
+        File f = fs.open(path.c_str(), "r");
+        auto r = new AsyncWebServerResponse();
+        if (!f) { r->code = 404; return r; }
+        r->code = 200; r->contentType = contentType;
+        int c; while ((c = f.read()) >= 0) r->body.push_back((char)c);
+        f.close();
+        return r;
+    }
+    AsyncWebServerResponse* beginResponse_P(int code, const String &contentType, const uint8_t *content, size_t len) {
+        auto r = new AsyncWebServerResponse();
+        r->code = code; r->contentType = contentType;
+        if (sim::drainBodies()) r->drained = len;   // Sent from flash / static RAM on the device
+        else r->body.assign((const char*)content, len);
+        return r;
+    }
+    AsyncWebServerResponse* beginChunkedResponse(const String &contentType, std::function<size_t(uint8_t*, size_t, size_t)> filler) {
+        auto r = new AsyncWebServerResponse();
+        r->code = 200; r->contentType = contentType;
+        uint8_t chunk[1436];   // one TCP segment per callback, as on the device
+        size_t n;
+        size_t index = 0;
+        while ((n = filler(chunk, sizeof(chunk), index)) > 0) {
+            if (sim::drainBodies()) r->drained += n;
+            else r->body.append((const char*)chunk, n);
+            index += n;
+        }
+        return r;
+    }
+    void redirect(const String &url) { result.code = 302; result.redirected = true; result.headers["Location"] = url.c_str(); }
+};
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest *request) { return false; }
+    virtual void handleRequest(AsyncWebServerRequest *request) {}
+};
+
+class AsyncStaticWebHandler : public AsyncWebHandler {
+public:
+    String uri, path, cacheControl, defaultFile = "index.htm";
+    FS *fs;
+
+    AsyncStaticWebHandler(const String &u, FS &f, const String &p) : uri(u), path(p), fs(&f) {}
+    AsyncStaticWebHandler& setCacheControl(const char *cc) { cacheControl = cc; return *this; }
+    AsyncStaticWebHandler& setDefaultFile(const char *f) { defaultFile = f; return *this; }
+    AsyncStaticWebHandler& setLastModified(const char *) { return *this; }
+    bool canHandle(AsyncWebServerRequest *req) override {
+        return req->method() == HTTP_GET && req->url().startsWith(uri) && fs->exists(path + req->url().substring(uri.length()));
+    }
+    void handleRequest(AsyncWebServerRequest *req) override {
+        req->send(*fs, path + req->url().substring(uri.length()));
+        if (cacheControl.length()) req->result.headers["Cache-Control"] = cacheControl.c_str();
+    }
+};
+
+// Event stream: the sim keeps a count of open clients and what was pushed
+class AsyncEventSourceClient {
+public:
+    uint64_t sent = 0, bytes = 0;
+    void send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        sent++; bytes += strlen(message) + (event ? strlen(event) : 0) + 24;
+    }
+};
+typedef std::function<void(AsyncEventSourceClient*)> ArEventHandlerFunction;
+
+class AsyncEventSource : public AsyncWebHandler {
+private:
+    String _url;
+    ArEventHandlerFunction connectFn;
+    std::vector<std::unique_ptr<AsyncEventSourceClient>> clients;
+
+public:
+    uint64_t eventsSent = 0, bytesSent = 0;
+
+    AsyncEventSource(const String &url) : _url(url) {}
+    const char* url() const { return _url.c_str(); }
+    void onConnect(ArEventHandlerFunction fn) { connectFn = fn; }
+    size_t count() const { return clients.size(); }
+    size_t avgPacketsWaiting() const { return 0; }
+    void close() { clients.clear(); }
+    void send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+        for (auto &c : clients) {
+            c->send(message, event, id, reconnect);
+            eventsSent++; bytesSent += strlen(message) + (event ? strlen(event) : 0) + 24;
+        }
+    }
+    // Sim-only: open a client connection
+    AsyncEventSourceClient* simConnect() {
+        clients.emplace_back(new AsyncEventSourceClient());
+        if (connectFn) connectFn(clients.back().get());
+        return clients.back().get();
+    }
+    bool canHandle(AsyncWebServerRequest *req) override { return req->url() == _url; }
+    void handleRequest(AsyncWebServerRequest *req) override { simConnect(); req->result.code = 200; req->result.contentType = "text/event-stream"; }
+};
+
+class AsyncWebServer {
+private:
+    struct Route {
+        String uri;
+        WebRequestMethodComposite method;
+        ArRequestHandlerFunction onRequest;
+        ArBodyHandlerFunction onBody;
+    };
+    std::vector<Route> routes;
+    std::vector<AsyncWebHandler*> handlers;
+    std::vector<AsyncWebHandler*> owned;     // created by serveStatic()
+    ArRequestHandlerFunction notFound;
+
+public:
+    AsyncWebServer(uint16_t port) { instances().push_back(this); }
+    ~AsyncWebServer() {
+        auto &v = instances();
+        v.erase(std::remove(v.begin(), v.end(), this), v.end());
+        for (auto h : owned) delete h;
+    }
+
+    static std::vector<AsyncWebServer*>& instances() { static std::vector<AsyncWebServer*> v; return v; }
+
+    void begin() {}
+    void end() {}
+
+    void on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+        routes.push_back({uri, method, onRequest, nullptr});
+    }
+    void on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+            ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody = nullptr) {
+        routes.push_back({uri, method, onRequest, onBody});
+    }
+    AsyncStaticWebHandler& serveStatic(const char *uri, FS &fs, const char *path) {
+        auto h = new AsyncStaticWebHandler(uri, fs, path);
+        handlers.push_back(h); owned.push_back(h);
+        return *h;
+    }
+    AsyncWebHandler& addHandler(AsyncWebHandler *h) { handlers.push_back(h); return *h; }
+    void onNotFound(ArRequestHandlerFunction fn) { notFound = fn; }
+
+    // Sim-only: totals across all event sources on this server
+    void simEventTotals(uint64_t &events, uint64_t &bytes) {
+        for (auto h : handlers) {
+            auto es = dynamic_cast<AsyncEventSource*>(h);
+            if (es) { events += es->eventsSent; bytes += es->bytesSent; }
+        }
+    }
+
+    // Sim-only: route one request exactly like the async server would.
+    // sent < body size: the client goes away after that many bytes.
+    SimResponse dispatch(AsyncWebServerRequest &req, const std::string &body = "", size_t sent = SIZE_MAX) {
+        for (auto &r : routes) {
+            if (r.uri == req.url() && (r.method & req.method())) {
+                // Delivered in TCP-sized pieces, like the async server does
+                for (size_t at = 0; r.onBody && at < body.size() && at < sent; at += SIM_BODY_CHUNK) {
+                    size_t n = std::min(body.size() - at, (size_t)SIM_BODY_CHUNK);
+                    std::vector<uint8_t> buf(body.begin() + at, body.begin() + at + n);
+                    buf.push_back(0);
+                    r.onBody(&req, buf.data(), n, at, body.size());
+                }
+                if (sent < body.size()) return req.result;
+                if (req.result.code == 0 && r.onRequest) r.onRequest(&req);
+                return req.result;
+            }
+        }
+        for (auto h : handlers) if (h->canHandle(&req)) { h->handleRequest(&req); return req.result; }
+        if (notFound) notFound(&req);
+        return req.result;
+    }
+};
+
+namespace sim {
+// Issue a request against the first web server the firmware created
+inline SimResponse http(WebRequestMethodComposite method, const String &url, const std::string &body = "",
+                        const std::vector<std::pair<String, String>> &headers = {}) {
+    auto &v = AsyncWebServer::instances();
+    if (v.empty()) return SimResponse();
+    AsyncWebServerRequest req(method, url);
+    for (auto &h : headers) req.simAddHeader(h.first, h.second);
+    return v.front()->dispatch(req, body);
+}
+
+// The client sends the first `sent` bytes of the body, then disconnects
+inline SimResponse httpCut(WebRequestMethodComposite method, const String &url, const std::string &body, size_t sent) {
+    auto &v = AsyncWebServer::instances();
+    if (v.empty()) return SimResponse();
+    AsyncWebServerRequest req(method, url);
+    return v.front()->dispatch(req, body, sent);
+}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <sys/stat.h>
+#include <cstdio>
+#include <string>
+#include "Arduino.h"
+
+// ==========================================================
+// FS / File - Host Simulation
+// Paths are mapped under sim::board().fsRoot on the host disk
+// ==========================================================
+
+namespace fs {
+
+class File : public Stream {
+private:
+    FILE *fp = nullptr;
+    std::string path;
+
+public:
+    File() {}
+    File(FILE *f, const std::string &p) : fp(f), path(p) {}
+
+    operator bool() const { return fp != nullptr; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t len) override {
+        if (!fp) return 0;
+        size_t n = fwrite(buf, 1, len, fp);
+        sim::board().stats.fsBytesWritten += n;
+        return n;
+    }
+    using Print::write;
+    int available() override {
+        if (!fp) return 0;
+        long cur = ftell(fp); fseek(fp, 0, SEEK_END); long end = ftell(fp); fseek(fp, cur, SEEK_SET);
+        return (int)(end - cur);
+    }
+    int read() override { return fp ? fgetc(fp) : -1; }
+    int read(uint8_t *buf, size_t len) { return fp ? (int)fread(buf, 1, len, fp) : -1; }
+    size_t readBytes(char *buf, size_t len) override { return fp ? fread(buf, 1, len, fp) : 0; }
+    int peek() override { if (!fp) return -1; int c = fgetc(fp); if (c >= 0) ungetc(c, fp); return c; }
+    bool seek(uint32_t pos) { return fp && fseek(fp, pos, SEEK_SET) == 0; }
+    size_t position() const { return fp ? (size_t)ftell(fp) : 0; }
+    size_t size() const {
+        if (!fp) return 0;
+        long cur = ftell(fp); fseek(fp, 0, SEEK_END); long end = ftell(fp); fseek(fp, cur, SEEK_SET);
+        return (size_t)end;
+    }
+    void flush() override { if (fp) fflush(fp); }
+    void close() { if (fp) { fclose(fp); fp = nullptr; } }
+    const char* name() const { size_t p = path.rfind('/'); return path.c_str() + (p == std::string::npos ? 0 : p + 1); }
+    const char* path_c() const { return path.c_str(); }
+};
+
+class FS {
+protected:
+    std::string host(const char *path) const { return sim::board().fsRoot + (path[0] == '/' ? "" : "/") + path; }
+
+public:
+    File open(const char *path, const char *mode = "r", bool create = false) {
+        std::string m = mode;
+        if (m == "r") m = "rb"; else if (m == "w") m = "wb"; else if (m == "a") m = "ab";
+        else if (m == "r+") m = "r+b"; else if (m == "w+") m = "w+b"; else if (m == "a+") m = "a+b";
+        FILE *f = fopen(host(path).c_str(), m.c_str());
+        if (f) sim::board().stats.fsOpens++;
+        return File(f, path);
+    }
+    File open(const String &path, const char *mode = "r", bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char *path) { struct stat st; return stat(host(path).c_str(), &st) == 0; }
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path) { return ::remove(host(path).c_str()) == 0; }
+    bool rename(const char *from, const char *to) { return ::rename(host(from).c_str(), host(to).c_str()) == 0; }
+    bool mkdir(const char *path) { return ::mkdir(host(path).c_str(), 0755) == 0; }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,35 @@
+#pragma once
+#include <sys/stat.h>
+#include <ftw.h>
+#include "FS.h"
+
+// ==========================================================
+// LittleFS - Host Simulation (directory-backed)
+// ==========================================================
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+    bool begin(bool formatOnFail = false) {
+        ::mkdir(sim::board().fsRoot.c_str(), 0755);
+        struct stat st;
+        return stat(sim::board().fsRoot.c_str(), &st) == 0;
+    }
+    void end() {}
+    size_t totalBytes() { return 1536 * 1024; }
+    // Sum of file sizes under the sim root
+    size_t usedBytes() {
+        static size_t used;
+        used = 0;
+        nftw(sim::board().fsRoot.c_str(), [](const char *, const struct stat *st, int type, struct FTW *) {
+            if (type == FTW_F) used += st->st_size;
+            return 0;
+        }, 8, FTW_PHYS);
+        return used;
+    }
+};
+
+} // namespace fs
+
+inline fs::LittleFSFS LittleFS;
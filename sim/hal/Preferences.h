@@ -0,0 +1,77 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+// ==========================================================
+// Preferences (NVS) - Host Simulation
+// One in-memory blob store per namespace, shared by all handles
+// ==========================================================
+
+namespace sim {
+typedef std::map<std::string, std::vector<uint8_t>> NvsNamespace;
+inline std::map<std::string, NvsNamespace>& nvs() {
+    static std::map<std::string, NvsNamespace> store;
+    return store;
+}
+}
+
+class Preferences {
+private:
+    std::string ns;
+    bool opened = false;
+    bool readOnly = false;
+
+    const std::vector<uint8_t>* find(const char *key) const {
+        if (!opened) return nullptr;
+        auto &space = sim::nvs()[ns];
+        auto it = space.find(key);
+        return it == space.end() ? nullptr : &it->second;
+    }
+
+    size_t store(const char *key, const void *data, size_t len) {
+        if (!opened || readOnly) return 0;
+        const uint8_t *p = (const uint8_t*)data;
+        sim::nvs()[ns][key] = std::vector<uint8_t>(p, p + len);
+        sim::board().stats.prefsWrites++;
+        return len;
+    }
+
+    template<typename T> T get(const char *key, T def) const {
+        auto v = find(key);
+        if (!v || v->size() != sizeof(T)) return def;
+        T out; memcpy(&out, v->data(), sizeof(T)); return out;
+    }
+
+public:
+    bool begin(const char *name, bool ro = false) { ns = name; opened = true; readOnly = ro; return true; }
+    void end() { opened = false; }
+    bool clear() { if (!opened || readOnly) return false; sim::nvs()[ns].clear(); return true; }
+    bool remove(const char *key) { if (!opened || readOnly) return false; return sim::nvs()[ns].erase(key) > 0; }
+    bool isKey(const char *key) { return find(key) != nullptr; }
+
+    size_t putInt(const char *key, int32_t v) { return store(key, &v, sizeof(v)); }
+    size_t putUInt(const char *key, uint32_t v) { return store(key, &v, sizeof(v)); }
+    size_t putBool(const char *key, bool v) { uint8_t b = v; return store(key, &b, 1); }
+    size_t putFloat(const char *key, float v) { return store(key, &v, sizeof(v)); }
+    size_t putString(const char *key, const String &v) { return store(key, v.c_str(), v.length()); }
+    size_t putString(const char *key, const char *v) { return store(key, v, strlen(v)); }
+    size_t putBytes(const char *key, const void *v, size_t len) { return store(key, v, len); }
+
+    int32_t getInt(const char *key, int32_t def = 0) { return get<int32_t>(key, def); }
+    uint32_t getUInt(const char *key, uint32_t def = 0) { return get<uint32_t>(key, def); }
+    bool getBool(const char *key, bool def = false) { return get<uint8_t>(key, def) != 0; }
+    float getFloat(const char *key, float def = 0) { return get<float>(key, def); }
+    String getString(const char *key, const String def = String()) {
+        auto v = find(key);
+        return v ? String(std::string(v->begin(), v->end())) : def;
+    }
+    size_t getBytesLength(const char *key) { auto v = find(key); return v ? v->size() : 0; }
+    size_t getBytes(const char *key, void *buf, size_t maxLen) {
+        auto v = find(key);
+        if (!v) return 0;
+        size_t n = std::min(maxLen, v->size());
+        memcpy(buf, v->data(), n); return n;
+    }
+};
@@ -0,0 +1,189 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "Arduino.h"
+#include "WiFi.h"
+
+// ==========================================================
+// PubSubClient - Host Simulation
+// Server "sim": an in-process broker that hands every publish
+// to sim::broker().onMessage (down while WiFi is, or when
+// broker().up is false).
+// Any other host: a real MQTT 3.1.1 connection (QoS 0), e.g.
+//   mosquitto -p 1883 -v  &  rosemary_sim --mqtt 127.0.0.1
+// Keepalive pings follow host time, since a broker times out
+// in real seconds.
+// ==========================================================
+
+#define MQTT_CONNECTED          0
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECT_FAILED     -2
+#define MQTT_DISCONNECTED       -1
+
+namespace sim {
+
+struct MqttMessage {
+    std::string topic;
+    std::string payload;
+};
+
+struct MqttBroker {
+    bool up = true;
+    unsigned long connects = 0;
+    std::function<void(const MqttMessage&)> onMessage;
+};
+
+inline MqttBroker& broker() {
+    static MqttBroker b;
+    return b;
+}
+
+} // namespace sim
+
+class PubSubClient {
+private:
+    std::string host;
+    uint16_t port = 1883;
+    uint16_t bufSize = 256;
+    uint16_t keepAlive = 15;
+    int fd = -1;
+    bool simConnected = false;
+    int st = MQTT_DISCONNECTED;
+    std::chrono::steady_clock::time_point lastOut;
+
+    bool local() const { return host == "sim"; }
+
+public:
+    PubSubClient(Client &c) {}
+    ~PubSubClient() { disconnect(); }
+
+    PubSubClient& setServer(const char *h, uint16_t p) { host = h; port = p; return *this; }
+    bool setBufferSize(uint16_t n) { bufSize = n; return true; }
+    PubSubClient& setKeepAlive(uint16_t s) { keepAlive = s; return *this; }
+    PubSubClient& setSocketTimeout(uint16_t s) { return *this; }
+    int state() { return st; }
+
+    bool connect(const char *id) { return connect(id, nullptr, nullptr); }
+    bool connect(const char *id, const char *user, const char *pass) {
+        disconnect();
+        if (WiFi.status() != WL_CONNECTED) { st = MQTT_CONNECT_FAILED; return false; }
+        if (local()) {
+            simConnected = sim::broker().up;
+            if (simConnected) sim::broker().connects++;
+            st = simConnected ? MQTT_CONNECTED : MQTT_CONNECTION_TIMEOUT;
+            return simConnected;
+        }
+        if (!openSocket()) { st = MQTT_CONNECTION_TIMEOUT; return false; }
+
+        // CONNECT: clean session, optional user/password
+        std::string vh("\x00\x04MQTT\x04", 7);
+        uint8_t flags = 0x02 | (user && *user ? 0x80 : 0) | (pass && *pass ? 0x40 : 0);
+        vh += (char)flags; vh += (char)(keepAlive >> 8); vh += (char)keepAlive;
+        appendStr(vh, id);
+        if (user && *user) appendStr(vh, user);
+        if (pass && *pass) appendStr(vh, pass);
+        uint8_t ack[4];
+        if (!sendPacket(0x10, vh) || !recvAll(ack, 4) || ack[0] != 0x20 || ack[3] != 0) {
+            closeSocket(); st = MQTT_CONNECT_FAILED; return false;
+        }
+        st = MQTT_CONNECTED;
+        return true;
+    }
+
+    bool connected() {
+        if (WiFi.status() != WL_CONNECTED) { disconnect(); return false; }
+        if (local()) { if (!sim::broker().up) simConnected = false; return simConnected; }
+        return fd >= 0;
+    }
+
+    bool publish(const char *topic, const uint8_t *payload, unsigned int len, bool retained = false) {
+        if (!connected()) return false;
+        if (len + strlen(topic) + 7 > bufSize) return false;   // As the real client: packet must fit the buffer
+        if (local()) {
+            if (sim::broker().onMessage) sim::broker().onMessage({ topic, std::string((const char*)payload, len) });
+            return true;
+        }
+        std::string body;
+        appendStr(body, topic);
+        body.append((const char*)payload, len);
+        if (!sendPacket(retained ? 0x31 : 0x30, body)) { closeSocket(); return false; }
+        return true;
+    }
+
+    bool loop() {
+        if (!connected()) return false;
+        if (local()) return true;
+        // Drain PINGRESP and anything else the broker sends
+        uint8_t junk[256];
+        ssize_t n = recv(fd, junk, sizeof(junk), MSG_DONTWAIT);
+        if (n == 0) { closeSocket(); return false; }
+        if (std::chrono::steady_clock::now() - lastOut > std::chrono::seconds(keepAlive / 2)) {
+            if (!sendPacket(0xC0, std::string())) { closeSocket(); return false; }
+        }
+        return true;
+    }
+
+    void disconnect() {
+        if (fd >= 0) { sendPacket(0xE0, std::string()); closeSocket(); }
+        simConnected = false;
+        st = MQTT_DISCONNECTED;
+    }
+
+private:
+    static void appendStr(std::string &out, const char *s) {
+        size_t n = strlen(s);
+        out += (char)(n >> 8); out += (char)n; out.append(s, n);
+    }
+
+    bool openSocket() {
+        char portStr[8];
+        snprintf(portStr, sizeof(portStr), "%u", (unsigned)port);
+        addrinfo hints{}, *res = nullptr;
+        hints.ai_family = AF_UNSPEC; hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host.c_str(), portStr, &hints, &res) != 0) return false;
+        for (addrinfo *a = res; a && fd < 0; a = a->ai_next) {
+            fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0) { close(fd); fd = -1; }
+        }
+        freeaddrinfo(res);
+        if (fd < 0) return false;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return true;
+    }
+
+    void closeSocket() { if (fd >= 0) { close(fd); fd = -1; } st = MQTT_DISCONNECTED; }
+
+    bool sendPacket(uint8_t type, const std::string &body) {
+        std::string pkt(1, (char)type);
+        size_t rem = body.size();
+        do { uint8_t b = rem & 0x7F; rem >>= 7; pkt += (char)(rem ? b | 0x80 : b); } while (rem);
+        pkt += body;
+        size_t off = 0;
+        while (off < pkt.size()) {
+            ssize_t n = send(fd, pkt.data() + off, pkt.size() - off, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            off += n;
+        }
+        lastOut = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool recvAll(uint8_t *buf, size_t len) {
+        size_t off = 0;
+        while (off < len) {
+            ssize_t n = recv(fd, buf + off, len - off, 0);
+            if (n <= 0) return false;
+            off += n;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include "Arduino.h"
+
+// ==========================================================
+// WiFi - Host Simulation
+// STA "connects" immediately; AP mode reports disconnected.
+// simSetLinkDown() models an outage: reconnects fail until
+// the link is back.
+// ==========================================================
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 } wl_status_t;
+typedef enum { WIFI_AUTH_OPEN = 0, WIFI_AUTH_WPA2_PSK = 3 } wifi_auth_mode_t;
+
+class IPAddress {
+private:
+    uint8_t b[4];
+
+public:
+    IPAddress(uint8_t a = 0, uint8_t c = 0, uint8_t d = 0, uint8_t e = 0) { b[0] = a; b[1] = c; b[2] = d; b[3] = e; }
+    String toString() const {
+        char buf[16]; snprintf(buf, sizeof(buf), "%u.%u.%u.%u", b[0], b[1], b[2], b[3]); return String(buf);
+    }
+};
+
+// Sockets live in the PubSubClient stub; this is just the handle
+class Client {};
+class WiFiClient : public Client {};
+
+class WiFiClass {
+private:
+    wifi_mode_t m = WIFI_OFF;
+    String ssid;
+    bool connected = false;
+    bool linkDown = false;
+    int scanned = -2;          // scanComplete(): -2 = no scan yet
+
+public:
+    bool mode(wifi_mode_t mode) { m = mode; return true; }
+    wifi_mode_t getMode() { return m; }
+    wl_status_t begin(const char *s, const char *pass = nullptr) { ssid = s; connected = !linkDown; return status(); }
+    wl_status_t status() { return connected ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool disconnect(bool wifiOff = false) { connected = false; return true; }
+    bool reconnect() { connected = ssid.length() > 0 && !linkDown; return true; }
+    String SSID() { return ssid; }
+    // Every 4th network has quotes and a backslash in its name (escaping)
+    String SSID(int i) { return i >= scanned ? String() : (i % 4 == 3 ? String("Cafe \"Guest\\") + String(i) : String("SimNet_") + String(i)); }
+    int32_t RSSI() { return connected ? -55 : 0; }
+    IPAddress localIP() { return connected ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+    bool softAP(const char *s, const char *pass = nullptr) { m = WIFI_AP; return true; }
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    uint8_t* macAddress(uint8_t *mac) { static const uint8_t m[6] = { 0x24, 0x6F, 0x28, 0x51, 0x7A, 0x0C }; memcpy(mac, m, 6); return mac; }
+    // A scan completes at once with simScanCount networks
+    int16_t scanNetworks(bool async = false) { scanned = simScanCount; return scanned; }
+    int16_t scanComplete() { return scanned; }
+    void scanDelete() { scanned = -2; }
+    wifi_auth_mode_t encryptionType(int i) { return i ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN; }
+    int simScanCount = 2;      // Sim-only: networks per scan
+    // Sim-only: drop / restore the link
+    void simSetConnected(bool c) { connected = c; }
+    void simSetLinkDown(bool down) { linkDown = down; if (down) connected = false; }
+};
+
+inline WiFiClass WiFi;
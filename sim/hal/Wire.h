@@ -0,0 +1,77 @@
+#pragma once
+#include <map>
+#include "Arduino.h"
+
+// ==========================================================
+// Rosemary Core - Wire (I2C) HAL (Host Simulation)
+// Transactions go to sim::I2cDevice models by address; bus
+// time (9 clocks per byte) is charged to the virtual clock.
+// ==========================================================
+
+namespace sim {
+
+class I2cDevice {
+public:
+    virtual ~I2cDevice() {}
+    virtual void onWrite(const uint8_t *data, size_t n) = 0;    // One transmission
+    virtual size_t onRead(uint8_t *data, size_t n) = 0;
+};
+
+inline std::map<uint8_t, I2cDevice*>& i2cBus() {
+    static std::map<uint8_t, I2cDevice*> devices;
+    return devices;
+}
+
+} // namespace sim
+
+class TwoWire {
+private:
+    uint32_t freq = 100000;
+    uint8_t txAddr = 0;
+    uint8_t txBuf[32];
+    size_t txLen = 0;
+    uint8_t rxBuf[32];
+    size_t rxLen = 0, rxPos = 0;
+
+    sim::I2cDevice* device(uint8_t addr) {
+        auto it = sim::i2cBus().find(addr);
+        return it == sim::i2cBus().end() ? nullptr : it->second;
+    }
+    // Address byte + payload, start/stop ignored
+    void charge(size_t bytes) {
+        sim::board().stats.i2cTransfers++;
+        sim::board().advanceUs((bytes + 1) * 9 * 1000000ULL / freq);
+    }
+
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 100000) { freq = frequency; return true; }
+    void setClock(uint32_t frequency) { freq = frequency; }
+
+    void beginTransmission(int addr) { txAddr = (uint8_t)addr; txLen = 0; }
+    size_t write(uint8_t b) {
+        if (txLen >= sizeof(txBuf)) return 0;
+        txBuf[txLen++] = b;
+        return 1;
+    }
+    // 0 = ok, 2 = address NACK
+    uint8_t endTransmission(bool stop = true) {
+        charge(txLen);
+        sim::I2cDevice *d = device(txAddr);
+        if (!d) return 2;
+        d->onWrite(txBuf, txLen);
+        return 0;
+    }
+
+    uint8_t requestFrom(int addr, int n) {
+        rxPos = 0; rxLen = 0;
+        if (n > (int)sizeof(rxBuf)) n = sizeof(rxBuf);
+        charge(n);
+        sim::I2cDevice *d = device((uint8_t)addr);
+        if (d) rxLen = d->onRead(rxBuf, n);
+        return (uint8_t)rxLen;
+    }
+    int available() { return (int)(rxLen - rxPos); }
+    int read() { return rxPos < rxLen ? rxBuf[rxPos++] : -1; }
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Arduino.h"
+
+// ==========================================================
+// esp_ota_ops / esp_partition - Host Simulation
+// Two app slots in RAM with the otadata states the bootloader
+// keeps when CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE is set.
+// sim::ota().restart() is the bootloader's part of a reset: a NEW
+// image comes up pending verification, one still pending is
+// aborted and the other slot boots. No image format check.
+// ==========================================================
+
+typedef int esp_err_t;
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_SIZE        0x104
+#define ESP_ERR_INVALID_STATE       0x103
+#define ESP_ERR_NOT_FOUND           0x105
+#define OTA_SIZE_UNKNOWN            0xffffffff
+#define OTA_WITH_SEQUENTIAL_WRITES  0xfffffffe
+
+#define SIM_OTA_SLOT_BYTES          0x640000     // app0 / app1 in default_16MB.csv
+
+typedef uint32_t esp_ota_handle_t;
+
+typedef enum {
+    ESP_OTA_IMG_NEW = 0,
+    ESP_OTA_IMG_PENDING_VERIFY = 1,
+    ESP_OTA_IMG_VALID = 2,
+    ESP_OTA_IMG_INVALID = 3,
+    ESP_OTA_IMG_ABORTED = 4,
+    ESP_OTA_IMG_UNDEFINED = -1,
+} esp_ota_img_states_t;
+
+struct esp_partition_t {
+    const char *label;
+    uint32_t address;
+    uint32_t size;
+};
+
+namespace sim {
+
+struct OtaSlot {
+    esp_partition_t part;
+    std::vector<uint8_t> flash;
+    esp_ota_img_states_t state = ESP_OTA_IMG_UNDEFINED;
+};
+
+class OtaFlash {
+public:
+    OtaSlot slots[2];
+    int running = 0;
+    int bootSlot = 0;
+    esp_ota_handle_t handle = 0;   // Open writer, 0 = none
+    int writing = -1;
+    uint32_t writePos = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+
+    OtaFlash() {
+        slots[0].part = { "app0", 0x10000, SIM_OTA_SLOT_BYTES };
+        slots[1].part = { "app1", 0x10000 + SIM_OTA_SLOT_BYTES, SIM_OTA_SLOT_BYTES };
+        for (auto &s : slots) s.flash.assign(SIM_OTA_SLOT_BYTES, 0xFF);
+    }
+
+    int slotOf(const esp_partition_t *p) {
+        for (int i = 0; i < 2; i++) if (p == &slots[i].part) return i;
+        return -1;
+    }
+
+    // As a USB flash: the image in the running slot, erased after it
+    void flashImage(const std::vector<uint8_t> &image) {
+        std::vector<uint8_t> &f = slots[running].flash;
+        std::fill(f.begin(), f.end(), 0xFF);
+        std::copy(image.begin(), image.begin() + std::min(image.size(), f.size()), f.begin());
+    }
+
+    // Reset: the bootloader picks the slot
+    void restart() {
+        OtaSlot &b = slots[bootSlot];
+        if (b.state == ESP_OTA_IMG_PENDING_VERIFY) { b.state = ESP_OTA_IMG_ABORTED; bootSlot = 1 - bootSlot; }
+        else if (b.state == ESP_OTA_IMG_NEW) b.state = ESP_OTA_IMG_PENDING_VERIFY;
+        running = bootSlot;
+        handle = 0; writing = -1;
+    }
+};
+
+inline OtaFlash& ota() {
+    static OtaFlash f;
+    return f;
+}
+
+} // namespace sim
+
+inline const esp_partition_t* esp_ota_get_running_partition() { return &sim::ota().slots[sim::ota().running].part; }
+
+inline const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t *start) {
+    return &sim::ota().slots[1 - sim::ota().running].part;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t *p, size_t offset, void *dst, size_t size) {
+    int s = sim::ota().slotOf(p);
+    if (s < 0 || offset + size > p->size) return ESP_ERR_INVALID_ARG;
+    memcpy(dst, sim::ota().slots[s].flash.data() + offset, size);
+    sim::ota().bytesRead += size;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ota_begin(const esp_partition_t *p, size_t size, esp_ota_handle_t *out) {
+    sim::OtaFlash &f = sim::ota();
+    int s = f.slotOf(p);
+    if (s < 0 || s == f.running) return ESP_ERR_INVALID_ARG;
+    bool sized = size != OTA_SIZE_UNKNOWN && size != OTA_WITH_SEQUENTIAL_WRITES;
+    if (sized && size > p->size) return ESP_ERR_INVALID_SIZE;
+    std::fill(f.slots[s].flash.begin(), f.slots[s].flash.end(), 0xFF);
+    f.slots[s].state = ESP_OTA_IMG_UNDEFINED;
+    f.writing = s; f.writePos = 0;
+    *out = ++f.handle;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ota_write(esp_ota_handle_t h, const void *data, size_t size) {
+    sim::OtaFlash &f = sim::ota();
+    if (!h || h != f.handle || f.writing < 0) return ESP_ERR_INVALID_ARG;
+    if (f.writePos + size > SIM_OTA_SLOT_BYTES) return ESP_ERR_INVALID_SIZE;
+    memcpy(f.slots[f.writing].flash.data() + f.writePos, data, size);
+    f.writePos += size;
+    f.bytesWritten += size;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ota_end(esp_ota_handle_t h) {
+    sim::OtaFlash &f = sim::ota();
+    if (!h || h != f.handle || f.writing < 0) return ESP_ERR_NOT_FOUND;
+    f.writing = -1;
+    return f.writePos ? ESP_OK : ESP_FAIL;
+}
+
+inline esp_err_t esp_ota_abort(esp_ota_handle_t h) {
+    sim::OtaFlash &f = sim::ota();
+    if (!h || h != f.handle) return ESP_ERR_NOT_FOUND;
+    f.writing = -1;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ota_set_boot_partition(const esp_partition_t *p) {
+    sim::OtaFlash &f = sim::ota();
+    int s = f.slotOf(p);
+    if (s < 0) return ESP_ERR_INVALID_ARG;
+    f.bootSlot = s;
+    if (s != f.running) f.slots[s].state = ESP_OTA_IMG_NEW;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ota_get_state_partition(const esp_partition_t *p, esp_ota_img_states_t *state) {
+    int s = sim::ota().slotOf(p);
+    if (s < 0) return ESP_ERR_INVALID_ARG;
+    *state = sim::ota().slots[s].state;
+    return ESP_OK;
+}
+
+inline esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+    sim::ota().slots[sim::ota().running].state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+// The device resets here; the sim flags it and returns
+inline esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot() {
+    sim::OtaFlash &f = sim::ota();
+    f.slots[f.running].state = ESP_OTA_IMG_INVALID;
+    f.bootSlot = 1 - f.running;
+    sim::board().rebootRequested = true;
+    return ESP_OK;
+}
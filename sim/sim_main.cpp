@@ -0,0 +1,272 @@
+// ==========================================================
+// Rosemary Core - Host Simulation Runner
+// Runs the real setup()/loop() from src/main.cpp against a
+// virtual clock, simulated ADC pins and a soil model, then
+// runs each feature's post-run checks (checks/*.h).
+//
+//   ./rosemary_sim --days 14 --tick-ms 10 --zones 4
+//   (zone front end: make LAYOUT=direct|mux|i2c)
+//   ./rosemary_sim --days 2 --mqtt sim --wifi-outage 20:6
+//   ./rosemary_sim --days 3 --sensor-fault 1:stuck:24   (stuck|noisy|step)
+//   ./rosemary_sim --days 1 --www build/fsimage   (make www)
+//   ./rosemary_sim --days 0.01 --ota old.bin:update.delta:new.bin   (make ota-check)
+// Exits 1 if any post-run check fails (listed on the last line).
+// ==========================================================
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include "SimBoard.h"
+#include "SimHeap.h"
+#include "SoilModel.h"
+#include "SimDevices.h"
+#include "TelemetryDecoder.h"
+#include "checks/SimRun.h"
+#include "checks/TasksCheck.h"
+#include "checks/HealthCheck.h"
+#include "checks/TelemetryCheck.h"
+#include "checks/MetricsCheck.h"
+#include "checks/DhtCheck.h"
+#include "checks/ConfigCheck.h"
+#include "checks/AssetsCheck.h"
+#include "checks/TraceCheck.h"
+#include "checks/BatchCheck.h"
+#include "checks/OtaCheck.h"
+#include "checks/MemoryCheck.h"
+
+static void usage() {
+    printf("usage: rosemary_sim [--days N] [--tick-ms N] [--zones N] [--seed N]\n"
+           "                    [--disconnect ZONE] [--sensor-fault ZONE:stuck|noisy|step:START_H]\n"
+           "                    [--fs DIR] [--dump URL] [--verbose]\n"
+           "                    [--clients N] [--poll-ms N] [--sse N]\n"
+           "                    [--mqtt sim|HOST[:PORT]] [--wifi-outage START_H:HOURS]\n"
+           "                    [--www IMAGE_DIR] [--dht-errors P] [--dht-outage START_H:HOURS]\n"
+           "                    [--ota OLD.bin:DELTA:NEW.bin]\n");
+}
+
+static bool parseArgs(int argc, char **argv, SimOptions &o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasVal = i + 1 < argc;
+        if (a == "--days" && hasVal) o.days = atof(argv[++i]);
+        else if (a == "--tick-ms" && hasVal) o.tickMs = std::max(1, atoi(argv[++i]));
+        else if (a == "--zones" && hasVal) o.zones = atoi(argv[++i]);
+        else if (a == "--seed" && hasVal) o.seed = (unsigned)atoi(argv[++i]);
+        else if (a == "--disconnect" && hasVal) o.disconnect = atoi(argv[++i]);
+        else if (a == "--fs" && hasVal) o.fsRoot = argv[++i];
+        else if (a == "--dump" && hasVal) o.dumpUrl = argv[++i];
+        else if (a == "--clients" && hasVal) o.clients = atoi(argv[++i]);
+        else if (a == "--poll-ms" && hasVal) o.pollMs = std::max(1, atoi(argv[++i]));
+        else if (a == "--sse" && hasVal) o.sseClients = atoi(argv[++i]);
+        else if (a == "--mqtt" && hasVal) o.mqtt = argv[++i];
+        else if (a == "--www" && hasVal) o.www = argv[++i];
+        else if (a == "--dht-errors" && hasVal) o.dhtErrors = atof(argv[++i]);
+        else if (a == "--dht-outage" && hasVal) {
+            if (sscanf(argv[++i], "%lf:%lf", &o.dhtOutageStartH, &o.dhtOutageHours) != 2) { usage(); return false; }
+        }
+        else if (a == "--sensor-fault" && hasVal) {
+            char kind[16];
+            if (sscanf(argv[++i], "%d:%15[a-z]:%lf", &o.faultZone, kind, &o.faultStartH) != 3) { usage(); return false; }
+            std::string k = kind;
+            o.fault = k == "stuck" ? sim::FAULT_STUCK : k == "noisy" ? sim::FAULT_NOISY : k == "step" ? sim::FAULT_STEP : sim::FAULT_NONE;
+            if (o.fault == sim::FAULT_NONE) { usage(); return false; }
+        }
+        else if (a == "--ota" && hasVal) {
+            std::stringstream in(argv[++i]);
+            if (!std::getline(in, o.otaOld, ':') || !std::getline(in, o.otaDelta, ':') || !std::getline(in, o.otaNew)) { usage(); return false; }
+        }
+        else if (a == "--wifi-outage" && hasVal) {
+            if (sscanf(argv[++i], "%lf:%lf", &o.outageStartH, &o.outageHours) != 2) { usage(); return false; }
+        }
+        else if (a == "--verbose") o.verbose = true;
+        else { usage(); return false; }
+    }
+    return true;
+}
+
+// Loop cost histogram (host time, microseconds)
+struct CostStats {
+    std::vector<uint32_t> buckets = std::vector<uint32_t>(100001, 0); // 0.1 us .. 10 ms
+    uint64_t count = 0;
+    double totalUs = 0, maxUs = 0;
+
+    void add(double us) {
+        count++; totalUs += us; if (us > maxUs) maxUs = us;
+        size_t b = (size_t)(us * 10.0);
+        buckets[std::min(b, buckets.size() - 1)]++;
+    }
+    double percentile(double p) const {
+        uint64_t target = (uint64_t)(p * count), seen = 0;
+        for (size_t i = 0; i < buckets.size(); i++) { seen += buckets[i]; if (seen > target) return i / 10.0; }
+        return maxUs;
+    }
+};
+
+int main(int argc, char **argv) {
+    SimRun run;
+    SimOptions &opt = run.opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+
+    sim::Board &board = run.board;
+    sim::SoilModel &world = run.world;
+    board.fsRoot = opt.fsRoot;
+    board.quiet = !opt.verbose;
+    world.rng.seed(opt.seed);
+    randomSeed(opt.seed);
+
+    sim::attachZones(board, world);
+    sim::attachDht(board);
+    world.climate.dhtErrorRate = opt.dhtErrors;
+    for (size_t i = 0; i < world.zones.size(); i++) {
+        sim::SoilZone &z = world.zones[i];
+        z.theta = 0.22 + 0.03 * (i % 4);
+        z.connected = ((int)i != opt.disconnect);
+        if ((int)i == opt.faultZone) { z.fault = opt.fault; z.faultAtSec = opt.faultStartH * 3600.0; }
+    }
+
+    TasksCheck tasksCheck;
+    HealthCheck healthCheck;
+    TelemetryCheck telemetryCheck;
+    MetricsCheck metricsCheck;
+    DhtCheck dhtCheck;
+    ConfigCheck configCheck;
+    AssetsCheck assetsCheck;
+    TraceCheck traceCheck;
+    BatchCheck batchCheck;
+    OtaCheck otaCheck;
+    MemoryCheck memoryCheck;
+    telemetryCheck.begin(run);
+    healthCheck.begin(run);
+    if (!assetsCheck.begin(run) || !otaCheck.begin(run)) return 2;
+
+    setup();
+
+    // Fresh filesystem: seed one plant per simulated zone
+    if (plantManager.getPlants().empty()) {
+        for (int i = 0; i < opt.zones && i < MAX_PLANTS; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "Zone %d", i);
+            plantManager.addPlant(name, "general", 40);
+        }
+    }
+
+    uint64_t endMs = board.nowMs() + (uint64_t)(opt.days * 86400000.0);
+    CostStats cost;
+
+    // Polling dashboards: each keeps the last ETag and revalidates
+    struct Client { std::string etag; uint64_t nextMs; };
+    std::vector<Client> clients;
+    for (int i = 0; i < opt.clients; i++) clients.push_back({"", board.nowMs() + (uint64_t)i * opt.pollMs / std::max(opt.clients, 1)});
+    uint64_t http200 = 0, http304 = 0, httpOther = 0, httpBytes = 0;
+
+    // Stream clients: one initial /api/data load, then events only
+    loop();
+    for (int i = 0; i < opt.sseClients; i++) {
+        sim::http(HTTP_GET, "/api/events");
+        SimResponse r = sim::http(HTTP_GET, "/api/data");
+        if (r.code == 200) { http200++; httpBytes += r.body.size(); }
+        else httpOther++;
+    }
+    auto wallStart = std::chrono::steady_clock::now();
+
+    while (board.nowMs() < endMs && !board.rebootRequested) {
+        telemetryCheck.tick(run);
+        dhtCheck.tick(run);
+        healthCheck.tick(run);
+        auto t0 = std::chrono::steady_clock::now();
+        loop();
+        auto t1 = std::chrono::steady_clock::now();
+        cost.add(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        tasksCheck.tick(run);
+
+        for (auto &c : clients) {
+            if (board.nowMs() < c.nextMs) continue;
+            c.nextMs += opt.pollMs;
+            std::vector<std::pair<String, String>> hdr;
+            if (!c.etag.empty()) hdr.push_back({"If-None-Match", c.etag.c_str()});
+            SimResponse r = sim::http(HTTP_GET, "/api/data", "", hdr);
+            if (r.code == 200) { http200++; httpBytes += r.body.size(); c.etag = r.headers["ETag"]; }
+            else if (r.code == 304) http304++;
+            else httpOther++;
+        }
+        board.advanceMs(opt.tickMs);
+    }
+
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simDays = board.nowMs() / 86400000.0;
+
+    if (opt.dumpUrl) {
+        SimResponse r = sim::http(HTTP_GET, opt.dumpUrl);
+        std::string body = r.body;
+        if (r.contentType == "application/cbor") {
+            sim::CborReader rd((const uint8_t*)r.body.data(), r.body.size());
+            sim::CborItem root;
+            body.clear();
+            if (rd.read(root)) sim::cborDiagnostic(root, body);
+            else body = "(invalid CBOR)";
+            char note[48];
+            snprintf(note, sizeof(note), "\n(%zu bytes CBOR)", r.body.size());
+            body += note;
+        }
+        printf("GET %s -> %d %s\n%s\n\n", opt.dumpUrl, r.code, r.contentType.c_str(), body.c_str());
+    }
+
+    printf("=== Rosemary Core Simulation ===\n");
+    printf("Simulated : %.2f days in %.2f s wall (%.0fx real time)\n", simDays, wallSec, simDays * 86400.0 / std::max(wallSec, 1e-9));
+    printf("Loop calls: %llu (tick %u ms)\n", (unsigned long long)cost.count, opt.tickMs);
+    printf("Loop cost : mean %.2f us | p50 %.1f us | p99 %.1f us | max %.1f us (host)\n",
+           cost.totalUs / std::max<uint64_t>(cost.count, 1), cost.percentile(0.50), cost.percentile(0.99), cost.maxUs);
+    printf("HAL calls : analogRead %llu | digitalWrite %llu | i2c %llu | delay %llu (%llu ms) | fs open %llu | fs write %llu B | nvs write %llu\n",
+           (unsigned long long)board.stats.analogReads, (unsigned long long)board.stats.digitalWrites,
+           (unsigned long long)board.stats.i2cTransfers,
+           (unsigned long long)board.stats.delayCalls, (unsigned long long)board.stats.delayMs,
+           (unsigned long long)board.stats.fsOpens, (unsigned long long)board.stats.fsBytesWritten,
+           (unsigned long long)board.stats.prefsWrites);
+    printf("Scan      : %d zones on %d lane(s) |", (int)world.zones.size(), adcSampler.getLaneCount());
+    for (int i = 0; i < adcSampler.getLaneCount(); i++) printf(" %dx%d", adcSampler.getLane(i).zones, adcSampler.getLane(i).samples);
+    printf(" samples | refresh max %lu ms (burst every %d ms)\n", adcSampler.getMaxRefreshMs(), ADC_BURST_MS);
+    tasksCheck.report(run);
+    WaterController &water = plantManager.getWater();
+    printf("Watering  : %lu early stops (%.0f s pump time saved) | %lu model updates | overshoot mean %.1f %% max %.1f %% | %lu focus bursts\n",
+           water.getEarlyStops(), water.getSavedMs() / 1000.0, water.getLearnCount(),
+           water.getOvershootMean() / 1000.0, water.getOvershootMax() / 1000.0, adcSampler.getFocusBurstCount());
+    healthCheck.report(run);
+    telemetryCheck.report(run);
+    metricsCheck.report(run);
+    dhtCheck.report(run);
+    configCheck.report(run);
+    assetsCheck.report(run);
+    traceCheck.report(run);
+    if (opt.sseClients > 0) {
+        uint64_t ev = 0, evBytes = 0;
+        for (auto srv : AsyncWebServer::instances()) srv->simEventTotals(ev, evBytes);
+        printf("SSE push  : %llu events (%llu B) to %d clients\n", (unsigned long long)ev, (unsigned long long)evBytes, opt.sseClients);
+    }
+    if (opt.clients > 0 || opt.sseClients > 0) {
+        printf("API polls : %llu x 200 (%llu B) | %llu x 304 | %llu other\n",
+               (unsigned long long)http200, (unsigned long long)httpBytes,
+               (unsigned long long)http304, (unsigned long long)httpOther);
+    }
+    printf("\nZone | Sensor | Pump starts | Pump time | Min %% | Max %% | Below threshold | Model gain / soak\n");
+    for (size_t i = 0; i < world.zones.size(); i++) {
+        const sim::SoilZone &z = world.zones[i];
+        const Plant *p = plantManager.getPlants().byZone(i);
+        printf("%4zu | %-6s | %11lu | %7.0f s | %5.1f | %5.1f | %13.1f h | %.2f %%/s / %.1f s\n", i, z.connected ? "ok" : "open",
+               z.stats.pumpStarts, z.stats.pumpOnSec, z.stats.minPct, z.stats.maxPct, z.stats.secBelowThreshold / 3600.0,
+               p ? p->waterGain / 1000.0 : 0.0, p ? p->soakMs / 1000.0 : 0.0);
+    }
+    batchCheck.report(run);
+    otaCheck.report(run);
+    memoryCheck.report(run);    // Last: deletes plants
+
+    if (!run.failed.empty()) {
+        printf("\nFAILED    :");
+        for (size_t i = 0; i < run.failed.size(); i++) printf(" %s%s", run.failed[i].c_str(), i + 1 < run.failed.size() ? " |" : "\n");
+        return 1;
+    }
+    return 0;
+}
@@ -8,21 +8,223 @@
 
 // --- HARDWARE PIN MAPPING (ESP32-S3 N16R8) ---
 #define PIN_BUZZER          10
-#define PIN_DHT             9
-#define DHT_TYPE            DHT22
+#define PIN_DHT             9        // DHT22 / AM2302 data, see Drivers/Dht22.h
 
+// --- ZONE LAYOUT (build flag: -DZONE_LAYOUT=...) ---
+// DIRECT: 4 zones on ESP32 ADC pins, pumps on LEDC PWM
+// MUX   : 74HC4067 muxes on the ADC pins, pumps on chained 74HC595s
+// I2C   : ADS1115 ADCs + MCP23017 expander for the pumps
+#define ZONE_LAYOUT_DIRECT  0
+#define ZONE_LAYOUT_MUX     1
+#define ZONE_LAYOUT_I2C     2
+#ifndef ZONE_LAYOUT
+#define ZONE_LAYOUT         ZONE_LAYOUT_DIRECT
+#endif
+
+#if ZONE_LAYOUT == ZONE_LAYOUT_MUX
+#define MUX_COUNT           4
+const int PINS_MUX_SELECT[4] = { 15, 16, 17, 18 };   // S0..S3, shared
+const int PINS_MUX_COMMON[MUX_COUNT] = { 4, 5, 6, 7 };
+#define PIN_SR_DATA         11
+#define PIN_SR_CLOCK        12
+#define PIN_SR_LATCH        13
+#define SR_CHIPS            (MUX_COUNT * 2)          // 8 pumps per 74HC595
+#define PUMP_EXT_MA         350                      // Per pump, all alike
+#define MAX_PLANTS          (MUX_COUNT * 16)
+#elif ZONE_LAYOUT == ZONE_LAYOUT_I2C
+#define PIN_I2C_SDA         17
+#define PIN_I2C_SCL         18
+#define I2C_FREQ            400000
+#define ADS_COUNT           4
+const uint8_t ADS_ADDR[ADS_COUNT] = { 0x48, 0x49, 0x4A, 0x4B };
+#define MCP_ADDR            0x20
+#define PUMP_EXT_MA         350
+#define MAX_PLANTS          (ADS_COUNT * 4)
+#else
 // Sensor Inputs (Analog Only)
 const int PINS_SENSOR[4] = { 4, 5, 6, 7 }; 
 
 // Pump Outputs (Active HIGH)
 const int PINS_PUMP[4]   = { 11, 12, 13, 14 };
 
-// --- SYSTEM LIMITS & TIMERS ---
+// Pump steady-state current (mA), used by the supply budget
+const int PUMP_CURRENT_MA[4] = { 350, 350, 350, 350 };
 #define MAX_PLANTS          4
+#endif
+
+// --- SYSTEM LIMITS & TIMERS ---
+#define PLANT_NAME_LEN      48       // Incl. terminator
+#define PLANT_AI_LEN        64
+#define PLANT_LISTENERS     2        // Plant event hooks (SSE, telemetry)
 #define WIFI_CHECK_MS       30000
-#define HISTORY_LOG_MS      3600000  // 1 Hour
+#define WIFI_LINK_POLL_MS   250      // Station link down: how soon its return is noticed
+#define AP_DNS_POLL_MS      20       // Setup AP: captive-portal DNS poll
 #define ENV_UPDATE_MS       2000     // 2 Seconds
 #define AUTO_WATER_COOLDOWN 60000    // 1 Minute per plant
+#define DHT_START_MS        2        // Host start pulse (>= 1 ms); the env task sleeps through it
+#define DHT_FRAME_US        8000     // Response + 40 bits take ~5 ms
+#define DHT_RETRY_MS        1000     // Next attempt after a timeout or bad frame
+#define DHT_STALE_MS        10000    // No valid frame this long: env reads as invalid
+
+// --- TASKS (FreeRTOS, pinned) ---
+// Tick = step interval while a task has work in progress; idle
+// tasks sleep until their next deadline or a wake (Core/Tasks.h)
+#define CONTROL_TICK_MS     5        // Pump timing resolution = stop jitter bound
+#define SENSE_TICK_MS       5
+#define NET_TICK_MS         10
+#define ENV_TICK_MS         100      // Starts / collects DHT frames: own task, below sensing
+#define MQTT_TICK_MS        20
+#define TASK_IDLE_MAX_MS    1000     // Longest sleep without a deadline (bounds a lost wake)
+#define TASK_CORE_CONTROL   1        // App core: control + sensing
+#define TASK_CORE_SENSE     1
+#define TASK_CORE_ENV       1
+#define TASK_CORE_NET       0        // Protocol core, next to the WiFi stack
+#define TASK_CORE_MQTT      0
+#define TASK_PRIO_CONTROL   5
+#define TASK_PRIO_SENSE     3
+#define TASK_PRIO_NET       2
+#define TASK_PRIO_ENV       1
+#define TASK_PRIO_MQTT      1        // Below network: a stalled socket only delays telemetry
+
+// --- POWER (esp_pm; needs CONFIG_PM_ENABLE + tickless idle in sdkconfig) ---
+#define POWER_LIGHT_SLEEP   1        // Light-sleep idle gaps while in STA mode
+#define POWER_CPU_MAX_MHZ   240
+#define POWER_CPU_MIN_MHZ   80       // Frequency scaling floor (pinned to max with ROSEMARY_TRACE)
+
+// --- PUMP SCHEDULER ---
+#define PUMP_SUPPLY_MA      800      // Total current available to pumps
+#define PUMP_SOFTSTART_MS   300      // LEDC duty ramp; one pump ramps at a time
+#define PUMP_PWM_FREQ       20000    // Above audible range
+#define PUMP_PWM_BITS       8
+#define PUMP_DUTY_MIN       64       // Ramp start (below this the motor stalls)
+#define PUMP_DUTY_MAX       255
+#define PUMP_AGING_MS       10000    // +1 priority point per 10s waiting
+#define PUMP_MAX_WAIT_MS    120000   // Starving: served first, holds the budget
+
+// --- CLOSED-LOOP WATERING ---
+#define WATER_TARGET_BAND   10       // Auto runs stop at threshold + 10 % (predicted)
+#define WATER_FILTER_MS     300      // Smoothing of focus readings
+#define WATER_GAIN_PRIOR    3000     // Untrained zone: 3 %/s (high = stops early)
+#define WATER_SOAK_PRIOR_MS 15000    // Untrained zone: soak-in time constant
+#define WATER_SOAK_FACTOR   4        // Observe 4 time constants before learning
+#define WATER_SOAK_MIN_MS   2000
+#define WATER_SOAK_MAX_MS   180000
+#define WATER_LEARN_MIN_MS  500      // Shorter runs teach nothing
+#define WATER_LEARN_MIN_RISE 2000    // Nor do rises under 2 % (milli-percent)
+
+// --- ADC ACQUISITION ---
+#define ADC_BURST_MS        500      // One filtered value per zone every 500ms
+#define ADC_BURST_SAMPLES   16       // Max samples per zone per burst (1/4 trimmed each end)
+#define ADC_MIN_SAMPLES     4        // Per zone per burst, for slow converters
+#define ADC_FOCUS_MS        100      // Extra bursts for zones being watered
+#define ADC_FOCUS_SAMPLES   8
+#define ADC_SCAN_BUDGET_US  1500     // Max busy time per sensing step
+#define ADC_MAX_LANES       8        // Sensor drivers scanned in parallel
+#define SENSOR_PROBE_SETTLE_MS 10    // Pull-up/pull-down settle time per phase
+#define SENSOR_RECHECK_MS   60000    // Presence re-check (catches unplugged probes)
+
+// --- API SNAPSHOT ---
+#if MAX_PLANTS > 4
+#define SNAPSHOT_BUF_SIZE   (1024 + 320 * MAX_PLANTS)   // Per buffer (x2, static)
+#else
+#define SNAPSHOT_BUF_SIZE   4096     // Per buffer (x2, static)
+#endif
+#define SENSORS_JSON_SIZE   (64 + 112 * MAX_PLANTS)     // "sensors" event
+#define JSON_ITEM_BYTES     256      // Streamed JSON bodies: one item (zone, network, key) at a time
+#define TELEMETRY_BUF_SIZE  (256 + (48 + PLANT_NAME_LEN) * MAX_PLANTS)   // /api/data.cbor, per buffer (x2, static)
+#define SNAPSHOT_MIN_MS     250      // Min gap between rebuilds
+#define SNAPSHOT_UPTIME_MS  60000    // "uptime" step: an idle snapshot is rebuilt this often
+#define MOISTURE_DEADBAND   2        // % change that counts as an API-visible update
+#define ASSET_MAX           16       // Dashboard URLs in /www/assets.idx (tools/build_assets.py)
+#define BATCH_MAX_OPS       32       // Operations per /api/batch request
+
+// --- METRICS (/metrics, Prometheus text) ---
+#define METRICS_ROUTES      24       // Instrumented HTTP routes
+#define METRICS_ITEM_BYTES  1536     // Streamed one block at a time
+#define METRICS_ZONES_PER_ITEM 16
+
+// --- TRACE (build flag: -DROSEMARY_TRACE, see Core/Trace.h) ---
+#define TRACE_EVENTS        512      // Ring slots (~20 B each), newest kept
+#define TRACE_MIN_US        20       // Shorter spans are not recorded
+#define TRACE_THREADS       12       // Task names per export
+
+// --- HISTORY LOG (LittleFS, ~768 KB budget) ---
+// More zones share the budget at a coarser resolution. A full ring
+// drops its oldest segment, so a series keeps at least all but one
+// segment. At the sim's rates that is 3+ months with 4 zones, 4+
+// months with 16, 6+ weeks with 64, and 7+ weeks of env (README).
+#if MAX_PLANTS > 16
+#define HIST_SAMPLE_MS      900000   // 15 min resolution
+#define HIST_KEEPALIVE_S    14400    // Re-log an unchanged value every 4 h
+#elif MAX_PLANTS > 4
+#define HIST_SAMPLE_MS      300000   // 5 min resolution
+#define HIST_KEEPALIVE_S    3600     // Re-log an unchanged value every hour
+#else
+#define HIST_SAMPLE_MS      60000    // 1 Minute resolution
+#define HIST_KEEPALIVE_S    900      // Re-log an unchanged value every 15 min
+#endif
+#define HIST_FLUSH_MS       600000   // RAM buffer -> flash every 10 min
+#define HIST_BUF_BYTES      128      // Per-series RAM buffer
+#if MAX_PLANTS > 16
+#define HIST_SEG_BYTES      4096     // One LittleFS block: smaller saves no flash
+#define HIST_ZONE_SEGMENTS  2        // 8 KB per zone
+#define HIST_ENV_SEGMENTS   32       // 128 KB for temp/hum/vpd
+#elif MAX_PLANTS > 4
+#define HIST_SEG_BYTES      8192
+#define HIST_ZONE_SEGMENTS  5        // 40 KB per zone
+#define HIST_ENV_SEGMENTS   16       // 128 KB for temp/hum/vpd
+#else
+#define HIST_SEG_BYTES      16384    // Segment size
+#define HIST_ZONE_SEGMENTS  8        // 128 KB per zone
+#define HIST_ENV_SEGMENTS   16       // 256 KB for temp/hum/vpd
+#endif
+#define HIST_KEY_EVERY      64       // Absolute record every N deltas
+
+// --- MQTT TELEMETRY (off until a broker is saved, see /api/save-mqtt) ---
+#define MQTT_PORT_DEFAULT   1883
+#define MQTT_TOPIC_PREFIX   "rosemary/"              // + node id + "/telemetry"
+#define MQTT_SAMPLE_MS      10000    // All zones + env
+#define MQTT_BATCH_MS       60000    // One frame per minute
+#define MQTT_FRAME_BYTES    (160 + 8 * (16 + 3 * MAX_PLANTS))   // Closed early if full
+#define MQTT_RAM_FRAMES     4        // Rides out short outages without flash writes
+#define MQTT_SPOOL_SEG_BYTES 8192
+#define MQTT_SPOOL_SEGMENTS 32       // 256 KB ring on LittleFS, oldest dropped when full
+#define MQTT_DRAIN_PER_S    4        // Backlog frames per second after reconnecting
+#define MQTT_RETRY_MS       5000     // Broker reconnect backoff
+#define MQTT_EVENT_QUEUE    64       // Control task -> telemetry (one add per zone fits)
+#define MQTT_KEEPALIVE_S    30
+#define MQTT_SOCKET_TIMEOUT_S 2
+
+// --- CONFIG PERSISTENCE ---
+#define SAVE_DEBOUNCE_MS    3000     // Commit after edits go quiet for 3s
+#define SAVE_MAX_DELAY_MS   30000    // ...or 30s after the first unsaved edit
+
+// --- SETTINGS (NVS, Core/ConfigStore.h) ---
+#define CONFIG_SCHEMA       1        // NVS layout version; bump together with a migrate() step
+#define CONFIG_JSON_SIZE    (1024 + 40 * MAX_PLANTS)   // /api/config import document (two per-zone arrays)
+#define CONFIG_IMPORT_MAX   (1024 + 32 * MAX_PLANTS)   // Largest /api/config body accepted
+
+// --- SENSOR HEALTH (Modules/SensorHealth.h, raw ADC counts) ---
+#define HEALTH_EWMA_SHIFT   4        // Mean / variance smoothing: 1/16 per burst (~8 s)
+#define HEALTH_NOISE_MAX    60       // Burst-to-burst sigma above this: noisy
+#define HEALTH_RATE_MAX     400      // Counts/s; soil does not move this fast unwatered
+#define HEALTH_JUMP_HOLD_MS 60000    // A jump stays flagged this long
+#define HEALTH_FLAT_MS      120000   // No noise, no change this long: flat (stuck)
+#define HEALTH_RAIL         16       // Counts from 0 / 4095 that count as the rail
+#define HEALTH_RAIL_MS      60000    // At a rail this long: saturated
+#define HEALTH_PENALTY      2        // Points per sample with a flag up
+#define HEALTH_JUMP_PENALTY 30       // Points per jump
+#define HEALTH_RECOVER_PER_MIN 10    // Points back per clean minute
+#define HEALTH_MIN_SCORE    50       // Auto-watering needs this score
+
+// --- OTA (POST /api/ota, Core/Ota.h; deltas from tools/make_delta.py) ---
+#define OTA_WINDOW_BITS_MAX 12       // LZ window the decoder holds (4 KB)
+#define OTA_READ_BYTES      256      // Old image bytes per flash read
+#define OTA_WRITE_BYTES     1024     // New image bytes per esp_ota_write
+#define OTA_IDLE_MS         30000    // An upload with no chunk this long gives way to a new one
+#define OTA_CONFIRM_MS      60000    // New image healthy this long: kept
+#define OTA_CONFIRM_TIMEOUT_MS 600000   // ...not by then: rolled back
+#define OTA_STALL_MS        (3 * TASK_IDLE_MAX_MS)   // A task that has not stepped this long is stuck
 
 // --- DEFAULT SETTINGS ---
 #define AP_SSID_DEFAULT     "Rosemary_Core_Setup"
\ No newline at end of file
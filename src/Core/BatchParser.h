@@ -0,0 +1,241 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#include "Types.h"
+
+// ==========================================================
+// BatchParser - Push parser for the /api/batch body
+// The body is a JSON array of flat objects, one per operation:
+//   [{"op":"update-config","id":48213,"threshold":40},
+//    {"op":"water","index":2}, ...]
+// feed() takes the body chunk by chunk as it arrives and fills
+// one BatchOp at a time, so memory is the op list plus one key
+// and one value buffer whatever the body size. Nested values are
+// not part of the format and fail the parse.
+//
+// A bad field (unknown op, number out of range) marks its op and
+// parsing goes on, so the reply can name every bad op. Syntax
+// errors stop the parse.
+// ==========================================================
+
+class BatchParser {
+public:
+    PlantBatch batch;
+
+private:
+    enum State : uint8_t {
+        ARRAY, OP_OR_END, OP, KEY_OR_END, KEY, COLON, VALUE,
+        STR, STR_ESC, STR_HEX, NUMBER, LITERAL, AFTER_VALUE, AFTER_OP, DONE, FAILED
+    };
+
+    State state = ARRAY;
+    BatchOp *cur = nullptr;
+    char key[16];
+    char value[PLANT_NAME_LEN];
+    uint8_t keyLen = 0, valueLen = 0;
+    bool inKey = false;            // STR fills key rather than value
+    bool truncated = false;        // value overflowed
+    uint16_t hex = 0;
+    uint8_t hexLen = 0;
+    size_t offset = 0;             // Bytes consumed so far
+    const char *failure = nullptr;
+    bool tooMany = false;
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    bool fail(const char *why) { failure = why; state = FAILED; return true; }
+    void opError(const char *why) { if (!cur->error) cur->error = why; }
+
+    void put(char c) {
+        if (inKey) { if (keyLen + 1u < sizeof(key)) key[keyLen++] = c; }
+        else if (valueLen + 1u < sizeof(value)) value[valueLen++] = c;
+        else truncated = true;
+    }
+
+    void putUtf8(uint16_t cp) {
+        if (cp >= 0xD800 && cp <= 0xDFFF) cp = '?';     // Surrogate halves: not kept
+        if (cp < 0x80) { put((char)cp); return; }
+        if (cp < 0x800) { put((char)(0xC0 | (cp >> 6))); put((char)(0x80 | (cp & 0x3F))); return; }
+        put((char)(0xE0 | (cp >> 12))); put((char)(0x80 | ((cp >> 6) & 0x3F))); put((char)(0x80 | (cp & 0x3F)));
+    }
+
+    void startString(bool forKey) {
+        inKey = forKey;
+        if (forKey) keyLen = 0; else { valueLen = 0; truncated = false; }
+        state = STR;
+    }
+
+    void beginOp() {
+        if (batch.count >= BATCH_MAX_OPS) { tooMany = true; fail("too many ops"); return; }
+        cur = &batch.ops[batch.count++];
+        *cur = BatchOp();
+        state = KEY_OR_END;
+    }
+
+    void endOp() {
+        if (cur->kind == BOP_NONE) opError("missing op");
+        state = AFTER_OP;
+    }
+
+    // Integer field within [lo, hi]; fractions and exponents are rejected
+    bool toInt(char kind, int32_t lo, int32_t hi, int32_t &out) {
+        if (kind != 'n') { opError("expected an integer"); return false; }
+        char *end;
+        long v = strtol(value, &end, 10);
+        if (*end || end == value) { opError("expected an integer"); return false; }
+        if (truncated || v < lo || v > hi) { opError("out of range"); return false; }
+        out = (int32_t)v;
+        return true;
+    }
+
+    // kind: 's' string, 'n' number, 'l' true/false/null
+    void onValue(char kind) {
+        key[keyLen] = 0;
+        value[valueLen] = 0;
+        if (kind == 'l' && !strcmp(value, "null")) return;   // Same as not given
+
+        if (!strcmp(key, "op")) {
+            static const char *ops[] = { "add", "delete", "update-config", "water", "calibrate" };
+            if (kind != 's') { opError("op must be a string"); return; }
+            for (uint8_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) if (!strcmp(value, ops[i])) { cur->kind = i; return; }
+            opError("unknown op");
+            return;
+        }
+        if (!strcmp(key, "name") || !strcmp(key, "type")) {
+            bool isName = key[0] == 'n';
+            if (kind != 's') { opError("expected a string"); return; }
+            size_t size = isName ? sizeof(cur->name) : sizeof(cur->type);
+            if (truncated || valueLen >= size) { opError(isName ? "name too long" : "unknown type"); return; }
+            strlcpy(isName ? cur->name : cur->type, value, size);
+            return;
+        }
+
+        int32_t v;
+        if (!strcmp(key, "id")) { if (toInt(kind, 1, INT32_MAX, v)) cur->id = v; return; }
+        static const struct { const char *name; int16_t BatchOp::*field; int16_t lo, hi; } fields[] = {
+            { "index",     &BatchOp::zone,      0, MAX_PLANTS - 1 },
+            { "threshold", &BatchOp::threshold, 0, 100 },
+            { "duration",  &BatchOp::duration,  1, 60 },
+            { "dry",       &BatchOp::dry,       0, 4095 },
+            { "wet",       &BatchOp::wet,       0, 4095 },
+        };
+        for (auto &f : fields) {
+            if (strcmp(key, f.name)) continue;
+            if (toInt(kind, f.lo, f.hi, v)) cur->*f.field = (int16_t)v;
+            return;
+        }
+        opError("unknown field");
+    }
+
+    // One character; false = not consumed (the state changed, look again)
+    bool step(char c) {
+        switch (state) {
+            case ARRAY:
+                if (isSpace(c)) return true;
+                if (c == '[') { state = OP_OR_END; return true; }
+                return fail("expected [");
+            case OP_OR_END:
+                if (isSpace(c)) return true;
+                if (c == ']') { state = DONE; return true; }
+                // fallthrough
+            case OP:
+                if (isSpace(c)) return true;
+                if (c == '{') { beginOp(); return true; }
+                return fail("expected {");
+            case KEY_OR_END:
+                if (isSpace(c)) return true;
+                if (c == '}') { endOp(); return true; }
+                // fallthrough
+            case KEY:
+                if (isSpace(c)) return true;
+                if (c == '"') { startString(true); return true; }
+                return fail("expected a key");
+            case COLON:
+                if (isSpace(c)) return true;
+                if (c == ':') { state = VALUE; return true; }
+                return fail("expected :");
+            case VALUE:
+                if (isSpace(c)) return true;
+                if (c == '"') { startString(false); return true; }
+                valueLen = 0; truncated = false; inKey = false;
+                if (c == '-' || (c >= '0' && c <= '9')) { put(c); state = NUMBER; return true; }
+                if (c >= 'a' && c <= 'z') { put(c); state = LITERAL; return true; }
+                if (c == '{' || c == '[') return fail("nested values are not supported");
+                return fail("expected a value");
+            case STR:
+                if (c == '"') {
+                    if (inKey) state = COLON;
+                    else { onValue('s'); state = AFTER_VALUE; }
+                    return true;
+                }
+                if (c == '\\') { state = STR_ESC; return true; }
+                if ((uint8_t)c < 0x20) return fail("control character in string");
+                put(c);
+                return true;
+            case STR_ESC: {
+                const char *from = "\"\\/bfnrt", *to = "\"\\/\b\f\n\r\t";
+                const char *e = strchr(from, c);
+                if (c == 'u') { hex = 0; hexLen = 0; state = STR_HEX; return true; }
+                if (!c || !e) return fail("bad escape");
+                put(to[e - from]);
+                state = STR;
+                return true;
+            }
+            case STR_HEX: {
+                int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                if (d < 0) return fail("bad \\u escape");
+                hex = (hex << 4) | d;
+                if (++hexLen == 4) { putUtf8(hex); state = STR; }
+                return true;
+            }
+            case NUMBER:
+                if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') { put(c); return true; }
+                onValue('n');
+                state = AFTER_VALUE;
+                return false;
+            case LITERAL:
+                if (c >= 'a' && c <= 'z') { put(c); return true; }
+                value[valueLen] = 0;
+                if (strcmp(value, "true") && strcmp(value, "false") && strcmp(value, "null")) return fail("expected a value");
+                onValue('l');
+                state = AFTER_VALUE;
+                return false;
+            case AFTER_VALUE:
+                if (isSpace(c)) return true;
+                if (c == ',') { state = KEY; return true; }
+                if (c == '}') { endOp(); return true; }
+                return fail("expected , or }");
+            case AFTER_OP:
+                if (isSpace(c)) return true;
+                if (c == ',') { state = OP; return true; }
+                if (c == ']') { state = DONE; return true; }
+                return fail("expected , or ]");
+            case DONE:
+                if (isSpace(c)) return true;
+                return fail("data after the array");
+            case FAILED:
+                return true;
+        }
+        return true;
+    }
+
+public:
+    // Any chunk size, in body order. False once the parse has failed.
+    bool feed(const uint8_t *data, size_t len) {
+        for (size_t i = 0; i < len && state != FAILED; i++) {
+            while (!step((char)data[i])) {}
+            if (state != FAILED) offset++;
+        }
+        return state != FAILED;
+    }
+
+    // Whole body seen: complete array, or why not
+    bool finish() {
+        if (state != DONE && state != FAILED) fail("unexpected end of body");
+        return state == DONE;
+    }
+
+    const char* getError() { return failure; }
+    size_t getErrorOffset() { return offset; }
+    bool isTooMany() { return tooMany; }
+};
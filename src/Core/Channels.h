@@ -0,0 +1,85 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// ==========================================================
+// Channels - Lock-free data exchange between tasks
+// SpscQueue : one producer task, one consumer task, fixed size
+// Mailbox   : latest-value double buffer (seqlock); the writer
+//             never waits, readers retry on a torn copy and
+//             never wait for a write in progress
+// T must be trivially copyable (no String, no heap).
+// ==========================================================
+
+template<typename T, int N>
+class SpscQueue {
+private:
+    T items[N];
+    std::atomic<uint32_t> head{0};   // Written by the producer
+    std::atomic<uint32_t> tail{0};   // Written by the consumer
+    std::atomic<uint32_t> dropped{0};
+
+public:
+    bool push(const T &v) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= (uint32_t)N) { dropped++; return false; }
+        items[h % N] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &v) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        v = items[t % N];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() { return tail.load() == head.load(); }
+    uint32_t getDropped() { return dropped.load(); }
+};
+
+// seq is odd while a publish is in progress; seq / 2 counts the
+// finished ones, and publish n goes to slot n & 1. A reader copies
+// the last finished slot even while seq is odd (the write goes to
+// the other one), so a higher-priority reader on the writer's core
+// never spins on a preempted publish. The copy is torn only if the
+// publish after next started meanwhile: that one reuses the slot.
+template<typename T>
+class Mailbox {
+private:
+    T slots[2];
+    std::atomic<uint32_t> seq{0};
+
+public:
+    void publish(const T &v) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);    // Odd: writing
+        std::atomic_thread_fence(std::memory_order_release);
+        slots[((s >> 1) + 1) & 1] = v;
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Copies the latest value if it is newer than lastSeq
+    bool read(T &out, uint32_t &lastSeq) {
+        while (true) {
+            uint32_t s = seq.load(std::memory_order_acquire), n = s >> 1;
+            if (n == 0 || n == lastSeq) return false;
+            out = slots[n & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Publish n + 2 sets seq to 2n + 3 before it writes this slot
+            if (seq.load(std::memory_order_relaxed) - (s & ~1u) <= 2) { lastSeq = n; return true; }
+        }
+    }
+
+    // Latest value (or T{} before the first publish)
+    T get() {
+        T out{}; uint32_t none = 0;
+        read(out, none);
+        return out;
+    }
+
+    // Finished publishes
+    uint32_t getSeq() { return seq.load(std::memory_order_acquire) >> 1; }
+};
@@ -0,0 +1,528 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include <stddef.h>
+#include "../Config.h"
+#include "Deadline.h"
+#include "Trace.h"
+#include "JsonWriter.h"
+
+// ==========================================================
+// ConfigStore - Typed settings, loaded once, served from RAM
+// Every NVS setting is a row in CONFIG_DEFS: export name, NVS
+// key, type, place in ConfigValues, default and range. begin()
+// reads them all from one namespace at boot; after that reads
+// never touch NVS.
+//
+// Writes mark keys dirty. The network task commits only the
+// dirty keys, through one handle, once edits go quiet for
+// SAVE_DEBOUNCE_MS (or SAVE_MAX_DELAY_MS after the first edit),
+// and before a reboot. Keys still at their default are not
+// stored at all.
+//
+// "schema" in NVS is the layout version. Older layouts are
+// upgraded once by migrate(), one step per version: v0 is the
+// scattered per-module namespaces (wifi, mqtt, sys_settings,
+// sensor_N) used before this store.
+//
+// Readers (any task) use a double buffer with a sequence count
+// that is odd while an edit is published, like Mailbox, but copy
+// single fields. Writers: the web server
+// task, or setup() before the tasks start, one edit at a time.
+// (The control task edits calibrations for /api/batch while the
+// web server task waits on it.)
+// ==========================================================
+
+#define CONFIG_NVS_NS       "config"
+#define CONFIG_NAME_MAX     15          // Export names: a-z 0-9 . _ (checked below)
+
+enum ConfigType : uint8_t { CFG_BOOL, CFG_INT, CFG_STR, CFG_ZONES };
+
+enum ConfigFlag : uint8_t {
+    CFG_SECRET = 1,     // Left out of exports unless asked for
+    CFG_REBOOT = 2      // Takes effect after a restart
+};
+
+enum ConfigKey : uint8_t {
+    CFG_WIFI_SSID, CFG_WIFI_PASS,
+    CFG_MQTT_HOST, CFG_MQTT_PORT, CFG_MQTT_USER, CFG_MQTT_PASS,
+    CFG_DND,
+    CFG_SENSOR_DRY, CFG_SENSOR_WET,
+    CFG_KEY_COUNT
+};
+
+// RAM copy of every setting (trivially copyable)
+struct ConfigValues {
+    char wifiSsid[33];
+    char wifiPass[65];
+    char mqttHost[64];
+    int32_t mqttPort;
+    char mqttUser[32];
+    char mqttPass[64];
+    bool dnd;
+    int16_t sensorDry[MAX_PLANTS];   // Raw ADC at 0 % / 100 % moisture, per zone
+    int16_t sensorWet[MAX_PLANTS];
+};
+
+struct ConfigDef {
+    const char *name;       // Export / import name
+    const char *nvsKey;     // <= 15 chars
+    ConfigType type;
+    uint16_t offset, size;  // Field in ConfigValues
+    int32_t def, min, max;  // Bools and ints (per zone for CFG_ZONES); strings default to ""
+    uint8_t flags;
+};
+
+#define CFG_FIELD(f) (uint16_t)offsetof(ConfigValues, f), (uint16_t)sizeof(ConfigValues::f)
+
+// Order = ConfigKey
+static constexpr ConfigDef CONFIG_DEFS[CFG_KEY_COUNT] = {
+    { "wifi.ssid",     "wifi_ssid",  CFG_STR,   CFG_FIELD(wifiSsid),  0,    0, 0,     CFG_REBOOT },
+    { "wifi.password", "wifi_pass",  CFG_STR,   CFG_FIELD(wifiPass),  0,    0, 0,     CFG_REBOOT | CFG_SECRET },
+    { "mqtt.host",     "mqtt_host",  CFG_STR,   CFG_FIELD(mqttHost),  0,    0, 0,     CFG_REBOOT },
+    { "mqtt.port",     "mqtt_port",  CFG_INT,   CFG_FIELD(mqttPort),  MQTT_PORT_DEFAULT, 1, 65535, CFG_REBOOT },
+    { "mqtt.user",     "mqtt_user",  CFG_STR,   CFG_FIELD(mqttUser),  0,    0, 0,     CFG_REBOOT },
+    { "mqtt.password", "mqtt_pass",  CFG_STR,   CFG_FIELD(mqttPass),  0,    0, 0,     CFG_REBOOT | CFG_SECRET },
+    { "buzzer.dnd",    "dnd",        CFG_BOOL,  CFG_FIELD(dnd),       0,    0, 1,     0 },
+    { "sensor.dry",    "sensor_dry", CFG_ZONES, CFG_FIELD(sensorDry), 4095, 0, 4095,  0 },
+    { "sensor.wet",    "sensor_wet", CFG_ZONES, CFG_FIELD(sensorWet), 1500, 0, 4095,  0 },
+};
+
+// Chars of a plain name (nothing to escape in JSON), or -1
+constexpr int configNameLen(const char *s) {
+    return !*s ? 0 : !((*s >= 'a' && *s <= 'z') || (*s >= '0' && *s <= '9') || *s == '.' || *s == '_') ? -1
+         : configNameLen(s + 1) < 0 ? -1 : 1 + configNameLen(s + 1);
+}
+constexpr bool configNamesFit(int i = 0) {
+    return i == CFG_KEY_COUNT || (configNameLen(CONFIG_DEFS[i].name) >= 0 && configNameLen(CONFIG_DEFS[i].name) <= CONFIG_NAME_MAX && configNamesFit(i + 1));
+}
+static_assert(configNamesFit(), "an export name is not plain or is longer than CONFIG_NAME_MAX");
+
+class ConfigStore {
+private:
+    ConfigValues slots[2];
+    std::atomic<uint32_t> seq{0};      // Odd while publishing; slot (seq / 2) & 1 is current
+    ConfigValues work;                 // Writer only: edit in progress
+    uint32_t editDirty = 0;
+
+    std::atomic<uint32_t> dirty{0};    // Key bits not yet in NVS
+    std::atomic<unsigned long> firstDirty{0};
+    std::atomic<unsigned long> lastDirty{0};
+    uint32_t storedSchema = 0;
+    std::atomic<uint32_t> commits{0};
+    std::atomic<uint32_t> keysWritten{0};
+    uint32_t migratedFrom = CONFIG_SCHEMA;
+
+    // fn(const ConfigValues&) copies what it needs; retried if the slot was reused meanwhile
+    template<typename Fn>
+    void read(Fn fn) {
+        while (true) {
+            uint32_t s = seq.load(std::memory_order_acquire);
+            fn(slots[(s >> 1) & 1]);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // The edit after next sets seq odd before it reuses this slot
+            if (seq.load(std::memory_order_relaxed) - (s & ~1u) <= 2) return;
+        }
+    }
+
+    static uint8_t* field(ConfigValues &v, ConfigKey k) { return (uint8_t*)&v + CONFIG_DEFS[k].offset; }
+    static const uint8_t* field(const ConfigValues &v, ConfigKey k) { return (const uint8_t*)&v + CONFIG_DEFS[k].offset; }
+
+    static void setDefault(ConfigValues &v, ConfigKey k) {
+        const ConfigDef &d = CONFIG_DEFS[k];
+        uint8_t *f = field(v, k);
+        switch (d.type) {
+            case CFG_BOOL:  *(bool*)f = d.def != 0; break;
+            case CFG_INT:   *(int32_t*)f = d.def; break;
+            case CFG_STR:   f[0] = 0; break;
+            case CFG_ZONES: for (int z = 0; z < MAX_PLANTS; z++) ((int16_t*)f)[z] = (int16_t)d.def; break;
+        }
+    }
+
+    static bool isDefault(const ConfigValues &v, ConfigKey k) {
+        ConfigValues def;
+        setDefault(def, k);
+        const ConfigDef &d = CONFIG_DEFS[k];
+        if (d.type == CFG_STR) return field(v, k)[0] == 0;
+        return memcmp(field(v, k), field(def, k), d.size) == 0;
+    }
+
+    // --- WRITER ---
+
+    void beginEdit() {
+        work = slots[(seq.load(std::memory_order_relaxed) >> 1) & 1];
+        editDirty = 0;
+    }
+
+    // Publishes the edit; returns the keys that changed
+    uint32_t endEdit() {
+        uint32_t changed = editDirty;
+        if (!changed) return 0;
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);    // Odd: publishing
+        std::atomic_thread_fence(std::memory_order_release);
+        slots[((s >> 1) + 1) & 1] = work;
+        seq.store(s + 2, std::memory_order_release);
+        unsigned long now = millis();
+        if (dirty.fetch_or(changed) == 0) firstDirty = now;
+        lastDirty = now;
+        return changed;
+    }
+
+    // --- NVS ---
+
+    void load(Preferences &p, ConfigValues &v) {
+        for (int i = 0; i < CFG_KEY_COUNT; i++) {
+            ConfigKey k = (ConfigKey)i;
+            const ConfigDef &d = CONFIG_DEFS[k];
+            if (!p.isKey(d.nvsKey)) continue;
+            uint8_t *f = field(v, k);
+            switch (d.type) {
+                case CFG_BOOL:  *(bool*)f = p.getBool(d.nvsKey, d.def != 0); break;
+                case CFG_INT:   *(int32_t*)f = constrain(p.getInt(d.nvsKey, d.def), d.min, d.max); break;
+                case CFG_STR:   strlcpy((char*)f, p.getString(d.nvsKey, "").c_str(), d.size); break;
+                case CFG_ZONES: p.getBytes(d.nvsKey, f, d.size); break;   // Fewer zones stored: the rest keep defaults
+            }
+        }
+    }
+
+    bool store(Preferences &p, const ConfigValues &v, ConfigKey k) {
+        const ConfigDef &d = CONFIG_DEFS[k];
+        if (isDefault(v, k)) { if (p.isKey(d.nvsKey)) p.remove(d.nvsKey); return true; }
+        const uint8_t *f = field(v, k);
+        switch (d.type) {
+            case CFG_BOOL:  return p.putBool(d.nvsKey, *(const bool*)f) > 0;
+            case CFG_INT:   return p.putInt(d.nvsKey, *(const int32_t*)f) > 0;
+            case CFG_STR:   return p.putString(d.nvsKey, (const char*)f) > 0;
+            case CFG_ZONES: return p.putBytes(d.nvsKey, f, d.size) > 0;
+        }
+        return false;
+    }
+
+    // One step per schema version; add new steps at the end
+    void migrate(uint32_t from) {
+        migratedFrom = from;
+        beginEdit();
+        switch (from) {
+            case 0: importLegacy(); // fallthrough
+            default: break;
+        }
+        endEdit();
+        Serial.printf("[CONFIG] Schema %u -> %u\n", (unsigned)from, (unsigned)CONFIG_SCHEMA);
+        if (commit() && from == 0) clearLegacy();
+    }
+
+    // v0: one namespace per module
+    void importLegacy() {
+        Preferences p;
+        if (p.begin("wifi", true)) {
+            putStr(CFG_WIFI_SSID, p.getString("ssid", "").c_str());
+            putStr(CFG_WIFI_PASS, p.getString("pass", "").c_str());
+            p.end();
+        }
+        if (p.begin("mqtt", true)) {
+            putStr(CFG_MQTT_HOST, p.getString("host", "").c_str());
+            putInt(CFG_MQTT_PORT, (int32_t)p.getUInt("port", MQTT_PORT_DEFAULT), 0);
+            putStr(CFG_MQTT_USER, p.getString("user", "").c_str());
+            putStr(CFG_MQTT_PASS, p.getString("pass", "").c_str());
+            p.end();
+        }
+        if (p.begin("sys_settings", true)) {
+            putBool(CFG_DND, p.getBool("dnd", false));
+            p.end();
+        }
+        for (int z = 0; z < MAX_PLANTS; z++) {
+            char ns[16];
+            snprintf(ns, sizeof(ns), "sensor_%d", z);
+            if (!p.begin(ns, true)) continue;
+            putInt(CFG_SENSOR_DRY, p.getInt("a_dry", CONFIG_DEFS[CFG_SENSOR_DRY].def), z);
+            putInt(CFG_SENSOR_WET, p.getInt("a_wet", CONFIG_DEFS[CFG_SENSOR_WET].def), z);
+            p.end();
+        }
+    }
+
+    static void clearNamespace(const char *ns, const char *probeKey) {
+        Preferences p;
+        if (!p.begin(ns, true)) return;
+        bool used = probeKey ? p.isKey(probeKey) : true;
+        p.end();
+        if (used && p.begin(ns, false)) { p.clear(); p.end(); }
+    }
+
+    void clearLegacy() {
+        clearNamespace("wifi", "ssid");
+        clearNamespace("mqtt", "host");
+        clearNamespace("sys_settings", "dnd");
+        for (int z = 0; z < MAX_PLANTS; z++) {
+            char ns[16];
+            snprintf(ns, sizeof(ns), "sensor_%d", z);
+            clearNamespace(ns, "a_dry");
+        }
+    }
+
+    // --- IMPORT ---
+
+    // Checks one value without applying it; err gets the reason
+    static bool validate(ConfigKey k, JsonVariantConst v, const char *&err) {
+        const ConfigDef &d = CONFIG_DEFS[k];
+        switch (d.type) {
+            case CFG_BOOL:
+                if (!v.is<bool>()) { err = "expected true/false"; return false; }
+                return true;
+            case CFG_INT:
+                if (!v.is<long>() || v.as<long>() < d.min || v.as<long>() > d.max) { err = "out of range"; return false; }
+                return true;
+            case CFG_STR:
+                if (!v.is<const char*>()) { err = "expected a string"; return false; }
+                if (strlen(v.as<const char*>()) >= d.size) { err = "too long"; return false; }
+                return true;
+            case CFG_ZONES: {
+                if (!v.is<JsonArrayConst>()) { err = "expected an array"; return false; }
+                JsonArrayConst a = v.as<JsonArrayConst>();
+                if (a.size() > MAX_PLANTS) { err = "more zones than this build has"; return false; }
+                for (JsonVariantConst e : a) {
+                    if (e.isNull()) continue;   // Zone left as is
+                    if (!e.is<long>() || e.as<long>() < d.min || e.as<long>() > d.max) { err = "out of range"; return false; }
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void apply(ConfigKey k, JsonVariantConst v) {
+        switch (CONFIG_DEFS[k].type) {
+            case CFG_BOOL: putBool(k, v.as<bool>()); break;
+            case CFG_INT:  putInt(k, v.as<long>(), 0); break;
+            case CFG_STR:  putStr(k, v.as<const char*>()); break;
+            case CFG_ZONES: {
+                int z = 0;
+                for (JsonVariantConst e : v.as<JsonArrayConst>()) {
+                    if (!e.isNull()) putInt(k, e.as<long>(), z);
+                    z++;
+                }
+                break;
+            }
+        }
+    }
+
+public:
+    // setup(), before anything reads a setting
+    void begin() {
+        for (int i = 0; i < CFG_KEY_COUNT; i++) setDefault(slots[0], (ConfigKey)i);
+        Preferences p;
+        if (p.begin(CONFIG_NVS_NS, true)) {
+            storedSchema = p.getUInt("schema", 0);
+            if (storedSchema > 0) load(p, slots[0]);
+            p.end();
+        }
+        slots[1] = slots[0];
+        if (storedSchema < CONFIG_SCHEMA) migrate(storedSchema);
+        else if (storedSchema > CONFIG_SCHEMA) Serial.printf("[CONFIG] Schema %u is newer than %u: unknown keys ignored\n", (unsigned)storedSchema, (unsigned)CONFIG_SCHEMA);
+    }
+
+    // --- READ (any task) ---
+
+    bool getBool(ConfigKey k) {
+        bool out = false;
+        read([&](const ConfigValues &v){ out = *(const bool*)field(v, k); });
+        return out;
+    }
+
+    int32_t getInt(ConfigKey k, int zone = 0) {
+        int32_t out = 0;
+        if (CONFIG_DEFS[k].type == CFG_ZONES) {
+            if (zone < 0 || zone >= MAX_PLANTS) return CONFIG_DEFS[k].def;
+            read([&](const ConfigValues &v){ out = ((const int16_t*)field(v, k))[zone]; });
+        } else {
+            read([&](const ConfigValues &v){ out = *(const int32_t*)field(v, k); });
+        }
+        return out;
+    }
+
+    // Copies at most size - 1 chars; returns the length
+    size_t getStr(ConfigKey k, char *out, size_t size) {
+        read([&](const ConfigValues &v){ strlcpy(out, (const char*)field(v, k), size); });
+        return strlen(out);
+    }
+
+    bool hasStr(ConfigKey k) {
+        bool set = false;
+        read([&](const ConfigValues &v){ set = field(v, k)[0] != 0; });
+        return set;
+    }
+
+    // --- WRITE (web server task / setup) ---
+
+    void setBool(ConfigKey k, bool b) { beginEdit(); putBool(k, b); endEdit(); }
+    void setInt(ConfigKey k, int32_t v, int zone = 0) {
+        if (zone < 0 || zone >= MAX_PLANTS) return;
+        beginEdit(); putInt(k, v, zone); endEdit();
+    }
+    void setStr(ConfigKey k, const char *s) { beginEdit(); putStr(k, s); endEdit(); }
+
+    // Several keys at once (one publish, one commit): fn calls put*().
+    // Returns the keys that changed.
+    template<typename Fn>
+    uint32_t edit(Fn fn) { beginEdit(); fn(); return endEdit(); }
+
+    void putBool(ConfigKey k, bool b) {
+        bool *f = (bool*)field(work, k);
+        if (*f != b) { *f = b; editDirty |= 1UL << k; }
+    }
+
+    void putInt(ConfigKey k, int32_t v, int zone) {
+        const ConfigDef &d = CONFIG_DEFS[k];
+        v = constrain(v, d.min, d.max);
+        if (d.type == CFG_ZONES) {
+            int16_t *f = (int16_t*)field(work, k) + zone;
+            if (*f != v) { *f = (int16_t)v; editDirty |= 1UL << k; }
+        } else {
+            int32_t *f = (int32_t*)field(work, k);
+            if (*f != v) { *f = v; editDirty |= 1UL << k; }
+        }
+    }
+
+    void putStr(ConfigKey k, const char *s) {
+        char *f = (char*)field(work, k);
+        if (strncmp(f, s, CONFIG_DEFS[k].size) == 0) return;
+        strlcpy(f, s, CONFIG_DEFS[k].size);
+        editDirty |= 1UL << k;
+    }
+
+    // All of values or nothing. Unknown names are counted, not fatal
+    // (an export from newer firmware). Returns false with err set.
+    bool importJson(JsonObject values, uint32_t &changed, int &ignored, String &err) {
+        int known = 0;
+        for (int i = 0; i < CFG_KEY_COUNT; i++) {
+            const char *name = CONFIG_DEFS[i].name;
+            if (!values.containsKey(name)) continue;
+            known++;
+            const char *why = nullptr;
+            if (!validate((ConfigKey)i, values[name], why)) { err = String(name) + ": " + why; return false; }
+        }
+        ignored = (int)values.size() - known;
+        beginEdit();
+        for (int i = 0; i < CFG_KEY_COUNT; i++) {
+            const char *name = CONFIG_DEFS[i].name;
+            if (values.containsKey(name)) apply((ConfigKey)i, values[name]);
+        }
+        changed = endEdit();
+        return true;
+    }
+
+    // GET /api/config body: one setting per item, per-zone arrays
+    // ZONES_PER_ITEM values and strings STR_BYTES_PER_ITEM bytes at
+    // a time. Exports the values as they were when the request came in.
+    class JsonExport : public JsonItemStream {
+    private:
+        static const int ZONES_PER_ITEM = 16;
+        static const int STR_BYTES_PER_ITEM = 32;
+        // Largest item: comma, quoted name and colon, then a string piece
+        // or ZONES_PER_ITEM int16 values with their commas and brackets
+        static_assert(JSON_ITEM_BYTES >= 4 + CONFIG_NAME_MAX +
+                      (JSON_STR_MAX(STR_BYTES_PER_ITEM) > 2 + 7 * ZONES_PER_ITEM ? JSON_STR_MAX(STR_BYTES_PER_ITEM) : 2 + 7 * ZONES_PER_ITEM),
+                      "a /api/config item can outgrow JSON_ITEM_BYTES");
+        ConfigValues v;
+        bool secrets;
+        int key = 0, zone = 0;
+        size_t pos = 0;       // Bytes of the current string already sent
+
+    protected:
+        bool next(JsonWriter &w, int i) override {
+            if (i == 0) {
+                w.openObject();
+                w.key("schema"); w.uint(CONFIG_SCHEMA);
+                w.key("values"); w.openObject();
+                return true;
+            }
+            while (key < CFG_KEY_COUNT && (CONFIG_DEFS[key].flags & CFG_SECRET) && !secrets) key++;
+            if (key > CFG_KEY_COUNT) return false;
+            if (key == CFG_KEY_COUNT) { w.closeObject(); w.closeObject(); key++; return true; }
+
+            const ConfigDef &d = CONFIG_DEFS[key];
+            const uint8_t *f = field(v, (ConfigKey)key);
+            if (d.type == CFG_ZONES) {
+                if (zone == 0) { w.key(d.name); w.openArray(); }
+                for (int end = std::min(zone + ZONES_PER_ITEM, MAX_PLANTS); zone < end; zone++) w.integer(((const int16_t*)f)[zone]);
+                if (zone < MAX_PLANTS) return true;
+                w.closeArray();
+                zone = 0;
+            } else if (d.type == CFG_STR) {
+                const char *s = (const char*)f;
+                size_t n = strlen(s), k = std::min(n - pos, (size_t)STR_BYTES_PER_ITEM);
+                if (pos == 0) { w.key(d.name); w.openStr(); }
+                w.strPart(s + pos, k);
+                pos += k;
+                if (pos < n) return true;
+                w.closeStr();
+                pos = 0;
+            } else {
+                w.key(d.name);
+                if (d.type == CFG_BOOL) w.boolean(*(const bool*)f);
+                else w.integer(*(const int32_t*)f);
+            }
+            key++;
+            return true;
+        }
+
+    public:
+        JsonExport(ConfigStore &store, bool withSecrets) : secrets(withSecrets) {
+            store.read([&](const ConfigValues &s){ v = s; });
+        }
+    };
+
+    // Any of the keys need a restart to take effect
+    static bool needsReboot(uint32_t keys) {
+        for (int i = 0; i < CFG_KEY_COUNT; i++) if (((keys >> i) & 1) && (CONFIG_DEFS[i].flags & CFG_REBOOT)) return true;
+        return false;
+    }
+
+    // --- COMMIT (network task) ---
+
+    bool due(unsigned long now) {
+        if (!dirty.load()) return false;
+        return now - lastDirty >= SAVE_DEBOUNCE_MS || now - firstDirty >= SAVE_MAX_DELAY_MS;
+    }
+
+    uint32_t dueInMs(unsigned long now) {
+        if (!dirty.load()) return TASK_IDLE_MAX_MS;
+        return std::min(msUntil(lastDirty + SAVE_DEBOUNCE_MS, now), msUntil(firstDirty + SAVE_MAX_DELAY_MS, now));
+    }
+
+    void persist() { if (due(millis())) commit(); }
+
+    // Writes the dirty keys through one handle. Keys that fail stay dirty.
+    bool commit() {
+        uint32_t keys = dirty.exchange(0);
+        if (!keys && storedSchema == CONFIG_SCHEMA) return true;
+        TRACE_SCOPE("config.commit");
+        ConfigValues v;
+        read([&](const ConfigValues &s){ v = s; });
+
+        Preferences p;
+        if (!p.begin(CONFIG_NVS_NS, false)) { dirty |= keys; Serial.println("[CONFIG] NVS open failed"); return false; }
+        uint32_t failed = 0, written = 0;
+        for (int i = 0; i < CFG_KEY_COUNT; i++) {
+            if (!((keys >> i) & 1)) continue;
+            if (store(p, v, (ConfigKey)i)) written++;
+            else failed |= 1UL << i;
+        }
+        if (storedSchema != CONFIG_SCHEMA && p.putUInt("schema", CONFIG_SCHEMA) > 0) storedSchema = CONFIG_SCHEMA;
+        p.end();
+
+        keysWritten += written;
+        commits++;
+        if (failed) { dirty |= failed; Serial.println("[CONFIG] NVS write failed, will retry"); }
+        return failed == 0;
+    }
+
+    bool isDirty() { return dirty.load() != 0; }
+    uint32_t getCommits() { return commits.load(); }
+    uint32_t getKeysWritten() { return keysWritten.load(); }
+    uint32_t getMigratedFrom() { return migratedFrom; }
+};
+
+extern ConfigStore config;
@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+
+// ==========================================================
+// Deadline - What a task step hands back to the TaskRunner
+// Steps return the ms until their task next has work; modules
+// answer with their own nextDueMs() and the step keeps the
+// earliest. 0 means "work in progress": run again next tick.
+// Nothing pending sleeps TASK_IDLE_MAX_MS.
+//
+// Input that arrives from another task (or an ISR) calls the
+// consumer's TaskWake hook, so a sleeping task runs at once
+// instead of at its next deadline.
+// ==========================================================
+
+// Plain function, no captures: also called from ISRs
+typedef void (*TaskWake)();
+
+// ms from now until due; 0 once it has passed
+inline uint32_t msUntil(unsigned long due, unsigned long now) {
+    long d = (long)(due - now);
+    return d > 0 ? (uint32_t)d : 0;
+}
+
+// Earliest of several deadlines, in ms from now
+class NextDue {
+private:
+    uint32_t ms = TASK_IDLE_MAX_MS;
+
+public:
+    void in(uint32_t d) { if (d < ms) ms = d; }
+    void at(unsigned long due, unsigned long now) { in(msUntil(due, now)); }
+    operator uint32_t() const { return ms; }
+};
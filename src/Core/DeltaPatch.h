@@ -0,0 +1,239 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+
+// ==========================================================
+// DeltaPatch - Streaming decoder for compressed image deltas
+// The /api/ota body, as tools/make_delta.py writes it:
+//
+//   header  "RDP1", version, LZ window bits, old image size and
+//           SHA-256, new image size and SHA-256 (80 bytes, LE)
+//   body    LZ-compressed patch records
+//
+// LZ: byte-aligned, distances within a 2^bits window. A token
+// below 0x80 starts a literal run of token + 1 bytes; above, a
+// match of (token & 0x7F) + 3 bytes (+ a varint when the low
+// bits are 0x7F) at a varint distance.
+// Patch: bsdiff records, each a diff run (old byte + diff byte),
+// an extra run (copied) and a zigzag seek of the old position.
+//
+// feed() takes the body in any chunk sizes and hands the new
+// image out through DeltaIo as it comes: memory is the window,
+// one old-image read and one write buffer, whatever the image
+// size. A delta from an empty old image is a compressed full
+// image. Parses only; hashes and flash are the caller's (Ota.h).
+// ==========================================================
+
+#define DELTA_HEADER_BYTES  80
+#define DELTA_VERSION       1
+
+// Old image in, new image out (the running and the next OTA slot)
+class DeltaIo {
+public:
+    virtual ~DeltaIo() {}
+    virtual bool readOld(uint32_t offset, uint8_t *buf, size_t len) = 0;
+    virtual bool writeNew(const uint8_t *data, size_t len) = 0;
+};
+
+struct DeltaHeader {
+    uint8_t windowBits = 0;
+    uint32_t oldSize = 0;
+    uint32_t newSize = 0;
+    uint8_t oldHash[32] = {};
+    uint8_t newHash[32] = {};
+
+    // Null when this firmware can apply it, else why not
+    const char* parse(const uint8_t *h) {
+        if (memcmp(h, "RDP1", 4)) return "not a delta";
+        if (h[4] != DELTA_VERSION) return "unknown delta version";
+        windowBits = h[5];
+        if (windowBits < 8 || windowBits > OTA_WINDOW_BITS_MAX) return "LZ window too large";
+        oldSize = le32(h + 8);
+        memcpy(oldHash, h + 12, 32);
+        newSize = le32(h + 44);
+        memcpy(newHash, h + 48, 32);
+        if (!newSize) return "empty image";
+        return nullptr;
+    }
+
+private:
+    static uint32_t le32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+};
+
+// LEB128, at most 32 bits
+struct Varint {
+    uint32_t value = 0;
+    uint8_t shift = 0;
+
+    // True once the last byte is in; bad when it runs past 32 bits
+    bool push(uint8_t b, bool &bad) {
+        if (shift == 28 && (b & 0xF0)) { bad = true; return true; }
+        value |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+        return !(b & 0x80);
+    }
+    uint32_t take() { uint32_t v = value; value = 0; shift = 0; return v; }
+};
+
+class DeltaPatch {
+private:
+    enum LzState : uint8_t { LZ_TOKEN, LZ_LITERAL, LZ_LENGTH, LZ_DISTANCE };
+    enum PatchState : uint8_t { P_DIFF_LEN, P_EXTRA_LEN, P_SEEK, P_DIFF, P_EXTRA };
+
+    DeltaIo *io = nullptr;
+    uint32_t oldSize = 0, newSize = 0;
+    const char *failure = nullptr;
+
+    // LZ: window of the last 2^bits patch bytes
+    uint8_t window[1 << OTA_WINDOW_BITS_MAX];
+    uint32_t mask = 0;
+    uint32_t produced = 0;
+    LzState lz = LZ_TOKEN;
+    uint32_t lzCount = 0;          // Literals left / match length
+    Varint lzNum;
+
+    // Patch records
+    PatchState ps = P_DIFF_LEN;
+    Varint num;
+    uint32_t diffLen = 0, extraLen = 0;
+    int32_t seek = 0;
+    uint32_t oldPos = 0;
+    uint32_t newPos = 0;           // New image bytes produced
+
+    uint8_t oldBuf[OTA_READ_BYTES];
+    uint32_t oldBufAt = 0, oldBufLen = 0;
+    uint8_t out[OTA_WRITE_BYTES];
+    size_t outLen = 0;
+
+    bool fail(const char *why) { if (!failure) failure = why; return false; }
+
+    bool flush() {
+        if (outLen && !io->writeNew(out, outLen)) return fail("flash write failed");
+        outLen = 0;
+        return true;
+    }
+
+    bool emit(uint8_t b) {
+        out[outLen++] = b;
+        newPos++;
+        return outLen < sizeof(out) || flush();
+    }
+
+    bool oldByte(uint32_t pos, uint8_t &b) {
+        if (pos - oldBufAt >= oldBufLen) {      // Unsigned: also below the buffer
+            oldBufAt = pos;
+            oldBufLen = std::min<uint32_t>(sizeof(oldBuf), oldSize - pos);
+            if (!io->readOld(pos, oldBuf, oldBufLen)) { oldBufLen = 0; return fail("old image read failed"); }
+        }
+        b = oldBuf[pos - oldBufAt];
+        return true;
+    }
+
+    // Diff run, extra run, seek, in that order; empty parts are skipped
+    bool nextPart() {
+        if (diffLen) { ps = P_DIFF; return true; }
+        if (extraLen) { ps = P_EXTRA; return true; }
+        int64_t pos = (int64_t)oldPos + seek;
+        if (pos < 0 || pos > oldSize) return fail("seek outside the old image");
+        oldPos = (uint32_t)pos;
+        ps = P_DIFF_LEN;
+        return true;
+    }
+
+    // One decompressed byte of the patch records
+    bool patchByte(uint8_t b) {
+        bool bad = false;
+        switch (ps) {
+            case P_DIFF_LEN:
+                if (newPos >= newSize) return fail("data after the image");
+                if (!num.push(b, bad)) return true;
+                diffLen = num.take();
+                ps = P_EXTRA_LEN;
+                break;
+            case P_EXTRA_LEN:
+                if (!num.push(b, bad)) return true;
+                extraLen = num.take();
+                ps = P_SEEK;
+                break;
+            case P_SEEK: {
+                if (!num.push(b, bad)) return true;
+                uint32_t z = num.take();
+                seek = (int32_t)((z >> 1) ^ (0u - (z & 1)));
+                if ((uint64_t)newPos + diffLen + extraLen > newSize) return fail("record past the new image");
+                if ((uint64_t)oldPos + diffLen > oldSize) return fail("record past the old image");
+                return bad ? fail("bad record") : nextPart();
+            }
+            case P_DIFF: {
+                uint8_t o;
+                if (!oldByte(oldPos++, o) || !emit(o + b)) return false;
+                return --diffLen ? true : nextPart();
+            }
+            case P_EXTRA:
+                if (!emit(b)) return false;
+                return --extraLen ? true : nextPart();
+        }
+        return bad ? fail("bad record") : true;
+    }
+
+    bool put(uint8_t b) {
+        window[produced++ & mask] = b;
+        return patchByte(b);
+    }
+
+public:
+    void begin(const DeltaHeader &h, DeltaIo *target) {
+        io = target;
+        oldSize = h.oldSize; newSize = h.newSize;
+        mask = (1u << h.windowBits) - 1;
+        failure = nullptr;
+        produced = 0; lz = LZ_TOKEN; lzCount = 0; lzNum = Varint();
+        ps = P_DIFF_LEN; num = Varint();
+        diffLen = extraLen = 0; seek = 0;
+        oldPos = newPos = 0;
+        oldBufAt = oldBufLen = 0;
+        outLen = 0;
+    }
+
+    // Compressed body, any chunk size, in order. False once it failed.
+    bool feed(const uint8_t *data, size_t len) {
+        for (size_t i = 0; i < len && !failure; i++) {
+            uint8_t b = data[i];
+            bool bad = false;
+            switch (lz) {
+                case LZ_TOKEN:
+                    if (b < 0x80) { lzCount = b + 1; lz = LZ_LITERAL; }
+                    else { lzCount = (b & 0x7F) + 3; lz = (b & 0x7F) == 0x7F ? LZ_LENGTH : LZ_DISTANCE; }
+                    break;
+                case LZ_LITERAL:
+                    put(b);
+                    if (--lzCount == 0) lz = LZ_TOKEN;
+                    break;
+                case LZ_LENGTH:
+                    if (!lzNum.push(b, bad)) break;
+                    if (bad || lzNum.value > newSize) { fail("bad match length"); break; }
+                    lzCount += lzNum.take();
+                    lz = LZ_DISTANCE;
+                    break;
+                case LZ_DISTANCE: {
+                    if (!lzNum.push(b, bad)) break;
+                    uint32_t d = lzNum.take();
+                    if (bad || d == 0 || d > mask + 1 || d > produced) { fail("bad match distance"); break; }
+                    for (; lzCount && put(window[(produced - d) & mask]); lzCount--) {}
+                    lz = LZ_TOKEN;
+                    break;
+                }
+            }
+        }
+        return !failure;
+    }
+
+    // Whole body fed: true when the new image came out complete
+    bool finish() {
+        if (failure) return false;
+        if (lz != LZ_TOKEN || ps != P_DIFF_LEN || newPos != newSize) return fail("delta ends early");
+        return flush();
+    }
+
+    uint32_t getWritten() { return newPos; }
+    const char* getError() { return failure; }
+};
@@ -0,0 +1,160 @@
+#pragma once
+#include <Arduino.h>
+#include <stdarg.h>
+#include "../Config.h"
+
+// ==========================================================
+// JsonWriter - JSON straight into a fixed buffer
+// The text counterpart of CborWriter: no document, no String,
+// commas and nesting tracked in one bit per level. Strings are
+// escaped, so SSIDs and plant names go out as given.
+//
+// JsonItemStream turns a producer into a chunked response body:
+// next() writes one item (a plant, a network, a zone) into a
+// small buffer, which fill() copies out in whatever chunk sizes
+// the TCP stack asks for. The writer keeps its nesting across
+// items, so memory per request is one item, however many items
+// the body holds. A producer keeps each item under
+// JSON_ITEM_BYTES (static_assert next to it); longer strings go
+// out in pieces, openStr() / strPart() / closeStr().
+// ==========================================================
+
+#define JSON_MAX_DEPTH      16
+
+// Longest str() output for n bytes: quotes, and every byte a
+// \u00XX escape (control characters)
+#define JSON_STR_MAX(n)     (2 + 6 * (n))
+
+class JsonWriter {
+private:
+    char *buf;
+    size_t cap;
+    size_t len = 0;
+    bool overflow = false;
+    uint8_t depth = 0;
+    uint16_t started = 0;        // Bit d: level d has a value (next one needs a comma)
+    bool afterKey = false;
+
+public:
+    JsonWriter(char *out, size_t size) : buf(out), cap(size) {}
+
+    // Continue into another buffer (the next stream item); nesting is kept
+    void reset(char *out, size_t size) { buf = out; cap = size; len = 0; overflow = false; }
+
+    void openObject() { value(); put('{'); push(); }
+    void closeObject() { pop(); put('}'); }
+    void openArray() { value(); put('['); push(); }
+    void closeArray() { pop(); put(']'); }
+
+    void key(const char *k) { value(); quoted(k); put(':'); afterKey = true; }
+
+    void str(const char *s) { value(); quoted(s); }
+    // One string over several items: up to n bytes per strPart()
+    void openStr() { value(); put('"'); }
+    void strPart(const char *s, size_t n) { escape(s, n); }
+    void closeStr() { put('"'); }
+    void integer(int32_t v) { value(); print("%ld", (long)v); }
+    void uint(uint32_t v) { value(); print("%lu", (unsigned long)v); }
+    void boolean(bool b) { value(); text(b ? "true" : "false"); }
+    void null() { value(); text("null"); }
+    // Fixed decimals; NaN / inf have no JSON form and go out as null
+    void real(float f, int decimals) {
+        value();
+        if (isnan(f) || isinf(f)) text("null");
+        else print("%.*f", decimals, f);
+    }
+
+    size_t size() { return len; }
+    bool ok() { return !overflow; }
+
+private:
+    // Comma before every value but the first of its level (a key's value is part of the pair)
+    void value() {
+        if (afterKey) { afterKey = false; return; }
+        if (depth && (started & (1u << depth))) put(',');
+        started |= 1u << depth;
+    }
+
+    void push() {
+        if (depth + 1 >= JSON_MAX_DEPTH) { overflow = true; return; }
+        depth++;
+        started &= ~(1u << depth);
+    }
+    void pop() { if (depth) depth--; }
+
+    void put(char c) {
+        if (len < cap) buf[len++] = c;
+        else overflow = true;
+    }
+
+    void text(const char *s) { while (*s) put(*s++); }
+
+    void print(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf + len, cap - len, fmt, ap);
+        va_end(ap);
+        if (n < 0 || (size_t)n >= cap - len) { overflow = true; len = cap; return; }
+        len += n;
+    }
+
+    void quoted(const char *s) {
+        put('"');
+        escape(s, strlen(s));
+        put('"');
+    }
+
+    void escape(const char *s, size_t n) {
+        for (const char *end = s + n; s < end && *s; s++) {
+            uint8_t c = (uint8_t)*s;
+            if (c == '"' || c == '\\') { put('\\'); put(c); }
+            else if (c == '\n') { put('\\'); put('n'); }
+            else if (c < 0x20) { static const char hex[] = "0123456789abcdef"; put('\\'); put('u'); put('0'); put('0'); put(hex[c >> 4]); put(hex[c & 15]); }
+            else put(c);
+        }
+    }
+};
+
+// Chunked response body built item by item (see the header)
+class JsonItemStream {
+private:
+    char item[JSON_ITEM_BYTES];
+    size_t itemLen = 0, itemPos = 0;
+    int index = 0;
+    bool done = false;
+    JsonWriter out{item, sizeof(item)};
+
+protected:
+    // Writes item i; false (nothing written) once the body is complete
+    virtual bool next(JsonWriter &w, int i) = 0;
+
+public:
+    virtual ~JsonItemStream() {}
+
+    // AsyncWebServer chunk filler: returns bytes written, 0 when done
+    size_t fill(char *buf, size_t maxLen) {
+        size_t n = 0;
+        while (n < maxLen) {
+            if (itemPos >= itemLen) {
+                if (done) break;
+                out.reset(item, sizeof(item));
+                if (!next(out, index++)) { done = true; break; }
+                if (!out.ok()) { Serial.println("[HTTP] JSON item overflow"); done = true; break; }
+                itemLen = out.size(); itemPos = 0;
+            }
+            size_t k = std::min(itemLen - itemPos, maxLen - n);
+            memcpy(buf + n, item + itemPos, k);
+            n += k; itemPos += k;
+        }
+        return n;
+    }
+
+    // Whole body into one buffer (SSE events); 0 if it did not fit
+    size_t write(char *buf, size_t size) {
+        JsonWriter w(buf, size);
+        for (int i = 0; next(w, i); i++) {}
+        if (!w.ok() || w.size() >= size) return 0;
+        buf[w.size()] = 0;
+        return w.size();
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+
+// ==========================================================
+// Metrics - Hot-path counters behind GET /metrics
+// Every series has exactly one writer task, which only does
+// relaxed atomic adds; readers (the scrape) may run on any
+// core. Nothing is formatted until /metrics is requested, so
+// an unscraped node pays a few adds per observation.
+//
+// Histogram values are microseconds; buckets are exported in
+// seconds, Prometheus style. The sum is kept in milliseconds
+// (the writer carries the sub-ms rest), which wraps after
+// ~49 days of accumulated latency instead of ~71 minutes.
+// ==========================================================
+
+#define METRICS_MAX_BUCKETS 12
+
+// Task steps and HTTP handlers: 50 us .. 100 ms
+static const uint32_t METRICS_LATENCY_US[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000 };
+// Pump queue wait: 1 s .. 5 min
+static const uint32_t METRICS_WAIT_US[] = { 1000000, 5000000, 15000000, 30000000, 60000000, 120000000, 300000000 };
+
+#define METRICS_BUCKETS(table) table, (uint8_t)(sizeof(table) / sizeof(table[0]))
+
+class Histogram {
+private:
+    const uint32_t *bounds;
+    uint8_t n;
+    std::atomic<uint32_t> counts[METRICS_MAX_BUCKETS + 1] = {};   // Last = +Inf
+    std::atomic<uint32_t> sumMs{0};
+    uint32_t restUs = 0;                                           // Writer only
+
+public:
+    Histogram(const uint32_t *b, uint8_t count) : bounds(b), n(count < METRICS_MAX_BUCKETS ? count : METRICS_MAX_BUCKETS) {}
+
+    // Writer task only
+    void observe(uint32_t us) {
+        uint8_t b = 0;
+        while (b < n && us > bounds[b]) b++;
+        counts[b].fetch_add(1, std::memory_order_relaxed);
+        restUs += us;
+        if (restUs >= 1000) { sumMs.fetch_add(restUs / 1000, std::memory_order_relaxed); restUs %= 1000; }
+    }
+
+    uint8_t buckets() const { return n; }
+    uint32_t bound(uint8_t i) const { return bounds[i]; }
+    // Observations in bucket i alone (i == buckets() is +Inf)
+    uint32_t count(uint8_t i) const { return counts[i].load(std::memory_order_relaxed); }
+    uint32_t getSumMs() const { return sumMs.load(std::memory_order_relaxed); }
+};
+
+// One instrumented HTTP route (written by the async_tcp task)
+struct RouteMetric {
+    const char *route = nullptr;
+    Histogram latency{METRICS_BUCKETS(METRICS_LATENCY_US)};
+};
+
+// --- TEXT FORMAT (scrape side) ---
+
+// Appends printf output to a fixed buffer, never past its end.
+// An add() that does not fit is dropped whole and sets
+// overflowed(); so is every add() after it, so the text always
+// ends on a line boundary.
+class MetricsText {
+private:
+    char *buf;
+    size_t cap;
+    size_t len = 0;
+    bool overflow = false;
+
+public:
+    MetricsText(char *out, size_t size) : buf(out), cap(size) { if (cap) buf[0] = 0; }
+
+    void add(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        if (overflow || len >= cap) { overflow = true; return; }
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf + len, cap - len, fmt, ap);
+        va_end(ap);
+        if (n < 0 || (size_t)n >= cap - len) { buf[len] = 0; overflow = true; return; }   // Drop the partial line
+        len += n;
+    }
+
+    void family(const char *name, const char *type, const char *help) {
+        add("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    // Cumulative buckets; labels like "task=\"control\"" or ""
+    void histogram(const char *name, const char *labels, const Histogram &h) {
+        const char *sep = labels[0] ? "," : "";
+        uint32_t total = 0;
+        char le[16];
+        for (uint8_t i = 0; i < h.buckets(); i++) {
+            total += h.count(i);
+            seconds(le, sizeof(le), h.bound(i));
+            add("%s_bucket{%s%sle=\"%s\"} %u\n", name, labels, sep, le, (unsigned)total);
+        }
+        total += h.count(h.buckets());
+        add("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, labels, sep, (unsigned)total);
+        uint32_t ms = h.getSumMs();
+        const char *open = labels[0] ? "{" : "", *close = labels[0] ? "}" : "";
+        add("%s_sum%s%s%s %u.%03u\n", name, open, labels, close, (unsigned)(ms / 1000), (unsigned)(ms % 1000));
+        add("%s_count%s%s%s %u\n", name, open, labels, close, (unsigned)total);
+    }
+
+    size_t size() { return len; }
+    bool overflowed() const { return overflow; }
+
+    // 250 -> "0.00025", 5000000 -> "5"
+    static void seconds(char *out, size_t size, uint32_t us) {
+        int n = snprintf(out, size, "%u.%06u", (unsigned)(us / 1000000), (unsigned)(us % 1000000));
+        while (n > 0 && out[n - 1] == '0') out[--n] = 0;
+        if (n > 0 && out[n - 1] == '.') out[--n] = 0;
+    }
+};
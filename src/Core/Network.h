@@ -5,113 +5,850 @@
 #include <AsyncTCP.h>
 #include <DNSServer.h>
 #include <ArduinoJson.h>
+#include <new>
 #include "../Config.h"
+#include "Snapshot.h"
+#include "JsonWriter.h"
+#include "Telemetry.h"
+#include "Channels.h"
+#include "Metrics.h"
+#include "Tasks.h"
+#include "Trace.h"
+#include "Power.h"
+#include "ConfigStore.h"
+#include "BatchParser.h"
+#include "Ota.h"
+#include "StaticAssets.h"
 #include "../Modules/PlantManager.h"
 #include "../Modules/SensorHub.h"
 #include "../Modules/Buzzer.h"
 #include "../Modules/UniversalSensor.h" 
+#include "../Modules/AdcSampler.h"
+#include "../Modules/HistoryLog.h"
+#include "../Modules/TelemetryPublisher.h"
 
-extern UniversalSensor sensors[4]; 
+extern UniversalSensor sensors[MAX_PLANTS]; 
+extern AdcSampler adcSampler;
+extern TaskRunner tasks;
+extern TelemetryPublisher telemetry;
+
+// Control task -> network task: which plant changed (-1 = structure)
+struct PlantEventMsg {
+    int8_t index;
+    uint8_t event;
+};
 
 class NetworkManager {
 private:
     AsyncWebServer server;
+    AsyncEventSource events;
     DNSServer dnsServer;
-    Preferences wifiPrefs;
     PlantManager* plantMgr;
     SensorHub* sensorHub;
     Buzzer* buzzer;
+    HistoryLog* history;
     bool wifiConnected = false;
+    bool apMode = false;                    // Setup AP up (no station configured)
     String currentSSID = "";
     unsigned long lastWifiCheck = 0;
+    uint32_t netVersion = 0;
+    uint32_t eventId = 0;
+    DataSnapshot<> snapshot;
+    DataSnapshot<TELEMETRY_BUF_SIZE> telemetry;
+    StaticAssets assets;
+
+    // Pushes are queued by the producing task and sent from update()
+    SpscQueue<PlantEventMsg, 16> plantEvents;
+    std::atomic<bool> envPending{false};
+    std::atomic<bool> resyncPending{false};
+    std::atomic<unsigned long> rebootAt{0};
+    uint32_t probeReported = 0;
+    uint32_t batchReported = 0;
+    char sensorsMsg[SENSORS_JSON_SIZE];     // Network task only
+
+    // [METRICS] Written by the network task (WiFi) and the async_tcp task (routes)
+    std::atomic<uint32_t> wifiReconnects{0};
+    std::atomic<uint32_t> wifiConnects{0};
+    std::atomic<uint32_t> batchesRejected{0};
+    std::atomic<uint32_t> batchesBusy{0};
+    std::atomic<uint32_t> metricsTruncated{0};
+    RouteMetric routes[METRICS_ROUTES];
+    int routeCount = 0;
 
 public:
-    NetworkManager(PlantManager* p, SensorHub* s, Buzzer* b) 
-        : server(80), plantMgr(p), sensorHub(s), buzzer(b) {}
+    // Wakes the network task for queued pushes and a pending reboot
+    TaskWake wake = nullptr;
+
+    NetworkManager(PlantManager* p, SensorHub* s, Buzzer* b, HistoryLog* h) 
+        : server(80), events("/api/events"), plantMgr(p), sensorHub(s), buzzer(b), history(h) {}
 
     void begin() {
-        wifiPrefs.begin("wifi", false);
-        String ssid = wifiPrefs.getString("ssid", "");
-        String pass = wifiPrefs.getString("pass", "");
-        if(ssid == "") { setupAP(); } 
-        else { WiFi.mode(WIFI_STA); WiFi.begin(ssid.c_str(), pass.c_str()); Serial.println("Connecting..."); }
+        char ssid[sizeof(ConfigValues::wifiSsid)], pass[sizeof(ConfigValues::wifiPass)];
+        config.getStr(CFG_WIFI_SSID, ssid, sizeof(ssid));
+        config.getStr(CFG_WIFI_PASS, pass, sizeof(pass));
+        if(!ssid[0]) { setupAP(); } 
+        else { WiFi.mode(WIFI_STA); WiFi.begin(ssid, pass); Serial.println("Connecting..."); }
+        snapshot.begin();
+        telemetry.begin();
+        plantMgr->addListener([this](const Plant *p, PlantEvent e){
+            if (!plantEvents.push({ (int8_t)(p ? p->originalIndex : -1), (uint8_t)e })) resyncPending = true;
+            if (wake) wake();
+        });
+        sensorHub->onEnvChange = [this](const EnvData &env){ envPending = true; if (wake) wake(); };
+        plantMgr->batchWake = wake;
         setupRoutes();
         server.begin();
     }
 
+    // Network task
     void update() {
-        dnsServer.processNextRequest();
+        { TRACE_SCOPE("net.dns"); dnsServer.processNextRequest(); }
         unsigned long now = millis();
+
+        // Deferred so the reply goes out and pending config hits flash first
+        unsigned long reboot = rebootAt.load();
+        if (reboot && (long)(now - reboot) >= 0) { rebootAt = 0; plantMgr->flush(); config.commit(); ESP.restart(); return; }
+        { TRACE_SCOPE("net.config"); config.persist(); }
         if (WiFi.status() != WL_CONNECTED) {
-            if (wifiPrefs.getString("ssid", "") != "" && (now - lastWifiCheck >= WIFI_CHECK_MS)) {
+            if (config.hasStr(CFG_WIFI_SSID) && (now - lastWifiCheck >= WIFI_CHECK_MS)) {
                 lastWifiCheck = now; WiFi.disconnect(); WiFi.reconnect();
+                wifiReconnects++;
             }
+            if(wifiConnected) { netVersion++; power.allowLightSleep(false); }
             wifiConnected = false;
         } else {
             if(!wifiConnected) {
                 wifiConnected = true; currentSSID = WiFi.SSID();
+                netVersion++;
+                wifiConnects++;
                 Serial.println("WiFi Connected: " + WiFi.localIP().toString());
                 buzzer->ready();
+                power.allowLightSleep(true);
             }
         }
+
+        // [OTA] A new image on trial: kept once healthy, else back to the previous one
+        if (ota.checkTrial(!config.hasStr(CFG_WIFI_SSID) || wifiConnected, now)) {
+            plantMgr->flush(); config.commit(); ota.rollback(); return;
+        }
+
+        // Refresh the shared /api/data snapshots only when something visible changed
+        uint32_t key = snapshotKey();
+        if (snapshot.needsRebuild(key)) {
+            TRACE_SCOPE("net.snapshot");
+            snapshot.rebuild(key, [this](uint8_t *out, size_t size, uint32_t version){ return fillData(out, size, version); });
+        }
+        if (telemetry.needsRebuild(key)) {
+            TRACE_SCOPE("net.cbor");
+            telemetry.rebuild(key, [this](uint8_t *out, size_t size, uint32_t version){ return fillTelemetry(out, size, version); });
+        }
+
+        TRACE_SCOPE("net.events");
+        drainEvents();
+    }
+
+    // Network task: ms until update() has work. Off-link it also
+    // polls: the setup AP's DNS, or the station link and its
+    // reconnect timer.
+    uint32_t nextDueMs() {
+        unsigned long now = millis();
+        NextDue next;
+        if (apMode) next.in(AP_DNS_POLL_MS);
+        else if (!wifiConnected) {
+            next.in(WIFI_LINK_POLL_MS);
+            if (config.hasStr(CFG_WIFI_SSID)) next.at(lastWifiCheck + WIFI_CHECK_MS, now);
+        }
+        unsigned long reboot = rebootAt.load();
+        if (reboot) next.at(reboot, now);
+        next.in(config.dueInMs(now));
+        next.in(ota.trialDueMs(now));
+        next.in(SNAPSHOT_UPTIME_MS - now % SNAPSHOT_UPTIME_MS);
+        uint32_t key = snapshotKey();
+        next.in(snapshot.rebuildDueMs(key));
+        next.in(telemetry.rebuildDueMs(key));
+        return next;
+    }
+
+    bool isApMode() { return apMode; }
+    uint32_t getDroppedEvents() { return plantEvents.getDropped(); }
+    uint32_t getDataBuildUs() { return snapshot.getBuildUs(); }
+    uint32_t getTelemetryBuildUs() { return telemetry.getBuildUs(); }
+
+    // --- METRICS EXPORT (/metrics, chunked, bounded memory) ---
+    // Reads the counters as they are; series written by other
+    // tasks may be a few observations apart within one scrape.
+    class MetricsStream {
+    private:
+        NetworkManager *net;
+        int stage = 0, index = 0;    // Stage = block of families, index = item within it
+        char item[METRICS_ITEM_BYTES];
+        size_t itemLen = 0, itemPos = 0;
+
+        // Fills item with the next block; false when the stage is done
+        bool emit(MetricsText &out) {
+            PumpScheduler &pumps = net->plantMgr->getPumps();
+            char labels[48];
+            switch (stage) {
+            case 0: {
+                if (index > 0) return false;
+                out.family("rosemary_uptime_seconds", "gauge", "Time since boot");
+                out.add("rosemary_uptime_seconds %lu\n", (unsigned long)(millis() / 1000));
+                uint32_t heapFree = ESP.getFreeHeap(), largest = ESP.getMaxAllocHeap();
+                out.family("rosemary_heap_free_bytes", "gauge", "Free heap");
+                out.add("rosemary_heap_free_bytes %u\n", (unsigned)heapFree);
+                out.family("rosemary_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+                out.add("rosemary_heap_min_free_bytes %u\n", (unsigned)ESP.getMinFreeHeap());
+                out.family("rosemary_heap_largest_free_block_bytes", "gauge", "Largest allocatable block");
+                out.add("rosemary_heap_largest_free_block_bytes %u\n", (unsigned)largest);
+                out.family("rosemary_heap_fragmentation_ratio", "gauge", "1 - largest block / free heap");
+                out.add("rosemary_heap_fragmentation_ratio %.3f\n", heapFree ? 1.0f - (float)largest / heapFree : 0.0f);
+                return true;
+            }
+            case 1: {
+                if (index > 0) return false;
+                out.family("rosemary_fs_total_bytes", "gauge", "LittleFS partition size");
+                out.add("rosemary_fs_total_bytes %u\n", (unsigned)LittleFS.totalBytes());
+                out.family("rosemary_fs_used_bytes", "gauge", "LittleFS bytes in use");
+                out.add("rosemary_fs_used_bytes %u\n", (unsigned)LittleFS.usedBytes());
+                out.family("rosemary_fs_writes_total", "counter", "Flash writes by source (history flush, config commit, spool record)");
+                out.add("rosemary_fs_writes_total{source=\"history\"} %u\n", (unsigned)net->history->getWrites());
+                out.add("rosemary_fs_writes_total{source=\"config\"} %u\n", (unsigned)net->plantMgr->getConfigCommits());
+                out.add("rosemary_fs_writes_total{source=\"spool\"} %u\n", (unsigned)::telemetry.getSpilled());
+                out.family("rosemary_fs_written_bytes_total", "counter", "Bytes appended to flash logs by source");
+                out.add("rosemary_fs_written_bytes_total{source=\"history\"} %u\n", (unsigned)net->history->getBytesWritten());
+                out.add("rosemary_fs_written_bytes_total{source=\"spool\"} %u\n", (unsigned)::telemetry.getSpilledBytes());
+                out.family("rosemary_nvs_commits_total", "counter", "Settings commits to NVS (dirty keys only)");
+                out.add("rosemary_nvs_commits_total %u\n", (unsigned)config.getCommits());
+                out.family("rosemary_nvs_keys_written_total", "counter", "Settings keys written to NVS");
+                out.add("rosemary_nvs_keys_written_total %u\n", (unsigned)config.getKeysWritten());
+                return true;
+            }
+            case 2: {
+                if (index > 0) return false;
+                out.family("rosemary_wifi_connected", "gauge", "Station link up");
+                out.add("rosemary_wifi_connected %d\n", WiFi.status() == WL_CONNECTED ? 1 : 0);
+                out.family("rosemary_wifi_rssi_dbm", "gauge", "Station signal strength");
+                out.add("rosemary_wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+                out.family("rosemary_wifi_reconnects_total", "counter", "Reconnect attempts while the link was down");
+                out.add("rosemary_wifi_reconnects_total %u\n", (unsigned)net->wifiReconnects.load());
+                out.family("rosemary_wifi_connects_total", "counter", "Link came up");
+                out.add("rosemary_wifi_connects_total %u\n", (unsigned)net->wifiConnects.load());
+                out.family("rosemary_sse_events_dropped_total", "counter", "Plant events coalesced into a resync");
+                out.add("rosemary_sse_events_dropped_total %u\n", (unsigned)net->getDroppedEvents());
+                out.family("rosemary_api_batches_total", "counter", "Plant change batches (/api/batch and the single-plant routes): accepted, rejected (bad body or op), busy (last one still queued)");
+                out.add("rosemary_api_batches_total{result=\"accepted\"} %u\n", (unsigned)net->plantMgr->getBatchesApplied());
+                out.add("rosemary_api_batches_total{result=\"rejected\"} %u\n", (unsigned)(net->batchesRejected.load() + net->plantMgr->getBatchesRefused()));
+                out.add("rosemary_api_batches_total{result=\"busy\"} %u\n", (unsigned)net->batchesBusy.load());
+                return true;
+            }
+            case 3: {   // One task per item
+                if (index >= tasks.size()) return false;
+                if (index == 0) out.family("rosemary_task_duration_seconds", "histogram", "Run time of one task step");
+                snprintf(labels, sizeof(labels), "task=\"%s\"", tasks.get(index).name);
+                out.histogram("rosemary_task_duration_seconds", labels, tasks.get(index).latency);
+                return true;
+            }
+            case 4: {
+                if (index > 0) return false;
+                out.family("rosemary_task_overruns_total", "counter", "Steps that took longer than the task period");
+                for (int i = 0; i < tasks.size(); i++) out.add("rosemary_task_overruns_total{task=\"%s\"} %u\n", tasks.get(i).name, (unsigned)tasks.get(i).overruns);
+                out.family("rosemary_task_wakeups_total", "counter", "Task steps by what ended the sleep (deadline or a wake from another task/ISR)");
+                for (int i = 0; i < tasks.size(); i++) {
+                    const PeriodicTask &t = tasks.get(i);
+                    out.add("rosemary_task_wakeups_total{task=\"%s\",cause=\"deadline\"} %u\n", t.name, (unsigned)(t.runs - t.woken));
+                    out.add("rosemary_task_wakeups_total{task=\"%s\",cause=\"wake\"} %u\n", t.name, (unsigned)t.woken);
+                }
+                out.family("rosemary_light_sleep_allowed", "gauge", "1 while idle gaps may light-sleep (STA mode, no holds)");
+                out.add("rosemary_light_sleep_allowed %d\n", power.canSleep() ? 1 : 0);
+                return true;
+            }
+            case 5: {   // One route per item; _count is the request count
+                if (index >= net->routeCount) return false;
+                if (index == 0) out.family("rosemary_http_request_duration_seconds", "histogram", "Handler time per route (excludes streaming the body)");
+                snprintf(labels, sizeof(labels), "route=\"%s\"", net->routes[index].route);
+                out.histogram("rosemary_http_request_duration_seconds", labels, net->routes[index].latency);
+                return true;
+            }
+            case 6: case 7: {   // Per-zone pump counters, METRICS_ZONES_PER_ITEM at a time
+                int first = index * METRICS_ZONES_PER_ITEM;
+                if (first >= MAX_PLANTS) return false;
+                bool runtime = stage == 7;
+                const char *name = runtime ? "rosemary_pump_runtime_seconds_total" : "rosemary_pump_starts_total";
+                if (index == 0) out.family(name, "counter", runtime ? "Pump on-time per zone (completed runs)" : "Pump starts per zone");
+                for (int z = first; z < first + METRICS_ZONES_PER_ITEM && z < MAX_PLANTS; z++) {
+                    if (runtime) { uint32_t ms = pumps.getRunMs(z); out.add("%s{zone=\"%d\"} %u.%03u\n", name, z, (unsigned)(ms / 1000), (unsigned)(ms % 1000)); }
+                    else out.add("%s{zone=\"%d\"} %u\n", name, z, (unsigned)pumps.getStarts(z));
+                }
+                return true;
+            }
+            case 8: {
+                if (index > 0) return false;
+                out.family("rosemary_water_queue_depth", "gauge", "Watering requests waiting for supply budget");
+                out.add("rosemary_water_queue_depth %u\n", (unsigned)pumps.getQueued());
+                out.family("rosemary_water_queue_wait_seconds", "histogram", "Time from request to pump start");
+                out.histogram("rosemary_water_queue_wait_seconds", "", pumps.getWait());
+                return true;
+            }
+            case 9: {
+                if (index > 0) return false;
+                static const char *names[] = { "busy", "ok", "timeout", "timing", "checksum" };
+                out.family("rosemary_dht_reads_total", "counter", "DHT22 frames by outcome");
+                for (int r = Dht22::OK; r < Dht22::RESULT_COUNT; r++)
+                    out.add("rosemary_dht_reads_total{result=\"%s\"} %u\n", names[r], (unsigned)net->sensorHub->getDhtResults((Dht22::Result)r));
+                out.family("rosemary_env_age_seconds", "gauge", "Time since the last valid DHT22 frame");
+                uint32_t age = net->sensorHub->getEnvAgeMs();
+                out.add("rosemary_env_age_seconds %u.%03u\n", (unsigned)(age / 1000), (unsigned)(age % 1000));
+                return true;
+            }
+            case 10: {   // Per-zone sensor health, METRICS_ZONES_PER_ITEM at a time
+                int first = index * METRICS_ZONES_PER_ITEM;
+                if (first >= MAX_PLANTS) return false;
+                SensorHealth &health = net->plantMgr->getHealth();
+                if (index == 0) {
+                    out.family("rosemary_sensor_anomalies_total", "counter", "Sensor anomaly flags raised, by kind");
+                    for (int k = 0; k < ANOMALY_KINDS; k++) out.add("rosemary_sensor_anomalies_total{kind=\"%s\"} %u\n", SensorHealth::kindName(k), (unsigned)health.getAnomalies(k));
+                    out.family("rosemary_auto_water_withheld_total", "counter", "Auto-watering refused for a low sensor health score");
+                    out.add("rosemary_auto_water_withheld_total %u\n", (unsigned)health.getWithheld());
+                    out.family("rosemary_sensor_health", "gauge", "Sensor health score per zone (0-100)");
+                }
+                for (int z = first; z < first + METRICS_ZONES_PER_ITEM && z < MAX_PLANTS; z++) out.add("rosemary_sensor_health{zone=\"%d\"} %u\n", z, (unsigned)health.getScore(z));
+                return true;
+            }
+            case 11: {
+                if (index > 0) return false;
+                out.family("rosemary_ota_updates_total", "counter", "POST /api/ota uploads: applied (boots next) or rejected");
+                out.add("rosemary_ota_updates_total{result=\"applied\"} %u\n", (unsigned)ota.getApplied());
+                out.add("rosemary_ota_updates_total{result=\"rejected\"} %u\n", (unsigned)ota.getRejected());
+                out.family("rosemary_ota_on_trial", "gauge", "1 while the running image is not kept yet");
+                out.add("rosemary_ota_on_trial %d\n", ota.isOnTrial() ? 1 : 0);
+                return true;
+            }
+            case 12: {  // Own block: with stage 2 it outgrows one item
+                if (index > 0 || !::telemetry.isEnabled()) return false;
+                out.family("rosemary_mqtt_published_frames_total", "counter", "Telemetry frames sent to the broker");
+                out.add("rosemary_mqtt_published_frames_total %u\n", (unsigned)::telemetry.getPublished());
+                out.family("rosemary_mqtt_dropped_frames_total", "counter", "Telemetry frames lost (spool full or unreadable)");
+                out.add("rosemary_mqtt_dropped_frames_total %u\n", (unsigned)::telemetry.getDropped());
+                out.family("rosemary_mqtt_backlog_frames", "gauge", "Telemetry frames waiting in RAM and spool");
+                out.add("rosemary_mqtt_backlog_frames %u\n", (unsigned)::telemetry.getBacklog());
+                out.family("rosemary_mqtt_connects_total", "counter", "Broker connections");
+                out.add("rosemary_mqtt_connects_total %u\n", (unsigned)::telemetry.getConnects());
+                return true;
+            }
+            case 13: {  // Last, so it counts this scrape's blocks too
+                if (index > 0) return false;
+                out.family("rosemary_metrics_truncated_total", "counter", "/metrics blocks cut short (METRICS_ITEM_BYTES too small)");
+                out.add("rosemary_metrics_truncated_total %u\n", (unsigned)net->metricsTruncated.load());
+                return true;
+            }
+            }
+            return false;
+        }
+
+        bool nextItem() {
+            while (stage <= 13) {
+                MetricsText out(item, sizeof(item));
+                if (emit(out)) {
+                    if (out.overflowed()) net->metricsTruncated++;   // Whole lines kept, the rest dropped
+                    index++; itemLen = out.size(); return true;
+                }
+                stage++; index = 0;
+            }
+            return false;
+        }
+
+    public:
+        MetricsStream(NetworkManager *n) : net(n) {}
+
+        // AsyncWebServer chunk filler: returns bytes written, 0 when done
+        size_t fill(char *buf, size_t maxLen) {
+            size_t n = 0;
+            while (n < maxLen) {
+                if (itemPos >= itemLen) {
+                    if (!nextItem()) break;
+                    itemPos = 0;
+                }
+                size_t k = std::min(itemLen - itemPos, maxLen - n);
+                memcpy(buf + n, item + itemPos, k);
+                n += k; itemPos += k;
+            }
+            return n;
+        }
+    };
+
+    // --- ENCODERS (also run by the host simulation to compare formats) ---
+
+    // /api/data, written straight into the snapshot buffer. Returns 0 on overflow.
+    size_t fillData(uint8_t *out, size_t size, uint32_t version) {
+        JsonWriter w((char*)out, size);
+        PlantTable& plants = plantMgr->getPlants();
+        w.openObject();
+        w.key("plants"); w.openArray();
+        for (auto &p : plants) {
+            w.openObject();
+            w.key("id"); w.integer(p.id);
+            w.key("name"); w.str(p.name);
+            w.key("type"); w.str(plantTypeName(p.type));
+            w.key("threshold"); w.integer(p.threshold);
+            w.key("moisture"); w.integer(p.currentMoisture);
+            w.key("noise"); w.integer(p.moistureNoise);
+            w.key("sensor_mode"); w.str(UniversalSensor::modeName(p.sensorMode));
+            w.key("error"); w.boolean(p.errorStatus);
+            w.key("originalIndex"); w.integer(p.originalIndex);
+            w.key("duration"); w.integer(p.duration);
+            w.key("is_watering"); w.boolean(p.isWatering);
+            w.key("water_gain"); w.integer(p.waterGain);
+            w.key("soak_ms"); w.integer(p.soakMs);
+            w.key("health"); w.integer(p.health);
+            w.key("anomaly"); w.str(SensorHealth::anomalyName(p.anomalies));
+            w.closeObject();
+        }
+        w.closeArray();
+
+        w.key("wifi_connected"); w.boolean(wifiConnected);
+        w.key("ssid"); w.str(wifiConnected ? currentSSID.c_str() : AP_SSID_DEFAULT);
+        w.key("ip"); w.str((wifiConnected ? WiFi.localIP() : WiFi.softAPIP()).toString().c_str());
+        w.key("uptime"); w.uint(millis() / 1000);
+        w.key("version"); w.uint(version);
+
+        EnvData env = sensorHub->getEnv();
+        w.key("env"); w.openObject();   // Empty while the DHT22 is stale
+        if (env.isValid()) { w.key("temp"); w.real(env.temp, 1); w.key("hum"); w.real(env.hum, 1); w.key("vpd"); w.real(env.vpd, 2); }
+        w.closeObject();
+        w.key("dnd"); w.boolean(buzzer->isDND());
+        w.key("pump_late_ms"); w.uint(plantMgr->getStopLateMax());
+        w.closeObject();
+        return w.ok() ? w.size() : 0;
+    }
+
+    // Same state as fillData, schema in Telemetry.h. Returns 0 on overflow.
+    size_t fillTelemetry(uint8_t *out, size_t size, uint32_t version) {
+        CborWriter w(out, size);
+        PlantTable::View plants = plantMgr->getPlants().view();   // Count and items must agree
+        w.map(TK_COUNT);
+        w.key(TK_SCHEMA); w.uint(TELEMETRY_SCHEMA);
+        w.key(TK_VERSION); w.uint(version);
+        w.key(TK_UPTIME); w.uint(millis() / 1000);
+
+        w.key(TK_PLANTS); w.array(plants.size());
+        for (auto &p : plants) {
+            w.map(TP_COUNT);
+            w.key(TP_ID); w.integer(p.id);
+            w.key(TP_NAME); w.text(p.name);
+            w.key(TP_TYPE); w.uint(p.type);
+            w.key(TP_THRESHOLD); w.integer(p.threshold);
+            w.key(TP_MOISTURE); w.integer(p.currentMoisture);
+            w.key(TP_NOISE); w.integer(p.moistureNoise);
+            w.key(TP_SENSOR); w.uint(p.sensorMode);
+            w.key(TP_ERROR); w.boolean(p.errorStatus);
+            w.key(TP_ZONE); w.integer(p.originalIndex);
+            w.key(TP_DURATION); w.integer(p.duration);
+            w.key(TP_WATERING); w.boolean(p.isWatering);
+            w.key(TP_WATER_GAIN); w.integer(p.waterGain);
+            w.key(TP_SOAK_MS); w.integer(p.soakMs);
+            w.key(TP_HEALTH); w.uint(p.health);
+            w.key(TP_ANOMALY); w.uint(p.anomalies);
+        }
+
+        EnvData env = sensorHub->getEnv();
+        w.key(TK_ENV); w.map(TE_COUNT);
+        w.key(TE_TEMP); w.real(env.temp);
+        w.key(TE_HUM); w.real(env.hum);
+        w.key(TE_VPD); w.real(env.vpd);
+
+        w.key(TK_WIFI); w.boolean(wifiConnected);
+        w.key(TK_SSID); w.text(wifiConnected ? currentSSID.c_str() : AP_SSID_DEFAULT);
+        w.key(TK_IP); w.text((wifiConnected ? WiFi.localIP() : WiFi.softAPIP()).toString().c_str());
+        w.key(TK_DND); w.boolean(buzzer->isDND());
+        w.key(TK_PUMP_LATE_MS); w.uint(plantMgr->getStopLateMax());
+        return w.ok() ? w.size() : 0;
     }
 
 private:
+    // Uptime counts in SNAPSHOT_UPTIME_MS steps, so a cached body (and
+    // its ETag) is never more than one step behind the clock
+    uint32_t snapshotKey() {
+        return plantMgr->getStateVersion() + sensorHub->getEnvVersion() + netVersion + millis() / SNAPSHOT_UPTIME_MS +
+               (buzzer->isDND() ? 0x80000000UL : 0);
+    }
+
+    // Any task (routes): the network task restarts once the reply is out
+    void scheduleReboot(unsigned long delayMs) {
+        rebootAt = millis() + delayMs;
+        if (wake) wake();
+    }
+
     void setupAP() {
+        apMode = true;
         WiFi.softAP(AP_SSID_DEFAULT);
         dnsServer.start(53, "*", WiFi.softAPIP());
     }
 
+    // Coalesce queued changes: at most one event per plant per pass
+    void drainEvents() {
+        PlantEventMsg msg;
+        static_assert(MAX_PLANTS <= 64, "zone mask is 64 bits");
+        uint64_t zones = 0;
+        bool sync = resyncPending.exchange(false);
+        while (plantEvents.pop(msg)) {
+            if (msg.index < 0 || msg.index >= MAX_PLANTS) sync = true;
+            else zones |= 1ULL << msg.index;
+        }
+        bool env = envPending.exchange(false);
+        uint32_t probes = adcSampler.getReportCount();
+        bool sensorsChanged = probes != probeReported;
+        probeReported = probes;
+        uint32_t batchDone = plantMgr->getBatchDone();
+        bool batchRan = batchDone != batchReported;
+        batchReported = batchDone;
+        if (events.count() == 0) return;
+
+        if (sync) events.send("{}", "sync", ++eventId);
+        else for (int i = 0; i < MAX_PLANTS; i++) if (zones & (1ULL << i)) pushPlant(i);
+        if (env) pushEnv(sensorHub->getEnv());
+        if (sensorsChanged) {
+            formatSensors(sensorsMsg, sizeof(sensorsMsg));
+            events.send(sensorsMsg, "sensors", ++eventId);
+        }
+        if (batchRan) {
+            char msg[48];
+            snprintf(msg, sizeof(msg), "{\"batch\":%u,\"applied\":%s}", (unsigned)(batchDone >> 1), batchDone & 1 ? "true" : "false");
+            events.send(msg, "batch", ++eventId);
+        }
+    }
+
+    // Presence probe results for all zones (no ADC access here), one zone per item
+    class SensorsJson : public JsonItemStream {
+    protected:
+        bool next(JsonWriter &w, int i) override {
+            if (i == 0) {
+                w.openObject();
+                w.key("probe"); w.uint(adcSampler.getProbeCount());
+                w.key("pending"); w.boolean(adcSampler.isProbing());
+                w.key("zones"); w.openArray();
+                return true;
+            }
+            int z = i - 1;
+            if (z > MAX_PLANTS) return false;
+            if (z == MAX_PLANTS) { w.closeArray(); w.closeObject(); return true; }
+            w.openObject();
+            w.key("index"); w.integer(z);
+            w.key("mode"); w.str(UniversalSensor::modeName(sensors[z].getMode()));
+            w.key("raw"); w.integer(sensors[z].getBurstRaw());
+            w.key("pull_high"); w.integer(sensors[z].getProbeHigh());
+            w.key("pull_low"); w.integer(sensors[z].getProbeLow());
+            w.closeObject();
+            return true;
+        }
+    };
+
+    // Finished scan, one network per item; the results are freed once sent
+    class ScanJson : public JsonItemStream {
+    private:
+        // Comma, {"ssid":, a 32-byte SSID of control characters, ,"secure":false}
+        static_assert(JSON_ITEM_BYTES >= 1 + 8 + JSON_STR_MAX(32) + 16, "a scanned network can outgrow JSON_ITEM_BYTES");
+        int count;
+
+    protected:
+        bool next(JsonWriter &w, int i) override {
+            if (i == 0) { w.openArray(); return true; }
+            if (i > count + 1) return false;
+            if (i == count + 1) { w.closeArray(); return true; }
+            w.openObject();
+            w.key("ssid"); w.str(WiFi.SSID(i - 1).c_str());
+            w.key("secure"); w.boolean(WiFi.encryptionType(i - 1) != WIFI_AUTH_OPEN);
+            w.closeObject();
+            return true;
+        }
+
+    public:
+        ScanJson(int n) : count(n) {}
+        ~ScanJson() { WiFi.scanDelete(); }
+    };
+
+    size_t formatSensors(char *out, size_t size) { return SensorsJson().write(out, size); }
+
+    // [PUSH] Small delta events instead of full-JSON polling
+    void pushPlant(int index) {
+        const Plant *p = plantMgr->getPlants().byZone(index);
+        if (!p) return;
+
+        char msg[200];
+        snprintf(msg, sizeof(msg), "{\"originalIndex\":%d,\"moisture\":%d,\"noise\":%d,\"threshold\":%d,\"duration\":%d,\"error\":%s,\"is_watering\":%s,\"health\":%d,\"anomaly\":\"%s\"}",
+                 p->originalIndex, p->currentMoisture, p->moistureNoise, p->threshold, p->duration,
+                 p->errorStatus ? "true" : "false", p->isWatering ? "true" : "false", p->health, SensorHealth::anomalyName(p->anomalies));
+        events.send(msg, "plant", ++eventId);
+    }
+
+    void pushEnv(const EnvData &env) {
+        char msg[96];
+        if (!env.isValid()) snprintf(msg, sizeof(msg), "{\"temp\":null,\"hum\":null,\"vpd\":null}");   // DHT stale
+        else snprintf(msg, sizeof(msg), "{\"temp\":%.1f,\"hum\":%.1f,\"vpd\":%.2f}", env.temp, env.hum, env.vpd);
+        events.send(msg, "env", ++eventId);
+    }
+
     void setupRoutes() {
-        server.on("/", HTTP_GET, [](AsyncWebServerRequest *req){ req->send(LittleFS, "/index.html", "text/html"); });
-        server.serveStatic("/", LittleFS, "/");
-
-        // [CORE API] Safe Memory Allocation
-        server.on("/api/data", HTTP_GET, [this](AsyncWebServerRequest *req){
-            DynamicJsonDocument *doc = new DynamicJsonDocument(16000); 
-            if (!doc) { req->send(500, "text/plain", "OOM"); return; }
-
-            JsonArray plantsArr = doc->createNestedArray("plants");
-            std::vector<Plant>& plants = plantMgr->getPlants();
-            for(auto &p : plants) {
-                JsonObject obj = plantsArr.createNestedObject();
-                obj["id"] = p.id; obj["name"] = p.name; obj["type"] = p.type;
-                obj["threshold"] = p.threshold; obj["moisture"] = p.currentMoisture;
-                obj["sensor_mode"] = p.sensorMode; obj["error"] = p.errorStatus;
-                obj["originalIndex"] = p.originalIndex; obj["duration"] = p.duration;
-                obj["is_watering"] = p.isWatering;
-            }
-
-            (*doc)["wifi_connected"] = wifiConnected;
-            (*doc)["ssid"] = wifiConnected ? currentSSID : AP_SSID_DEFAULT;
-            (*doc)["ip"] = wifiConnected ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
-            (*doc)["uptime"] = millis()/1000;
-            
-            EnvData env = sensorHub->getEnv();
-            (*doc)["env"]["temp"] = env.temp; (*doc)["env"]["hum"] = env.hum; (*doc)["env"]["vpd"] = env.vpd;
-            (*doc)["dnd"] = buzzer->isDND();
-            
-            String res; serializeJson(*doc, res); 
-            req->send(200, "application/json", res);
-            delete doc;
-        });
+        // [ASSETS] Pre-gzipped /www image from tools/build_assets.py
+        if (assets.begin(trackRoute("/static"))) {
+            server.addHandler(&assets);
+        } else {
+            // Raw data/ upload: served as is, uncompressed and uncached
+            Serial.println("[WEB] No " ASSET_INDEX_PATH ", serving raw files");
+            server.on("/", HTTP_GET, timed("/", [](AsyncWebServerRequest *req){ req->send(LittleFS, "/index.html", "text/html"); }));
+            server.serveStatic("/", LittleFS, "/");
+        }
+
+        // [CORE API] Shared Snapshot: zero-copy, no per-request allocation, ETag/304
+        server.on("/api/data", HTTP_GET, timed("/api/data", [this](AsyncWebServerRequest *req){ serveSnapshot(req, snapshot, "application/json"); }));
+        // [TELEMETRY] Same state as CBOR with integer keys, for fleet scrapers
+        server.on("/api/data.cbor", HTTP_GET, timed("/api/data.cbor", [this](AsyncWebServerRequest *req){ serveSnapshot(req, telemetry, "application/cbor"); }));
+
+        // [PUSH] SSE stream; clients resync from /api/data on (re)connect
+        events.onConnect([this](AsyncEventSourceClient *client){ client->send("{}", "hello", eventId, 3000); });
+        server.addHandler(&events);
+
+        // [HISTORY] ?zone=N or ?series=env, &hours=24, &step=seconds (downsample)
+        server.on("/api/history", HTTP_GET, timed("/api/history", [this](AsyncWebServerRequest *req){
+            int s = req->hasParam("zone") ? req->getParam("zone")->value().toInt() : -1;
+            if (req->hasParam("series") && req->getParam("series")->value() == "env") s = HIST_SERIES_ENV;
+            if (s < 0 || s >= HIST_SERIES_COUNT) { req->send(400, "text/plain", "Error"); return; }
+
+            uint32_t hours = req->hasParam("hours") ? req->getParam("hours")->value().toInt() : 24;
+            uint32_t step = req->hasParam("step") ? req->getParam("step")->value().toInt() : 0;
+            uint32_t now = history->clock();
+            uint32_t since = (now > hours * 3600) ? now - hours * 3600 : 0;
+
+            auto stream = std::make_shared<HistoryLog::JsonStream>(history, s, since, step);
+            req->send(req->beginChunkedResponse("application/json", [stream](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                return stream->fill((char*)buf, maxLen);
+            }));
+        }));
 
         server.on("/api/water", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, 
-            [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){
+            timedBody("/api/water", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){
                 DynamicJsonDocument doc(128); deserializeJson(doc, data);
-                if(doc.containsKey("index")) { plantMgr->activatePump(doc["index"]); req->send(200,"text/plain","OK"); }
-                else req->send(400,"text/plain","Error");
-            });
+                int idx = doc.containsKey("index") ? doc["index"].as<int>() : -1;
+                if(idx >= 0 && idx < MAX_PLANTS) { BatchOp op; op.kind = BOP_WATER; op.zone = idx; runOne(req, op); }
+                else req->send(400,"text/plain","Index Error");
+            }));
 
-        server.on("/api/add-plant", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(1024); deserializeJson(doc, data); bool success = plantMgr->addPlant(doc["name"].as<String>(), doc["type"].as<String>(), doc["threshold"].as<int>()); if(success) req->send(200,"text/plain","OK"); else req->send(400,"text/plain","Error"); });
-        server.on("/api/update-config", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(512); deserializeJson(doc, data); int id = doc["id"]; int threshold = doc.containsKey("threshold") ? doc["threshold"].as<int>() : -1; int duration = doc.containsKey("duration") ? doc["duration"].as<int>() : -1; if(plantMgr->updateConfig(id, threshold, duration)) req->send(200, "text/plain", "Updated"); else req->send(404, "text/plain", "Not Found"); });
-        server.on("/api/delete-plant", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(256); deserializeJson(doc,data); if(plantMgr->deletePlant(doc["id"])) req->send(200,"text/plain","Deleted"); else req->send(404,"text/plain","Not Found"); });
+        // Single-plant changes are one-op batches: checked and applied on the control task
+        server.on("/api/add-plant", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/add-plant", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(1024); deserializeJson(doc, data); BatchOp op; op.kind = BOP_ADD; strlcpy(op.name, doc["name"] | "", sizeof(op.name)); strlcpy(op.type, doc["type"] | "", sizeof(op.type)); if (doc.containsKey("threshold")) op.threshold = constrain(doc["threshold"].as<int>(), 0, 100); runOne(req, op); }));
+        server.on("/api/update-config", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/update-config", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(512); deserializeJson(doc, data); int id = doc["id"]; int threshold = doc.containsKey("threshold") ? doc["threshold"].as<int>() : -1; int duration = doc.containsKey("duration") ? doc["duration"].as<int>() : -1; BatchOp op; op.kind = BOP_UPDATE; op.id = id; op.threshold = threshold; op.duration = duration; runOne(req, op); }));
+        server.on("/api/delete-plant", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/delete-plant", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(256); deserializeJson(doc,data); BatchOp op; op.kind = BOP_DELETE; op.id = doc["id"]; runOne(req, op); }));
+        // Queued, not waited on: the result arrives as a "batch" event and
+        // through GET /api/batch once "batch" reaches the returned number
+        server.on("/api/batch", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/batch", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ batchBody(req, data, len, index, total); }));
+        server.on("/api/batch", HTTP_GET, timed("/api/batch", [this](AsyncWebServerRequest *req){ sendBatchResult(req); }));
         
-        server.on("/api/scan", HTTP_GET, [](AsyncWebServerRequest *req){ int n = WiFi.scanComplete(); if(n == -2) { WiFi.scanNetworks(true); req->send(200, "application/json", "[]"); } else if(n == -1) { req->send(200, "application/json", "[]"); } else { String json = "["; for(int i=0; i<n; ++i){ if(i) json += ","; json += "{\"ssid\":\""+WiFi.SSID(i)+"\",\"secure\":"+(WiFi.encryptionType(i)!=WIFI_AUTH_OPEN)+"}"; } json += "]"; WiFi.scanDelete(); req->send(200, "application/json", json); } });
-        server.on("/api/save-wifi", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(512); deserializeJson(doc,data); wifiPrefs.putString("ssid", doc["ssid"].as<String>()); wifiPrefs.putString("pass", doc["password"].as<String>()); req->send(200,"text/plain","Saved"); delay(1000); ESP.restart(); });
-        server.on("/api/reboot", HTTP_POST, [](AsyncWebServerRequest *req){ req->send(200,"text/plain","Rebooting"); delay(500); ESP.restart(); });
-        server.on("/api/detect-sensor", HTTP_GET, [this](AsyncWebServerRequest *req){ if(req->hasParam("index")){ int idx = req->getParam("index")->value().toInt(); if(idx >= 0 && idx < 4) { sensors[idx].forceDetect(); int raw = sensors[idx].getRaw(); String mode = sensors[idx].getModeString(); String json = "{\"raw\":" + String(raw) + ", \"mode\":\"" + mode + "\"}"; buzzer->beep(); req->send(200,"application/json",json); } else { req->send(400,"text/plain","Index Error"); } } else { req->send(400,"text/plain","Error"); } });
+        server.on("/api/scan", HTTP_GET, timed("/api/scan", [](AsyncWebServerRequest *req){ int n = WiFi.scanComplete(); if(n == -2) { WiFi.scanNetworks(true); req->send(200, "application/json", "[]"); } else if(n == -1) { req->send(200, "application/json", "[]"); } else { sendStream(req, std::make_shared<ScanJson>(n)); } }));
+        server.on("/api/save-wifi", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/save-wifi", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(512); deserializeJson(doc,data); config.setStr(CFG_WIFI_SSID, doc["ssid"] | ""); config.setStr(CFG_WIFI_PASS, doc["password"] | ""); req->send(200,"text/plain","Saved"); scheduleReboot(1000); }));
+        // [TELEMETRY] MQTT broker for TelemetryPublisher (empty host = off), applied after reboot
+        server.on("/api/save-mqtt", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/save-mqtt", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ DynamicJsonDocument doc(512); deserializeJson(doc,data); config.edit([&]{ config.putStr(CFG_MQTT_HOST, doc["host"] | ""); config.putInt(CFG_MQTT_PORT, doc.containsKey("port") ? doc["port"].as<int>() : MQTT_PORT_DEFAULT, 0); config.putStr(CFG_MQTT_USER, doc["user"] | ""); config.putStr(CFG_MQTT_PASS, doc["password"] | ""); }); req->send(200,"text/plain","Saved"); scheduleReboot(1000); }));
+        // Settings export / import, to clone one node's setup across a fleet
+        server.on("/api/config", HTTP_GET, timed("/api/config", [](AsyncWebServerRequest *req){ sendStream(req, std::make_shared<ConfigStore::JsonExport>(config, req->hasParam("secrets"))); }));
+        server.on("/api/config", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/config", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ char *body = collectBody(req, data, len, index, total, CONFIG_IMPORT_MAX); if (body) importConfig(req, body, total); }));
+        // [OTA] Delta from tools/make_delta.py against the running image; reboots into it
+        server.on("/api/ota", HTTP_GET, timed("/api/ota", [](AsyncWebServerRequest *req){
+            char json[160];
+            snprintf(json, sizeof(json), "{\"running\":\"%s\",\"trial\":%s,\"applied\":%u,\"rejected\":%u,\"last_bytes\":%u,\"confirm_ms\":%u}",
+                     ota.getRunningLabel(), ota.isOnTrial() ? "true" : "false", (unsigned)ota.getApplied(), (unsigned)ota.getRejected(),
+                     (unsigned)ota.getLastBytes(), (unsigned)ota.getConfirmMs());
+            req->send(200, "application/json", json);
+        }));
+        server.on("/api/ota", HTTP_POST, [](AsyncWebServerRequest *req){}, NULL, timedBody("/api/ota", [this](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){ otaBody(req, data, len, index, total); }));
+        server.on("/api/reboot", HTTP_POST, timed("/api/reboot", [this](AsyncWebServerRequest *req){ req->send(200,"text/plain","Rebooting"); scheduleReboot(500); }));
+        // [DETECT] Queues a probe of all zones; the result arrives as a "sensors"
+        // event and through /api/sensors once "probe" reaches the returned number
+        server.on("/api/detect-sensor", HTTP_GET, timed("/api/detect-sensor", [this](AsyncWebServerRequest *req){ if(req->hasParam("index")){ int idx = req->getParam("index")->value().toInt(); if(idx >= 0 && idx < MAX_PLANTS) { uint32_t probe = adcSampler.requestProbe(); char json[64]; snprintf(json, sizeof(json), "{\"index\":%d,\"probe\":%u,\"pending\":true}", idx, (unsigned)probe); buzzer->beep(); req->send(202,"application/json",json); } else { req->send(400,"text/plain","Index Error"); } } else { req->send(400,"text/plain","Error"); } }));
+        server.on("/api/sensors", HTTP_GET, timed("/api/sensors", [](AsyncWebServerRequest *req){ sendStream(req, std::make_shared<SensorsJson>()); }));
+
+        // [METRICS] Prometheus scrape; text is formatted only here, block by block
+        server.on("/metrics", HTTP_GET, timed("/metrics", [this](AsyncWebServerRequest *req){
+            auto stream = std::make_shared<MetricsStream>(this);
+            req->send(req->beginChunkedResponse("text/plain; version=0.0.4", [stream](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                return stream->fill((char*)buf, maxLen);
+            }));
+        }));
+
+#ifdef ROSEMARY_TRACE
+        // [TRACE] Recent slow spans as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+        server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *req){
+            auto stream = std::make_shared<TraceJsonStream>(&traceRing);
+            req->send(req->beginChunkedResponse("application/json", [stream](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                return stream->fill((char*)buf, maxLen);
+            }));
+        });
+#endif
 
         server.onNotFound([](AsyncWebServerRequest *req){ req->redirect("/"); });
     }
+
+    // Chunked JSON body; the stream lives as long as the response
+    static void sendStream(AsyncWebServerRequest *req, std::shared_ptr<JsonItemStream> stream) {
+        req->send(req->beginChunkedResponse("application/json", [stream](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+            return stream->fill((char*)buf, maxLen);
+        }));
+    }
+
+    template<size_t N>
+    void serveSnapshot(AsyncWebServerRequest *req, DataSnapshot<N> &snap, const char *contentType) {
+        if (!snap.ready()) { req->send(503, "text/plain", "Starting"); return; }
+
+        int b = snap.acquire();
+        AsyncWebHeader *inm = req->getHeader("If-None-Match");
+        if (inm && inm->value() == snap.etag(b)) {
+            AsyncWebServerResponse *res = req->beginResponse(304);
+            res->addHeader("ETag", snap.etag(b));
+            snap.release(b);
+            req->send(res);
+            return;
+        }
+
+        AsyncWebServerResponse *res = req->beginResponse_P(200, contentType, (const uint8_t*)snap.data(b), snap.size(b));
+        res->addHeader("ETag", snap.etag(b));
+        res->addHeader("Cache-Control", "no-cache");
+        req->onDisconnect([&snap, b](){ snap.release(b); });
+        req->send(res);
+    }
+
+    // [METRICS] Count and time a handler under its route label (one
+    // series per path, whatever the method)
+    RouteMetric* trackRoute(const char *route) {
+        for (int i = 0; i < routeCount; i++) if (!strcmp(routes[i].route, route)) return &routes[i];
+        if (routeCount >= METRICS_ROUTES) return nullptr;
+        routes[routeCount].route = route;
+        return &routes[routeCount++];
+    }
+    ArRequestHandlerFunction timed(const char *route, ArRequestHandlerFunction fn) {
+        RouteMetric *m = trackRoute(route);
+        return [m, fn](AsyncWebServerRequest *req){
+            TRACE_SCOPE(m ? m->route : "http");
+            uint32_t t0 = micros();
+            fn(req);
+            if (m) m->latency.observe(micros() - t0);
+        };
+    }
+    ArBodyHandlerFunction timedBody(const char *route, ArBodyHandlerFunction fn) {
+        RouteMetric *m = trackRoute(route);
+        return [m, fn](AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total){
+            TRACE_SCOPE(m ? m->route : "http");
+            uint32_t t0 = micros();
+            fn(req, data, len, index, total);
+            if (m) m->latency.observe(micros() - t0);
+        };
+    }
+
+    // Bodies arrive in TCP-sized chunks. Returns the whole body (freed
+    // with the request) once the last chunk is in, nullptr before.
+    static char* collectBody(AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total, size_t max) {
+        if (total > max) { if (index == 0) req->send(413, "text/plain", "Too Large"); return nullptr; }
+        if (index == 0) req->_tempObject = malloc(total + 1);
+        char *body = (char*)req->_tempObject;
+        if (!body) { if (index == 0) req->send(503, "text/plain", "Busy"); return nullptr; }
+        memcpy(body + index, data, len);
+        if (index + len < total) return nullptr;
+        body[total] = 0;
+        return body;
+    }
+
+    // /api/batch: parsed as the chunks arrive (the parser lives in
+    // the request's scratch), then queued whole for the control task
+    void batchBody(AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (index == 0) {
+            void *mem = malloc(sizeof(BatchParser));    // Freed with the request
+            req->_tempObject = mem ? new (mem) BatchParser() : nullptr;
+            if (!mem) { req->send(503, "text/plain", "Busy"); return; }
+        }
+        BatchParser *parser = (BatchParser*)req->_tempObject;
+        if (!parser) return;
+        parser->feed(data, len);
+        if (index + len < total) return;
+
+        if (!parser->finish()) {
+            char msg[80];
+            snprintf(msg, sizeof(msg), "%s at byte %u", parser->getError(), (unsigned)parser->getErrorOffset());
+            req->send(parser->isTooMany() ? 413 : 400, "text/plain", msg);
+            batchesRejected++;
+            return;
+        }
+        PlantBatch *slot = plantMgr->beginBatch();
+        if (slot) *slot = parser->batch;
+        queueBatch(req, slot);
+    }
+
+    // Single-plant routes as one-op batches, so the plant is looked
+    // up (and a full table refused) on the control task too
+    void runOne(AsyncWebServerRequest *req, const BatchOp &op) {
+        PlantBatch *slot = plantMgr->beginBatch();
+        if (slot) { slot->ops[0] = op; slot->count = 1; }
+        queueBatch(req, slot);
+    }
+
+    // Web server task: hands the filled slot (nullptr while the last
+    // batch is still queued) to the control task and replies with the
+    // batch number at once
+    void queueBatch(AsyncWebServerRequest *req, PlantBatch *slot) {
+        uint32_t n = slot ? plantMgr->submitBatch() : 0;
+        if (!n) { batchesBusy++; req->send(503, "text/plain", "Busy"); return; }
+        char json[48];
+        snprintf(json, sizeof(json), "{\"batch\":%u,\"pending\":true}", (unsigned)n);
+        req->send(202, "application/json", json);
+    }
+
+    // GET /api/batch: the last batch and, once run, its per-op results
+    // in request order. Only the last result is kept: a client whose
+    // number has been passed has the "batch" event's applied flag.
+    void sendBatchResult(AsyncWebServerRequest *req) {
+        const PlantBatch *done = plantMgr->batchResult();
+        if (!done) {
+            char json[48];
+            snprintf(json, sizeof(json), "{\"batch\":%u,\"pending\":%s}", (unsigned)plantMgr->getBatchSeq(), plantMgr->isBatchQueued() ? "true" : "false");
+            req->send(200, "application/json", json);
+            return;
+        }
+        const PlantBatch &b = *done;
+        bool ok = true;
+        for (int i = 0; i < b.count; i++) ok &= !b.ops[i].error;
+        size_t size = 80 + 64 * b.count;
+        char *json = (char*)malloc(size);
+        if (!json) { req->send(503, "text/plain", "Busy"); return; }
+        size_t n = snprintf(json, size, "{\"batch\":%u,\"pending\":false,\"applied\":%s,\"results\":[", (unsigned)plantMgr->getBatchSeq(), ok ? "true" : "false");
+        for (int i = 0; i < b.count && n < size; i++) {
+            const BatchOp &op = b.ops[i];
+            if (op.error) n += snprintf(json + n, size - n, "%s{\"ok\":false,\"error\":\"%s\"}", i ? "," : "", op.error);
+            else if (op.kind == BOP_ADD && ok) n += snprintf(json + n, size - n, "%s{\"ok\":true,\"id\":%ld}", i ? "," : "", (long)op.id);
+            else n += snprintf(json + n, size - n, "%s{\"ok\":true}", i ? "," : "");
+        }
+        if (n < size) snprintf(json + n, size - n, "]}");
+        req->send(200, "application/json", json);
+        free(json);
+    }
+
+    // /api/ota: nothing is kept in RAM, each chunk is patched straight into
+    // the next app slot. A client that goes away mid-body frees the slot.
+    void otaBody(AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total) {
+        if (index == 0) req->onDisconnect([req](){ ota.drop(req); });
+        const char *why = nullptr;
+        int code = ota.write(req, data, len, index, total, why);
+        if (code == 200) {
+            char json[48];
+            snprintf(json, sizeof(json), "{\"bytes\":%u,\"reboot\":true}", (unsigned)total);
+            req->send(200, "application/json", json);
+            scheduleReboot(1000);
+        } else if (code) req->send(code, "text/plain", why);
+    }
+
+    // All values are checked before any is applied; omitted keys keep their value
+    void importConfig(AsyncWebServerRequest *req, const char *body, size_t len) {
+        DynamicJsonDocument doc(CONFIG_JSON_SIZE);
+        if (deserializeJson(doc, body, len) || !doc["values"].is<JsonObject>()) { req->send(400, "text/plain", "Expected {\"values\":{...}}"); return; }
+        uint32_t changed = 0; int ignored = 0; String err;
+        if (!config.importJson(doc["values"].as<JsonObject>(), changed, ignored, err)) { req->send(400, "text/plain", err); return; }
+        bool reboot = ConfigStore::needsReboot(changed);
+        char json[80];
+        snprintf(json, sizeof(json), "{\"changed\":%d,\"ignored\":%d,\"reboot\":%s}", __builtin_popcount(changed), ignored, reboot ? "true" : "false");
+        req->send(200, "application/json", json);
+        if (reboot) scheduleReboot(1000);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include "../Config.h"
+#include "DeltaPatch.h"
+#include "Tasks.h"
+
+// ==========================================================
+// OtaUpdater - Delta updates into the inactive app slot
+// POST /api/ota streams a delta (Core/DeltaPatch.h) made against
+// the running image. The header is checked before anything is
+// written: the first old-size bytes of the running slot must hash
+// to the delta's old image, and the new image must fit. Then each
+// body chunk is decompressed and patched straight into the next
+// OTA slot, hashed on the way. Only a matching hash (and
+// esp_ota_end's image check) switches the boot slot; the network
+// task restarts once the reply is out.
+//
+// The new image boots on trial. It is kept once it has been
+// healthy for OTA_CONFIRM_MS: every task stepping and, when an
+// SSID is saved, the station link up (a node that cannot be
+// reached cannot be fixed by the next update). Not kept within
+// OTA_CONFIRM_TIMEOUT_MS: back to the previous slot. A crash or
+// reset before that, and the bootloader goes back by itself.
+//
+// Needs CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE; without it a new
+// image boots as valid, with no trial.
+// Upload state belongs to the async_tcp task (all body chunks
+// and disconnects run there); the trial to the network task.
+// ==========================================================
+
+extern TaskRunner tasks;
+
+class OtaUpdater : private DeltaIo {
+private:
+    // [UPLOAD] async_tcp task
+    const void *owner = nullptr;         // Request whose body fills the slot
+    unsigned long lastChunkMs = 0;
+    uint8_t head[DELTA_HEADER_BYTES];
+    size_t headLen = 0;
+    DeltaHeader header;
+    DeltaPatch patch;
+    mbedtls_sha256_context sha;
+    const esp_partition_t *running = nullptr;
+    const esp_partition_t *target = nullptr;
+    esp_ota_handle_t handle = 0;
+    bool opened = false;                 // esp_ota_begin done
+    bool hashing = false;                // sha holds the new image hash
+    const char *failure = nullptr;
+
+    // [TRIAL] Network task
+    std::atomic<bool> onTrial{false};
+    unsigned long bootMs = 0;
+    unsigned long healthySince = 0;
+    uint32_t seenRuns[TASK_MAX] = {};
+    unsigned long seenAt[TASK_MAX] = {};
+
+    // [METRICS]
+    std::atomic<uint32_t> applied{0};
+    std::atomic<uint32_t> rejected{0};
+    std::atomic<uint32_t> lastBytes{0};  // Body size of the last applied update
+    std::atomic<uint32_t> confirmMs{0};  // Boot to confirmed, this image
+
+    bool readOld(uint32_t offset, uint8_t *buf, size_t len) override {
+        return esp_partition_read(running, offset, buf, len) == ESP_OK;
+    }
+
+    bool writeNew(const uint8_t *data, size_t len) override {
+        mbedtls_sha256_update(&sha, data, len);
+        return esp_ota_write(handle, data, len) == ESP_OK;
+    }
+
+    int fail(int code, const char *why) { failure = why; return code; }
+
+    // Is the running slot the image the delta was made from
+    bool oldImageMatches() {
+        if (header.oldSize > running->size) return false;
+        uint8_t buf[OTA_READ_BYTES], digest[32];
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts(&sha, 0);
+        for (uint32_t at = 0; at < header.oldSize; at += sizeof(buf)) {
+            size_t n = std::min<uint32_t>(sizeof(buf), header.oldSize - at);
+            if (!readOld(at, buf, n)) { mbedtls_sha256_free(&sha); return false; }
+            mbedtls_sha256_update(&sha, buf, n);
+        }
+        mbedtls_sha256_finish(&sha, digest);
+        mbedtls_sha256_free(&sha);
+        return !memcmp(digest, header.oldHash, sizeof(digest));
+    }
+
+    // Header complete: 0 to go on, else an HTTP status
+    int openSlot() {
+        const char *bad = header.parse(head);
+        if (bad) return fail(400, bad);
+        running = esp_ota_get_running_partition();
+        target = esp_ota_get_next_update_partition(nullptr);
+        if (!running || !target) return fail(500, "no OTA slot");
+        if (header.newSize > target->size) return fail(413, "image larger than the slot");
+        if (!oldImageMatches()) return fail(409, "delta is for another image");
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+        size_t erase = OTA_WITH_SEQUENTIAL_WRITES;    // Sector by sector as it is written
+#else
+        size_t erase = header.newSize;
+#endif
+        if (esp_ota_begin(target, erase, &handle) != ESP_OK) return fail(500, "cannot open the OTA slot");
+        opened = true;
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts(&sha, 0);
+        hashing = true;
+        patch.begin(header, this);
+        Serial.printf("[OTA] %u B -> %s, from %u B on %s\n", (unsigned)header.newSize, target->label, (unsigned)header.oldSize, running->label);
+        return 0;
+    }
+
+    int consume(const uint8_t *data, size_t len) {
+        if (headLen < DELTA_HEADER_BYTES) {
+            size_t n = std::min(len, DELTA_HEADER_BYTES - headLen);
+            memcpy(head + headLen, data, n);
+            headLen += n; data += n; len -= n;
+            if (headLen < DELTA_HEADER_BYTES) return 0;
+            int code = openSlot();
+            if (code) return code;
+        }
+        if (!patch.feed(data, len)) return fail(400, patch.getError());
+        return 0;
+    }
+
+    // Last chunk in: check the result and switch the boot slot
+    int finish() {
+        if (headLen < DELTA_HEADER_BYTES) return fail(400, "delta ends early");
+        if (!patch.finish()) return fail(400, patch.getError());
+        uint8_t digest[32];
+        mbedtls_sha256_finish(&sha, digest);
+        if (memcmp(digest, header.newHash, sizeof(digest))) return fail(422, "new image hash mismatch");
+        opened = false;
+        if (esp_ota_end(handle) != ESP_OK) return fail(422, "image check failed");
+        if (esp_ota_set_boot_partition(target) != ESP_OK) return fail(500, "cannot switch the boot slot");
+        return 200;
+    }
+
+    void close() {
+        if (opened) esp_ota_abort(handle);
+        if (hashing) mbedtls_sha256_free(&sha);
+        opened = hashing = false;
+        owner = nullptr;
+        headLen = 0;
+    }
+
+    // Every task has stepped within OTA_STALL_MS (idle ones wake every TASK_IDLE_MAX_MS)
+    bool tasksStepping(unsigned long now) {
+        bool ok = true;
+        for (int i = 0; i < tasks.size() && i < TASK_MAX; i++) {
+            uint32_t runs = tasks.get(i).runs;
+            if (runs != seenRuns[i] || !seenAt[i]) { seenRuns[i] = runs; seenAt[i] = now; }
+            else if (now - seenAt[i] > OTA_STALL_MS) ok = false;
+        }
+        return ok;
+    }
+
+public:
+    // Boot: is this image on trial
+    void begin() {
+        const esp_partition_t *p = esp_ota_get_running_partition();
+        esp_ota_img_states_t state;
+        bool trial = p && esp_ota_get_state_partition(p, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY;
+        onTrial = trial;
+        bootMs = millis();
+        healthySince = 0;
+        for (int i = 0; i < TASK_MAX; i++) seenAt[i] = 0;
+        if (trial) Serial.printf("[OTA] %s on trial: kept after %d s healthy\n", p->label, OTA_CONFIRM_MS / 1000);
+    }
+
+    // async_tcp task: one body chunk of POST /api/ota. 0 while more is
+    // expected (or this request was already answered), 200 once the new
+    // image is in place and boots next, else an error status and why.
+    int write(const void *req, const uint8_t *data, size_t len, size_t index, size_t total, const char *&why) {
+        unsigned long now = millis();
+        if (index == 0) {
+            if (owner && now - lastChunkMs < OTA_IDLE_MS) { why = "update in progress"; rejected++; return 409; }
+            if (onTrial) { why = "running image not kept yet"; rejected++; return 409; }
+            close();                     // A stalled upload gives way
+            owner = req;
+            failure = nullptr;
+        }
+        if (owner != req) return 0;
+        lastChunkMs = now;
+
+        int code = consume(data, len);
+        if (!code && index + len >= total) code = finish();
+        if (code == 200) {
+            close();
+            applied++;
+            lastBytes = total;
+            Serial.printf("[OTA] %u B image verified, boots from %s\n", (unsigned)header.newSize, target->label);
+        } else if (code) {
+            why = failure;
+            Serial.printf("[OTA] Rejected (%d): %s\n", code, why);
+            close();
+            rejected++;
+        }
+        return code;
+    }
+
+    // async_tcp task: the client went away mid-body
+    void drop(const void *req) {
+        if (owner != req) return;
+        Serial.println("[OTA] Upload cut off");
+        close();
+        rejected++;
+    }
+
+    // Network task: while on trial, keep the image once healthy long
+    // enough. True when it has to go (rollback() after a flush).
+    bool checkTrial(bool linkOk, unsigned long now) {
+        if (!onTrial) return false;
+        bool healthy = tasksStepping(now) && linkOk;
+        if (!healthy) healthySince = 0;
+        else if (!healthySince) healthySince = now;
+        else if (now - healthySince >= OTA_CONFIRM_MS) {
+            esp_ota_mark_app_valid_cancel_rollback();
+            onTrial = false;
+            confirmMs = now - bootMs;
+            Serial.printf("[OTA] Image kept after %lu s\n", (now - bootMs) / 1000);
+            return false;
+        }
+        return now - bootMs >= OTA_CONFIRM_TIMEOUT_MS;
+    }
+
+    // ms until checkTrial() can decide; health is sampled at least every TASK_IDLE_MAX_MS
+    uint32_t trialDueMs(unsigned long now) {
+        NextDue next;
+        if (!onTrial) return next;
+        if (healthySince) next.at(healthySince + OTA_CONFIRM_MS, now);
+        next.at(bootMs + OTA_CONFIRM_TIMEOUT_MS, now);
+        return next;
+    }
+
+    // Network task: previous slot, restart (does not return on the device)
+    void rollback() {
+        Serial.println("[OTA] Image not healthy in time: rolling back");
+        onTrial = false;
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+
+    bool isOnTrial() { return onTrial; }
+    uint32_t getApplied() { return applied; }
+    uint32_t getRejected() { return rejected; }
+    uint32_t getLastBytes() { return lastBytes; }
+    uint32_t getConfirmMs() { return confirmMs; }
+    const char* getRunningLabel() { const esp_partition_t *p = esp_ota_get_running_partition(); return p ? p->label : "?"; }
+};
+
+extern OtaUpdater ota;
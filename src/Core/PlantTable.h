@@ -0,0 +1,112 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#include "Types.h"
+#include "Channels.h"
+
+// ==========================================================
+// PlantTable - Fixed plant storage, one slot per zone
+// byZone() is a direct index; iteration follows insertion
+// order (the order the API has always listed plants in).
+// Adding or removing never moves a Plant in memory.
+//
+// Only the control task (or setup()) adds and removes. Every
+// change publishes the zone order through a Mailbox; begin()
+// and view() copy it, so a task iterating while a plant is
+// removed walks the old list instead of a shifting one.
+// size() and operator[] read the live list: control task only.
+// ==========================================================
+
+class PlantTable {
+private:
+    Plant slots[MAX_PLANTS];          // Indexed by zone (originalIndex)
+    bool used[MAX_PLANTS] = {false};
+
+public:
+    struct Order {
+        int8_t zones[MAX_PLANTS];    // Zones in insertion order
+        int count;
+    };
+
+private:
+    Order order = {};                 // Live list (writer)
+    Mailbox<Order> published;        // Copy for readers
+
+    void publish() { published.publish(order); }
+
+public:
+    // Walks its own copy of the order; end() is only a marker
+    class iterator {
+        PlantTable *t; Order o; int i;
+    public:
+        iterator(PlantTable *table, const Order &order, int index) : t(table), o(order), i(index) {}
+        Plant& operator*() { return t->slots[o.zones[i]]; }
+        Plant* operator->() { return &t->slots[o.zones[i]]; }
+        iterator& operator++() { i++; return *this; }
+        bool operator!=(const iterator&) const { return i < o.count; }
+    };
+
+    // The plants at one instant, for a reader that needs the count too
+    class View {
+        PlantTable *t; Order o;
+    public:
+        View(PlantTable *table, const Order &order) : t(table), o(order) {}
+        iterator begin() { return iterator(t, o, 0); }
+        iterator end() { return iterator(t, o, o.count); }
+        size_t size() const { return o.count; }
+    };
+
+    PlantTable() { publish(); }
+
+    iterator begin() { return iterator(this, published.get(), 0); }
+    iterator end() { return iterator(this, order, order.count); }
+    View view() { return View(this, published.get()); }
+    size_t size() const { return order.count; }
+    bool empty() const { return order.count == 0; }
+    Plant& operator[](int i) { return slots[order.zones[i]]; }
+
+    Plant* byZone(int zone) {
+        if (zone < 0 || zone >= MAX_PLANTS || !used[zone]) return nullptr;
+        return &slots[zone];
+    }
+
+    Plant* byId(int id) {
+        for (int i = 0; i < order.count; i++) if (slots[order.zones[i]].id == id) return &slots[order.zones[i]];
+        return nullptr;
+    }
+
+    int freeZone() {
+        for (int z = 0; z < MAX_PLANTS; z++) if (!used[z]) return z;
+        return -1;
+    }
+
+    // Returns the new slot (defaults + zone set), or null if taken/full
+    Plant* add(int zone) {
+        if (zone < 0 || zone >= MAX_PLANTS || used[zone]) return nullptr;
+        slots[zone] = Plant();
+        slots[zone].originalIndex = zone;
+        used[zone] = true;
+        order.zones[order.count++] = zone;
+        publish();
+        return &slots[zone];
+    }
+
+    bool removeById(int id) {
+        for (int i = 0; i < order.count; i++) {
+            int z = order.zones[i];
+            if (slots[z].id != id) continue;
+            used[z] = false;
+            for (int j = i; j < order.count - 1; j++) order.zones[j] = order.zones[j + 1];
+            order.count--;
+            publish();
+            return true;
+        }
+        return false;
+    }
+
+    void clear() {
+        for (int z = 0; z < MAX_PLANTS; z++) used[z] = false;
+        order.count = 0;
+        publish();
+    }
+};
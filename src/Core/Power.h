@@ -0,0 +1,103 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#ifndef ROSEMARY_SIM
+#include <esp_pm.h>
+#include <esp_idf_version.h>
+#endif
+
+// ==========================================================
+// Power - Automatic light sleep between task deadlines
+// With esp_pm configured, FreeRTOS tickless idle light-sleeps
+// whenever every task is blocked for a few ticks, and the CPU
+// clock drops to POWER_CPU_MIN_MHZ while busy with little. The
+// TaskRunner supplies the blocking: tasks wait on their next
+// deadline rather than a fixed period.
+//
+// Light sleep is only allowed while the radio can take it: in
+// STA mode (modem sleep keeps the AP association across DTIM
+// beacons). The setup AP must answer at any time, so it stays
+// awake. Holds keep the chip awake while something would break:
+// LEDC stops in light sleep (pumps), and the DHT frame edges
+// arrive on a GPIO interrupt that does not wake the chip.
+//
+// Needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE;
+// without them begin() says so and the tasks still sleep, just
+// without the clock gated.
+// ==========================================================
+
+enum PowerHold : uint8_t { POWER_HOLD_PUMPS, POWER_HOLD_DHT, POWER_HOLD_COUNT };
+
+class PowerManager {
+private:
+    bool available = false;
+    bool sleepAllowed = false;             // Network task
+    bool held[POWER_HOLD_COUNT] = {};      // Each reason has one owning task
+#ifndef ROSEMARY_SIM
+    esp_pm_lock_handle_t locks[POWER_HOLD_COUNT] = {};
+
+    bool configure(bool lightSleep) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+        esp_pm_config_t pm = {};
+#else
+        esp_pm_config_esp32s3_t pm = {};
+#endif
+        pm.max_freq_mhz = POWER_CPU_MAX_MHZ;
+#ifdef ROSEMARY_TRACE
+        pm.min_freq_mhz = POWER_CPU_MAX_MHZ;   // Trace converts cycles at a fixed clock
+#else
+        pm.min_freq_mhz = POWER_CPU_MIN_MHZ;
+#endif
+        pm.light_sleep_enable = lightSleep;
+        return esp_pm_configure(&pm) == ESP_OK;
+    }
+#endif
+
+public:
+    void begin() {
+#ifndef ROSEMARY_SIM
+        static const char *names[POWER_HOLD_COUNT] = { "pumps", "dht" };
+        available = configure(false);
+        for (int i = 0; available && i < POWER_HOLD_COUNT; i++) {
+            if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, names[i], &locks[i]) != ESP_OK) available = false;
+        }
+        if (!available) Serial.println("[POWER] esp_pm not enabled in this build: no light sleep");
+#else
+        available = true;
+#endif
+    }
+
+    // Network task, on WiFi mode / link changes
+    void allowLightSleep(bool on) {
+        on = on && POWER_LIGHT_SLEEP;
+        if (!available || on == sleepAllowed) return;
+#ifndef ROSEMARY_SIM
+        if (!configure(on)) return;
+#endif
+        sleepAllowed = on;
+        Serial.printf("[POWER] Light sleep %s\n", on ? "on" : "off");
+    }
+
+    // Owning task only. Cheap when nothing changes.
+    void hold(PowerHold reason, bool on) {
+        if (held[reason] == on) return;
+        held[reason] = on;
+#ifndef ROSEMARY_SIM
+        if (!locks[reason]) return;
+        if (on) esp_pm_lock_acquire(locks[reason]);
+        else esp_pm_lock_release(locks[reason]);
+#endif
+    }
+
+    bool isHeld(PowerHold reason) { return held[reason]; }
+    bool isLightSleepAllowed() { return sleepAllowed; }
+
+    // Would an idle gap light-sleep right now
+    bool canSleep() {
+        if (!sleepAllowed) return false;
+        for (int i = 0; i < POWER_HOLD_COUNT; i++) if (held[i]) return false;
+        return true;
+    }
+};
+
+extern PowerManager power;
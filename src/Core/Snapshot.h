@@ -0,0 +1,98 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "../Config.h"
+#include "Deadline.h"
+
+// ==========================================================
+// DataSnapshot - Pre-serialized, versioned response
+// Built on the loop task only when the source state changes,
+// served zero-copy to every client from a double buffer.
+// A buffer is never rebuilt while a response still reads it.
+// Encoders (JsonWriter, CborWriter) write the buffer directly,
+// so a rebuild allocates nothing.
+// ==========================================================
+
+template<size_t BufSize = SNAPSHOT_BUF_SIZE>
+class DataSnapshot {
+private:
+    char buf[2][BufSize];
+    size_t len[2] = {0, 0};
+    char etags[2][24];
+    std::atomic<int> front{0};
+    std::atomic<int> readers[2];
+
+    uint32_t bootId = 0;
+    uint32_t version = 0;
+    uint32_t sourceKey = 0xFFFFFFFF;
+    unsigned long lastBuild = 0;
+    uint32_t buildUs = 0;
+
+public:
+    DataSnapshot() {
+        readers[0] = 0; readers[1] = 0;
+        etags[0][0] = 0; etags[1][0] = 0;
+    }
+
+    void begin() {
+        bootId = (uint32_t)random(0x10000, 0xFFFFF);
+    }
+
+    // key: any value that changes whenever the source state changes
+    bool needsRebuild(uint32_t key) {
+        if (key == sourceKey && version > 0) return false;
+        return millis() - lastBuild >= SNAPSHOT_MIN_MS || version == 0;
+    }
+
+    // ms until needsRebuild(key) turns true (idle while current)
+    uint32_t rebuildDueMs(uint32_t key) {
+        if (key == sourceKey && version > 0) return TASK_IDLE_MAX_MS;
+        return version == 0 ? 0 : msUntil(lastBuild + SNAPSHOT_MIN_MS, millis());
+    }
+
+    // Encode into the back buffer and publish it. Returns false if
+    // the back buffer is still being sent (retry next loop).
+    // fill(uint8_t *out, size_t size, uint32_t version) returns the
+    // encoded length, 0 if it did not fit
+    template<typename Fill>
+    bool rebuild(uint32_t key, Fill fill) {
+        int back = 1 - front.load();
+        if (readers[back].load() > 0) return false;
+
+        unsigned long t0 = micros();
+        size_t n = fill((uint8_t*)buf[back], BufSize, version + 1);
+        if (n == 0) { Serial.println("Snapshot overflow"); return false; }
+        return publish(back, n, key, t0);
+    }
+
+    // Pin the current front buffer for one response (async task side)
+    int acquire() {
+        while (true) {
+            int b = front.load();
+            readers[b]++;
+            if (front.load() == b) return b;
+            readers[b]--;
+        }
+    }
+    void release(int b) { readers[b]--; }
+
+    const char* data(int b) { return buf[b]; }
+    size_t size(int b) { return len[b]; }
+    const char* etag(int b) { return etags[b]; }
+    uint32_t getVersion() { return version; }
+    bool ready() { return version > 0; }
+    // Encode time of the last rebuild
+    uint32_t getBuildUs() { return buildUs; }
+
+private:
+    bool publish(int back, size_t n, uint32_t key, unsigned long t0) {
+        version++;
+        len[back] = n;
+        snprintf(etags[back], sizeof(etags[back]), "\"%05X-%u\"", (unsigned)bootId, (unsigned)version);
+        sourceKey = key;
+        lastBuild = millis();
+        buildUs = micros() - t0;
+        front.store(back);
+        return true;
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ESPAsyncWebServer.h>
+#include "../Config.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+// ==========================================================
+// StaticAssets - Pre-compressed dashboard files
+// tools/build_assets.py minifies and gzips data/ into /www and
+// writes /www/assets.idx, one URL per line:
+//   <url> <file> <etag> <max-age>
+// Files referenced by index.html carry their content hash in the
+// name and are cached immutable for a year; index.html itself is
+// revalidated on each load and answered 304 while its ETag holds.
+// Bodies go out as stored, with Content-Encoding: gzip: nothing
+// is compressed on the device and the FS reads are ~3x smaller.
+//
+// The index is parsed once at boot into a fixed table; lookups
+// run in the async_tcp task.
+// ==========================================================
+
+#define ASSET_INDEX_PATH    "/www/assets.idx"
+
+struct StaticAsset {
+    char url[48];
+    char file[64];
+    char etag[12];        // Quoted, 8 hex digits
+    uint32_t maxAge;      // 0 = no-cache (revalidate)
+};
+
+class StaticAssets : public AsyncWebHandler {
+private:
+    StaticAsset assets[ASSET_MAX];
+    int count = 0;
+    RouteMetric *metric = nullptr;
+
+    const StaticAsset* find(const String &url) const {
+        for (int i = 0; i < count; i++) if (url == assets[i].url) return &assets[i];
+        return nullptr;
+    }
+
+    static const char* contentType(const char *url) {
+        const char *dot = strrchr(url, '.');
+        if (!dot || strchr(dot, '/')) return "text/html";   // "/"
+        if (!strcmp(dot, ".html") || !strcmp(dot, ".htm")) return "text/html";
+        if (!strcmp(dot, ".css")) return "text/css";
+        if (!strcmp(dot, ".js")) return "application/javascript";
+        if (!strcmp(dot, ".json")) return "application/json";
+        if (!strcmp(dot, ".svg")) return "image/svg+xml";
+        if (!strcmp(dot, ".png")) return "image/png";
+        if (!strcmp(dot, ".ico")) return "image/x-icon";
+        return "application/octet-stream";
+    }
+
+    void addCacheHeaders(AsyncWebServerResponse *res, const StaticAsset &a) {
+        char cc[48];
+        if (a.maxAge) snprintf(cc, sizeof(cc), "public, max-age=%u, immutable", (unsigned)a.maxAge);
+        else snprintf(cc, sizeof(cc), "no-cache");
+        res->addHeader("ETag", a.etag);
+        res->addHeader("Cache-Control", cc);
+    }
+
+public:
+    // False if the image was uploaded without the build step
+    bool begin(RouteMetric *m) {
+        metric = m;
+        count = 0;
+        File f = LittleFS.open(ASSET_INDEX_PATH, "r");
+        if (!f) return false;
+
+        char line[160];
+        size_t n = 0;
+        int c;
+        do {
+            c = f.read();
+            if (c >= 0 && c != '\n') { if (n < sizeof(line) - 1) line[n++] = (char)c; continue; }
+            line[n] = 0;
+            n = 0;
+            if (!line[0] || count >= ASSET_MAX) continue;
+            StaticAsset &a = assets[count];
+            unsigned maxAge = 0;
+            if (sscanf(line, "%47s %63s %11s %u", a.url, a.file, a.etag, &maxAge) == 4) {
+                a.maxAge = maxAge;
+                count++;
+            }
+        } while (c >= 0);
+        f.close();
+        return count > 0;
+    }
+
+    int getCount() const { return count; }
+
+    bool canHandle(AsyncWebServerRequest *req) override {
+        if (req->method() != HTTP_GET || !find(req->url())) return false;
+        req->addInterestingHeader("If-None-Match");
+        return true;
+    }
+
+    void handleRequest(AsyncWebServerRequest *req) override {
+        TRACE_SCOPE("web.static");
+        uint32_t t0 = micros();
+        const StaticAsset *a = find(req->url());
+        AsyncWebServerResponse *res;
+        AsyncWebHeader *inm = req->getHeader("If-None-Match");
+        if (inm && inm->value() == a->etag) {
+            res = req->beginResponse(304);
+        } else {
+            // Every browser the dashboard runs on takes gzip; only .gz is stored
+            res = req->beginResponse(LittleFS, a->file, contentType(a->url));
+            res->addHeader("Content-Encoding", "gzip");
+        }
+        addCacheHeaders(res, *a);
+        req->send(res);
+        if (metric) metric->latency.observe(micros() - t0);
+    }
+};
@@ -0,0 +1,211 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Deadline.h"
+
+// ==========================================================
+// TaskRunner - Deadline-driven tasks pinned to cores
+// On the ESP32 each task is a FreeRTOS task that runs its step,
+// then blocks on its task notification until the deadline the
+// step returned (Core/Deadline.h). The FreeRTOS delayed list is
+// the timer queue: with every task blocked the idle task runs,
+// and tickless idle can light-sleep the gap (Core/Power.h).
+// wake() / wakeFromISR() end the wait early when another task or
+// an interrupt hands over work. Arduino loop() is deleted.
+// A step that returns 0 runs again after the task's tick, so
+// work in progress keeps its old fixed-rate timing.
+//
+// In the host simulation the steps run cooperatively from
+// loop(); while a step blocks in delay(), tasks that would
+// preempt it (other core or higher priority) keep running.
+// Every step's run time also feeds the task's /metrics histogram,
+// and with -DROSEMARY_TRACE each step is a trace span.
+// ==========================================================
+
+#define TASK_MAX 6
+
+struct PeriodicTask {
+    const char *name = "";
+    uint32_t (*step)() = nullptr; // Returns ms until its next deadline
+    uint32_t periodMs = 10;       // Tick while the step has work in progress
+    uint8_t core = 1;
+    uint8_t priority = 1;
+    uint32_t stack = 4096;
+
+    // Stats
+    uint32_t runs = 0;
+    uint32_t woken = 0;           // Runs started by wake() rather than the deadline
+    uint32_t maxRunUs = 0;
+    uint32_t overruns = 0;        // Step took longer than its tick
+    Histogram latency{METRICS_BUCKETS(METRICS_LATENCY_US)};
+#ifdef ROSEMARY_SIM
+    unsigned long nextMs = 0;
+    bool active = false;
+    bool notified = false;
+    uint64_t heapAllocs = 0;      // Includes tasks that preempted this one
+#else
+    TaskHandle_t handle = nullptr;
+#endif
+};
+
+class TaskRunner {
+private:
+    PeriodicTask tasks[TASK_MAX];
+    int count = 0;
+#ifdef ROSEMARY_SIM
+    int current = -1;             // Task whose step is executing
+#endif
+
+public:
+    // Returns the task id for wake(), -1 when full
+    int add(const char *name, uint32_t (*step)(), uint32_t periodMs, uint8_t core, uint8_t priority, uint32_t stack) {
+        if (count >= TASK_MAX) return -1;
+        PeriodicTask &t = tasks[count];
+        t.name = name; t.step = step; t.periodMs = periodMs;
+        t.core = core; t.priority = priority; t.stack = stack;
+        return count++;
+    }
+
+    void start() {
+#ifdef ROSEMARY_SIM
+        for (int i = 0; i < count; i++) tasks[i].nextMs = millis();
+        sim::board().onDelay = [this](){ runDue(current); };
+#else
+        for (int i = 0; i < count; i++) {
+            PeriodicTask &t = tasks[i];
+            xTaskCreatePinnedToCore(trampoline, t.name, t.stack, &t, t.priority, &t.handle, t.core);
+            Serial.printf("Task %s: core %d prio %d tick %lums\n", t.name, t.core, t.priority, (unsigned long)t.periodMs);
+        }
+#endif
+    }
+
+    // Body of Arduino loop()
+    void idle() {
+#ifdef ROSEMARY_SIM
+        runDue(-1);
+#else
+        vTaskDelete(NULL);
+#endif
+    }
+
+    // Any task: run the step now instead of at its deadline
+    void wake(int id) {
+        if (id < 0 || id >= count) return;
+#ifdef ROSEMARY_SIM
+        PeriodicTask &t = tasks[id];
+        t.notified = true;
+        if (!t.active) t.nextMs = millis();
+#else
+        if (tasks[id].handle) xTaskNotifyGive(tasks[id].handle);
+#endif
+    }
+
+    void IRAM_ATTR wakeFromISR(int id) {
+#ifdef ROSEMARY_SIM
+        wake(id);
+#else
+        if (id < 0 || id >= count || !tasks[id].handle) return;
+        BaseType_t higher = pdFALSE;
+        vTaskNotifyGiveFromISR(tasks[id].handle, &higher);
+        if (higher) portYIELD_FROM_ISR();
+#endif
+    }
+
+    int size() { return count; }
+    const PeriodicTask& get(int i) { return tasks[i]; }
+
+#ifdef ROSEMARY_SIM
+    // ms until the earliest task deadline (0 = something is due)
+    uint32_t idleMs() {
+        unsigned long now = millis();
+        uint32_t idle = TASK_IDLE_MAX_MS;
+        for (int i = 0; i < count; i++) {
+            uint32_t d = msUntil(tasks[i].nextMs, now);
+            if (d < idle) idle = d;
+        }
+        return idle;
+    }
+#endif
+
+private:
+    // Deadline returned by a step -> time to block
+    static uint32_t sleepMs(const PeriodicTask &t, uint32_t next) {
+        if (next == 0) return t.periodMs;
+        return next < TASK_IDLE_MAX_MS ? next : TASK_IDLE_MAX_MS;
+    }
+
+    static void record(PeriodicTask &t, uint32_t us) {
+        t.runs++;
+        t.latency.observe(us);
+        if (us > t.maxRunUs) t.maxRunUs = us;
+        if (us > t.periodMs * 1000) t.overruns++;
+    }
+
+#ifdef ROSEMARY_SIM
+    bool preempts(int i, int running) {
+        if (running < 0) return true;
+        return tasks[i].core != tasks[running].core || tasks[i].priority > tasks[running].priority;
+    }
+
+    // Highest priority first, like the FreeRTOS scheduler
+    void runDue(int running) {
+        bool ran[TASK_MAX] = {false};
+        for (int n = 0; n < count; n++) {
+            int best = -1;
+            for (int i = 0; i < count; i++) {
+                if (ran[i] || tasks[i].active || !preempts(i, running)) continue;
+                if (best < 0 || tasks[i].priority > tasks[best].priority) best = i;
+            }
+            if (best < 0) return;
+            ran[best] = true;
+
+            PeriodicTask &t = tasks[best];
+            unsigned long now = millis();
+            if ((long)(now - t.nextMs) < 0) continue;
+            if (t.notified) t.woken++;
+            t.notified = false;
+
+            int prev = current;
+            const char *prevName = sim::board().taskName;
+            uint8_t prevCore = sim::board().taskCore;
+            current = best; t.active = true;
+            sim::board().taskName = t.name; sim::board().taskCore = t.core;
+            uint32_t t0 = micros();
+            uint64_t a0 = sim::board().stats.heapAllocs;
+            uint32_t next;
+            {
+                TRACE_SCOPE(t.name);
+                next = t.step();
+            }
+            record(t, micros() - t0);
+            // Like the device: the deadline counts from the step's start, a wake during it is kept
+            t.nextMs = t.notified ? millis() : now + sleepMs(t, next);
+            t.heapAllocs += sim::board().stats.heapAllocs - a0;
+            sim::board().taskName = prevName; sim::board().taskCore = prevCore;
+            t.active = false; current = prev;
+        }
+    }
+#else
+    static void trampoline(void *arg) {
+        PeriodicTask &t = *(PeriodicTask*)arg;
+        for (;;) {
+            TickType_t start = xTaskGetTickCount();
+            uint32_t t0 = micros();
+            uint32_t next;
+            {
+                TRACE_SCOPE(t.name);
+                next = t.step();
+            }
+            record(t, micros() - t0);
+
+            // Block until the deadline; a notification (wake) ends the wait early
+            TickType_t due = start + pdMS_TO_TICKS(sleepMs(t, next));
+            TickType_t now = xTaskGetTickCount();
+            TickType_t wait = (int32_t)(due - now) > 0 ? due - now : 0;
+            if (ulTaskNotifyTake(pdTRUE, wait) > 0) t.woken++;
+        }
+    }
+#endif
+};
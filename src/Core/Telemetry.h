@@ -0,0 +1,134 @@
+#pragma once
+#include <Arduino.h>
+#include <string.h>
+
+// ==========================================================
+// Telemetry - Compact binary form of /api/data for scrapers
+// CBOR (RFC 8949), written straight into a fixed buffer: no
+// document, no heap. Maps use small integer keys instead of
+// names, and enums go out as numbers. The MQTT publisher's
+// batch frames use the same encoding.
+//
+// Schema rules: a key never changes meaning or type. New fields
+// get new keys, and decoders skip keys they do not know. Only a
+// breaking change bumps TELEMETRY_SCHEMA.
+// ==========================================================
+
+#define TELEMETRY_SCHEMA 1
+
+// Top-level map
+enum TelemetryKey {
+    TK_SCHEMA = 0,        // uint
+    TK_VERSION = 1,       // uint, snapshot version
+    TK_UPTIME = 2,        // uint, seconds
+    TK_PLANTS = 3,        // array of plant maps
+    TK_ENV = 4,           // env map
+    TK_WIFI = 5,          // bool, station connected
+    TK_SSID = 6,          // text
+    TK_IP = 7,            // text
+    TK_DND = 8,           // bool
+    TK_PUMP_LATE_MS = 9,  // uint
+    TK_COUNT
+};
+
+// One map per plant
+enum TelemetryPlantKey {
+    TP_ID = 0,            // int
+    TP_NAME = 1,          // text
+    TP_TYPE = 2,          // uint, PlantType
+    TP_THRESHOLD = 3,     // int, %
+    TP_MOISTURE = 4,      // int, %
+    TP_NOISE = 5,         // int, raw ADC counts (1 sigma)
+    TP_SENSOR = 6,        // uint, SensorType
+    TP_ERROR = 7,         // bool
+    TP_ZONE = 8,          // int, originalIndex
+    TP_DURATION = 9,      // int, seconds
+    TP_WATERING = 10,     // bool
+    TP_WATER_GAIN = 11,   // int, milli-% per pump-second
+    TP_SOAK_MS = 12,      // int
+    TP_HEALTH = 13,       // uint, sensor health score 0..100
+    TP_ANOMALY = 14,      // uint, SensorAnomaly flags
+    TP_COUNT
+};
+
+// Env map, float32 values
+enum TelemetryEnvKey { TE_TEMP = 0, TE_HUM = 1, TE_VPD = 2, TE_COUNT };
+
+// --- MQTT FRAMES (TelemetryPublisher) ---
+// One map per published batch. Records are delta-coded within
+// the frame (deltas start from 0), so every frame decodes alone:
+//   [REC_SAMPLE, dt, dTemp, dHum, dM0 .. dM(zones-1)]
+//       temp and hum x10, null = no reading;
+//       moisture %, -1 = no plant or sensor error
+//   [REC_EVENT, dt, zone, event, value]
+//       event = PlantEvent, zone -1 = plant list changed;
+//       EVT_PUMP value = running, EVT_CONFIG value = threshold
+// dt: ms since the previous record (frame start for the first).
+enum TelemetryFrameKey {
+    FK_SCHEMA = 0,        // uint
+    FK_NODE = 1,          // text, station MAC
+    FK_BOOT = 2,          // uint, random per boot
+    FK_SEQ = 3,           // uint, frame number within the boot
+    FK_T = 4,             // uint, uptime ms at frame start
+    FK_CLOCK = 5,         // uint, history log clock (s) at frame start
+    FK_ZONES = 6,         // uint, moisture values per sample
+    FK_RECORDS = 7,       // indefinite array of records
+    FK_COUNT
+};
+
+enum TelemetryRecord { REC_SAMPLE = 0, REC_EVENT = 1 };
+
+// Minimal CBOR encoder (definite lengths, plus openArray/close)
+class CborWriter {
+private:
+    uint8_t *buf;
+    size_t cap;
+    size_t len = 0;
+    bool overflow = false;
+
+public:
+    CborWriter(uint8_t *out, size_t size) : buf(out), cap(size) {}
+
+    void map(uint32_t pairs) { head(5, pairs); }
+    void array(uint32_t items) { head(4, items); }
+    void openArray() { put(0x9F); }     // Indefinite length, until close()
+    void close() { put(0xFF); }
+    void key(uint32_t k) { head(0, k); }
+    void uint(uint32_t v) { head(0, v); }
+    void integer(int32_t v) { if (v < 0) head(1, (uint32_t)(-1 - v)); else head(0, (uint32_t)v); }
+    void boolean(bool b) { put(b ? 0xF5 : 0xF4); }
+    void null() { put(0xF6); }
+
+    void text(const char *s) {
+        size_t n = strlen(s);
+        head(3, n);
+        if (len + n > cap) { overflow = true; return; }
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+
+    void real(float f) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        put(0xFA);
+        put(bits >> 24); put(bits >> 16); put(bits >> 8); put(bits);
+    }
+
+    size_t size() { return len; }
+    size_t room() { return cap - len; }
+    bool ok() { return !overflow; }
+
+private:
+    void head(uint8_t major, uint32_t v) {
+        major <<= 5;
+        if (v < 24) put(major | v);
+        else if (v <= 0xFF) { put(major | 24); put(v); }
+        else if (v <= 0xFFFF) { put(major | 25); put(v >> 8); put(v); }
+        else { put(major | 26); put(v >> 24); put(v >> 16); put(v >> 8); put(v); }
+    }
+
+    void put(uint8_t b) {
+        if (len < cap) buf[len++] = b;
+        else overflow = true;
+    }
+};
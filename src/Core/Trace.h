@@ -0,0 +1,198 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "../Config.h"
+
+// ==========================================================
+// Trace - Scoped cost trace points (build flag -DROSEMARY_TRACE)
+// TRACE_SCOPE("name") times the rest of the enclosing block with
+// the CPU cycle counter. On exit a span that took at least
+// TRACE_MIN_US claims a slot in a lock-free ring shared by every
+// task on both cores; shorter ones cost two counter reads and a
+// compare. The ring keeps stalls and outliers; /metrics keeps
+// the distributions.
+//
+// GET /api/trace exports the ring as Chrome trace JSON: open it
+// in chrome://tracing or ui.perfetto.dev. One process per core,
+// one thread per task.
+//
+// The cycle counter is per core and wraps every ~18 s, so it
+// only times spans; the start is placed on the shared micros()
+// clock when the span is recorded.
+// Without the flag TRACE_SCOPE expands to nothing.
+// ==========================================================
+
+#ifdef ROSEMARY_TRACE
+
+struct TraceEvent {
+    std::atomic<uint32_t> seq{0};    // Claim index + 1 once complete, 0 while written
+    const char *name = nullptr;
+    const char *thread = nullptr;
+    uint32_t startUs = 0;
+    uint32_t cycles = 0;
+    uint8_t core = 0;
+};
+
+class TraceRing {
+private:
+    TraceEvent events[TRACE_EVENTS];
+    std::atomic<uint32_t> head{0};   // Claims so far
+    uint32_t cpuMhz = 240;
+    uint32_t minCycles = TRACE_MIN_US * 240;
+
+public:
+    void begin() {
+        cpuMhz = ESP.getCpuFreqMHz();
+        minCycles = TRACE_MIN_US * cpuMhz;
+    }
+
+    // Any task, any core
+    void record(const char *name, uint32_t cycles) {
+        if (cycles < minCycles) return;
+        uint32_t startUs = micros() - cycles / cpuMhz;
+        uint32_t i = head.fetch_add(1, std::memory_order_relaxed);
+        TraceEvent &e = events[i % TRACE_EVENTS];
+        e.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        e.name = name;
+        e.thread = threadName();
+        e.core = coreId();
+        e.startUs = startUs;
+        e.cycles = cycles;
+        e.seq.store(i + 1, std::memory_order_release);
+    }
+
+    // Copies claim i if it is complete and still in the ring
+    bool read(uint32_t i, TraceEvent &out) {
+        TraceEvent &e = events[i % TRACE_EVENTS];
+        if (e.seq.load(std::memory_order_acquire) != i + 1) return false;
+        out.name = e.name; out.thread = e.thread; out.core = e.core;
+        out.startUs = e.startUs; out.cycles = e.cycles;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return e.seq.load(std::memory_order_relaxed) == i + 1;
+    }
+
+    uint32_t getRecorded() { return head.load(); }
+    uint32_t getCpuMhz() { return cpuMhz; }
+
+private:
+#ifdef ROSEMARY_SIM
+    static const char* threadName() { return sim::board().taskName; }
+    static uint8_t coreId() { return sim::board().taskCore; }
+#else
+    static const char* threadName() { return pcTaskGetName(NULL); }
+    static uint8_t coreId() { return (uint8_t)xPortGetCoreID(); }
+#endif
+};
+
+extern TraceRing traceRing;
+
+class TraceScope {
+private:
+    const char *name;
+    uint32_t c0;
+
+public:
+    TraceScope(const char *n) : name(n), c0(ESP.getCycleCount()) {}
+    ~TraceScope() { traceRing.record(name, ESP.getCycleCount() - c0); }
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+// --- Chrome trace export for /api/trace (chunked, bounded memory) ---
+// {"displayTimeUnit":"ns","otherData":{..},"traceEvents":[..]}
+// ts is in us since the oldest span in the dump, dur in us.
+class TraceJsonStream {
+private:
+    TraceRing *ring;
+    uint32_t next, end;
+    uint32_t baseUs = 0;
+    bool anyEvent = false;
+    int stage = 0;                   // 0 header, 1 events, 2 footer, 3 done
+    const char *threads[TRACE_THREADS];
+    int threadCount = 0;
+    char item[320];
+    size_t itemLen = 0, itemPos = 0;
+
+    // Chrome wants numeric thread ids: number tasks as first seen
+    int threadId(const char *name, uint8_t core, size_t &n) {
+        for (int i = 0; i < threadCount; i++) if (threads[i] == name) return i + 1;
+        if (threadCount >= TRACE_THREADS) return 0;
+        threads[threadCount++] = name;
+        n += snprintf(item + n, sizeof(item) - n,
+                      "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                      anyEvent ? "," : "", (unsigned)core, threadCount, name ? name : "?");
+        anyEvent = true;
+        return threadCount;
+    }
+
+    bool nextItem() {
+        if (stage == 0) {
+            itemLen = snprintf(item, sizeof(item),
+                               "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"recorded\":%u,\"capacity\":%u,\"min_us\":%u,\"cpu_mhz\":%u},\"traceEvents\":[",
+                               (unsigned)end, (unsigned)TRACE_EVENTS, (unsigned)TRACE_MIN_US, (unsigned)ring->getCpuMhz());
+            stage = 1;
+            return true;
+        }
+        if (stage == 1) {
+            TraceEvent e;
+            while (next < end) {
+                if (!ring->read(next++, e)) continue;   // Overwritten while streaming
+                size_t n = 0;
+                int tid = threadId(e.thread, e.core, n);
+                uint32_t durNs = (uint32_t)((uint64_t)e.cycles * 1000 / ring->getCpuMhz());
+                n += snprintf(item + n, sizeof(item) - n,
+                              "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%d,\"ts\":%u,\"dur\":%u.%03u}",
+                              anyEvent ? "," : "", e.name, (unsigned)e.core, tid,
+                              (unsigned)((int32_t)(e.startUs - baseUs) > 0 ? e.startUs - baseUs : 0), (unsigned)(durNs / 1000), (unsigned)(durNs % 1000));
+                anyEvent = true;
+                itemLen = n < sizeof(item) ? n : sizeof(item) - 1;
+                return true;
+            }
+            stage = 2;
+        }
+        if (stage == 2) {
+            itemLen = snprintf(item, sizeof(item), "]}");
+            stage = 3;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    TraceJsonStream(TraceRing *r) : ring(r) {
+        end = r->getRecorded();
+        next = end > TRACE_EVENTS ? end - TRACE_EVENTS : 0;
+        // Spans are stored as they end: the earliest start is not the first slot
+        TraceEvent e;
+        bool first = true;
+        for (uint32_t i = next; i < end; i++) {
+            if (!ring->read(i, e)) continue;
+            if (first || (int32_t)(e.startUs - baseUs) < 0) baseUs = e.startUs;
+            first = false;
+        }
+    }
+
+    // AsyncWebServer chunk filler: returns bytes written, 0 when done
+    size_t fill(char *buf, size_t maxLen) {
+        size_t n = 0;
+        while (n < maxLen) {
+            if (itemPos >= itemLen) {
+                if (!nextItem()) break;
+                itemPos = 0;
+            }
+            size_t k = std::min(itemLen - itemPos, maxLen - n);
+            memcpy(buf + n, item + itemPos, k);
+            n += k; itemPos += k;
+        }
+        return n;
+    }
+};
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif
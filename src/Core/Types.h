@@ -1,43 +1,99 @@
 #pragma once
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include "../Config.h"
 
+// Numeric values are part of the telemetry schema: append only
 enum PlantType { TYPE_GENERAL, TYPE_DRY, TYPE_WET };
-enum SensorType { SENS_UNKNOWN, SENS_RADAR, SENS_ANALOG };
+enum SensorType { SENS_UNKNOWN, SENS_RADAR, SENS_ANALOG, SENS_SEARCHING };
+enum PlantEvent { EVT_MOISTURE, EVT_PUMP, EVT_CONFIG };
+enum PlantField { FIELD_LIST = 1, FIELD_THRESHOLD = 2, FIELD_DURATION = 4, FIELD_MODEL = 8 };  // Persisted config, dirty bits
+enum PlantCommandOp { CMD_BATCH };
+
+// API -> control task (fixed size, no heap); every plant change from
+// the API is a PlantBatch, this only says one is queued
+struct PlantCommand {
+    uint8_t op = CMD_BATCH;
+};
+
+enum BatchOpKind : uint8_t { BOP_ADD, BOP_DELETE, BOP_UPDATE, BOP_WATER, BOP_CALIBRATE, BOP_NONE };
+
+// One /api/batch operation (fixed size, no heap); -1 = not given
+struct BatchOp {
+    uint8_t kind = BOP_NONE;
+    int32_t id = -1;          // Plant id; adds get theirs when checked
+    int16_t zone = -1;        // water / calibrate ("index", or resolved from id)
+    int16_t threshold = -1;
+    int16_t duration = -1;
+    int16_t dry = -1;
+    int16_t wet = -1;
+    char name[PLANT_NAME_LEN] = {0};
+    char type[16] = {0};
+    const char *error = nullptr;   // Static text, set by parsing or checking
+};
+
+// API -> control task: applied in one step, all ops or none
+struct PlantBatch {
+    BatchOp ops[BATCH_MAX_OPS];
+    uint8_t count = 0;
+};
+
+// Sensing -> control task, latest filtered value per zone
+struct ZoneReadings {
+    int16_t moisture[MAX_PLANTS];
+    int16_t noise[MAX_PLANTS];
+    SensorType mode[MAX_PLANTS];
+    int16_t raw[MAX_PLANTS];        // Filtered ADC counts, -1 = none yet
+    uint16_t sample[MAX_PLANTS];    // Bursts so far (focus bursts republish the rest)
+};
 
 struct EnvData {
     float temp = 0.0; float hum = 0.0; float vpd = 0.0;
-    bool isValid() { return !isnan(temp) && !isnan(hum) && temp > -40; }
+    bool isValid() const { return !isnan(temp) && !isnan(hum) && temp > -40; }
 };
 
+inline const char* plantTypeName(PlantType t) {
+    if (t == TYPE_DRY) return "dry";
+    if (t == TYPE_WET) return "wet";
+    return "general";
+}
+
+inline PlantType parsePlantType(const char *s) {
+    if (s && strcmp(s, "dry") == 0) return TYPE_DRY;
+    if (s && strcmp(s, "wet") == 0) return TYPE_WET;
+    return TYPE_GENERAL;
+}
+
+// Fixed size, no heap: safe to read from other tasks while
+// the control task updates readings in place
 struct Plant {
     int id;
-    String name;
-    String type;
+    char name[PLANT_NAME_LEN];
+    PlantType type;
     int originalIndex;
     int threshold;
     int duration;
     int currentMoisture;
+    int reportedMoisture;   // Last value announced to API clients
+    int moistureNoise;
     bool errorStatus;
     bool isWatering;
-    String aiResult;
-    String sensorMode;
-
-    // Fixed Array (Memory Safe)
-    int history[6]; 
+    char aiResult[PLANT_AI_LEN];
+    SensorType sensorMode;
+    int waterGain;          // Learned response: milli-% per pump-second
+    int soakMs;             // ...and soak-in time constant
+    uint8_t waterRuns;      // Runs the model has learned from
+    uint8_t health;         // Sensor health score 0..100 (SensorHealth)
+    uint8_t anomalies;      // ...and the SensorAnomaly flags up now
 
     Plant() {
-        id = 0; threshold = 40; duration = 5;
-        currentMoisture = 0; errorStatus = false; isWatering = false;
+        id = 0; threshold = 40; duration = 5; type = TYPE_GENERAL;
+        currentMoisture = 0; reportedMoisture = 0; moistureNoise = 0; errorStatus = false; isWatering = false;
         originalIndex = -1;
-        sensorMode = "Searching..."; // Default State
-        for(int i=0; i<6; i++) history[i] = 0;
-    }
-
-    // Shift Register Helper
-    void addHistory(int val) {
-        for(int i=0; i<5; i++) history[i] = history[i+1];
-        history[5] = val;
+        name[0] = 0; aiResult[0] = 0;
+        sensorMode = SENS_SEARCHING; // Default State
+        waterGain = WATER_GAIN_PRIOR; soakMs = WATER_SOAK_PRIOR_MS; waterRuns = 0;
+        health = 100; anomalies = 0;
     }
 };
 
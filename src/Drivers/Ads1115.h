@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include "SensorDriver.h"
+
+// ==========================================================
+// Ads1115 - 4-channel 16-bit I2C ADC, single-shot mode
+// start() kicks a conversion and returns; the result is read
+// once the conversion time has passed, so several boards (and
+// the internal ADC) convert in parallel. Readings are scaled
+// to the 12-bit range of the on-chip ADC (0..3.3 V).
+// No pull resistors to probe with: presence comes from the
+// readings, so fit a high-value pull-down (~1M) on each input
+// to hold an open channel at 0 V.
+// ==========================================================
+
+#define ADS_REG_CONVERSION  0x00
+#define ADS_REG_CONFIG      0x01
+#define ADS_CONFIG_BASE     0x83E3   // OS=1, PGA +-4.096V, single-shot, 860 SPS, comparator off
+#define ADS_CONVERSION_US   1200     // 860 SPS + margin
+
+class Ads1115 : public SensorDriver {
+private:
+    TwoWire *wire;
+    uint8_t address;
+    unsigned long startedAt = 0;
+
+    void writeReg(uint8_t reg, uint16_t v) {
+        wire->beginTransmission(address);
+        wire->write(reg); wire->write(v >> 8); wire->write(v & 0xFF);
+        wire->endTransmission();
+    }
+
+public:
+    Ads1115(TwoWire *w = nullptr, uint8_t addr = 0x48) : wire(w), address(addr) {}
+
+    void begin() override {}
+    int channels() override { return 4; }
+
+    void start(int ch) override {
+        uint16_t mux = 0x4 | (ch & 0x3);             // AINx vs GND
+        writeReg(ADS_REG_CONFIG, ADS_CONFIG_BASE | (mux << 12));
+        startedAt = micros();
+    }
+    bool ready() override { return micros() - startedAt >= ADS_CONVERSION_US; }
+
+    int read() override {
+        wire->beginTransmission(address);
+        wire->write(ADS_REG_CONVERSION);
+        wire->endTransmission();
+        if (wire->requestFrom((int)address, 2) != 2) return 0;
+        uint8_t hi = wire->read();
+        uint8_t lo = wire->read();
+        int16_t v = (int16_t)((hi << 8) | lo);
+        if (v < 0) v = 0;
+        // 1 LSB = 125 uV; 12-bit full scale = 3.3 V
+        int32_t raw = ((int32_t)v * 4095 + 13200) / 26400;
+        return raw > 4095 ? 4095 : (int)raw;
+    }
+    uint32_t sampleUs() override { return ADS_CONVERSION_US; }
+    bool async() override { return true; }
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#include "../Core/Deadline.h"
+
+// ==========================================================
+// Dht22 - Non-blocking DHT22 / AM2302 reader (edge capture)
+// start() holds the line low for the start pulse (the task
+// sleeps meanwhile) and releases it with a CHANGE interrupt
+// armed. The ISR only timestamps edges; poll() decodes the
+// frame once all edges are in, so neither step busy-waits or
+// masks interrupts. The last edge calls onFrame (from the ISR)
+// so the reader can sleep until then.
+//
+// Edges: our own release (rising), the sensor's response low
+// and high (80 us each), then per bit a 50 us low and a
+// 26-28 us (0) or 70 us (1) high; the falling edge after bit
+// 39 closes the frame.
+// ==========================================================
+
+#define DHT_EDGES           (1 + 2 + 40 * 2 + 1)
+#define DHT_BIT_ONE_US      48       // High pulse longer than this = 1
+#define DHT_PULSE_MIN_US    10
+#define DHT_PULSE_MAX_US    120
+
+class Dht22 {
+public:
+    enum Result : uint8_t { BUSY, OK, TIMEOUT, TIMING, CHECKSUM, RESULT_COUNT };
+
+    // ISR context: must be IRAM-safe
+    TaskWake onFrame = nullptr;
+
+private:
+    uint8_t pin;
+    volatile uint32_t edges[DHT_EDGES];
+    volatile uint8_t edgeCount = 0;
+    uint32_t releasedUs = 0;
+    bool armed = false;
+
+    static void IRAM_ATTR onEdge(void *arg) {
+        Dht22 *d = (Dht22*)arg;
+        uint8_t n = d->edgeCount;
+        if (n >= DHT_EDGES) return;
+        d->edges[n] = micros();
+        d->edgeCount = n + 1;
+        if (n + 1 == DHT_EDGES && d->onFrame) d->onFrame();
+    }
+
+    static bool inRange(uint32_t us) { return us >= DHT_PULSE_MIN_US && us <= DHT_PULSE_MAX_US; }
+
+    void disarm() {
+        detachInterrupt(digitalPinToInterrupt(pin));
+        armed = false;
+    }
+
+    Result decode(float &t, float &h) {
+        // Response pulses also check that no edge was missed or doubled up front
+        if (!inRange(edges[1] - edges[0]) || !inRange(edges[2] - edges[1]) || !inRange(edges[3] - edges[2])) return TIMING;
+        uint8_t b[5] = {0};
+        for (int i = 0; i < 40; i++) {
+            uint32_t low = edges[4 + 2 * i] - edges[3 + 2 * i];
+            uint32_t high = edges[5 + 2 * i] - edges[4 + 2 * i];
+            if (!inRange(low) || !inRange(high)) return TIMING;
+            b[i / 8] = (b[i / 8] << 1) | (high > DHT_BIT_ONE_US ? 1 : 0);
+        }
+        if ((uint8_t)(b[0] + b[1] + b[2] + b[3]) != b[4]) return CHECKSUM;
+
+        h = ((b[0] << 8) | b[1]) * 0.1f;
+        t = (((b[2] & 0x7F) << 8) | b[3]) * 0.1f;
+        if (b[2] & 0x80) t = -t;
+        // A valid sum over nonsense still means a bad frame
+        if (h > 100.0f || t < -40.0f || t > 80.0f) return CHECKSUM;
+        return OK;
+    }
+
+public:
+    Dht22(uint8_t p) : pin(p) {}
+
+    void begin() {
+        pinMode(pin, INPUT_PULLUP);
+    }
+
+    // Env task: start pulse, then the sensor answers in the background
+    void start() {
+        if (armed) disarm();
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+        delay(DHT_START_MS);
+        edgeCount = 0;
+        attachInterruptArg(digitalPinToInterrupt(pin), onEdge, this, CHANGE);
+        pinMode(pin, INPUT_PULLUP);
+        releasedUs = micros();
+        armed = true;
+    }
+
+    // BUSY until the frame is complete or DHT_FRAME_US has passed
+    Result poll(float &t, float &h) {
+        if (!armed) return TIMEOUT;
+        if (edgeCount < DHT_EDGES) {
+            if (micros() - releasedUs < DHT_FRAME_US) return BUSY;
+            disarm();
+            return TIMEOUT;
+        }
+        disarm();
+        return decode(t, h);
+    }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+#include "SensorDriver.h"
+
+// ==========================================================
+// DirectAdc - Sensors wired straight to ESP32 ADC pins
+// ==========================================================
+
+class DirectAdc : public SensorDriver {
+private:
+    const int *pins;
+    int count;
+    int current = 0;
+
+public:
+    DirectAdc(const int *p, int n) : pins(p), count(n) {}
+
+    void begin() override {
+        analogReadResolution(12);
+        for (int i = 0; i < count; i++) pinMode(pins[i], INPUT);
+    }
+    int channels() override { return count; }
+
+    void start(int ch) override { current = ch; }
+    bool ready() override { return true; }
+    int read() override { return analogRead(pins[current]); }
+    uint32_t sampleUs() override { return 25; }
+
+    // Every pin has its own pull resistors: one round covers all
+    int probeRounds() override { return 1; }
+    bool inProbeRound(int round, int ch) override { return true; }
+    void setPull(int round, int mode) override {
+        for (int i = 0; i < count; i++) pinMode(pins[i], mode);
+    }
+    int probeRead(int ch) override { return analogRead(pins[ch]); }
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#include "OutputDriver.h"
+
+// ==========================================================
+// LedcOutput - Pumps on ESP32 pins through LEDC PWM
+// (one LEDC channel per pump, so soft-start ramps are possible)
+// ==========================================================
+
+class LedcOutput : public OutputDriver {
+private:
+    const int *pins;
+    const int *currents;
+    int count;
+    int firstChannel;
+
+public:
+    LedcOutput(const int *p, const int *mA, int n, int ledcBase = 0) : pins(p), currents(mA), count(n), firstChannel(ledcBase) {}
+
+    void begin() override {
+        for (int i = 0; i < count; i++) {
+            ledcSetup(firstChannel + i, PUMP_PWM_FREQ, PUMP_PWM_BITS);
+            ledcAttachPin(pins[i], firstChannel + i);
+            ledcWrite(firstChannel + i, 0);
+        }
+    }
+    int channels() override { return count; }
+    bool pwm() override { return true; }
+    void write(int ch, uint8_t duty) override { ledcWrite(firstChannel + ch, duty); }
+    int currentMa(int ch) override { return currents[ch]; }
+};
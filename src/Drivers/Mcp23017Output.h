@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include "OutputDriver.h"
+
+// ==========================================================
+// Mcp23017Output - 16 pumps on an MCP23017 I2C expander
+// Both ports are outputs; OLATA/OLATB are written on commit()
+// when something changed. On/off only.
+// ==========================================================
+
+#define MCP_REG_IODIRA  0x00
+#define MCP_REG_OLATA   0x14
+
+class Mcp23017Output : public OutputDriver {
+private:
+    TwoWire *wire;
+    uint8_t address;
+    int pumpMa;
+    uint16_t bits = 0;
+    bool dirty = true;
+
+public:
+    Mcp23017Output(TwoWire *w, uint8_t addr, int mA) : wire(w), address(addr), pumpMa(mA) {}
+
+    void begin() override {
+        wire->beginTransmission(address);
+        wire->write(MCP_REG_IODIRA); wire->write(0x00); wire->write(0x00);   // IODIRA, IODIRB
+        wire->endTransmission();
+        commit();
+    }
+    int channels() override { return 16; }
+
+    void write(int ch, uint8_t duty) override {
+        uint16_t next = duty ? (bits | (1 << ch)) : (bits & ~(1 << ch));
+        if (next != bits) { bits = next; dirty = true; }
+    }
+
+    void commit() override {
+        if (!dirty) return;
+        wire->beginTransmission(address);
+        wire->write(MCP_REG_OLATA); wire->write(bits & 0xFF); wire->write(bits >> 8);
+        wire->endTransmission();
+        dirty = false;
+    }
+    int currentMa(int ch) override { return pumpMa; }
+};
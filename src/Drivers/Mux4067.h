@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include "SensorDriver.h"
+
+// ==========================================================
+// Mux4067 - Bank of 74HC4067 16:1 analog muxes
+// All muxes share the 4 select lines; each has its own common
+// pin on an ESP32 ADC input. Channel = mux * 16 + select.
+// Scan order walks every mux for one select value before
+// switching, so the select lines change once per 'muxes' reads,
+// and steps the select value in Gray code: one line per change.
+// The settle after a select change is a short busy wait: far
+// below a task tick, so not worth a scheduling round trip.
+// ==========================================================
+
+#define MUX_WAYS        16
+#define MUX_SETTLE_US   10      // Select change -> stable common pin
+
+class Mux4067 : public SensorDriver {
+private:
+    const int *selectPins;      // S0..S3
+    const int *commonPins;
+    int muxes;
+    int selected = -1;
+    int current = 0;
+
+    void select(int sel) {
+        if (sel == selected) return;
+        int diff = selected < 0 ? 0xF : sel ^ selected;
+        for (int b = 0; b < 4; b++) if ((diff >> b) & 1) digitalWrite(selectPins[b], (sel >> b) & 1);
+        selected = sel;
+        delayMicroseconds(MUX_SETTLE_US);
+    }
+
+public:
+    Mux4067(const int *sel, const int *common, int n) : selectPins(sel), commonPins(common), muxes(n) {}
+
+    void begin() override {
+        analogReadResolution(12);
+        for (int b = 0; b < 4; b++) pinMode(selectPins[b], OUTPUT);
+        for (int m = 0; m < muxes; m++) pinMode(commonPins[m], INPUT);
+        select(0);
+    }
+    int channels() override { return muxes * MUX_WAYS; }
+
+    void start(int ch) override { current = ch; select(ch % MUX_WAYS); }
+    bool ready() override { return true; }
+    int read() override { return analogRead(commonPins[current / MUX_WAYS]); }
+    uint32_t sampleUs() override { return 25 + MUX_SETTLE_US / muxes; }
+    int scanOrder(int i) override {
+        int step = i / muxes;
+        return (i % muxes) * MUX_WAYS + (step ^ (step >> 1));
+    }
+
+    // Pulls act on the common pin, i.e. on the selected channel of
+    // every mux: one round per select value
+    int probeRounds() override { return MUX_WAYS; }
+    bool inProbeRound(int round, int ch) override { return ch % MUX_WAYS == round; }
+    void setPull(int round, int mode) override {
+        select(round);
+        for (int m = 0; m < muxes; m++) pinMode(commonPins[m], mode);
+    }
+    int probeRead(int ch) override { return analogRead(commonPins[ch / MUX_WAYS]); }
+};
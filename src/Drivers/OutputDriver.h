@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h>
+
+// ==========================================================
+// OutputDriver - One pump output bank serving N channels
+// write() only stages the level; commit() pushes staged
+// changes to the hardware (once per control pass for shift
+// registers and expanders). Non-PWM banks treat duty > 0 as on.
+// ==========================================================
+
+class OutputDriver {
+public:
+    virtual ~OutputDriver() {}
+    virtual void begin() = 0;
+    virtual int channels() = 0;
+    virtual bool pwm() { return false; }
+    virtual void write(int ch, uint8_t duty) = 0;
+    virtual void commit() {}
+    // Steady-state current of the pump on this channel
+    virtual int currentMa(int ch) = 0;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// ==========================================================
+// SensorDriver - One analog front end serving N channels
+// Conversions are non-blocking: start(ch), poll ready(),
+// then read() a 12-bit value. AdcSampler gives every driver
+// its own scan lane, so slow converters run in parallel.
+//
+// Presence probing (pull-up/pull-down swing test) happens in
+// rounds: every channel listed for a round is pulled at once.
+// Drivers without pull resistors report 0 rounds and are
+// classified from their readings instead.
+// ==========================================================
+
+class SensorDriver {
+public:
+    virtual ~SensorDriver() {}
+    virtual void begin() = 0;
+    virtual int channels() = 0;
+
+    virtual void start(int ch) = 0;
+    virtual bool ready() = 0;
+    virtual int read() = 0;
+    // Nominal cost of one sample incl. settling, for scan planning
+    virtual uint32_t sampleUs() = 0;
+    // Conversion runs in the background: the lane comes back for
+    // it next tick instead of polling (one sample per tick)
+    virtual bool async() { return false; }
+    // Scan position -> channel (lets a mux minimise select changes)
+    virtual int scanOrder(int i) { return i; }
+
+    virtual int probeRounds() { return 0; }
+    virtual bool inProbeRound(int round, int ch) { return false; }
+    virtual void setPull(int round, int mode) {}
+    virtual int probeRead(int ch) { return 0; }
+};
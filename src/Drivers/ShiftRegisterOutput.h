@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include "OutputDriver.h"
+
+// ==========================================================
+// ShiftRegisterOutput - Daisy-chained 74HC595s (8 pumps each)
+// The whole chain is shifted out and latched on commit() when
+// any bit changed. On/off only.
+// ==========================================================
+
+#define SR_MAX_CHIPS 8
+
+class ShiftRegisterOutput : public OutputDriver {
+private:
+    int dataPin, clockPin, latchPin;
+    int chips;
+    int pumpMa;
+    uint8_t bits[SR_MAX_CHIPS] = {0};
+    bool dirty = true;
+
+public:
+    ShiftRegisterOutput(int data, int clock, int latch, int n, int mA)
+        : dataPin(data), clockPin(clock), latchPin(latch), chips(n > SR_MAX_CHIPS ? SR_MAX_CHIPS : n), pumpMa(mA) {}
+
+    void begin() override {
+        pinMode(dataPin, OUTPUT); pinMode(clockPin, OUTPUT); pinMode(latchPin, OUTPUT);
+        digitalWrite(latchPin, LOW);
+        commit();
+    }
+    int channels() override { return chips * 8; }
+
+    void write(int ch, uint8_t duty) override {
+        uint8_t mask = 1 << (ch & 7);
+        uint8_t next = duty ? (bits[ch >> 3] | mask) : (bits[ch >> 3] & ~mask);
+        if (next != bits[ch >> 3]) { bits[ch >> 3] = next; dirty = true; }
+    }
+
+    // Last chip in the chain is shifted first
+    void commit() override {
+        if (!dirty) return;
+        for (int c = chips - 1; c >= 0; c--) shiftOut(dataPin, clockPin, MSBFIRST, bits[c]);
+        digitalWrite(latchPin, HIGH);
+        digitalWrite(latchPin, LOW);
+        dirty = false;
+    }
+    int currentMa(int ch) override { return pumpMa; }
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#include "SensorDriver.h"
+#include "OutputDriver.h"
+
+// ==========================================================
+// ZoneMap - Zone index -> (driver, channel) for sensors/pumps
+// Drivers are added in order and take consecutive zones:
+// addSensors(muxBank) with 64 channels covers zones 0..63.
+// Built once in setup(); read-only afterwards.
+// ==========================================================
+
+#define ZONE_MAX_DRIVERS 8
+
+class ZoneMap {
+private:
+    SensorDriver *sensorDrv[ZONE_MAX_DRIVERS];
+    int sensorBase[ZONE_MAX_DRIVERS];
+    int sensorDrvCount = 0;
+    int sensorZones = 0;
+
+    OutputDriver *pumpDrv[ZONE_MAX_DRIVERS];
+    int pumpDrvCount = 0;
+    int pumpZones = 0;
+    int8_t pumpOf[MAX_PLANTS];          // Zone -> output driver
+    uint8_t pumpCh[MAX_PLANTS];
+
+public:
+    void addSensors(SensorDriver *d) {
+        if (sensorDrvCount >= ZONE_MAX_DRIVERS || sensorZones >= MAX_PLANTS) return;
+        sensorDrv[sensorDrvCount] = d;
+        sensorBase[sensorDrvCount++] = sensorZones;
+        sensorZones += min(d->channels(), MAX_PLANTS - sensorZones);
+    }
+
+    void addPumps(OutputDriver *d) {
+        if (pumpDrvCount >= ZONE_MAX_DRIVERS) return;
+        for (int ch = 0; ch < d->channels() && pumpZones < MAX_PLANTS; ch++) {
+            pumpOf[pumpZones] = pumpDrvCount;
+            pumpCh[pumpZones++] = ch;
+        }
+        pumpDrv[pumpDrvCount++] = d;
+    }
+
+    void begin() {
+        for (int i = 0; i < sensorDrvCount; i++) sensorDrv[i]->begin();
+        for (int i = 0; i < pumpDrvCount; i++) pumpDrv[i]->begin();
+        Serial.printf("Zones: %d sensed on %d driver(s), %d pumps on %d driver(s)\n",
+                      sensorZones, sensorDrvCount, pumpZones, pumpDrvCount);
+    }
+
+    // Zones with both a sensor and a pump
+    int zones() { return min(sensorZones, pumpZones); }
+
+    // --- SENSORS (one scan lane per driver) ---
+    int sensorDrivers() { return sensorDrvCount; }
+    SensorDriver* sensorDriver(int i) { return sensorDrv[i]; }
+    int sensorFirstZone(int i) { return sensorBase[i]; }
+    int sensorZoneCount(int i) { return min(sensorDrv[i]->channels(), MAX_PLANTS - sensorBase[i]); }
+
+    // --- PUMPS ---
+    bool hasPump(int zone) { return zone >= 0 && zone < pumpZones; }
+    bool pumpPwm(int zone) { return hasPump(zone) && pumpDrv[pumpOf[zone]]->pwm(); }
+    int pumpCurrentMa(int zone) { return hasPump(zone) ? pumpDrv[pumpOf[zone]]->currentMa(pumpCh[zone]) : 0; }
+    void pumpWrite(int zone, uint8_t duty) {
+        if (hasPump(zone)) pumpDrv[pumpOf[zone]]->write(pumpCh[zone], duty);
+    }
+    // Push staged pump levels (shift registers, expanders)
+    void pumpCommit() {
+        for (int i = 0; i < pumpDrvCount; i++) pumpDrv[i]->commit();
+    }
+};
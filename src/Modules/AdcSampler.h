@@ -0,0 +1,334 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "../Config.h"
+#include "../Drivers/ZoneMap.h"
+#include "../Core/Deadline.h"
+#include "UniversalSensor.h"
+
+// ==========================================================
+// AdcSampler - Batched, filtered acquisition for all zones
+// One scan lane per sensor driver (see ZoneMap). Lanes run side
+// by side: an I2C converter busy with a conversion never holds
+// up the on-chip ADC. Each lane samples its zones in interleaved
+// bursts every ADC_BURST_MS, then runs a fixed-point trimmed
+// mean + IQR noise estimate per zone. Samples per zone are sized
+// from the driver's conversion time so that one full scan fits
+// the burst period. Busy time per update() is capped at
+// ADC_SCAN_BUDGET_US.
+//
+// Between bursts each lane also runs the sensor presence probe:
+// its zones are pulled up, then down, with a timed settle instead
+// of delay(), in rounds (all pins at once when direct, one select
+// value per round behind a mux). A sweep over every round runs
+// back to back at boot and on request (API, any task), and one
+// round per gap between bursts every SENSOR_RECHECK_MS.
+// Drivers without pull resistors classify zones from the burst.
+//
+// Zones in the focus set (pump running or soaking in, set by the
+// control task) get an extra short burst every ADC_FOCUS_MS in
+// the gaps, so closed-loop watering sees them at a high rate.
+// Between bursts the sensing task sleeps: nextDueMs() is the
+// next burst, focus burst or re-check, and a probe request or a
+// new focus set wakes it.
+// ==========================================================
+
+enum ProbePhase { PROBE_IDLE, PROBE_PULLUP, PROBE_PULLDOWN };
+
+struct ScanLane {
+    SensorDriver *drv = nullptr;
+    int firstZone = 0;
+    int zones = 0;
+    int channels = 0;
+    int samples = ADC_BURST_SAMPLES;      // Per zone per burst
+    uint32_t scanUs = 0;                  // Planned duration of one burst
+
+    bool bursting = false;
+    bool converting = false;
+    int pos = 0;                          // Scan position within a sample round
+    int sample = 0;
+    int burstSamples = 0;
+    uint64_t only = 0;                    // Focus burst: just these channels (0 = full scan)
+    unsigned long lastBurst = 0;
+    unsigned long lastFocus = 0;
+
+    bool sweeping = false;
+    bool gapUsed = false;                 // A probe round already ran since the last burst
+    int round = 0;
+    ProbePhase phase = PROBE_IDLE;
+    unsigned long phaseAt = 0;
+};
+
+class AdcSampler {
+private:
+    UniversalSensor* sensors;
+    ZoneMap* zoneMap;
+    ScanLane lanes[ADC_MAX_LANES];
+    int laneCount = 0;
+    int firstLane = 0;                    // Rotates, so a tight budget is shared fairly
+
+    uint16_t samples[MAX_PLANTS][ADC_BURST_SAMPLES];
+    uint16_t probeHigh[MAX_PLANTS];
+    unsigned long lastPublish[MAX_PLANTS];
+    unsigned long maxRefreshMs = 0;
+    unsigned long burstCount = 0;
+
+    bool sweepUrgent = false;
+    bool sweepReport = false;
+    bool sweepChanged = false;
+    unsigned long lastSweep = 0;
+    std::atomic<bool> sweepActive{false};
+    std::atomic<bool> probeRequested{true};   // First sweep at boot
+    std::atomic<uint32_t> probeCount{0};
+    std::atomic<uint32_t> reportCount{0};     // Probes worth telling clients about
+    std::atomic<uint64_t> focusZones{0};
+    unsigned long focusBursts = 0;
+
+public:
+    // Wakes the sensing task on a probe request or focus change
+    TaskWake wake = nullptr;
+
+    AdcSampler(UniversalSensor* s, ZoneMap* z) : sensors(s), zoneMap(z) {}
+
+    void begin() {
+        unsigned long now = millis();
+        const uint32_t tickUs = SENSE_TICK_MS * 1000UL;
+        laneCount = min(zoneMap->sensorDrivers(), ADC_MAX_LANES);
+        for (int i = 0; i < laneCount; i++) {
+            ScanLane &l = lanes[i];
+            l.drv = zoneMap->sensorDriver(i);
+            l.firstZone = zoneMap->sensorFirstZone(i);
+            l.zones = zoneMap->sensorZoneCount(i);
+            l.channels = l.drv->channels();
+
+            // A background conversion completes at most once per tick
+            uint32_t perSample = l.drv->sampleUs();
+            if (l.drv->async()) perSample = max(perSample, tickUs);
+            int n = (int)((uint32_t)ADC_BURST_MS * 1000UL / (perSample * max(l.zones, 1)));
+            l.samples = constrain(n, ADC_MIN_SAMPLES, ADC_BURST_SAMPLES);
+            l.scanUs = perSample * l.zones * l.samples;
+            l.lastBurst = now - ADC_BURST_MS;    // First burst right away
+            Serial.printf("Scan lane %d: zones %d-%d, %d samples, %lu ms per scan\n",
+                          i, l.firstZone, l.firstZone + l.zones - 1, l.samples, (unsigned long)(l.scanUs / 1000));
+        }
+        for (int z = 0; z < MAX_PLANTS; z++) lastPublish[z] = now;
+        lastSweep = now;
+    }
+
+    // Returns true when a burst or sweep finished and fresh values were published
+    bool update() {
+        unsigned long now = millis();
+        if (!sweepActive.load()) {
+            bool requested = probeRequested.exchange(false);
+            if (requested || now - lastSweep >= SENSOR_RECHECK_MS) startSweep(requested);
+        }
+
+        bool published = false;
+        unsigned long t0 = micros();
+        for (int k = 0; k < laneCount; k++) {
+            if (stepLane(lanes[(firstLane + k) % laneCount], now, t0)) published = true;
+        }
+        if (laneCount > 0) firstLane = (firstLane + 1) % laneCount;
+
+        if (sweepActive.load() && sweepDone()) {
+            sweepActive = false;
+            lastSweep = now;
+            probeCount++;
+            if (sweepChanged || sweepReport) reportCount++;
+            published = true;
+        }
+        return published;
+    }
+
+    // Sensing task: ms until update() has work; 0 while a burst,
+    // conversion or sweep is in progress
+    uint32_t nextDueMs() {
+        if (sweepActive.load() || probeRequested.load()) return 0;
+        unsigned long now = millis();
+        NextDue next;
+        next.at(lastSweep + SENSOR_RECHECK_MS, now);
+        for (int i = 0; i < laneCount; i++) {
+            const ScanLane &l = lanes[i];
+            if (l.bursting || l.phase != PROBE_IDLE) return 0;
+            next.at(l.lastBurst + ADC_BURST_MS, now);
+            if (laneFocus(l)) next.at(l.lastFocus + ADC_FOCUS_MS, now);
+        }
+        return next;
+    }
+
+    // Any task. Bit = zone.
+    void setFocus(uint64_t zones) {
+        if (focusZones.exchange(zones) != zones && wake) wake();
+    }
+
+    unsigned long getBurstCount() { return burstCount; }
+    unsigned long getFocusBurstCount() { return focusBursts; }
+    // Longest gap seen between two fresh values of one zone
+    unsigned long getMaxRefreshMs() { return maxRefreshMs; }
+    int getLaneCount() { return laneCount; }
+    const ScanLane& getLane(int i) { return lanes[i]; }
+
+    // Any task. Returns the probe number that will carry the result.
+    uint32_t requestProbe() {
+        uint32_t target = probeCount.load() + (sweepActive.load() ? 2 : 1);
+        probeRequested = true;
+        if (wake) wake();
+        return target;
+    }
+    uint32_t getProbeCount() { return probeCount.load(); }
+    uint32_t getReportCount() { return reportCount.load(); }
+    bool isProbing() { return sweepActive.load() || probeRequested.load(); }
+
+private:
+    // --- SCAN ---
+
+    bool stepLane(ScanLane &l, unsigned long now, unsigned long t0) {
+        if (!l.bursting) {
+            if (l.phase != PROBE_IDLE) { stepProbe(l, now); return false; }
+            if (l.sweeping && (sweepUrgent || !l.gapUsed)) { startRound(l, now); return false; }
+            uint64_t focus = laneFocus(l);
+            if (now - l.lastBurst >= ADC_BURST_MS) {
+                l.lastBurst = l.lastFocus = now;
+                l.only = 0; l.burstSamples = l.samples; l.gapUsed = false;
+            } else if (focus && now - l.lastFocus >= ADC_FOCUS_MS) {
+                l.lastFocus = now;
+                l.only = focus; l.burstSamples = ADC_FOCUS_SAMPLES;
+            } else return false;
+            l.bursting = true; l.converting = false;
+            l.pos = 0; l.sample = 0;
+        }
+
+        // Interleave zones so pump noise is spread evenly across them
+        while (micros() - t0 < ADC_SCAN_BUDGET_US) {
+            int ch = l.drv->scanOrder(l.pos);
+            if (ch < l.zones && (!l.only || ((l.only >> ch) & 1))) {
+                if (!l.converting) { l.drv->start(ch); l.converting = true; }
+                if (!l.drv->ready()) return false;
+                samples[l.firstZone + ch][l.sample] = l.drv->read();
+                l.converting = false;
+            }
+            if (++l.pos >= l.channels) {
+                l.pos = 0;
+                if (++l.sample >= l.burstSamples) break;
+            }
+        }
+        if (l.sample < l.burstSamples) return false;
+
+        publishLane(l, now);
+        l.bursting = false;
+        return true;
+    }
+
+    // Focus set, as a mask of this lane's channels
+    uint64_t laneFocus(const ScanLane &l) {
+        uint64_t mask = focusZones.load() >> l.firstZone;
+        return l.zones >= 64 ? mask : mask & ((1ULL << l.zones) - 1);
+    }
+
+    void publishLane(ScanLane &l, unsigned long now) {
+        if (l.only) {
+            for (int ch = 0; ch < l.zones; ch++) {
+                if (!((l.only >> ch) & 1)) continue;
+                int z = l.firstZone + ch;
+                sortSamples(samples[z], l.burstSamples);
+                if (sensors[z].isAnalog()) publish(z, samples[z], l.burstSamples);
+            }
+            focusBursts++;
+            return;
+        }
+
+        bool pulls = l.drv->probeRounds() > 0;
+        for (int i = 0; i < l.zones; i++) {
+            int z = l.firstZone + i;
+            uint16_t *v = samples[z];
+            sortSamples(v, l.samples);
+
+            // No pull resistors: a missing sensor sits at a rail
+            if (!pulls) {
+                int median = v[l.samples / 2];
+                bool first = sensors[z].getMode() == SENS_SEARCHING;
+                if (sensors[z].applyProbe(median, median) || first) reportCount++;
+            }
+            if (sensors[z].isAnalog()) publish(z, v, l.samples);
+
+            unsigned long age = now - lastPublish[z];
+            if (age > maxRefreshMs) maxRefreshMs = age;
+            lastPublish[z] = now;
+        }
+        burstCount++;
+    }
+
+    // --- PRESENCE SWEEP ---
+
+    void startSweep(bool requested) {
+        sweepUrgent = requested;
+        sweepReport = requested;
+        sweepChanged = false;
+        for (int i = 0; i < laneCount; i++) {
+            lanes[i].sweeping = lanes[i].drv->probeRounds() > 0;
+            lanes[i].round = 0;
+        }
+        sweepActive = true;
+    }
+
+    bool sweepDone() {
+        for (int i = 0; i < laneCount; i++) if (lanes[i].sweeping) return false;
+        return true;
+    }
+
+    void startRound(ScanLane &l, unsigned long now) {
+        l.drv->setPull(l.round, INPUT_PULLUP);
+        l.phase = PROBE_PULLUP; l.phaseAt = now;
+        l.gapUsed = true;
+    }
+
+    void stepProbe(ScanLane &l, unsigned long now) {
+        if (now - l.phaseAt < SENSOR_PROBE_SETTLE_MS) return;
+
+        if (l.phase == PROBE_PULLUP) {
+            for (int ch = 0; ch < l.zones; ch++) {
+                if (l.drv->inProbeRound(l.round, ch)) probeHigh[l.firstZone + ch] = l.drv->probeRead(ch);
+            }
+            l.drv->setPull(l.round, INPUT_PULLDOWN);
+            l.phase = PROBE_PULLDOWN; l.phaseAt = now;
+            return;
+        }
+
+        for (int ch = 0; ch < l.zones; ch++) {
+            if (!l.drv->inProbeRound(l.round, ch)) continue;
+            int z = l.firstZone + ch;
+            if (sensors[z].applyProbe(probeHigh[z], l.drv->probeRead(ch))) sweepChanged = true;
+        }
+        l.drv->setPull(l.round, INPUT);
+        l.phase = PROBE_IDLE;
+        if (++l.round >= l.drv->probeRounds()) l.sweeping = false;
+    }
+
+    // --- FILTER ---
+
+    // Insertion sort (<= 16 elements, no heap)
+    static void sortSamples(uint16_t *v, int n) {
+        for (int i = 1; i < n; i++) {
+            uint16_t key = v[i]; int j = i - 1;
+            while (j >= 0 && v[j] > key) { v[j + 1] = v[j]; j--; }
+            v[j + 1] = key;
+        }
+    }
+
+    // v is sorted
+    void publish(int z, const uint16_t *v, int n) {
+        int trim = n / 4;
+
+        // Trimmed mean in Q4 (1/16 LSB)
+        uint32_t sum = 0;
+        for (int i = trim; i < n - trim; i++) sum += v[i];
+        const int kept = n - 2 * trim;
+        int32_t valueQ4 = (int32_t)((sum << 4) + kept / 2) / kept;
+
+        // Sigma ~= IQR / 1.349  ->  IQR * 759 / 1024, in Q4
+        int32_t iqr = v[(n * 3) / 4 - 1] - v[n / 4];
+        int32_t noiseQ4 = (iqr * 16 * 759) >> 10;
+
+        sensors[z].publishSample(valueQ4, noiseQ4);
+    }
+};
@@ -1,7 +1,8 @@
 #pragma once
 #include <Arduino.h>
-#include <Preferences.h>
 #include "../Config.h"
+#include "../Core/Deadline.h"
+#include "../Core/ConfigStore.h"
 
 class Buzzer {
 public:
@@ -10,9 +11,9 @@ public:
     int state = 0;
     bool alarmActive = false;
     bool errorActive = false;
-    bool _dndMode = false;
 
-    Preferences prefs;
+    // Control task runs update(); patterns also start from the network task
+    TaskWake wake = nullptr;
 
 public:
     Buzzer() : pin(PIN_BUZZER) {}
@@ -20,29 +21,27 @@ public:
     void begin() {
         pinMode(pin, OUTPUT);
         digitalWrite(pin, LOW);
-
-        prefs.begin("sys_settings", false);
-        _dndMode = prefs.getBool("dnd", false);
     }
 
-    void setDND(bool enable) { _dndMode = enable;
-    prefs.putBool("dnd", enable);
-    }
+    void setDND(bool enable) { config.setBool(CFG_DND, enable); }
     
-    bool isDND() { return _dndMode; }
+    bool isDND() { return config.getBool(CFG_DND); }
 
     void beep() {
-        if(_dndMode) return;
+        if(isDND()) return;
         state = 1; lastUpdate = millis(); digitalWrite(pin, HIGH);
+        if (wake) wake();
     }
 
     void ready() {
         state = 2; lastUpdate = millis(); digitalWrite(pin, HIGH);
+        if (wake) wake();
     }
 
     void setAlarm(bool active) {
         if (active && !alarmActive && !errorActive) {
             alarmActive = true; state = 10; lastUpdate = millis(); digitalWrite(pin, HIGH);
+            if (wake) wake();
         } else if (!active && alarmActive) {
             alarmActive = false; state = 0; digitalWrite(pin, LOW);
         }
@@ -51,6 +50,7 @@ public:
     void setError(bool active) {
         if (active && !errorActive) {
             errorActive = true; alarmActive = false; state = 20; lastUpdate = millis(); digitalWrite(pin, HIGH);
+            if (wake) wake();
         } else if (!active && errorActive) {
             errorActive = false; state = 0; digitalWrite(pin, LOW);
         }
@@ -74,4 +74,17 @@ public:
             case 25: if(now-lastUpdate>2000) { digitalWrite(pin,HIGH); state=20; lastUpdate=now; } break;
         }
     }
+
+    // ms until update() flips the pin (idle when silent)
+    uint32_t nextDueMs() {
+        unsigned long hold;
+        switch(state) {
+            case 0: return TASK_IDLE_MAX_MS;
+            case 1: hold = 150; break;
+            case 10: hold = 500; break;
+            case 11: case 25: hold = 2000; break;
+            default: hold = 100; break;
+        }
+        return msUntil(lastUpdate + hold + 1, millis());
+    }
 };
\ No newline at end of file
@@ -0,0 +1,400 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <LittleFS.h>
+#include "../Config.h"
+#include "../Core/Types.h"
+#include "../Core/Trace.h"
+#include "../Core/Deadline.h"
+#include "PlantManager.h"
+#include "SensorHub.h"
+
+// ==========================================================
+// HistoryLog - Append-only binary time series on LittleFS
+// One ring of fixed-size segments per series (zones + env).
+// Frame: [type:2|len:6][payload][crc8]
+//   KEY   payload: varint t, zigzag varint absolute values
+//   DELTA payload: varint dt, zigzag varint value deltas
+// Values are only written when they change (or every
+// HIST_KEEPALIVE_S), buffered in RAM and flushed in batches.
+// A torn frame at the tail fails its CRC and is skipped; the
+// next write starts a fresh segment.
+//
+// Time is a "log clock" in seconds that resumes from the newest
+// record after a reboot (there is no RTC); downtime is not counted.
+// ==========================================================
+
+#define HIST_SERIES_ENV     MAX_PLANTS
+#define HIST_SERIES_COUNT   (MAX_PLANTS + 1)
+#define HIST_MAX_FIELDS     3
+#define HIST_HEADER_BYTES   12
+#define HIST_FRAME_KEY      1
+#define HIST_FRAME_DELTA    2
+
+struct HistSeries {
+    uint8_t fields = 1;
+    int slots = 0;
+    int slot = -1;               // Active segment slot, -1 = none yet
+    uint32_t seq = 0;            // Sequence number of the active segment
+    uint32_t segBytes = 0;       // Bytes already on flash in the active segment
+    bool needKey = true;
+    uint16_t sinceKey = 0;
+    int32_t last[HIST_MAX_FIELDS] = {0};
+    uint32_t lastT = 0;
+    bool hasLast = false;
+
+    uint8_t buf[HIST_BUF_BYTES];
+    uint16_t bufLen = 0;
+};
+
+class HistoryLog {
+private:
+    PlantManager* plantMgr;
+    SensorHub* sensorHub;
+    HistSeries series[HIST_SERIES_COUNT];
+
+    uint32_t clockBase = 0;
+    unsigned long bootMillis = 0;
+    unsigned long lastSample = 0;
+    unsigned long lastFlush = 0;
+    std::atomic<uint32_t> bytesWritten{0};
+    std::atomic<uint32_t> writes{0};
+
+public:
+    HistoryLog(PlantManager* p, SensorHub* s) : plantMgr(p), sensorHub(s) {}
+
+    void begin() {
+        LittleFS.mkdir("/hist");
+        for (int i = 0; i < HIST_SERIES_COUNT; i++) {
+            series[i].fields = (i == HIST_SERIES_ENV) ? 3 : 1;
+            series[i].slots = (i == HIST_SERIES_ENV) ? HIST_ENV_SEGMENTS : HIST_ZONE_SEGMENTS;
+            recover(i);
+            if (series[i].hasLast && series[i].lastT > clockBase) clockBase = series[i].lastT;
+        }
+        if (clockBase > 0) clockBase += HIST_SAMPLE_MS / 1000;
+        bootMillis = millis();
+        lastSample = millis();
+        lastFlush = millis();
+    }
+
+    void update() {
+        unsigned long now = millis();
+        if (now - lastSample >= HIST_SAMPLE_MS) {
+            lastSample = now;
+            uint32_t t = clock();
+
+            for (auto &p : plantMgr->getPlants()) {
+                if (p.originalIndex < 0 || p.originalIndex >= MAX_PLANTS || p.errorStatus) continue;
+                int32_t v[1] = { p.currentMoisture };
+                append(p.originalIndex, t, v);
+            }
+
+            EnvData env = sensorHub->getEnv();
+            if (env.isValid()) {
+                int32_t v[3] = { (int32_t)lroundf(env.temp * 10), (int32_t)lroundf(env.hum * 10), (int32_t)lroundf(env.vpd * 100) };
+                append(HIST_SERIES_ENV, t, v);
+            }
+        }
+
+        if (now - lastFlush >= HIST_FLUSH_MS) {
+            lastFlush = now;
+            flushAll();
+        }
+    }
+
+    // Network task: ms until the next sample or flush
+    uint32_t nextDueMs() {
+        unsigned long now = millis();
+        NextDue next;
+        next.at(lastSample + HIST_SAMPLE_MS, now);
+        next.at(lastFlush + HIST_FLUSH_MS, now);
+        return next;
+    }
+
+    void flushAll() {
+        for (int i = 0; i < HIST_SERIES_COUNT; i++) flush(i);
+    }
+
+    uint32_t clock() { return clockBase + (millis() - bootMillis) / 1000; }
+    uint32_t getBytesWritten() { return bytesWritten.load(); }
+    uint32_t getWrites() { return writes.load(); }
+    uint8_t fieldCount(int s) { return series[s].fields; }
+
+    // --- Reader (used by the API, one per request) ---
+    class Cursor {
+    private:
+        int id;
+        uint8_t fields;
+        int order[HIST_ENV_SEGMENTS > HIST_ZONE_SEGMENTS ? HIST_ENV_SEGMENTS : HIST_ZONE_SEGMENTS];
+        int count = 0, pos = -1;
+        File file;
+        int32_t vals[HIST_MAX_FIELDS] = {0};
+        uint32_t t = 0;
+        bool primed = false;
+
+    public:
+        Cursor(HistoryLog *log, int s) : id(s), fields(log->series[s].fields) {
+            // Oldest -> newest by segment sequence
+            uint32_t seqs[sizeof(order) / sizeof(order[0])];
+            for (int slot = 0; slot < log->series[s].slots; slot++) {
+                uint32_t seq;
+                if (!readHeader(s, slot, seq)) continue;
+                int i = count++;
+                while (i > 0 && seqs[i - 1] > seq) { seqs[i] = seqs[i - 1]; order[i] = order[i - 1]; i--; }
+                seqs[i] = seq; order[i] = slot;
+            }
+        }
+        ~Cursor() { if (file) file.close(); }
+
+        bool next(uint32_t &outT, int32_t *out) {
+            while (true) {
+                if (!file) {
+                    if (++pos >= count) return false;
+                    file = LittleFS.open(segPath(id, order[pos]), "r");
+                    if (!file) continue;
+                    file.seek(HIST_HEADER_BYTES);
+                    primed = false;   // Each segment starts with a KEY
+                }
+                uint8_t type; uint8_t payload[64]; uint8_t len;
+                if (!readFrame(file, type, payload, len)) { file.close(); continue; }
+                if (!decode(type, payload, len, fields, t, vals, primed)) continue;
+                outT = t;
+                for (int f = 0; f < fields; f++) out[f] = vals[f];
+                return true;
+            }
+        }
+    };
+
+    // --- JSON export for /api/history (chunked, bounded memory) ---
+    // {"series":"z0","now":T,"fields":[..],"points":[[t,v..],..]}
+    // Only flushed records are visible (up to HIST_FLUSH_MS behind).
+    class JsonStream {
+    private:
+        Cursor cursor;
+        int id;
+        uint32_t since, step, now;
+        uint32_t lastEmit = 0;
+        bool anyPoint = false;
+        int stage = 0;               // 0 header, 1 points, 2 footer, 3 done
+        char item[96];
+        size_t itemLen = 0, itemPos = 0;
+
+        bool nextItem() {
+            if (stage == 0) {
+                const char *fields = (id == HIST_SERIES_ENV) ? "\"temp\",\"hum\",\"vpd\"" : "\"moisture\"";
+                String name = (id == HIST_SERIES_ENV) ? String("env") : "z" + String(id);
+                itemLen = snprintf(item, sizeof(item), "{\"series\":\"%s\",\"now\":%u,\"fields\":[%s],\"points\":[", name.c_str(), (unsigned)now, fields);
+                stage = 1;
+                return true;
+            }
+            if (stage == 1) {
+                uint32_t t; int32_t v[HIST_MAX_FIELDS];
+                while (cursor.next(t, v)) {
+                    if (t < since) continue;
+                    if (step && anyPoint && t - lastEmit < step) continue;
+                    lastEmit = t;
+                    const char *sep = anyPoint ? "," : "";
+                    anyPoint = true;
+                    if (id == HIST_SERIES_ENV) itemLen = snprintf(item, sizeof(item), "%s[%u,%.1f,%.1f,%.2f]", sep, (unsigned)t, v[0] / 10.0f, v[1] / 10.0f, v[2] / 100.0f);
+                    else itemLen = snprintf(item, sizeof(item), "%s[%u,%d]", sep, (unsigned)t, (int)v[0]);
+                    return true;
+                }
+                stage = 2;
+            }
+            if (stage == 2) {
+                itemLen = snprintf(item, sizeof(item), "]}");
+                stage = 3;
+                return true;
+            }
+            return false;
+        }
+
+    public:
+        JsonStream(HistoryLog *log, int s, uint32_t sinceT, uint32_t stepS)
+            : cursor(log, s), id(s), since(sinceT), step(stepS), now(log->clock()) {}
+
+        // AsyncWebServer chunk filler: returns bytes written, 0 when done
+        size_t fill(char *buf, size_t maxLen) {
+            size_t n = 0;
+            while (n < maxLen) {
+                if (itemPos >= itemLen) {
+                    if (!nextItem()) break;
+                    itemPos = 0;
+                }
+                size_t k = std::min(itemLen - itemPos, maxLen - n);
+                memcpy(buf + n, item + itemPos, k);
+                n += k; itemPos += k;
+            }
+            return n;
+        }
+    };
+
+    static String segPath(int s, int slot) {
+        return (s == HIST_SERIES_ENV) ? "/hist/env_" + String(slot) + ".bin" : "/hist/z" + String(s) + "_" + String(slot) + ".bin";
+    }
+
+    // --- Encoding helpers ---
+    // CRC-8 (poly 0x07), also used by the telemetry spool
+    static uint8_t crc8(const uint8_t *d, size_t n) {
+        uint8_t c = 0;
+        while (n--) {
+            c ^= *d++;
+            for (int i = 0; i < 8; i++) c = (c & 0x80) ? (uint8_t)((c << 1) ^ 0x07) : (uint8_t)(c << 1);
+        }
+        return c;
+    }
+
+private:
+    static int putVarint(uint8_t *p, uint32_t v) {
+        int n = 0;
+        while (v >= 0x80) { p[n++] = (uint8_t)(v | 0x80); v >>= 7; }
+        p[n++] = (uint8_t)v;
+        return n;
+    }
+    static bool getVarint(const uint8_t *p, uint8_t len, uint8_t &i, uint32_t &v) {
+        v = 0;
+        for (int shift = 0; shift < 35 && i < len; shift += 7) {
+            uint8_t b = p[i++];
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+    static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+    static bool readFrame(File &f, uint8_t &type, uint8_t *payload, uint8_t &len) {
+        int h = f.read();
+        if (h < 0) return false;
+        type = (uint8_t)h >> 6; len = (uint8_t)h & 0x3F;
+        if ((type != HIST_FRAME_KEY && type != HIST_FRAME_DELTA) || len == 0) return false;
+        if (f.read(payload, len) != len) return false;
+        int crc = f.read();
+        if (crc < 0) return false;
+        uint8_t frame[65]; frame[0] = (uint8_t)h; memcpy(frame + 1, payload, len);
+        return crc8(frame, len + 1) == (uint8_t)crc;
+    }
+
+    static bool decode(uint8_t type, const uint8_t *p, uint8_t len, uint8_t fields, uint32_t &t, int32_t *vals, bool &primed) {
+        uint8_t i = 0; uint32_t v;
+        if (!getVarint(p, len, i, v)) return false;
+        if (type == HIST_FRAME_KEY) t = v;
+        else if (primed) t += v;
+        else return false;
+        for (int f = 0; f < fields; f++) {
+            if (!getVarint(p, len, i, v)) return false;
+            vals[f] = (type == HIST_FRAME_KEY) ? unzigzag(v) : vals[f] + unzigzag(v);
+        }
+        primed = true;
+        return true;
+    }
+
+    static bool readHeader(int s, int slot, uint32_t &seq) {
+        File f = LittleFS.open(segPath(s, slot), "r");
+        if (!f) return false;
+        uint8_t h[HIST_HEADER_BYTES];
+        bool ok = f.read(h, HIST_HEADER_BYTES) == HIST_HEADER_BYTES && h[0] == 'R' && h[1] == 'H' && h[2] == 'L' && h[3] == '1' && h[4] == s;
+        f.close();
+        if (ok) memcpy(&seq, h + 8, 4);
+        return ok;
+    }
+
+    // --- Writer ---
+    void recover(int s) {
+        HistSeries &hs = series[s];
+        uint32_t bestSeq = 0;
+        for (int slot = 0; slot < hs.slots; slot++) {
+            uint32_t seq;
+            if (readHeader(s, slot, seq) && seq >= bestSeq) { bestSeq = seq; hs.slot = slot; }
+        }
+        if (hs.slot < 0) return;
+        hs.seq = bestSeq;
+
+        // Replay the newest segment to restore delta state
+        File f = LittleFS.open(segPath(s, hs.slot), "r");
+        if (!f) { hs.slot = -1; return; }
+        size_t size = f.size();
+        f.seek(HIST_HEADER_BYTES);
+        uint8_t type, len, payload[64];
+        bool primed = false;
+        uint32_t t = 0; int32_t vals[HIST_MAX_FIELDS] = {0};
+        size_t good = HIST_HEADER_BYTES;
+        while (readFrame(f, type, payload, len)) {
+            if (!decode(type, payload, len, hs.fields, t, vals, primed)) break;
+            good = f.position();
+            hs.sinceKey = (type == HIST_FRAME_KEY) ? 0 : hs.sinceKey + 1;
+        }
+        f.close();
+
+        hs.segBytes = size;
+        if (primed) {
+            hs.hasLast = true; hs.lastT = t;
+            for (int i = 0; i < hs.fields; i++) hs.last[i] = vals[i];
+        }
+        // Torn tail: leave it for readers to skip and continue in a new segment
+        hs.needKey = true;
+        if (good != size) hs.segBytes = HIST_SEG_BYTES;
+    }
+
+    void append(int s, uint32_t t, const int32_t *v) {
+        HistSeries &hs = series[s];
+
+        bool same = hs.hasLast;
+        for (int i = 0; i < hs.fields && same; i++) same = (v[i] == hs.last[i]);
+        if (same && t - hs.lastT < HIST_KEEPALIVE_S) return;
+
+        uint8_t frame[1 + 63 + 1];
+        uint8_t n = 1;
+        bool key = hs.needKey || !hs.hasLast || hs.sinceKey >= HIST_KEY_EVERY || t < hs.lastT;
+        n += putVarint(frame + n, key ? t : t - hs.lastT);
+        for (int i = 0; i < hs.fields; i++) n += putVarint(frame + n, zigzag(key ? v[i] : v[i] - hs.last[i]));
+        frame[0] = (uint8_t)(((key ? HIST_FRAME_KEY : HIST_FRAME_DELTA) << 6) | (n - 1));
+        frame[n] = crc8(frame, n);
+        n++;
+
+        if (hs.slot < 0 || hs.segBytes + hs.bufLen + n > HIST_SEG_BYTES) {
+            flush(s);
+            rotate(s);
+            if (!key) { append(s, t, v); return; }   // Re-encode as KEY
+        }
+        if (hs.bufLen + n > HIST_BUF_BYTES) flush(s);
+
+        memcpy(hs.buf + hs.bufLen, frame, n);
+        hs.bufLen += n;
+        hs.needKey = false;
+        hs.sinceKey = key ? 0 : hs.sinceKey + 1;
+        hs.hasLast = true; hs.lastT = t;
+        for (int i = 0; i < hs.fields; i++) hs.last[i] = v[i];
+    }
+
+    void flush(int s) {
+        HistSeries &hs = series[s];
+        if (hs.bufLen == 0 || hs.slot < 0) return;
+        TRACE_SCOPE("history.flush");
+        File f = LittleFS.open(segPath(s, hs.slot), "a");
+        if (!f) { Serial.println("History write failed"); return; }
+        size_t w = f.write(hs.buf, hs.bufLen);
+        f.close();
+        hs.segBytes += w;
+        bytesWritten += w;
+        writes++;
+        if (w != hs.bufLen) hs.segBytes = HIST_SEG_BYTES;  // Partial write: move on
+        hs.bufLen = 0;
+    }
+
+    void rotate(int s) {
+        HistSeries &hs = series[s];
+        hs.slot = (hs.slot + 1) % hs.slots;
+        hs.seq++;
+        String path = segPath(s, hs.slot);
+        LittleFS.remove(path.c_str());
+
+        uint8_t h[HIST_HEADER_BYTES] = { 'R', 'H', 'L', '1', (uint8_t)s, hs.fields, 0, 0 };
+        memcpy(h + 8, &hs.seq, 4);
+        File f = LittleFS.open(path, "w");
+        if (f) { f.write(h, HIST_HEADER_BYTES); f.close(); }
+        hs.segBytes = HIST_HEADER_BYTES;
+        hs.needKey = true;
+        hs.bufLen = 0;
+    }
+};
@@ -1,44 +1,76 @@
 #pragma once
 #include <Arduino.h>
-#include <vector>
-#include <deque> 
+#include <functional>
+#include <atomic>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 #include "../Config.h"
 #include "../Core/Types.h"
+#include "../Core/Channels.h"
+#include "../Core/Deadline.h"
+#include "../Core/PlantTable.h"
 #include "Buzzer.h"
+#include "PlantStore.h"
+#include "PumpScheduler.h"
+#include "WaterController.h"
+#include "SensorHealth.h"
 
 class PlantManager; 
 extern PlantManager* sysPlants; 
 
 class PlantManager {
 private:
-    std::vector<Plant> plants;
+    PlantTable plants;
     Buzzer* buzzer;
+    PlantStore store;
     
-    // Sequential Watering
-    int activePumpIndex = -1;             
-    std::deque<int> waterQueue;           
-    
-    unsigned long pumpStartTime = 0;      
+    // Concurrent watering within the supply budget
+    PumpScheduler pumps;
+    WaterController water;
+    SensorHealth health;
     unsigned long lastAutoWaterTime[MAX_PLANTS] = {0};
 
+    // Bumped on any change visible through the API
+    std::atomic<uint32_t> stateVersion{0};
+
+    // API requests, executed on the control task
+    SpscQueue<PlantCommand, 8> commands;
+
+    // /api/batch: one batch slot. The web server task fills and numbers
+    // it; the control task checks and applies it (CMD_BATCH) and leaves
+    // the result there until the web server task begins the next one.
+    enum BatchState : uint8_t { BATCH_IDLE, BATCH_QUEUED, BATCH_DONE };
+    PlantBatch batch;
+    std::atomic<uint8_t> batchState{BATCH_IDLE};
+    uint32_t batchSeq = 0;                  // Number of the batch in the slot
+    std::atomic<uint32_t> batchDone{0};     // Last one run: number << 1 | applied
+    uint32_t batchesApplied = 0, batchesRefused = 0;
+
+    // Push hooks (Network, telemetry), run on the control task
+    std::function<void(const Plant*, PlantEvent)> listeners[PLANT_LISTENERS];
+
 public:
+    // Wakes the control task when a command is queued
+    TaskWake wake = nullptr;
+    // Wakes the network task once a batch has run (its "batch" event)
+    TaskWake batchWake = nullptr;
+
     PlantManager(Buzzer* b) : buzzer(b) {
         sysPlants = this; 
     }
 
-    void begin() {
+    void begin(ZoneMap* zones) {
         if(!LittleFS.begin(true)) Serial.println("FS Error");
-        for(int i=0; i<4; i++) {
-            pinMode(PINS_PUMP[i], OUTPUT);
-            digitalWrite(PINS_PUMP[i], LOW);
-        }
+        pumps.begin(zones);
+        pumps.onChange = [this](int zone, bool running){ onPumpChange(zone, running); };
         loadPlants();
         randomSeed(analogRead(0) + millis());
     }
 
+    // Control task
     void loop() {
+        processCommands();
+
         unsigned long now = millis();
         bool anySensorCritical = false;
 
@@ -47,7 +79,7 @@ public:
             if(p.errorStatus) {
                 anySensorCritical = true;
                
-                if (activePumpIndex == p.originalIndex) stopWatering();
+                pumps.cancel(p.originalIndex);
                
             }
         }
@@ -65,133 +97,275 @@ public:
                
                 bool cooldownOK = (now - lastAutoWaterTime[i] > AUTO_WATER_COOLDOWN);
                 bool needWater = (p.threshold > 0 && p.currentMoisture < p.threshold);
-                bool notInQueue = true;
                 
-                if (activePumpIndex != i && cooldownOK && needWater && !p.errorStatus && p.currentMoisture > 0) {
+                if (!pumps.isRunning(i) && cooldownOK && needWater && !p.errorStatus && p.currentMoisture > 0 && health.allowsAutoWater(i)) {
                     
-                    requestWatering(i);
+                    requestWatering(i, p.threshold - p.currentMoisture, true);
                 }
             }
         }
+
+        // 4. Closed-loop stops and model updates
+        for(auto &p : plants) {
+            WaterAction a = water.update(p, now);
+            if (a == WATER_STOP) pumps.cancel(p.originalIndex);
+            else if (a == WATER_LEARNED) store.markDirty(FIELD_MODEL);
+        }
         
-        // 4. [CORE] Sequential Watering Processor 
+        // 5. [CORE] Budgeted Watering Scheduler
         processWateringQueue(now);
+    }
 
-        // 5. History Log
-        static unsigned long lastLog = 0;
-        if (now - lastLog >= HISTORY_LOG_MS) { 
-            lastLog = now;
-            for(auto &p : plants) p.addHistory(p.currentMoisture);
-            savePlants(true); 
-            Serial.println("History Logged & Saved.");
-        }
+    // Control task: ms until loop() has timed work. Without pumps
+    // busy it only reacts to new readings and commands (both wake).
+    uint32_t nextDueMs() {
+        return pumps.isBusy() ? 0 : TASK_IDLE_MAX_MS;
     }
-    
-    void requestWatering(int index) {
-        for(int q : waterQueue) if(q == index) return;
-        if(activePumpIndex == index) return; 
 
-        waterQueue.push_back(index);
-        Serial.printf("Plant %d added to water queue.\n", index);
+    // Network task: debounced config commit
+    void persist() {
+        if (store.due(millis())) savePlants();
     }
+    uint32_t persistDueMs() { return store.dueInMs(millis()); }
 
-    void processWateringQueue(unsigned long now) {
-        if (activePumpIndex != -1) {
-            Plant* p = nullptr;
-            for(auto &plant : plants) if(plant.originalIndex == activePumpIndex) p = &plant;
-            
-            if (p) {
-                if (now - pumpStartTime >= (p->duration * 1000)) {
-                    stopWatering();
-                }
-            } else {
-                stopWatering(); 
+    // Any task: queue an API request for the control task
+    bool submit(const PlantCommand &cmd) {
+        if (!commands.push(cmd)) return false;
+        if (wake) wake();
+        return true;
+    }
+
+    void processCommands() {
+        PlantCommand cmd;
+        while (commands.pop(cmd)) {
+            switch (cmd.op) {
+                case CMD_BATCH:  applyBatch(); break;
             }
-        } 
+        }
+    }
+
+    // Dry run against the table as it is now, in op order (a delete
+    // frees its zone for a later add). Marks each failing op, gives
+    // adds their id and resolves water/calibrate zones from ids.
+    // Control task, in the step that applies the batch.
+    bool checkBatch(PlantBatch &b) {
+        int32_t ids[MAX_PLANTS];            // Plant id per zone, 0 = free
+        for (int z = 0; z < MAX_PLANTS; z++) { Plant *p = plants.byZone(z); ids[z] = p ? p->id : 0; }
+        auto zoneOf = [&](int32_t id) { for (int z = 0; z < MAX_PLANTS; z++) if (id > 0 && ids[z] == id) return z; return -1; };
+        // A new id is not one this batch deletes, so each result id names one plant
+        auto taken = [&](int32_t id, int upTo) {
+            if (zoneOf(id) >= 0) return true;
+            for (int i = 0; i < upTo; i++) if (b.ops[i].kind == BOP_DELETE && b.ops[i].id == id) return true;
+            return false;
+        };
 
-        else if (!waterQueue.empty()) {
-            int nextIdx = waterQueue.front();
-            waterQueue.pop_front();
-            startWatering(nextIdx);
+        bool ok = true;
+        for (int i = 0; i < b.count; i++) {
+            BatchOp &op = b.ops[i];
+            if (!op.error) switch (op.kind) {
+                case BOP_ADD: {
+                    int z = 0;
+                    while (z < MAX_PLANTS && ids[z]) z++;
+                    if (z == MAX_PLANTS) { op.error = "no free zone"; break; }
+                    if (op.id < 0) { do op.id = random(10000, 99999); while (taken(op.id, i)); }
+                    else if (zoneOf(op.id) >= 0) { op.error = "id in use"; break; }
+                    ids[z] = op.id; op.zone = z;
+                    break;
+                }
+                case BOP_DELETE: {
+                    int z = zoneOf(op.id);
+                    if (z < 0) { op.error = "no such plant"; break; }
+                    ids[z] = 0;
+                    break;
+                }
+                case BOP_UPDATE:
+                    if (zoneOf(op.id) < 0) op.error = "no such plant";
+                    else if (op.threshold < 0 && op.duration < 0) op.error = "nothing to update";
+                    break;
+                case BOP_WATER:
+                case BOP_CALIBRATE:
+                    if (op.zone >= MAX_PLANTS) { op.error = "index out of range"; break; }
+                    if (op.id > 0) {
+                        int z = zoneOf(op.id);
+                        if (z < 0) { op.error = "no such plant"; break; }
+                        if (op.zone >= 0 && op.zone != z) { op.error = "index does not match id"; break; }
+                        op.zone = z;
+                    }
+                    if (op.zone < 0) { op.error = "missing index or id"; break; }
+                    if (op.kind == BOP_WATER) { if (!ids[op.zone]) op.error = "no plant on that zone"; break; }
+                    if (op.dry < 0 && op.wet < 0) { op.error = "nothing to calibrate"; break; }
+                    if ((op.dry >= 0 ? op.dry : config.getInt(CFG_SENSOR_DRY, op.zone)) == (op.wet >= 0 ? op.wet : config.getInt(CFG_SENSOR_WET, op.zone))) op.error = "dry and wet must differ";
+                    break;
+                default:
+                    op.error = "missing op";
+                    break;
+            }
+            if (op.error) ok = false;
         }
+        return ok;
     }
 
-    void startWatering(int index) {
-        if(index < 0 || index >= 4) return;
-        
-        activePumpIndex = index;
-        pumpStartTime = millis();
-        
-        digitalWrite(PINS_PUMP[index], HIGH);
-        buzzer->beep();
-        
+    // Web server task: the batch slot to fill (dropping the last
+    // result), nullptr while the last batch is still queued
+    PlantBatch* beginBatch() {
+        if (batchState.load(std::memory_order_acquire) == BATCH_QUEUED) return nullptr;
+        batchState.store(BATCH_IDLE, std::memory_order_relaxed);
+        batch.count = 0;
+        return &batch;
+    }
 
-        for(auto &p : plants) if(p.originalIndex == index) p.isWatering = true;
-        
-        Serial.printf("Pump %d STARTED (Sequential)\n", index);
+    // Web server task: hand the filled slot to the control task.
+    // Returns the batch number, 0 if the command queue is full (the
+    // slot is free again).
+    uint32_t submitBatch() {
+        batchSeq++;
+        batchState.store(BATCH_QUEUED, std::memory_order_release);
+        PlantCommand cmd;
+        cmd.op = CMD_BATCH;
+        if (submit(cmd)) return batchSeq;
+        batchState.store(BATCH_IDLE, std::memory_order_release);
+        return 0;
     }
 
-    void stopWatering() {
-        if(activePumpIndex != -1) {
-            digitalWrite(PINS_PUMP[activePumpIndex], LOW);
-            
-            for(auto &p : plants) if(p.originalIndex == activePumpIndex) {
-                p.isWatering = false;
-                lastAutoWaterTime[activePumpIndex] = millis();
+    // Web server task: the batch in the slot once the control task has
+    // run it (failing ops carry their error, adds their id), nullptr
+    // while queued or before the first one
+    const PlantBatch* batchResult() {
+        return batchState.load(std::memory_order_acquire) == BATCH_DONE ? &batch : nullptr;
+    }
+    uint32_t getBatchSeq() { return batchSeq; }     // Web server task
+    bool isBatchQueued() { return batchState.load(std::memory_order_acquire) == BATCH_QUEUED; }
+
+    // Any task: number << 1 | applied of the last batch run, 0 before
+    uint32_t getBatchDone() { return batchDone.load(std::memory_order_acquire); }
+    uint32_t getBatchesApplied() { return batchesApplied; }
+    uint32_t getBatchesRefused() { return batchesRefused; }
+
+    // Control task: check, then every op in this one step, so plant
+    // edits fall in one save debounce (one commit) and calibrations in
+    // one config edit. If any op fails, none apply. The web server
+    // task leaves the slot alone until it is DONE, and makes no config
+    // edit of its own for a batch.
+    void applyBatch() {
+        if (batchState.load(std::memory_order_acquire) != BATCH_QUEUED) return;
+        bool ok = checkBatch(batch);
+        if (ok) {
+            bool calibrate = false;
+            for (int i = 0; i < batch.count; i++) {
+                const BatchOp &op = batch.ops[i];
+                switch (op.kind) {
+                    case BOP_ADD:
+                        addPlant(op.name, op.type, op.threshold, op.id);
+                        if (op.duration > 0) updateConfig(op.id, -1, op.duration);
+                        break;
+                    case BOP_DELETE:    deletePlant(op.id); break;
+                    case BOP_UPDATE:    updateConfig(op.id, op.threshold, op.duration); break;
+                    case BOP_WATER:     requestWatering(op.zone); break;
+                    case BOP_CALIBRATE: calibrate = true; break;
+                }
             }
-            
-            Serial.printf("Pump %d STOPPED\n", activePumpIndex);
-            activePumpIndex = -1; 
+            if (calibrate) config.edit([&]{
+                for (int i = 0; i < batch.count; i++) {
+                    const BatchOp &op = batch.ops[i];
+                    if (op.kind != BOP_CALIBRATE) continue;
+                    if (op.dry >= 0) config.putInt(CFG_SENSOR_DRY, op.dry, op.zone);
+                    if (op.wet >= 0) config.putInt(CFG_SENSOR_WET, op.wet, op.zone);
+                }
+            });
         }
+        ok ? batchesApplied++ : batchesRefused++;
+        batchDone.store(batchSeq << 1 | (ok ? 1 : 0), std::memory_order_release);
+        batchState.store(BATCH_DONE, std::memory_order_release);
+        if (batchWake) batchWake();
     }
     
-    void activatePump(int index) {
-        requestWatering(index);
+    // Control task: a zone's latest reading into its health model.
+    // True when the plant's anomalies or score (in steps of 10) changed.
+    bool checkSensor(Plant &p, int raw, int noise, uint16_t sample, bool analog) {
+        int z = p.originalIndex;
+        if (analog) health.observe(z, raw, noise, sample, pumps.anyRunning() || (water.focusMask() >> z & 1), millis());
+        uint8_t score = health.getScore(z), flags = health.getFlags(z);
+        bool changed = flags != p.anomalies || score / 10 != p.health / 10;
+        p.health = score; p.anomalies = flags;
+        return changed;
     }
 
-    std::vector<Plant>& getPlants() { return plants; }
-    bool hasPlant(int id) { for(const auto &p : plants) if(p.id == id) return true; return false; }
-    bool deletePlant(int id) {
-        auto it = std::remove_if(plants.begin(), plants.end(), [id](const Plant& p){ return p.id == id; });
-        if (it != plants.end()) { plants.erase(it, plants.end()); savePlants(true); return true; } return false;
-    }
-    bool addPlant(String name, String type, int threshold) {
-        if(plants.size() >= MAX_PLANTS) return false;
-        int targetIdx = -1; bool slotTaken[4] = {false};
-        for(auto &p : plants) if(p.originalIndex >=0 && p.originalIndex <4) slotTaken[p.originalIndex] = true;
-        for(int i=0; i<4; i++) if(!slotTaken[i]) { targetIdx = i; break; }
-        if(targetIdx == -1) return false;
-        Plant p; p.id = random(10000, 99999); p.name = name; p.type = type; p.threshold = threshold; p.originalIndex = targetIdx;
-        plants.push_back(p); savePlants(true); buzzer->beep(); return true;
-    }
-    void savePlants(bool force=false) {
-        DynamicJsonDocument doc(24000); JsonArray arr = doc.to<JsonArray>();
-        for (const auto &p : plants) {
-            JsonObject obj = arr.createNestedObject();
-            obj["id"] = p.id; obj["name"] = p.name; obj["type"] = p.type; obj["threshold"] = p.threshold; 
-            obj["ai"] = p.aiResult; obj["idx"] = p.originalIndex; obj["dur"] = p.duration;
-            JsonArray hist = obj.createNestedArray("hist"); for(int v : p.history) hist.add(v);
+    // deficit: % below threshold (manual requests count as 100).
+    // Closed-loop runs stop at the target band, others run `duration`.
+    void requestWatering(int index, int deficit = 100, bool closedLoop = false) {
+        Plant *p = plants.byZone(index);
+        if (!p) return;
+        bool queued = pumps.isWaiting(index);
+        if (pumps.request(index, deficit, (unsigned long)p->duration * 1000)) water.arm(index, closedLoop, queued);
+    }
+
+    void processWateringQueue(unsigned long now) {
+        // Drop runs whose plant was deleted
+        for(int i=0; i<MAX_PLANTS; i++) {
+            if ((pumps.isRunning(i) || pumps.isWaiting(i)) && !plants.byZone(i)) pumps.cancel(i);
         }
-        File file = LittleFS.open("/plants.json", "w"); serializeJson(doc, file); file.close();
+        pumps.update(now);
     }
-    void loadPlants() {
-        if (!LittleFS.exists("/plants.json")) return;
-        File file = LittleFS.open("/plants.json", "r");
-        DynamicJsonDocument doc(24000); deserializeJson(doc, file); file.close();
-        plants.clear();
-        for (JsonObject obj : doc.as<JsonArray>()) {
-            Plant p; p.id = obj["id"]; p.name = obj["name"].as<String>(); p.type = obj["type"].as<String>();
-            p.threshold = obj["threshold"]; p.aiResult = obj["ai"] | ""; p.originalIndex = obj["idx"] | -1; p.duration = obj["dur"] | 5;
-            if(p.originalIndex == -1) p.originalIndex = plants.size();
-            if(obj.containsKey("hist")) { int h=0; for(int v : obj["hist"].as<JsonArray>()) { if(h<6) p.history[h++] = v; } }
-            plants.push_back(p);
+
+    void onPumpChange(int index, bool running) {
+        if (running) buzzer->beep();
+        else lastAutoWaterTime[index] = millis();
+        Plant *p = plants.byZone(index);
+        if (p) {
+            if (running) water.onStart(*p, millis()); else water.onStop(index, millis());
+            p->isWatering = running; notify(p, EVT_PUMP);
         }
+        else water.cancel(index);
+    }
+    
+    PlantTable& getPlants() { return plants; }
+    void markChanged() { stateVersion++; }
+    void notify(const Plant *p, PlantEvent e) {
+        markChanged();
+        for (auto &fn : listeners) if (fn) fn(p, e);
+    }
+    // Register before the tasks start; p is null for structural changes
+    bool addListener(std::function<void(const Plant*, PlantEvent)> fn) {
+        for (auto &slot : listeners) if (!slot) { slot = fn; return true; }
+        return false;
+    }
+    uint32_t getStateVersion() { return stateVersion.load(); }
+    unsigned long getStopLateMax() { return pumps.getStopLateMax(); }
+    int getPumpLoadMa() { return pumps.getLoadMa(); }
+    int getMaxConcurrentPumps() { return pumps.getMaxConcurrent(); }
+    // Zones the sampler should read at the focus rate
+    uint64_t getFocusZones() { return water.focusMask(); }
+    WaterController& getWater() { return water; }
+    SensorHealth& getHealth() { return health; }
+    PumpScheduler& getPumps() { return pumps; }
+    uint32_t getConfigCommits() { return store.getCommits(); }
+    bool deletePlant(int id) {
+        Plant *p = plants.byId(id);
+        if (p) water.cancel(p->originalIndex);
+        if (plants.removeById(id)) { notify(nullptr, EVT_CONFIG); store.markDirty(FIELD_LIST); return true; } return false;
+    }
+    // id 0 picks one; threshold < 0 keeps the default
+    bool addPlant(const char *name, const char *type, int threshold, int id = 0) {
+        Plant *p = plants.add(plants.freeZone());
+        if(!p) return false;
+        p->id = id > 0 ? id : random(10000, 99999); strlcpy(p->name, name ? name : "", sizeof(p->name)); p->type = parsePlantType(type); if (threshold >= 0) p->threshold = threshold;
+        notify(nullptr, EVT_CONFIG); store.markDirty(FIELD_LIST); buzzer->beep(); return true;
+    }
+    bool savePlants() { return store.save(plants); }
+    // Commit now if anything is pending (before a reboot)
+    void flush() { if (store.isDirty()) savePlants(); }
+    bool hasUnsavedChanges() { return store.isDirty(); }
+    void loadPlants() {
+        if (!store.load(plants)) return;
+        notify(nullptr, EVT_CONFIG);
     }
     bool updateConfig(int id, int threshold, int duration) {
-        for(auto &p : plants) { if(p.id == id) {
-            if(threshold >= 0) p.threshold = constrain(threshold, 0, 100);
-            if(duration > 0) p.duration = constrain(duration, 1, 60);
-            savePlants(true); return true;
-        }} return false;
+        Plant *p = plants.byId(id);
+        if(!p) return false;
+        uint8_t changed = 0;
+        if(threshold >= 0 && constrain(threshold, 0, 100) != p->threshold) { p->threshold = constrain(threshold, 0, 100); changed |= FIELD_THRESHOLD; }
+        if(duration > 0 && constrain(duration, 1, 60) != p->duration) { p->duration = constrain(duration, 1, 60); changed |= FIELD_DURATION; }
+        if(changed) { notify(p, EVT_CONFIG); store.markDirty(changed); }
+        return true;
     }
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include "../Config.h"
+#include "../Core/Types.h"
+#include "../Core/PlantTable.h"
+#include "../Core/Trace.h"
+#include "../Core/Deadline.h"
+
+// ==========================================================
+// PlantStore - Debounced, atomic persistence for plant config
+// Edits only mark fields dirty; the file is rewritten once the
+// edits go quiet (or at the latest after SAVE_MAX_DELAY_MS).
+// Commit = write /plants.tmp, then rename over /plants.json.
+// Load streams one plant object at a time (no 24 KB document).
+// markDirty() runs on the control task, save() on the network
+// task; an edit that lands mid-save simply leaves it dirty.
+// ==========================================================
+
+#define PLANTS_FILE     "/plants.json"
+#define PLANTS_TMP_FILE "/plants.tmp"
+
+class PlantStore {
+private:
+    std::atomic<uint8_t> dirty{0};   // PlantField bits not yet on flash
+    std::atomic<uint32_t> edits{0};
+    uint32_t savedEdits = 0;         // Edits covered by the last commit
+    std::atomic<unsigned long> firstDirty{0};
+    std::atomic<unsigned long> lastDirty{0};
+    std::atomic<uint32_t> commits{0};
+
+public:
+    void markDirty(uint8_t fields) {
+        unsigned long now = millis();
+        if (dirty.fetch_or(fields) == 0) firstDirty = now;
+        lastDirty = now;
+        edits++;
+    }
+
+    bool isDirty() { return edits.load() != savedEdits; }
+    uint32_t getCommits() { return commits.load(); }
+
+    // Quiet for SAVE_DEBOUNCE_MS, or dirty for SAVE_MAX_DELAY_MS
+    bool due(unsigned long now) {
+        if (!isDirty()) return false;
+        return now - lastDirty >= SAVE_DEBOUNCE_MS || now - firstDirty >= SAVE_MAX_DELAY_MS;
+    }
+
+    // ms until due() turns true (idle when clean)
+    uint32_t dueInMs(unsigned long now) {
+        if (!isDirty()) return TASK_IDLE_MAX_MS;
+        unsigned long quiet = lastDirty + SAVE_DEBOUNCE_MS, cap = firstDirty + SAVE_MAX_DELAY_MS;
+        return std::min(msUntil(quiet, now), msUntil(cap, now));
+    }
+
+    bool save(PlantTable &plants) {
+        TRACE_SCOPE("plants.save");
+        uint32_t covered = edits.load();
+        uint8_t fields = dirty.exchange(0);
+
+        File file = LittleFS.open(PLANTS_TMP_FILE, "w");
+        if (!file) return fail(fields, "open");
+
+        // One small document per plant; strings are referenced, not copied.
+        // Iterates a copy of the order: the control task may add or remove meanwhile.
+        bool ok = file.print("[") == 1;
+        size_t i = 0;
+        for (const Plant &p : plants) {
+            if (!ok) break;
+            StaticJsonDocument<256> doc;
+            doc["id"] = p.id; doc["name"] = (const char*)p.name; doc["type"] = plantTypeName(p.type); doc["threshold"] = p.threshold;
+            doc["ai"] = (const char*)p.aiResult; doc["idx"] = p.originalIndex; doc["dur"] = p.duration;
+            doc["wg"] = p.waterGain; doc["ws"] = p.soakMs; doc["wn"] = p.waterRuns;
+            if (i++ > 0) ok = file.print(",") == 1;
+            if (ok) ok = serializeJson(doc, file) > 0;
+        }
+        if (ok) ok = file.print("]") == 1;
+        file.close();
+
+        if (!ok) { LittleFS.remove(PLANTS_TMP_FILE); return fail(fields, "write"); }
+        if (!LittleFS.rename(PLANTS_TMP_FILE, PLANTS_FILE)) {
+            // Some FS builds refuse to rename over an existing file.
+            // The tmp file is complete, so load() can recover from it.
+            LittleFS.remove(PLANTS_FILE);
+            if (!LittleFS.rename(PLANTS_TMP_FILE, PLANTS_FILE)) return fail(fields, "rename");
+        }
+
+        Serial.printf("Plants saved (%u edits, fields 0x%02X)\n", (unsigned)(covered - savedEdits), (unsigned)fields);
+        savedEdits = covered;
+        commits++;
+        return true;
+    }
+
+    bool load(PlantTable &plants) {
+        // A lone tmp file means a commit died between remove and rename
+        bool fromTmp = !LittleFS.exists(PLANTS_FILE);
+        if (fromTmp) {
+            if (!LittleFS.exists(PLANTS_TMP_FILE)) return false;
+        } else if (LittleFS.exists(PLANTS_TMP_FILE)) {
+            LittleFS.remove(PLANTS_TMP_FILE);   // Torn commit, keep the old file
+        }
+
+        File file = LittleFS.open(fromTmp ? PLANTS_TMP_FILE : PLANTS_FILE, "r");
+        if (!file) return false;
+        plants.clear();
+
+        int c = skipSpace(file);
+        if (c != '[') { file.close(); Serial.println("Plants file corrupt"); return false; }
+
+        // deserializeJson() stops right after each object
+        StaticJsonDocument<512> doc;
+        while (plants.size() < MAX_PLANTS) {
+            if (deserializeJson(doc, file)) break;
+            JsonObject obj = doc.as<JsonObject>();
+            // Legacy files may lack "idx"; a bad or duplicate zone gets the first free one
+            Plant *p = plants.add(obj["idx"] | -1);
+            if (!p) p = plants.add(plants.freeZone());
+            if (!p) break;
+            p->id = obj["id"]; strlcpy(p->name, obj["name"] | "", sizeof(p->name)); p->type = parsePlantType(obj["type"] | "general");
+            p->threshold = obj["threshold"]; strlcpy(p->aiResult, obj["ai"] | "", sizeof(p->aiResult)); p->duration = obj["dur"] | 5;
+            p->waterGain = obj["wg"] | WATER_GAIN_PRIOR; p->soakMs = obj["ws"] | WATER_SOAK_PRIOR_MS; p->waterRuns = obj["wn"] | 0;
+            if (skipSpace(file) != ',') break;
+        }
+        file.close();
+        if (fromTmp) LittleFS.rename(PLANTS_TMP_FILE, PLANTS_FILE);
+        return true;
+    }
+
+private:
+    // Keep the edits pending and retry after another debounce window
+    bool fail(uint8_t fields, const char *stage) {
+        Serial.printf("Save failed: %s\n", stage);
+        dirty |= fields;
+        firstDirty = millis(); lastDirty = millis();
+        return false;
+    }
+
+    static int skipSpace(File &file) {
+        int c;
+        do { c = file.read(); } while (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+        return c;
+    }
+};
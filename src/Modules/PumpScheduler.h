@@ -0,0 +1,194 @@
+#pragma once
+#include <Arduino.h>
+#include <functional>
+#include <atomic>
+#include "../Config.h"
+#include "../Core/Metrics.h"
+#include "../Drivers/ZoneMap.h"
+
+// ==========================================================
+// PumpScheduler - Concurrent watering within a supply budget
+// Each pump has a current rating (from its OutputDriver); pumps
+// run together as long as their sum stays within PUMP_SUPPLY_MA.
+// Starts are soft (duty ramp, on PWM outputs) and staggered:
+// only one pump starts per PUMP_SOFTSTART_MS, so inrush never
+// stacks. On/off outputs (shift registers, expanders) switch
+// straight to full on and keep the stagger.
+//
+// Waiting requests are ordered by moisture deficit plus one
+// point per PUMP_AGING_MS waited. A request that has waited
+// PUMP_MAX_WAIT_MS is starving: it goes first, and if it does
+// not fit yet nothing else may start until it does.
+// ==========================================================
+
+enum PumpState { PUMP_IDLE, PUMP_WAITING, PUMP_RAMPING, PUMP_RUNNING };
+
+struct PumpSlot {
+    uint8_t state = PUMP_IDLE;
+    int deficit = 0;                  // % below threshold at the last request
+    unsigned long requestedAt = 0;
+    unsigned long startedAt = 0;
+    unsigned long durationMs = 0;
+};
+
+class PumpScheduler {
+private:
+    PumpSlot pumps[MAX_PLANTS];
+    ZoneMap* zones = nullptr;
+
+    // Pump stop lateness vs. the requested duration
+    unsigned long stopLateLast = 0;
+    unsigned long stopLateMax = 0;
+    int maxConcurrent = 0;
+
+    // /metrics, written here on the control task
+    std::atomic<uint32_t> starts[MAX_PLANTS] = {};
+    std::atomic<uint32_t> runMs[MAX_PLANTS] = {};
+    std::atomic<uint32_t> queued{0};
+    Histogram wait{METRICS_BUCKETS(METRICS_WAIT_US)};
+
+public:
+    // (zone, running) on every start and stop
+    std::function<void(int, bool)> onChange;
+
+    // Drivers are started by ZoneMap::begin()
+    void begin(ZoneMap* z) { zones = z; }
+
+    // Queue a run, or refresh the deficit of a queued one.
+    // Returns false if the zone is already pumping.
+    bool request(int zone, int deficit, unsigned long durationMs) {
+        if (zone < 0 || zone >= MAX_PLANTS || !zones->hasPump(zone)) return false;
+        PumpSlot &s = pumps[zone];
+        if (s.state == PUMP_RAMPING || s.state == PUMP_RUNNING) return false;
+        if (s.state == PUMP_IDLE) {
+            s.state = PUMP_WAITING;
+            queued++;
+            s.requestedAt = millis();
+            s.deficit = deficit;
+            Serial.printf("Plant %d added to water queue.\n", zone);
+        }
+        if (deficit > s.deficit) s.deficit = deficit;   // A manual request keeps its priority
+        s.durationMs = durationMs;
+        return true;
+    }
+
+    // Stops a running pump or drops a queued request
+    void cancel(int zone) {
+        if (zone < 0 || zone >= MAX_PLANTS) return;
+        PumpSlot &s = pumps[zone];
+        if (s.state == PUMP_RAMPING || s.state == PUMP_RUNNING) stop(zone);
+        else if (s.state == PUMP_WAITING) { s.state = PUMP_IDLE; queued--; }
+    }
+
+    void update(unsigned long now) {
+        // 1. Ramps and timed stops
+        bool ramping = false;
+        for (int i = 0; i < MAX_PLANTS; i++) {
+            PumpSlot &s = pumps[i];
+            if (s.state != PUMP_RAMPING && s.state != PUMP_RUNNING) continue;
+
+            unsigned long elapsed = now - s.startedAt;
+            if (elapsed >= s.durationMs) {
+                stopLateLast = elapsed - s.durationMs;
+                if (stopLateLast > stopLateMax) stopLateMax = stopLateLast;
+                stop(i);
+                continue;
+            }
+            if (s.state == PUMP_RAMPING) {
+                if (elapsed >= PUMP_SOFTSTART_MS) { s.state = PUMP_RUNNING; zones->pumpWrite(i, PUMP_DUTY_MAX); }
+                else {
+                    if (zones->pumpPwm(i)) zones->pumpWrite(i, PUMP_DUTY_MIN + (PUMP_DUTY_MAX - PUMP_DUTY_MIN) * elapsed / PUMP_SOFTSTART_MS);
+                    ramping = true;
+                }
+            }
+        }
+
+        // 2. At most one new start per pass, never during another ramp
+        if (!ramping) startNext(now);
+        zones->pumpCommit();
+    }
+
+    bool isRunning(int zone) { return pumps[zone].state == PUMP_RAMPING || pumps[zone].state == PUMP_RUNNING; }
+    bool isWaiting(int zone) { return pumps[zone].state == PUMP_WAITING; }
+    bool anyRunning() {
+        for (int i = 0; i < MAX_PLANTS; i++) if (isRunning(i)) return true;
+        return false;
+    }
+    // Ramps, stops and queued starts need update() every control tick
+    bool isBusy() {
+        for (int i = 0; i < MAX_PLANTS; i++) if (pumps[i].state != PUMP_IDLE) return true;
+        return false;
+    }
+    int getLoadMa() {
+        int ma = 0;
+        for (int i = 0; i < MAX_PLANTS; i++) if (isRunning(i)) ma += zones->pumpCurrentMa(i);
+        return ma;
+    }
+    int getMaxConcurrent() { return maxConcurrent; }
+    unsigned long getStopLateMax() { return stopLateMax; }
+    unsigned long getStopLateLast() { return stopLateLast; }
+
+    // Any task
+    uint32_t getStarts(int zone) { return starts[zone].load(std::memory_order_relaxed); }
+    uint32_t getRunMs(int zone) { return runMs[zone].load(std::memory_order_relaxed); }
+    uint32_t getQueued() { return queued.load(std::memory_order_relaxed); }
+    const Histogram& getWait() { return wait; }
+
+private:
+    long score(const PumpSlot &s, unsigned long now) {
+        return s.deficit + (long)((now - s.requestedAt) / PUMP_AGING_MS);
+    }
+
+    void startNext(unsigned long now) {
+        int load = getLoadMa();
+        bool tried[MAX_PLANTS] = {false};
+
+        // Best candidate first: starving by age, then by score
+        for (int n = 0; n < MAX_PLANTS; n++) {
+            int best = -1; bool bestStarving = false;
+            for (int i = 0; i < MAX_PLANTS; i++) {
+                const PumpSlot &s = pumps[i];
+                if (tried[i] || s.state != PUMP_WAITING) continue;
+                bool starving = now - s.requestedAt >= PUMP_MAX_WAIT_MS;
+                if (best < 0 ||
+                    (starving && !bestStarving) ||
+                    (starving && bestStarving && s.requestedAt < pumps[best].requestedAt) ||
+                    (!starving && !bestStarving && score(s, now) > score(pumps[best], now))) {
+                    best = i; bestStarving = starving;
+                }
+            }
+            if (best < 0) return;
+            tried[best] = true;
+
+            // A pump larger than the whole budget may still run alone
+            if (load == 0 || load + zones->pumpCurrentMa(best) <= PUMP_SUPPLY_MA) { start(best, now); return; }
+            if (bestStarving) return;   // Hold the budget for it
+        }
+    }
+
+    void start(int zone, unsigned long now) {
+        PumpSlot &s = pumps[zone];
+        s.state = PUMP_RAMPING;
+        s.startedAt = now;
+        queued--;
+        starts[zone].fetch_add(1, std::memory_order_relaxed);
+        unsigned long waited = now - s.requestedAt;
+        wait.observe(waited < 4000000UL ? waited * 1000 : 4000000000UL);
+        zones->pumpWrite(zone, zones->pumpPwm(zone) ? PUMP_DUTY_MIN : PUMP_DUTY_MAX);
+
+        int running = 0;
+        for (int i = 0; i < MAX_PLANTS; i++) if (isRunning(i)) running++;
+        if (running > maxConcurrent) maxConcurrent = running;
+
+        Serial.printf("Pump %d STARTED (%d mA load, waited %lus)\n", zone, getLoadMa(), (now - s.requestedAt) / 1000);
+        if (onChange) onChange(zone, true);
+    }
+
+    void stop(int zone) {
+        zones->pumpWrite(zone, 0);
+        pumps[zone].state = PUMP_IDLE;
+        runMs[zone].fetch_add(millis() - pumps[zone].startedAt, std::memory_order_relaxed);
+        Serial.printf("Pump %d STOPPED\n", zone);
+        if (onChange) onChange(zone, false);
+    }
+};
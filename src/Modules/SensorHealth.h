@@ -0,0 +1,149 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+
+// ==========================================================
+// SensorHealth - Per-zone anomaly detection on raw readings
+// The probe presence test only catches a floating pin. A probe
+// that is stuck, shorted, pinned at a rail or picking up noise
+// still reads "Analog" and keeps asking for water. Each filtered
+// burst value (ADC counts) goes through a few O(1) detectors in
+// integer math, with no history kept:
+//
+//   mean += (raw - mean) >> HEALTH_EWMA_SHIFT          Q4
+//   var  += ((raw - mean)^2 - var) >> HEALTH_EWMA_SHIFT  Q4
+//
+//   noisy      EWMA sigma above HEALTH_NOISE_MAX counts
+//   jump       a step faster than HEALTH_RATE_MAX counts/s;
+//              shown for HEALTH_JUMP_HOLD_MS
+//   flat       no burst noise and no change for HEALTH_FLAT_MS
+//   saturated  within HEALTH_RAIL of 0 or 4095 for HEALTH_RAIL_MS
+//
+// Noisy and jump are not judged while any pump runs (supply
+// noise on the ADC) or while the zone soaks after its own run
+// (moisture moves fast then): the variance is left alone and a
+// noisy flag stays up.
+//
+// Score 0..100, in milli-points: every sample with a flag up
+// costs HEALTH_PENALTY, a new jump HEALTH_JUMP_PENALTY once, and
+// clean time earns HEALTH_RECOVER_PER_MIN back. The state is the
+// zone's, kept while the presence test loses the probe, so one
+// that comes and goes is not forgiven. Auto-watering needs
+// HEALTH_MIN_SCORE; manual watering is not gated.
+// Control task only; the counters are read by /metrics.
+// ==========================================================
+
+enum SensorAnomaly : uint8_t {
+    ANOMALY_NOISY = 1,
+    ANOMALY_JUMP = 2,
+    ANOMALY_FLAT = 4,
+    ANOMALY_SATURATED = 8,
+};
+#define ANOMALY_KINDS 4
+
+struct ZoneHealth {
+    bool primed = false;              // First sample in
+    int32_t meanQ4 = 0;
+    uint32_t varQ4 = 0;
+    int16_t lastRaw = 0;
+    uint16_t lastSample = 0;
+    unsigned long lastAt = 0;
+    unsigned long stillSince = 0;     // Unchanged since, 0 = moving
+    unsigned long railSince = 0;      // At a rail since, 0 = not
+    unsigned long jumpAt = 0;
+    int32_t scoreM = 100000;
+    uint8_t flags = 0;
+    bool withheld = false;            // Auto-watering refused (counted once)
+};
+
+class SensorHealth {
+private:
+    ZoneHealth zones[MAX_PLANTS];
+
+    // Totals since boot
+    uint32_t anomalies[ANOMALY_KINDS] = {};   // Flag raised, by kind (bit order)
+    uint32_t withheldRuns = 0;
+
+    static uint32_t sq(int32_t v) { return (uint32_t)v * (uint32_t)v; }
+
+public:
+    // One filtered burst value. `sample` counts the zone's bursts:
+    // focus bursts republish the other zones, those are skipped.
+    void observe(int zone, int raw, int noise, uint16_t sample, bool settling, unsigned long now) {
+        if (zone < 0 || zone >= MAX_PLANTS || raw < 0) return;
+        ZoneHealth &h = zones[zone];
+        if (h.primed && sample == h.lastSample) return;
+        if (!h.primed) {
+            h.primed = true;
+            h.meanQ4 = raw << 4; h.varQ4 = 0;
+            h.lastRaw = raw; h.lastSample = sample; h.lastAt = now;
+            return;
+        }
+        uint32_t dt = max(now - h.lastAt, 1UL);
+        int step = abs(raw - h.lastRaw);
+        uint8_t flags = 0;
+
+        // EWMA mean and variance (deviation before the mean moves)
+        int32_t dev = (raw << 4) - h.meanQ4;
+        h.meanQ4 += dev >> HEALTH_EWMA_SHIFT;
+        if (!settling) {
+            int32_t d = (int32_t)(sq(dev) >> 4) - (int32_t)h.varQ4;
+            h.varQ4 += d >> HEALTH_EWMA_SHIFT;
+            if (h.varQ4 > (uint32_t)(HEALTH_NOISE_MAX * HEALTH_NOISE_MAX) << 4) flags |= ANOMALY_NOISY;
+        } else flags |= h.flags & ANOMALY_NOISY;
+
+        // Rate of change
+        bool newJump = !settling && (uint32_t)step * 1000 > (uint32_t)HEALTH_RATE_MAX * dt;
+        if (newJump) h.jumpAt = now;
+        if (h.jumpAt && now - h.jumpAt < HEALTH_JUMP_HOLD_MS) flags |= ANOMALY_JUMP;
+        else h.jumpAt = 0;
+
+        // Flat line: a live ADC always shows some noise
+        if (noise > 0 || step > 0) h.stillSince = 0;
+        else if (!h.stillSince) h.stillSince = h.lastAt;
+        if (h.stillSince && now - h.stillSince >= HEALTH_FLAT_MS) flags |= ANOMALY_FLAT;
+
+        // Saturation
+        bool rail = raw <= HEALTH_RAIL || raw >= 4095 - HEALTH_RAIL;
+        if (!rail) h.railSince = 0;
+        else if (!h.railSince) h.railSince = now;
+        if (h.railSince && now - h.railSince >= HEALTH_RAIL_MS) flags |= ANOMALY_SATURATED;
+
+        // Score
+        if (flags & (ANOMALY_NOISY | ANOMALY_FLAT | ANOMALY_SATURATED)) h.scoreM -= HEALTH_PENALTY * 1000;
+        if (newJump) h.scoreM -= HEALTH_JUMP_PENALTY * 1000;
+        if (!flags) h.scoreM += min(dt, (uint32_t)(4 * ADC_BURST_MS)) * HEALTH_RECOVER_PER_MIN / 60;   // Gaps (probe away) earn nothing
+        h.scoreM = constrain(h.scoreM, 0, 100000);
+
+        for (int k = 0; k < ANOMALY_KINDS; k++) if ((flags & ~h.flags) & (1 << k)) anomalies[k]++;
+        h.flags = flags;
+        h.lastRaw = raw; h.lastSample = sample; h.lastAt = now;
+    }
+
+    // Auto-watering check for a zone that wants water
+    bool allowsAutoWater(int zone) {
+        ZoneHealth &h = zones[zone];
+        bool ok = h.scoreM >= HEALTH_MIN_SCORE * 1000;
+        if (!ok && !h.withheld) withheldRuns++;
+        h.withheld = !ok;
+        return ok;
+    }
+
+    uint8_t getScore(int zone) { return zones[zone].scoreM / 1000; }
+    uint8_t getFlags(int zone) { return zones[zone].flags; }
+    uint32_t getAnomalies(int kind) { return anomalies[kind]; }
+    uint32_t getWithheld() { return withheldRuns; }
+
+    // Worst flag first
+    static const char* anomalyName(uint8_t flags) {
+        if (flags & ANOMALY_SATURATED) return "saturated";
+        if (flags & ANOMALY_FLAT) return "flat";
+        if (flags & ANOMALY_NOISY) return "noisy";
+        if (flags & ANOMALY_JUMP) return "jump";
+        return "none";
+    }
+    static const char* kindName(int kind) {
+        static const char *names[ANOMALY_KINDS] = { "noisy", "jump", "flat", "saturated" };
+        return names[kind];
+    }
+};
@@ -1,41 +1,98 @@
 #pragma once
 #include <Arduino.h>
-#include <DHT.h>
+#include <functional>
+#include <atomic>
 #include "../Config.h"
 #include "../Core/Types.h"
+#include "../Core/Channels.h"
+#include "../Core/Deadline.h"
+#include "../Core/Power.h"
+#include "../Drivers/Dht22.h"
 
 class SensorHub {
 private:
-    DHT dht;
-    EnvData currentEnv;
-    unsigned long lastEnvUpdate = 0;
+    Dht22 dht;
+    EnvData currentEnv;                // Env task only
+    Mailbox<EnvData> published;        // Read by the other tasks
+    bool reading = false;              // Frame in flight
+    unsigned long nextRead = 0;
+    bool stale = false;
+    std::atomic<uint32_t> envVersion{0};
+    std::atomic<uint32_t> lastGoodMs{0};
+    std::atomic<uint32_t> results[Dht22::RESULT_COUNT] = {};
+
+    void publish() {
+        published.publish(currentEnv);
+        envVersion++;
+        if (onEnvChange) onEnvChange(currentEnv);
+    }
 
 public:
-    SensorHub() : dht(PIN_DHT, DHT_TYPE) {}
+    // Push hook (Network), fired on the sensing task when a reading changes
+    std::function<void(const EnvData&)> onEnvChange;
+
+    SensorHub() : dht(PIN_DHT) {}
 
-    void begin() {
+    // frameWake: IRAM-safe, wakes the env task when a frame is complete
+    void begin(TaskWake frameWake = nullptr) {
+        dht.onFrame = frameWake;
         dht.begin();
+        lastGoodMs = millis();
     }
 
-    void updateEnv() {
+    // Env task: starts a frame every ENV_UPDATE_MS, publishes only full valid ones.
+    // Returns ms until the next start, or the frame timeout while one is in flight.
+    uint32_t updateEnv() {
         unsigned long now = millis();
-        if (now - lastEnvUpdate < ENV_UPDATE_MS) return;
-        lastEnvUpdate = now;
-
-        float t = dht.readTemperature();
-        float h = dht.readHumidity();
-
-        if (!isnan(t) && !isnan(h)) {
-            currentEnv.temp = t;
-            currentEnv.hum = h;
-            
-            float svp = 0.61078 * exp((17.27 * t) / (t + 237.3));
-            float vpd = svp * (1.0 - (h / 100.0));
-            currentEnv.vpd = vpd;
+        if (!reading) {
+            if ((long)(now - nextRead) < 0) return msUntil(nextRead, now);
+            power.hold(POWER_HOLD_DHT, true);   // Edge interrupts do not wake light sleep
+            dht.start();
+            reading = true;
+            return DHT_START_MS + DHT_FRAME_US / 1000 + 1;
+        }
+
+        float t, h;
+        Dht22::Result r = dht.poll(t, h);
+        if (r == Dht22::BUSY) return 1;
+        power.hold(POWER_HOLD_DHT, false);
+        reading = false;
+        results[r]++;
+        now = millis();
+
+        if (r != Dht22::OK) {
+            // Retry sooner; after DHT_STALE_MS the last values are withdrawn
+            nextRead = now + DHT_RETRY_MS;
+            if (!stale && now - lastGoodMs.load() >= DHT_STALE_MS) {
+                stale = true;
+                currentEnv.temp = currentEnv.hum = currentEnv.vpd = NAN;
+                publish();
+            }
+            return DHT_RETRY_MS;
         }
+
+        nextRead = now + ENV_UPDATE_MS;
+        lastGoodMs = now;
+        bool changed = stale || t != currentEnv.temp || h != currentEnv.hum;
+        stale = false;
+        currentEnv.temp = t;
+        currentEnv.hum = h;
+
+        float svp = 0.61078 * exp((17.27 * t) / (t + 237.3));
+        float vpd = svp * (1.0 - (h / 100.0));
+        currentEnv.vpd = vpd;
+        if (changed) publish();
+        return ENV_UPDATE_MS;
     }
 
     EnvData getEnv() {
-        return currentEnv;
+        return published.get();
     }
+
+    // Bumped whenever a new reading differs from the last one
+    uint32_t getEnvVersion() { return envVersion; }
+
+    // [METRICS] Any task
+    uint32_t getEnvAgeMs() { return millis() - lastGoodMs.load(); }
+    uint32_t getDhtResults(Dht22::Result r) { return results[r].load(std::memory_order_relaxed); }
 };
\ No newline at end of file
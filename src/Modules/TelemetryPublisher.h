@@ -0,0 +1,413 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <LittleFS.h>
+#include "../Config.h"
+#include "../Core/Types.h"
+#include "../Core/Channels.h"
+#include "../Core/Telemetry.h"
+#include "../Core/Trace.h"
+#include "../Core/Deadline.h"
+#include "../Core/ConfigStore.h"
+#include "PlantManager.h"
+#include "SensorHub.h"
+#include "HistoryLog.h"
+
+// ==========================================================
+// TelemetryPublisher - Store-and-forward MQTT telemetry
+// A sample of every zone and the env sensor each MQTT_SAMPLE_MS,
+// plus pump and config events, is batched into a delta-coded
+// CBOR frame (format in Telemetry.h) closed every MQTT_BATCH_MS.
+//
+// Closed frames wait in a small RAM queue. While the broker is
+// out of reach the oldest spill to a ring of segments on
+// LittleFS: [len:16][crc8][frame] per record, the oldest segment
+// dropped when the ring is full. Once connected the backlog
+// drains oldest first at MQTT_DRAIN_PER_S, ahead of live frames.
+//
+// Runs on its own low-priority task; the control task only
+// pushes events into a lock-free queue. Frames are numbered
+// (boot, seq): a segment replayed after a reboot may repeat
+// frames, so collectors drop duplicates.
+// ==========================================================
+
+#define MQTT_SPOOL_HEADER   8
+#define MQTT_RECORD_MAX     (8 + 3 * (4 + MAX_PLANTS))   // Worst-case sample record
+#define MQTT_EVENT_MAX      24
+
+// Control task -> telemetry task
+struct TelemetryEventMsg {
+    unsigned long at;
+    int8_t zone;
+    uint8_t event;
+    int16_t value;
+};
+
+class TelemetryPublisher {
+private:
+    PlantManager* plantMgr;
+    SensorHub* sensorHub;
+    HistoryLog* history;
+    WiFiClient net;
+    PubSubClient mqtt;
+
+    bool enabled = false;
+    char host[64];
+    uint16_t port = MQTT_PORT_DEFAULT;
+    char user[32];
+    char pass[64];
+    char nodeId[13];
+    char topic[48];
+
+    SpscQueue<TelemetryEventMsg, MQTT_EVENT_QUEUE> events;
+
+    // Frame being built
+    uint8_t frame[MQTT_FRAME_BYTES];
+    CborWriter w{frame, sizeof(frame)};
+    bool frameOpen = false;
+    unsigned long frameStart = 0;
+    unsigned long lastRecord = 0;
+    unsigned long lastSample = 0;
+    int32_t prevMoisture[MAX_PLANTS];
+    int32_t prevTemp = 0, prevHum = 0;
+    uint32_t bootId = 0;
+    uint32_t seq = 0;
+
+    // Closed frames, oldest at ramHead
+    uint8_t ram[MQTT_RAM_FRAMES][MQTT_FRAME_BYTES];
+    uint16_t ramLen[MQTT_RAM_FRAMES];
+    int ramHead = 0, ramCount = 0;
+
+    // Spool ring on LittleFS (frames older than anything in RAM)
+    int headSlot = -1, tailSlot = -1;
+    uint32_t headOff = 0, tailBytes = 0, tailSeq = 0;
+    uint16_t segFrames[MQTT_SPOOL_SEGMENTS] = {0};
+    uint32_t spoolFrames = 0;
+    uint8_t sendBuf[MQTT_FRAME_BYTES];
+
+    unsigned long lastAttempt = 0;
+    unsigned long lastSend = 0;
+    bool wasConnected = false;
+
+    // Stats
+    uint32_t published = 0, publishedBytes = 0;
+    uint32_t spilled = 0, spilledBytes = 0, dropped = 0, maxBacklog = 0;
+    uint32_t samples = 0, connects = 0;
+
+public:
+    TelemetryPublisher(PlantManager* p, SensorHub* s, HistoryLog* h)
+        : plantMgr(p), sensorHub(s), history(h), mqtt(net) {}
+
+    void begin() {
+        config.getStr(CFG_MQTT_HOST, host, sizeof(host));
+        port = (uint16_t)config.getInt(CFG_MQTT_PORT);
+        config.getStr(CFG_MQTT_USER, user, sizeof(user));
+        config.getStr(CFG_MQTT_PASS, pass, sizeof(pass));
+        enabled = host[0] != 0;
+        if (!enabled) return;
+
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+        snprintf(nodeId, sizeof(nodeId), "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        snprintf(topic, sizeof(topic), MQTT_TOPIC_PREFIX "%s/telemetry", nodeId);
+        bootId = (uint32_t)random(1, 0x7FFFFFFF);
+
+        mqtt.setServer(host, port);
+        mqtt.setBufferSize(MQTT_FRAME_BYTES + sizeof(topic) + 8);
+        mqtt.setKeepAlive(MQTT_KEEPALIVE_S);
+        mqtt.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
+
+        LittleFS.mkdir("/mq");
+        recoverSpool();
+        if (spoolFrames) Serial.printf("Telemetry: %lu frames spooled from before reboot\n", (unsigned long)spoolFrames);
+
+        plantMgr->addListener([this](const Plant *p, PlantEvent e){
+            if (e == EVT_MOISTURE) return;   // Covered by samples
+            TelemetryEventMsg m;
+            m.at = millis();
+            m.zone = (int8_t)(p ? p->originalIndex : -1);
+            m.event = (uint8_t)e;
+            m.value = (int16_t)(!p ? 0 : e == EVT_PUMP ? p->isWatering : p->threshold);
+            events.push(m);
+        });
+        lastSample = millis() - MQTT_SAMPLE_MS;
+        Serial.printf("Telemetry: %s -> %s:%u\n", topic, host, (unsigned)port);
+    }
+
+    // Telemetry task
+    void update() {
+        if (!enabled) return;
+        unsigned long now = millis();
+        if (frameOpen && now - frameStart >= MQTT_BATCH_MS) closeFrame();
+
+        TelemetryEventMsg e;
+        while (events.pop(e)) {
+            reserve(MQTT_EVENT_MAX, now);
+            writeEvent(e);
+        }
+        if (now - lastSample >= MQTT_SAMPLE_MS) {
+            lastSample = now;
+            reserve(MQTT_RECORD_MAX, now);
+            writeSample(now);
+        }
+
+        service(now);
+    }
+
+    // Telemetry task: ms until update() has work. Events are not
+    // urgent (they carry their own time); connected, the idle cap
+    // keeps mqtt.loop() running well inside the keepalive.
+    uint32_t nextDueMs() {
+        if (!enabled) return TASK_IDLE_MAX_MS;
+        unsigned long now = millis();
+        NextDue next;
+        if (frameOpen) next.at(frameStart + MQTT_BATCH_MS, now);
+        next.at(lastSample + MQTT_SAMPLE_MS, now);
+        if (!mqtt.connected()) {
+            if (WiFi.status() == WL_CONNECTED) next.at(lastAttempt + MQTT_RETRY_MS, now);
+        } else if (spoolFrames > 0 || ramCount > 0) {
+            next.at(lastSend + 1000 / MQTT_DRAIN_PER_S, now);
+        }
+        return next;
+    }
+
+    bool isEnabled() { return enabled; }
+    bool isConnected() { return mqtt.connected(); }
+    uint32_t getPublished() { return published; }
+    uint32_t getPublishedBytes() { return publishedBytes; }
+    uint32_t getSpilled() { return spilled; }
+    uint32_t getSpilledBytes() { return spilledBytes; }
+    uint32_t getDropped() { return dropped; }
+    uint32_t getBacklog() { return spoolFrames + ramCount; }
+    uint32_t getMaxBacklog() { return maxBacklog; }
+    uint32_t getSamples() { return samples; }
+    uint32_t getConnects() { return connects; }
+    uint32_t getLostEvents() { return events.getDropped(); }
+
+private:
+    // --- FRAME ---
+
+    // Room for one more record, or start the next frame
+    void reserve(size_t bytes, unsigned long now) {
+        if (frameOpen && w.room() < bytes + 1) closeFrame();
+        if (frameOpen) return;
+
+        w = CborWriter(frame, sizeof(frame));
+        w.map(FK_COUNT);
+        w.key(FK_SCHEMA); w.uint(TELEMETRY_SCHEMA);
+        w.key(FK_NODE); w.text(nodeId);
+        w.key(FK_BOOT); w.uint(bootId);
+        w.key(FK_SEQ); w.uint(seq++);
+        w.key(FK_T); w.uint(now);
+        w.key(FK_CLOCK); w.uint(history->clock());
+        w.key(FK_ZONES); w.uint(MAX_PLANTS);
+        w.key(FK_RECORDS); w.openArray();
+        frameOpen = true;
+        frameStart = lastRecord = now;
+        for (int i = 0; i < MAX_PLANTS; i++) prevMoisture[i] = 0;
+        prevTemp = prevHum = 0;
+    }
+
+    void writeSample(unsigned long now) {
+        w.array(4 + MAX_PLANTS);
+        w.uint(REC_SAMPLE);
+        w.uint(now - lastRecord);
+        lastRecord = now;
+
+        EnvData env = sensorHub->getEnv();
+        if (env.isValid()) {
+            int32_t t = (int32_t)lroundf(env.temp * 10), h = (int32_t)lroundf(env.hum * 10);
+            w.integer(t - prevTemp); w.integer(h - prevHum);
+            prevTemp = t; prevHum = h;
+        } else {
+            w.null(); w.null();
+        }
+
+        PlantTable& plants = plantMgr->getPlants();
+        for (int z = 0; z < MAX_PLANTS; z++) {
+            const Plant *p = plants.byZone(z);
+            int32_t m = (p && !p->errorStatus) ? p->currentMoisture : -1;
+            w.integer(m - prevMoisture[z]);
+            prevMoisture[z] = m;
+        }
+        samples++;
+    }
+
+    void writeEvent(const TelemetryEventMsg &e) {
+        // Queued before the newest record: keep time monotonic
+        unsigned long dt = (long)(e.at - lastRecord) > 0 ? e.at - lastRecord : 0;
+        lastRecord += dt;
+        w.array(5);
+        w.uint(REC_EVENT);
+        w.uint(dt);
+        w.integer(e.zone);
+        w.uint(e.event);
+        w.integer(e.value);
+    }
+
+    void closeFrame() {
+        w.close();
+        frameOpen = false;
+        if (!w.ok()) { Serial.println("Telemetry frame overflow"); dropped++; return; }
+
+        // RAM full: the oldest frame goes to flash
+        if (ramCount == MQTT_RAM_FRAMES) {
+            spill(ram[ramHead], ramLen[ramHead]);
+            ramHead = (ramHead + 1) % MQTT_RAM_FRAMES;
+            ramCount--;
+        }
+        int slot = (ramHead + ramCount) % MQTT_RAM_FRAMES;
+        memcpy(ram[slot], frame, w.size());
+        ramLen[slot] = (uint16_t)w.size();
+        ramCount++;
+        if (getBacklog() > maxBacklog) maxBacklog = getBacklog();
+    }
+
+    // --- LINK ---
+
+    void service(unsigned long now) {
+        if (!mqtt.connected()) {
+            if (wasConnected) { wasConnected = false; Serial.println("Telemetry: broker lost, buffering"); }
+            if (WiFi.status() != WL_CONNECTED || now - lastAttempt < MQTT_RETRY_MS) return;
+            lastAttempt = now;
+            TRACE_SCOPE("mqtt.connect");
+            bool ok = user[0] ? mqtt.connect(nodeId, user, pass) : mqtt.connect(nodeId);
+            if (!ok) return;
+            wasConnected = true;
+            connects++;
+            Serial.printf("Telemetry: connected, %lu frames to send\n", (unsigned long)getBacklog());
+        }
+        mqtt.loop();
+
+        // Oldest first, at a bounded rate
+        if (now - lastSend < 1000 / MQTT_DRAIN_PER_S) return;
+        if (spoolFrames > 0) {
+            lastSend = now;
+            sendSpooled();
+        } else if (ramCount > 0) {
+            lastSend = now;
+            if (!send(ram[ramHead], ramLen[ramHead])) return;
+            ramHead = (ramHead + 1) % MQTT_RAM_FRAMES;
+            ramCount--;
+        }
+    }
+
+    bool send(const uint8_t *data, size_t len) {
+        TRACE_SCOPE("mqtt.publish");
+        if (!mqtt.publish(topic, data, len, false)) return false;
+        published++;
+        publishedBytes += len;
+        return true;
+    }
+
+    // --- SPOOL ---
+
+    static String segPath(int slot) { return "/mq/s" + String(slot) + ".bin"; }
+
+    void spill(const uint8_t *data, uint16_t len) {
+        TRACE_SCOPE("mqtt.spill");
+        if (tailSlot < 0 || tailBytes + 3 + len > MQTT_SPOOL_SEG_BYTES) rotateSpool();
+        uint8_t h[3] = { (uint8_t)len, (uint8_t)(len >> 8), HistoryLog::crc8(data, len) };
+        File f = LittleFS.open(segPath(tailSlot), "a");
+        if (!f) { dropped++; return; }
+        size_t n = f.write(h, 3);
+        n += f.write(data, len);
+        f.close();
+        if (n != 3u + len) { dropped++; tailBytes = MQTT_SPOOL_SEG_BYTES; return; }   // Torn: next segment
+        tailBytes += n;
+        segFrames[tailSlot]++;
+        spoolFrames++;
+        spilled++;
+        spilledBytes += n;
+    }
+
+    void rotateSpool() {
+        int next = tailSlot < 0 ? 0 : (tailSlot + 1) % MQTT_SPOOL_SEGMENTS;
+        if (spoolFrames > 0 && next == headSlot) {
+            // Ring full: lose the oldest segment
+            dropped += segFrames[headSlot];
+            spoolFrames -= segFrames[headSlot];
+            segFrames[headSlot] = 0;
+            LittleFS.remove(segPath(headSlot).c_str());
+            headSlot = (headSlot + 1) % MQTT_SPOOL_SEGMENTS;
+            headOff = MQTT_SPOOL_HEADER;
+        }
+
+        tailSlot = next;
+        tailSeq++;
+        String path = segPath(tailSlot);
+        LittleFS.remove(path.c_str());
+        uint8_t h[MQTT_SPOOL_HEADER] = { 'R', 'M', 'Q', '1' };
+        memcpy(h + 4, &tailSeq, 4);
+        File f = LittleFS.open(path, "w");
+        if (f) { f.write(h, MQTT_SPOOL_HEADER); f.close(); }
+        tailBytes = MQTT_SPOOL_HEADER;
+        segFrames[tailSlot] = 0;
+        if (spoolFrames == 0) { headSlot = tailSlot; headOff = MQTT_SPOOL_HEADER; }
+    }
+
+    void sendSpooled() {
+        uint16_t len = 0;
+        bool good = false;
+        File f = LittleFS.open(segPath(headSlot), "r");
+        if (f && f.seek(headOff)) {
+            uint8_t h[3];
+            if (f.read(h, 3) == 3) {
+                len = h[0] | (h[1] << 8);
+                good = len <= sizeof(sendBuf) && f.read(sendBuf, len) == len && HistoryLog::crc8(sendBuf, len) == h[2];
+            }
+        }
+        if (f) f.close();
+
+        if (!good) {
+            // Unreadable: give up on the rest of this segment
+            dropped += segFrames[headSlot];
+            spoolFrames -= segFrames[headSlot];
+            segFrames[headSlot] = 0;
+        } else {
+            if (!send(sendBuf, len)) return;
+            headOff += 3 + len;
+            segFrames[headSlot]--;
+            spoolFrames--;
+        }
+        if (segFrames[headSlot] > 0) return;
+
+        // Segment drained
+        LittleFS.remove(segPath(headSlot).c_str());
+        if (spoolFrames == 0) { headSlot = tailSlot = -1; return; }
+        headSlot = (headSlot + 1) % MQTT_SPOOL_SEGMENTS;
+        headOff = MQTT_SPOOL_HEADER;
+    }
+
+    // Rebuild the ring from the segment headers after a reboot
+    void recoverSpool() {
+        uint32_t minSeq = 0xFFFFFFFF;
+        for (int slot = 0; slot < MQTT_SPOOL_SEGMENTS; slot++) {
+            File f = LittleFS.open(segPath(slot), "r");
+            if (!f) continue;
+            uint8_t h[MQTT_SPOOL_HEADER];
+            bool ok = f.read(h, MQTT_SPOOL_HEADER) == MQTT_SPOOL_HEADER && h[0] == 'R' && h[1] == 'M' && h[2] == 'Q' && h[3] == '1';
+            uint32_t s = 0, bytes = MQTT_SPOOL_HEADER;
+            uint16_t n = 0;
+            if (ok) {
+                memcpy(&s, h + 4, 4);
+                uint8_t r[3];
+                while (f.read(r, 3) == 3) {
+                    uint16_t len = r[0] | (r[1] << 8);
+                    if (len > sizeof(sendBuf) || f.read(sendBuf, len) != len || HistoryLog::crc8(sendBuf, len) != r[2]) break;
+                    bytes += 3 + len;
+                    n++;
+                }
+            }
+            f.close();
+            if (!ok || n == 0) { LittleFS.remove(segPath(slot).c_str()); continue; }
+
+            segFrames[slot] = n;
+            spoolFrames += n;
+            if (s < minSeq) { minSeq = s; headSlot = slot; }
+            if (tailSlot < 0 || s > tailSeq) { tailSeq = s; tailSlot = slot; tailBytes = MQTT_SPOOL_SEG_BYTES; }
+        }
+        headOff = MQTT_SPOOL_HEADER;   // Resent from the start: collectors dedupe
+    }
+};
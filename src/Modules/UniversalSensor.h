@@ -1,80 +1,97 @@
 #pragma once
 #include <Arduino.h>
-#include <Preferences.h>
 #include "../Config.h"
 #include "../Core/Types.h"
+#include "../Core/ConfigStore.h"
 
 
 
+// One zone's sensor. Acquisition and presence probing are done
+// by AdcSampler through the zone's SensorDriver; this class only
+// holds the latest filtered reading; calibration lives in the
+// ConfigStore (sensor.dry / sensor.wet).
 class UniversalSensor {
 private:
-    int zoneIndex;
-    int pinRX;
+    int zoneIndex = -1;
 
     
-    SensorType lockedMode = SENS_UNKNOWN; 
+    SensorType lockedMode = SENS_SEARCHING; 
+    bool probed = false;
+    int probeHigh = 0;        // Last swing test: pull-up / pull-down reads
+    int probeLow = 0;
     
-    int analogDry = 4095;
-    int analogWet = 1500;
-
-    Preferences prefs;
+    // Filtered acquisition (fed by AdcSampler), Q4 fixed point
+    int32_t filteredQ4 = -1;
+    int32_t noiseQ4 = 0;
+    uint16_t samples = 0;     // Bursts published (wraps)
 
 public:
-    UniversalSensor(int index, int rx, int tx = -1) 
-        : zoneIndex(index), pinRX(rx) {}
-
-    void begin() {
-        pinMode(pinRX, INPUT); 
-        String nvsName = "sensor_" + String(zoneIndex);
-        prefs.begin(nvsName.c_str(), false);
-        analogDry = prefs.getInt("a_dry", 4095);
-        analogWet = prefs.getInt("a_wet", 1500);
-        
-
-        detectSensorType(true); 
+    void begin(int index) {
+        zoneIndex = index;
+        // Presence is probed by AdcSampler, all zones in parallel
     }
 
-    void update() {
-
-        if (lockedMode == SENS_ANALOG) {
-
-        } 
+    // Result of the pull-up/pull-down swing test (AdcSampler drives
+    // the pins; drivers without pulls pass the burst median twice).
+    // Returns true if the sensor appeared or went away.
+    bool applyProbe(int valHigh, int valLow) {
+        probeHigh = valHigh; probeLow = valLow;
+        SensorType mode = isFloating(valHigh, valLow) ? SENS_UNKNOWN : SENS_ANALOG;
+        if (probed && mode == lockedMode) return false;
+
+        bool changed = probed;
+        probed = true;
+        lockedMode = mode;
+        filteredQ4 = -1; noiseQ4 = 0;
+        if (mode == SENS_ANALOG) Serial.printf("Zone %d: Analog Sensor Detected\n", zoneIndex);
+        else Serial.printf("Zone %d: No Sensor Detected (Floating)\n", zoneIndex);
+        return changed;
     }
 
-    void forceDetect() {
-        detectSensorType(true);
+    void publishSample(int32_t valueQ4, int32_t spreadQ4) {
+        filteredQ4 = valueQ4;
+        noiseQ4 = spreadQ4;
+        samples++;
     }
 
+    // Moisture %, 0 = no reading (no sensor, or no burst since the
+    // probe test last changed the mode; auto-watering skips 0)
     int getValue() {
-        if (lockedMode == SENS_ANALOG) {
-            int raw = analogRead(pinRX);
+        int raw = getBurstRaw();
+        if (lockedMode == SENS_ANALOG && raw >= 0) {
+            int32_t dry = config.getInt(CFG_SENSOR_DRY, zoneIndex);
+            int32_t wet = config.getInt(CFG_SENSOR_WET, zoneIndex);
+            if (dry == wet) return 0;
 
-            return constrain(map(raw, analogDry, analogWet, 0, 100), 0, 100);
+            return constrain(map(raw, dry, wet, 0, 100), 0, 100);
         }
         return 0;
     }
     
-    int getRaw() {
-        return analogRead(pinRX);
-    }
+    // Last filtered value without touching the ADC (-1 = none yet)
+    int getBurstRaw() { return filteredQ4 < 0 ? -1 : (filteredQ4 + 8) >> 4; }
+
+    // 1-sigma noise of the last burst, in raw ADC counts
+    int getNoise() { return (noiseQ4 + 8) >> 4; }
+    uint16_t getSamples() { return samples; }
+
+    int getProbeHigh() { return probeHigh; }
+    int getProbeLow() { return probeLow; }
+    bool isAnalog() { return lockedMode == SENS_ANALOG; }
 
-    String getModeString() {
-        if (lockedMode == SENS_ANALOG) return "Capacitive (Analog)";
+    SensorType getMode() { return lockedMode; }
+    String getModeString() { return modeName(lockedMode); }
+
+    static const char* modeName(SensorType mode) {
+        if (mode == SENS_ANALOG) return "Capacitive (Analog)";
+        if (mode == SENS_SEARCHING) return "Searching...";
         return "No Sensor"; 
     }
 
 private:
 
-    bool isFloatingDeepCheck() {
-        pinMode(pinRX, INPUT_PULLUP); 
-        delay(10); 
-        int valHigh = analogRead(pinRX);
-        
-        pinMode(pinRX, INPUT_PULLDOWN); 
-        delay(10); 
-        int valLow = analogRead(pinRX);
-        
-        pinMode(pinRX, INPUT); 
+    // A floating input follows the pull resistor; a driven one does not
+    static bool isFloating(int valHigh, int valLow) {
         int swing = abs(valHigh - valLow);
         if (swing > 3000) return true; 
         
@@ -83,17 +100,4 @@ private:
 
         return false;
     }
-
-    void detectSensorType(bool isHardCheck = false) {
-
-        if (isHardCheck) {
-            if (isFloatingDeepCheck()) {
-                lockedMode = SENS_UNKNOWN;
-                Serial.printf("Zone %d: No Sensor Detected (Floating)\n", zoneIndex);
-            } else {
-                lockedMode = SENS_ANALOG;
-                Serial.printf("Zone %d: Analog Sensor Detected\n", zoneIndex);
-            }
-        }
-    }
 };
\ No newline at end of file
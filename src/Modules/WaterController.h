@@ -0,0 +1,161 @@
+#pragma once
+#include <Arduino.h>
+#include "../Config.h"
+#include "../Core/Types.h"
+
+// ==========================================================
+// WaterController - Closed-loop watering with a soak model
+// While a zone's pump runs, and while the water soaks in after,
+// AdcSampler samples that zone every ADC_FOCUS_MS. Water pumped
+// but not yet seen by the sensor is tracked per zone with a
+// first-order model:
+//
+//   pending += gain * dt             (pump on)
+//   pending -= pending * dt / soak   (reaches the sensor)
+//
+// An automatic run stops once measured + pending reaches
+// threshold + WATER_TARGET_BAND; `duration` stays as the cap.
+// When the run has soaked for WATER_SOAK_FACTOR x soak, the
+// observed response updates the model (manual runs included):
+//
+//   gain = rise / pump time
+//   soak = settle time - pump time / 2 - area / rise
+//
+// with area = integral of (moisture - start) since the start.
+// Moisture is in milli-percent, pending water in micro-percent.
+// ==========================================================
+
+enum WaterPhase { WATER_IDLE, WATER_PUMPING, WATER_SOAKING };
+enum WaterAction { WATER_CONTINUE, WATER_STOP, WATER_LEARNED };
+
+struct WaterRun {
+    uint8_t phase = WATER_IDLE;
+    bool closedLoop = false;
+    bool armedClosed = false;         // Mode of the queued request
+    int32_t startMp = 0;              // Moisture at pump start
+    int32_t filteredMp = 0;           // Smoothed focus readings
+    int32_t targetMp = 0;
+    int32_t pendingUp = 0;            // Pumped, not yet at the sensor
+    int64_t area = 0;                 // Integral of (moisture - start), mp * ms
+    unsigned long startedAt = 0;
+    unsigned long stoppedAt = 0;
+    unsigned long lastAt = 0;
+};
+
+class WaterController {
+private:
+    WaterRun runs[MAX_PLANTS];
+
+    // Totals since boot
+    unsigned long earlyStops = 0;
+    unsigned long savedMs = 0;        // Pump time saved vs. the duration cap
+    unsigned long learnCount = 0;
+    int64_t overshootSum = 0;         // Settled moisture - target, closed-loop runs
+    int32_t overshootMax = 0;
+    unsigned long overshootRuns = 0;
+
+public:
+    // Before each request; a queued manual request stays open-loop
+    void arm(int zone, bool closedLoop, bool merge) {
+        WaterRun &r = runs[zone];
+        r.armedClosed = merge ? (r.armedClosed && closedLoop) : closedLoop;
+    }
+
+    void onStart(const Plant &p, unsigned long now) {
+        WaterRun &r = runs[p.originalIndex];
+        r.phase = WATER_PUMPING;
+        r.closedLoop = r.armedClosed;
+        r.startMp = r.filteredMp = p.currentMoisture * 1000;
+        r.targetMp = min(p.threshold + WATER_TARGET_BAND, 100) * 1000;
+        r.pendingUp = 0;
+        r.area = 0;
+        r.startedAt = r.lastAt = now;
+    }
+
+    void onStop(int zone, unsigned long now) {
+        WaterRun &r = runs[zone];
+        if (r.phase != WATER_PUMPING) return;
+        r.phase = WATER_SOAKING;
+        r.stoppedAt = now;
+    }
+
+    void cancel(int zone) { runs[zone].phase = WATER_IDLE; }
+
+    // Control task, every tick for zones with a run in progress
+    WaterAction update(Plant &p, unsigned long now) {
+        WaterRun &r = runs[p.originalIndex];
+        if (r.phase == WATER_IDLE) return WATER_CONTINUE;
+        if (p.errorStatus) { r.phase = WATER_IDLE; return WATER_CONTINUE; }
+
+        int64_t dt = (int64_t)(now - r.lastAt);
+        if (dt <= 0) return WATER_CONTINUE;
+        r.lastAt = now;
+
+        int32_t m = p.currentMoisture * 1000;
+        r.filteredMp += (int32_t)((m - r.filteredMp) * dt / (dt + WATER_FILTER_MS));
+        r.area += (r.filteredMp - r.startMp) * dt;
+
+        if (r.phase == WATER_PUMPING) r.pendingUp += (int32_t)(p.waterGain * dt);
+        r.pendingUp -= (int32_t)(r.pendingUp * dt / max(p.soakMs, 1));
+
+        if (r.phase == WATER_PUMPING) {
+            if (r.closedLoop && r.filteredMp + r.pendingUp / 1000 >= r.targetMp) {
+                unsigned long ran = now - r.startedAt, cap = (unsigned long)p.duration * 1000;
+                earlyStops++;
+                if (cap > ran) savedMs += cap - ran;
+                Serial.printf("Zone %d: target reached (%ld.%ld%% + %ld.%ld%% pending) after %lu ms\n", p.originalIndex,
+                              (long)(r.filteredMp / 1000), (long)(r.filteredMp % 1000 / 100),
+                              (long)(r.pendingUp / 1000000), (long)(r.pendingUp / 100000 % 10), ran);
+                return WATER_STOP;
+            }
+            return WATER_CONTINUE;
+        }
+
+        unsigned long settle = min((unsigned long)p.soakMs * WATER_SOAK_FACTOR, (unsigned long)WATER_SOAK_MAX_MS);
+        if (now - r.stoppedAt < settle) return WATER_CONTINUE;
+        r.phase = WATER_IDLE;
+        return learn(p, r, now) ? WATER_LEARNED : WATER_CONTINUE;
+    }
+
+    // Zones to sample at the focus rate (bit = zone)
+    uint64_t focusMask() {
+        uint64_t mask = 0;
+        for (int z = 0; z < MAX_PLANTS; z++) if (runs[z].phase != WATER_IDLE) mask |= 1ULL << z;
+        return mask;
+    }
+
+    bool isClosedLoop(int zone) { return runs[zone].phase == WATER_PUMPING && runs[zone].closedLoop; }
+    unsigned long getEarlyStops() { return earlyStops; }
+    unsigned long getSavedMs() { return savedMs; }
+    unsigned long getLearnCount() { return learnCount; }
+    // Settled moisture above target, closed-loop runs (milli-percent)
+    int32_t getOvershootMean() { return overshootRuns ? (int32_t)(overshootSum / (int64_t)overshootRuns) : 0; }
+    int32_t getOvershootMax() { return overshootMax; }
+
+private:
+    bool learn(Plant &p, WaterRun &r, unsigned long now) {
+        if (r.closedLoop) {
+            int32_t over = r.filteredMp - r.targetMp;
+            overshootSum += over; overshootRuns++;
+            if (over > overshootMax) overshootMax = over;
+        }
+
+        int32_t rise = r.filteredMp - r.startMp;
+        long pumpMs = (long)(r.stoppedAt - r.startedAt);
+        if (pumpMs < WATER_LEARN_MIN_MS || rise < WATER_LEARN_MIN_RISE) return false;
+
+        int32_t gain = (int32_t)((int64_t)rise * 1000 / pumpMs);
+        long soak = (long)(now - r.startedAt) - pumpMs / 2 - (long)(r.area / rise);
+        soak = constrain(soak, (long)WATER_SOAK_MIN_MS, (long)(WATER_SOAK_MAX_MS / WATER_SOAK_FACTOR));
+
+        // First observation replaces half the prior, later ones a quarter
+        int shift = p.waterRuns == 0 ? 1 : 2;
+        p.waterGain += (gain - p.waterGain) / (1 << shift);
+        p.soakMs += (int)((soak - p.soakMs) / (1 << shift));
+        if (p.waterRuns < 255) p.waterRuns++;
+        learnCount++;
+        Serial.printf("Zone %d: +%ld.%ld%% in %ld ms -> gain %d m%%/s, soak %d ms\n", p.originalIndex,
+                      (long)(rise / 1000), (long)(rise % 1000 / 100), pumpMs, p.waterGain, p.soakMs);
+        return true;
+    }
+};
@@ -3,78 +3,213 @@
 #include "Core/Types.h"
 #include "Modules/Buzzer.h"
 #include "Modules/UniversalSensor.h"
+#include "Modules/AdcSampler.h"
 #include "Modules/PlantManager.h"
 #include "Modules/SensorHub.h"
+#include "Modules/HistoryLog.h"
+#include "Modules/TelemetryPublisher.h"
 #include "Core/Network.h"
+#include "Core/Channels.h"
+#include "Core/Tasks.h"
+#include "Core/Trace.h"
+#include "Core/Power.h"
+#include "Core/ConfigStore.h"
+#include "Core/Ota.h"
+#include "Drivers/ZoneMap.h"
+#if ZONE_LAYOUT == ZONE_LAYOUT_MUX
+#include "Drivers/Mux4067.h"
+#include "Drivers/ShiftRegisterOutput.h"
+#elif ZONE_LAYOUT == ZONE_LAYOUT_I2C
+#include <Wire.h>
+#include "Drivers/Ads1115.h"
+#include "Drivers/Mcp23017Output.h"
+#else
+#include "Drivers/DirectAdc.h"
+#include "Drivers/LedcOutput.h"
+#endif
 // #include "Core/HarborMesh.h" // [REMOVED] Core version has no Mesh
 
 Buzzer buzzer; 
 PlantManager* sysPlants = nullptr;
 PlantManager plantManager(&buzzer);
 SensorHub sensorHub;
-NetworkManager network(&plantManager, &sensorHub, &buzzer);
+HistoryLog historyLog(&plantManager, &sensorHub);
+NetworkManager network(&plantManager, &sensorHub, &buzzer, &historyLog);
+TelemetryPublisher telemetry(&plantManager, &sensorHub, &historyLog);
 
-UniversalSensor sensors[4] = {
-    UniversalSensor(0, PINS_SENSOR[0]),
-    UniversalSensor(1, PINS_SENSOR[1]),
-    UniversalSensor(2, PINS_SENSOR[2]),
-    UniversalSensor(3, PINS_SENSOR[3])
-};
+// [ZONES] Sensor/pump front ends for the selected layout
+#if ZONE_LAYOUT == ZONE_LAYOUT_MUX
+Mux4067 muxBank(PINS_MUX_SELECT, PINS_MUX_COMMON, MUX_COUNT);
+ShiftRegisterOutput pumpChain(PIN_SR_DATA, PIN_SR_CLOCK, PIN_SR_LATCH, SR_CHIPS, PUMP_EXT_MA);
+#elif ZONE_LAYOUT == ZONE_LAYOUT_I2C
+Ads1115 adcBoards[ADS_COUNT];
+Mcp23017Output pumpExpander(&Wire, MCP_ADDR, PUMP_EXT_MA);
+#else
+DirectAdc directAdc(PINS_SENSOR, 4);
+LedcOutput ledcPumps(PINS_PUMP, PUMP_CURRENT_MA, 4);
+#endif
+ZoneMap zoneMap;
+
+UniversalSensor sensors[MAX_PLANTS];
+AdcSampler adcSampler(sensors, &zoneMap);
+Mailbox<ZoneReadings> zoneReadings;    // Sensing -> control
+TaskRunner tasks;
+PowerManager power;
+ConfigStore config;
+OtaUpdater ota;
+int controlTask = -1, sensingTask = -1, networkTask = -1, envTask = -1;
+#ifdef ROSEMARY_TRACE
+TraceRing traceRing;
+#endif
+
+// [WAKE] Hand-offs between tasks end the consumer's sleep
+void wakeControl() { tasks.wake(controlTask); }
+void wakeSensing() { tasks.wake(sensingTask); }
+void wakeNetwork() { tasks.wake(networkTask); }
+void IRAM_ATTR wakeEnvFromISR() { tasks.wakeFromISR(envTask); }
+
+// [TASK] Control: pump timing and alarms, highest priority
+uint32_t controlStep() {
+    static uint32_t readingSeq = 0;
+    ZoneReadings r;
+    if (zoneReadings.read(r, readingSeq)) {
+        TRACE_SCOPE("control.readings");
+        PlantTable& plants = plantManager.getPlants();
+        for(int idx=0; idx<MAX_PLANTS; idx++) {
+            Plant *p = plants.byZone(idx);
+            if(!p) continue;
+
+            int moisture = r.moisture[idx];
+            bool wasError = p->errorStatus;
+            p->moistureNoise = r.noise[idx];
+            p->sensorMode = r.mode[idx];
+            p->errorStatus = (r.mode[idx] != SENS_ANALOG);
+            bool healthChanged = plantManager.checkSensor(*p, r.raw[idx], r.noise[idx], r.sample[idx], !p->errorStatus);
+
+            p->currentMoisture = moisture;
+            if (abs(moisture - p->reportedMoisture) >= MOISTURE_DEADBAND || wasError != p->errorStatus || healthChanged) {
+                p->reportedMoisture = moisture;
+                plantManager.notify(p, EVT_MOISTURE);
+            }
+        }
+    }
+    {
+        TRACE_SCOPE("plants.loop");
+        plantManager.loop();
+    }
+    adcSampler.setFocus(plantManager.getFocusZones());
+    buzzer.update();
+    power.hold(POWER_HOLD_PUMPS, plantManager.getPumps().anyRunning());   // LEDC stops in light sleep
+
+    // New readings and commands wake this task
+    NextDue next;
+    next.in(plantManager.nextDueMs());
+    next.in(buzzer.nextDueMs());
+    return next;
+}
+
+// [TASK] Sensing: ADC scan lanes, all zones
+uint32_t sensingStep() {
+    // Burst sampler publishes all zones at once
+    if (adcSampler.update()) {
+        ZoneReadings r;
+        for(int i=0; i<MAX_PLANTS; i++) {
+            r.moisture[i] = sensors[i].getValue();
+            r.noise[i] = sensors[i].getNoise();
+            r.mode[i] = sensors[i].getMode();
+            r.raw[i] = sensors[i].getBurstRaw();
+            r.sample[i] = sensors[i].getSamples();
+        }
+        zoneReadings.publish(r);
+        wakeControl();
+    }
+    return adcSampler.nextDueMs();
+}
+
+// [TASK] Env: DHT22 frames, captured by the edge ISR in the background
+uint32_t envStep() {
+    TRACE_SCOPE("env.read");
+    return sensorHub.updateEnv();
+}
+
+// [TASK] Network: web/DNS, snapshot, flash writes (other core)
+uint32_t networkStep() {
+    { TRACE_SCOPE("net.update"); network.update(); }
+    { TRACE_SCOPE("plants.persist"); plantManager.persist(); }
+    { TRACE_SCOPE("history.update"); historyLog.update(); }
+    NextDue next;
+    next.in(network.nextDueMs());
+    next.in(plantManager.persistDueMs());
+    next.in(historyLog.nextDueMs());
+    return next;
+}
+
+// [TASK] Telemetry: MQTT batches and offline spool, below the network task
+uint32_t telemetryStep() {
+    telemetry.update();
+    return telemetry.nextDueMs();
+}
+
+void setupZones() {
+#if ZONE_LAYOUT == ZONE_LAYOUT_MUX
+    zoneMap.addSensors(&muxBank);
+    zoneMap.addPumps(&pumpChain);
+#elif ZONE_LAYOUT == ZONE_LAYOUT_I2C
+    Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL, I2C_FREQ);
+    for(int i=0; i<ADS_COUNT; i++) {
+        adcBoards[i] = Ads1115(&Wire, ADS_ADDR[i]);
+        zoneMap.addSensors(&adcBoards[i]);
+    }
+    zoneMap.addPumps(&pumpExpander);
+#else
+    zoneMap.addSensors(&directAdc);
+    zoneMap.addPumps(&ledcPumps);
+#endif
+    zoneMap.begin();
+}
 
 void setup() {
     Serial.begin(115200);
+#ifdef ROSEMARY_TRACE
+    traceRing.begin();
+#endif
     Serial.println("\n\n>>> Rosemary Core Booting...");
+    power.begin();
+    config.begin();     // Settings load (and migrate) before any module reads one
+    ota.begin();        // A freshly updated image starts its trial
 
     buzzer.begin();
+    buzzer.wake = wakeControl;
     
-    for(int i=0; i<4; i++) {
-        sensors[i].begin();
+    setupZones();
+    for(int i=0; i<MAX_PLANTS; i++) {
+        sensors[i].begin(i);
     }
+    adcSampler.begin();
+    adcSampler.wake = wakeSensing;
     
-    plantManager.begin();
-    sensorHub.begin();
+    plantManager.begin(&zoneMap);
+    plantManager.wake = wakeControl;
+    sensorHub.begin(wakeEnvFromISR);
+    historyLog.begin();
     
+    network.wake = wakeNetwork;
     network.begin();
+    telemetry.begin();
     // harbor.begin(); // [REMOVED]
 
+    controlTask = tasks.add("control", controlStep, CONTROL_TICK_MS, TASK_CORE_CONTROL, TASK_PRIO_CONTROL, 4096);
+    sensingTask = tasks.add("sensing", sensingStep, SENSE_TICK_MS, TASK_CORE_SENSE, TASK_PRIO_SENSE, 4096);
+    networkTask = tasks.add("network", networkStep, NET_TICK_MS, TASK_CORE_NET, TASK_PRIO_NET, 8192);
+    envTask = tasks.add("env", envStep, ENV_TICK_MS, TASK_CORE_ENV, TASK_PRIO_ENV, 4096);
+    tasks.add("mqtt", telemetryStep, MQTT_TICK_MS, TASK_CORE_MQTT, TASK_PRIO_MQTT, 6144);
+    tasks.start();
+
     Serial.println(">>> System Ready (Analog Mode)");
     buzzer.beep();
 }
 
 void loop() {
-    unsigned long now = millis();
-
-    network.update();
-    plantManager.loop();
-    sensorHub.updateEnv(); 
-    buzzer.update();
-    // harbor.loop(); // [REMOVED]
-
-    // Sensor Loop
-    static int currentSensorIdx = 0;
-    static unsigned long lastSensorRead = 0;
-    
-    if (now - lastSensorRead > 50) {
-        lastSensorRead = now;
-        
-        sensors[currentSensorIdx].update();
-        
-        std::vector<Plant>& plants = plantManager.getPlants();
-        for(auto &p : plants) {
-            if(p.originalIndex == currentSensorIdx) {
-                p.currentMoisture = sensors[currentSensorIdx].getValue();
-                p.sensorMode = sensors[currentSensorIdx].getModeString();
-                
-                
-                if (p.sensorMode.indexOf("Analog") >= 0) {
-                    p.errorStatus = false; 
-                } else {
-                    p.errorStatus = true;
-                }
-            }
-        }
-
-        currentSensorIdx++;
-        if (currentSensorIdx >= 4) currentSensorIdx = 0;
-    }
+    // Work runs in the pinned tasks started by setup()
+    tasks.idle();
 }
\ No newline at end of file
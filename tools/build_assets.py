@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+# ==========================================================
+# build_assets.py - Dashboard assets -> LittleFS image
+#
+# Minifies and gzips data/ into <out>/www and writes the index
+# the firmware serves from (src/Core/StaticAssets.h):
+#
+#   /www/assets.idx     <url> <file> <etag> <max-age>, one per line
+#   /www/index.html.gz  revalidated on every load (no-cache)
+#   /www/css/style.<hash>.css.gz   immutable, max-age one year
+#
+# Files referenced from an HTML page get their content hash in
+# the name, so a new build busts caches through index.html alone.
+# Output is deterministic (gzip mtime 0): same sources, same
+# ETags, and no 200s after a reflash that changed nothing.
+#
+# Standalone:  python3 tools/build_assets.py [--src data] [--out .pio/fsimage]
+# PlatformIO:  extra_scripts = pre:tools/build_assets.py
+#              (rebuilds on every run and points buildfs/uploadfs
+#              at the output instead of data/)
+# ==========================================================
+
+import argparse
+import gzip
+import hashlib
+import io
+import os
+import re
+import shutil
+import sys
+
+IMMUTABLE_MAX_AGE = 31536000            # One year
+MAX_ASSETS = 16                         # ASSET_MAX in src/Config.h
+MAX_URL = 47                            # StaticAsset::url[48] less the terminator
+
+STRING_RE = re.compile(r'("(?:\\.|[^"\\\n])*"|\'(?:\\.|[^\'\\\n])*\')')
+
+
+# --- MINIFIERS (conservative: whitespace and comments only) ---
+
+def outside_strings(text, fn):
+    """Applies fn to everything except quoted string literals."""
+    parts = STRING_RE.split(text)
+    return "".join(p if i % 2 else fn(p) for i, p in enumerate(parts))
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+
+    def squeeze(s):
+        s = re.sub(r"\s+", " ", s)
+        s = re.sub(r"\s*([{};,>])\s*", r"\1", s)
+        s = re.sub(r":\s+", ":", s)          # Not before ':', "a :hover" is a selector
+        return s.replace(";}", "}")
+
+    return outside_strings(text, squeeze).strip()
+
+
+def minify_js(text):
+    # No tokenizer here: only indentation, blank lines and whole-line
+    # comments go. Template literals just lose leading indentation.
+    lines = []
+    for line in text.splitlines():
+        line = line.strip()
+        if line and not line.startswith("//"):
+            lines.append(line)
+    return "\n".join(lines)
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    return "\n".join(l.strip() for l in text.splitlines() if l.strip())
+
+
+MINIFIERS = {".css": minify_css, ".js": minify_js, ".html": minify_html, ".htm": minify_html}
+
+
+def gzip_bytes(data):
+    buf = io.BytesIO()
+    with gzip.GzipFile(filename="", mode="wb", compresslevel=9, fileobj=buf, mtime=0) as f:
+        f.write(data)
+    return buf.getvalue()
+
+
+def digest(data):
+    return hashlib.sha256(data).hexdigest()[:8]
+
+
+# --- BUILD ---
+
+def build(src, out, quiet=False):
+    www = os.path.join(out, "www")
+    if os.path.isdir(www):
+        shutil.rmtree(www)
+    os.makedirs(www)
+
+    sources = []
+    for root, _, files in os.walk(src):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            sources.append(os.path.relpath(path, src).replace(os.sep, "/"))
+    sources.sort()
+    pages = [p for p in sources if os.path.splitext(p)[1] in (".html", ".htm")]
+    others = [p for p in sources if p not in pages]
+
+    def load(rel):
+        with open(os.path.join(src, rel), "rb") as f:
+            raw = f.read()
+        fn = MINIFIERS.get(os.path.splitext(rel)[1].lower())
+        return raw, (fn(raw.decode("utf-8")).encode("utf-8") if fn else raw)
+
+    referenced = set()
+    page_text = {}
+    for rel in pages:
+        raw, body = load(rel)
+        page_text[rel] = (raw, body.decode("utf-8"))
+        for other in others:
+            if re.search(r"""["'](?:\./|/)?%s["']""" % re.escape(other), page_text[rel][1]):
+                referenced.add(other)
+
+    entries = []                        # (url, file, etag, max_age)
+    renames = {}
+    total_raw = total_gz = 0
+
+    def emit(rel, raw, body, hashed):
+        nonlocal total_raw, total_gz
+        gz = gzip_bytes(body)
+        tag = digest(gz)
+        name = rel
+        if hashed:
+            stem, ext = os.path.splitext(rel)
+            name = "%s.%s%s" % (stem, tag, ext)
+        fs_rel = name + ".gz"
+        dest = os.path.join(www, fs_rel)
+        os.makedirs(os.path.dirname(dest), exist_ok=True)
+        with open(dest, "wb") as f:
+            f.write(gz)
+        total_raw += len(raw)
+        total_gz += len(gz)
+        if not quiet:
+            print("  %-28s %6d -> %5d B" % (name, len(raw), len(gz)))
+        return name, "/www/" + fs_rel, tag
+
+    for rel in others:
+        raw, body = load(rel)
+        hashed = rel in referenced
+        name, fs_path, tag = emit(rel, raw, body, hashed)
+        renames[rel] = name
+        entries.append(("/" + name, fs_path, tag, IMMUTABLE_MAX_AGE if hashed else 0))
+
+    for rel in pages:
+        raw, text = page_text[rel]
+        for old, new in renames.items():
+            if old != new:
+                text = re.sub(r"""(["'])((?:\./|/)?)%s\1""" % re.escape(old),
+                              lambda m: m.group(1) + m.group(2) + new + m.group(1), text)
+        _, fs_path, tag = emit(rel, raw, text.encode("utf-8"), False)
+        entries.append(("/" + rel, fs_path, tag, 0))
+        if rel in ("index.html", "index.htm"):
+            entries.append(("/", fs_path, tag, 0))
+
+    for url, fs_path, _, _ in entries:
+        if len(url) > MAX_URL or len(fs_path) > MAX_URL + 16 or " " in url:
+            sys.exit("build_assets: path too long or has spaces: " + url)
+    if len(entries) > MAX_ASSETS:
+        sys.exit("build_assets: %d URLs, firmware table holds %d (ASSET_MAX)" % (len(entries), MAX_ASSETS))
+
+    with open(os.path.join(www, "assets.idx"), "w", newline="\n") as f:
+        for url, fs_path, tag, max_age in sorted(entries):
+            f.write("%s %s \"%s\" %d\n" % (url, fs_path, tag, max_age))
+
+    if not quiet:
+        print("build_assets: %d files, %d -> %d B gzip, %d URLs" % (len(sources), total_raw, total_gz, len(entries)))
+    return entries
+
+
+def main(argv=None):
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser(description="Minify and gzip data/ into a LittleFS image")
+    ap.add_argument("--src", default=os.path.join(here, "..", "data"))
+    ap.add_argument("--out", default=os.path.join(here, "..", ".pio", "fsimage"))
+    ap.add_argument("--quiet", action="store_true")
+    args = ap.parse_args(argv)
+    build(args.src, args.out, args.quiet)
+
+
+# PlatformIO runs this file through SCons, where Import() is defined
+try:
+    Import("env")                       # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    project = env.subst("$PROJECT_DIR")  # noqa: F821
+    image = os.path.join(env.subst("$BUILD_DIR"), "fsimage")  # noqa: F821
+    build(os.path.join(project, "data"), image, quiet=True)
+    env.Replace(PROJECT_DATA_DIR=image)  # noqa: F821
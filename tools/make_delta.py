@@ -0,0 +1,267 @@
+#!/usr/bin/env python3
+# ==========================================================
+# make_delta.py - Firmware image -> compressed delta for /api/ota
+#
+# Writes the format src/Core/DeltaPatch.h decodes:
+#
+#   header  "RDP1", version 1, window bits, 2 reserved bytes,
+#           old size (u32) + SHA-256, new size (u32) + SHA-256
+#   body    the patch records below, LZ-compressed
+#
+# Patch records are bsdiff's: a diff run (new byte = old byte +
+# diff byte, mod 256), an extra run (bytes copied as they are),
+# then a seek of the old position. Code that only moved keeps its
+# bytes or shifts a few address bytes, so diff runs are mostly
+# zeros and compress to almost nothing.
+#
+# The LZ pass is byte-aligned and bounded by the window the
+# device holds (OTA_WINDOW_BITS_MAX, 4 KB):
+#   token < 0x80   literal run of token + 1 bytes
+#   token >= 0x80  match of (token & 0x7F) + 3 bytes, plus a
+#                  varint when the low bits are 0x7F, then a
+#                  varint distance (1 .. window)
+# Varints are LEB128, the seek is zigzag-coded.
+#
+# The old image must be the exact .bin the device runs: the
+# device hashes that many bytes of its running slot and refuses
+# a delta made from anything else (409). With "-" as the old
+# image the output is a compressed full image, which applies on
+# top of anything.
+#
+#   python3 tools/make_delta.py old.bin new.bin -o update.delta
+#   curl --data-binary @update.delta http://<node>/api/ota
+# ==========================================================
+
+import argparse
+import hashlib
+import struct
+import sys
+import time
+
+MAGIC = b"RDP1"
+VERSION = 1
+WINDOW_BITS = 12                        # OTA_WINDOW_BITS_MAX in src/Config.h
+SEED = 8                                # Shortest exact match that starts a diff run
+CANDIDATES = 8                          # Old positions kept per seed
+
+
+# --- VARINTS ---
+
+def varint(v, out):
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+
+
+def zigzag(v):
+    return (v << 1) if v >= 0 else ((-v << 1) - 1)
+
+
+# --- DIFF (bsdiff records, greedy matching) ---
+
+def index_old(old):
+    """Seed -> up to CANDIDATES old positions, latest first."""
+    table = {}
+    for i in range(len(old) - SEED + 1):
+        key = old[i:i + SEED]
+        hit = table.get(key)
+        if hit is None:
+            table[key] = [i]
+        elif len(hit) < CANDIDATES:
+            hit.append(i)
+    return table
+
+
+def exact_len(old, new, o, n):
+    """Bytes old[o:] and new[n:] share, in 64-byte steps first."""
+    length = 0
+    limit = min(len(old) - o, len(new) - n)
+    while length + 64 <= limit and old[o + length:o + length + 64] == new[n + length:n + length + 64]:
+        length += 64
+    while length < limit and old[o + length] == new[n + length]:
+        length += 1
+    return length
+
+
+def extend(old, new, o, n, limit):
+    """bsdiff's approximate run: the length with the most matches over mismatches."""
+    score = best = best_len = i = 0
+    limit = min(limit, len(old) - o, len(new) - n)
+    while i < limit:
+        step = exact_len(old, new, o + i, n + i)
+        if step:
+            i += step
+            score += step
+        else:
+            i += 1
+            score -= 1
+        if score > best:
+            best, best_len = score, i
+        elif score < best - 32:
+            break
+    return best_len
+
+
+def extend_back(old, new, o, n, limit):
+    """Same, backwards from (o, n) into the pending extra bytes."""
+    score = best = best_len = 0
+    for i in range(1, min(limit, o, n) + 1):
+        score += 1 if old[o - i] == new[n - i] else -1
+        if score > best:
+            best, best_len = score, i
+        elif score < best - 16:
+            break
+    return best_len
+
+
+def diff(old, new):
+    """Patch records as one byte string."""
+    table = index_old(old) if len(old) >= SEED else {}
+    out = bytearray()
+    records = 0
+
+    last_new = last_old = 0             # End of the previous diff run
+    run_new = run_old = run_len = 0     # The pending record's diff run
+    scan = 0
+    while scan < len(new):
+        # Continuing the previous alignment is the usual case (code that moved as a block)
+        cands = [last_old + (scan - last_new)] if last_old + (scan - last_new) < len(old) else []
+        cands += table.get(new[scan:scan + SEED], ())
+        best_o, best_n = -1, 0
+        for o in cands:
+            length = exact_len(old, new, o, scan)
+            if length > best_n:
+                best_o, best_n = o, length
+        if best_n < SEED:
+            scan += 1
+            continue
+
+        back = extend_back(old, new, best_o, scan, scan - last_new)
+        start_n, start_o = scan - back, best_o - back
+        length = back + extend(old, new, best_o, scan, len(new))
+
+        # Close the pending record: its diff run, the bytes up to here, the seek
+        emit(out, old, new, run_new, run_old, run_len, last_new, start_n, start_o - (run_old + run_len))
+        records += 1
+        run_new, run_old, run_len = start_n, start_o, length
+        last_new, last_old = start_n + length, start_o + length
+        scan = last_new
+
+    emit(out, old, new, run_new, run_old, run_len, last_new, len(new), 0)
+    return bytes(out), records + 1
+
+
+def emit(out, old, new, run_new, run_old, run_len, extra_from, extra_to, seek):
+    varint(run_len, out)
+    varint(extra_to - extra_from, out)
+    varint(zigzag(seek), out)
+    out += bytes((new[run_new + i] - old[run_old + i]) & 0xFF for i in range(run_len))
+    out += new[extra_from:extra_to]
+
+
+# --- LZ (greedy, hash chains over 3-byte keys) ---
+
+def compress(data, window_bits):
+    window = 1 << window_bits
+    out = bytearray()
+    literals = bytearray()
+    head = {}
+    chain = [0] * window                # Previous position with the same key (pos & mask)
+    mask = window - 1
+
+    def flush():
+        for at in range(0, len(literals), 128):
+            part = literals[at:at + 128]
+            out.append(len(part) - 1)
+            out.extend(part)
+        literals.clear()
+
+    def insert(p):
+        key = data[p:p + 3]
+        chain[p & mask] = head.get(key, -1)
+        head[key] = p
+
+    i = 0
+    n = len(data)
+    while i < n:
+        best_len = best_dist = 0
+        if i + 3 <= n:
+            p = head.get(data[i:i + 3], -1)
+            tries = 16
+            while p >= 0 and i - p <= window and tries:
+                length = 0
+                limit = n - i
+                while length + 64 <= limit and data[p + length:p + length + 64] == data[i + length:i + length + 64]:
+                    length += 64
+                while length < limit and data[p + length] == data[i + length]:
+                    length += 1
+                if length > best_len:
+                    best_len, best_dist = length, i - p
+                nxt = chain[p & mask]
+                if nxt >= p:
+                    break
+                p = nxt
+                tries -= 1
+        # A far match has to pay for its two-byte distance
+        if best_len < 3 or (best_dist >= 128 and best_len < 4):
+            literals.append(data[i])
+            insert(i)
+            i += 1
+            continue
+
+        flush()
+        extra = best_len - 3
+        out.append(0x80 | min(extra, 0x7F))
+        if extra >= 0x7F:
+            varint(extra - 0x7F, out)
+        varint(best_dist, out)
+        # Long runs (zeros, 0xFF padding): index the tail only
+        for p in range(max(i, i + best_len - 64), i + best_len):
+            insert(p)
+        i += best_len
+    flush()
+    return bytes(out)
+
+
+def make_delta(old, new, window_bits=WINDOW_BITS):
+    patch, records = diff(old, new)
+    body = compress(patch, window_bits)
+    header = MAGIC + struct.pack("<BBH", VERSION, window_bits, 0)
+    header += struct.pack("<I", len(old)) + hashlib.sha256(old).digest()
+    header += struct.pack("<I", len(new)) + hashlib.sha256(new).digest()
+    return header + body, records, len(patch)
+
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description="Compressed binary delta for POST /api/ota")
+    ap.add_argument("old", help="image the device runs now (.bin), or - for a full image")
+    ap.add_argument("new", help="image to install (.bin)")
+    ap.add_argument("-o", "--out", required=True)
+    ap.add_argument("--window", type=int, default=WINDOW_BITS,
+                    help="LZ window bits, 8..%d (default %d)" % (WINDOW_BITS, WINDOW_BITS))
+    ap.add_argument("--quiet", action="store_true")
+    args = ap.parse_args(argv)
+    if not 8 <= args.window <= WINDOW_BITS:
+        sys.exit("make_delta: --window must be 8..%d (the device holds a %d-byte window)" % (WINDOW_BITS, 1 << WINDOW_BITS))
+
+    old = b""
+    if args.old != "-":
+        with open(args.old, "rb") as f:
+            old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+    if not new:
+        sys.exit("make_delta: new image is empty")
+
+    t0 = time.time()
+    delta, records, patch_len = make_delta(old, new, args.window)
+    with open(args.out, "wb") as f:
+        f.write(delta)
+    if not args.quiet:
+        print("make_delta: %d -> %d B image, %d records, patch %d B -> delta %d B (%.1f%% of the image) in %.1f s"
+              % (len(old), len(new), records, patch_len, len(delta), 100.0 * len(delta) / len(new), time.time() - t0))
+
+
+if __name__ == "__main__":
+    main()